@@ -0,0 +1,232 @@
+///////////////////////////////////////////////////////////////////////////////
+// framebenchmark.cpp
+// ============
+// collect CPU frame times and report their percentiles
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameBenchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+	/***********************************************************
+	 *  Percentile()
+	 *
+	 *  Nearest-rank percentile of sorted samples.
+	 ***********************************************************/
+	double Percentile(const std::vector<double>& sorted, double percent)
+	{
+		if (sorted.empty())
+		{
+			return(0.0);
+		}
+
+		size_t rank = static_cast<size_t>(std::ceil(percent / 100.0 * sorted.size()));
+		rank = std::min(std::max(rank, static_cast<size_t>(1)), sorted.size());
+		return(sorted[rank - 1]);
+	}
+}
+
+/***********************************************************
+ *  FrameBenchmark()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameBenchmark::FrameBenchmark()
+{
+	m_frameStart = std::chrono::steady_clock::now();
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for dropping the recorded samples,
+ *  reserving room so recording never allocates mid-run.
+ ***********************************************************/
+void FrameBenchmark::Reset(int expectedFrames)
+{
+	m_frameTimes.clear();
+	if (expectedFrames > 0)
+	{
+		m_frameTimes.reserve(expectedFrames);
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for marking the start of a frame.
+ ***********************************************************/
+void FrameBenchmark::BeginFrame()
+{
+	m_frameStart = std::chrono::steady_clock::now();
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for recording the time since the
+ *  last BeginFrame() call.
+ ***********************************************************/
+void FrameBenchmark::EndFrame()
+{
+	std::chrono::duration<double, std::milli> elapsed =
+		std::chrono::steady_clock::now() - m_frameStart;
+	m_frameTimes.push_back(elapsed.count());
+}
+
+/***********************************************************
+ *  SetInfo()
+ *
+ *  These methods are used for attaching a named string or
+ *  number to the JSON report.
+ ***********************************************************/
+void FrameBenchmark::SetInfo(const char* name, const std::string& value)
+{
+	SetInfoText(name, QuoteJSON(value));
+}
+
+void FrameBenchmark::SetInfo(const char* name, double value)
+{
+	std::ostringstream text;
+	text << std::setprecision(10) << value;
+	SetInfoText(name, text.str());
+}
+
+void FrameBenchmark::SetInfoText(const char* name, const std::string& json)
+{
+	for (std::pair<std::string, std::string>& info : m_info)
+	{
+		if (info.first == name)
+		{
+			info.second = json;
+			return;
+		}
+	}
+	m_info.push_back(std::make_pair(std::string(name), json));
+}
+
+/***********************************************************
+ *  QuoteJSON()
+ *
+ *  This method is used for quoting a string for JSON,
+ *  escaping what needs it.
+ ***********************************************************/
+std::string FrameBenchmark::QuoteJSON(const std::string& text)
+{
+	std::string quoted = "\"";
+	for (char c : text)
+	{
+		if ((c == '"') || (c == '\\'))
+		{
+			quoted += '\\';
+			quoted += c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20)
+		{
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+			quoted += escaped;
+		}
+		else
+		{
+			quoted += c;
+		}
+	}
+	quoted += "\"";
+	return(quoted);
+}
+
+/***********************************************************
+ *  GetStats()
+ *
+ *  This method is used for summarizing the recorded frame
+ *  times.
+ ***********************************************************/
+FrameBenchmark::FRAME_STATS FrameBenchmark::GetStats() const
+{
+	FRAME_STATS stats = {};
+	stats.frameCount = static_cast<int>(m_frameTimes.size());
+	if (m_frameTimes.empty())
+	{
+		return(stats);
+	}
+
+	std::vector<double> sorted = m_frameTimes;
+	std::sort(sorted.begin(), sorted.end());
+
+	double total = 0.0;
+	for (double frameTime : sorted)
+	{
+		total += frameTime;
+	}
+
+	stats.mean = total / sorted.size();
+	stats.min = sorted.front();
+	stats.p50 = Percentile(sorted, 50.0);
+	stats.p95 = Percentile(sorted, 95.0);
+	stats.p99 = Percentile(sorted, 99.0);
+	stats.max = sorted.back();
+	return(stats);
+}
+
+/***********************************************************
+ *  PrintSummary()
+ *
+ *  This method is used for printing the percentiles on the
+ *  console.
+ ***********************************************************/
+void FrameBenchmark::PrintSummary() const
+{
+	FRAME_STATS stats = GetStats();
+	std::cout << std::fixed << std::setprecision(3)
+		<< "Frame time over " << stats.frameCount << " frames: p50 " << stats.p50
+		<< " ms, p95 " << stats.p95 << " ms, p99 " << stats.p99
+		<< " ms (mean " << stats.mean << ", min " << stats.min << ", max " << stats.max << ")"
+		<< std::defaultfloat << std::endl;
+}
+
+/***********************************************************
+ *  WriteJSON()
+ *
+ *  This method is used for writing the attached values and
+ *  the frame time summary to the passed in file.
+ ***********************************************************/
+bool FrameBenchmark::WriteJSON(const char* filename) const
+{
+	std::ofstream file(filename);
+	if (!file)
+	{
+		std::cout << "Could not write benchmark results to " << filename << std::endl;
+		return(false);
+	}
+
+	FRAME_STATS stats = GetStats();
+
+	file << "{\n";
+	for (const std::pair<std::string, std::string>& info : m_info)
+	{
+		file << "  " << QuoteJSON(info.first) << ": " << info.second << ",\n";
+	}
+	file << std::fixed << std::setprecision(4)
+		<< "  \"frames\": " << stats.frameCount << ",\n"
+		<< "  \"frameTimeMs\": {\n"
+		<< "    \"mean\": " << stats.mean << ",\n"
+		<< "    \"min\": " << stats.min << ",\n"
+		<< "    \"p50\": " << stats.p50 << ",\n"
+		<< "    \"p95\": " << stats.p95 << ",\n"
+		<< "    \"p99\": " << stats.p99 << ",\n"
+		<< "    \"max\": " << stats.max << "\n"
+		<< "  }\n"
+		<< "}\n";
+
+	return(file.good());
+}
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// framebenchmark.h
+// ============
+// collect CPU frame times and report their percentiles
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+/***********************************************************
+ *  FrameBenchmark
+ *
+ *  This class records how long each measured frame took on
+ *  the CPU, from BeginFrame() to EndFrame(), and summarizes
+ *  the samples as percentiles.  The summary can be printed
+ *  or written as JSON together with named values that
+ *  describe the run.
+ ***********************************************************/
+class FrameBenchmark
+{
+public:
+	// summary of the recorded frame times, in milliseconds
+	struct FRAME_STATS
+	{
+		int frameCount;
+		double mean;
+		double min;
+		double p50;
+		double p95;
+		double p99;
+		double max;
+	};
+
+	// constructor
+	FrameBenchmark();
+
+	// drop the samples and make room for the passed in count
+	void Reset(int expectedFrames);
+
+	// time one frame
+	void BeginFrame();
+	void EndFrame();
+
+	// attach a value to the report, replacing any of the same name
+	void SetInfo(const char* name, const std::string& value);
+	void SetInfo(const char* name, double value);
+
+	int GetFrameCount() const { return static_cast<int>(m_frameTimes.size()); }
+	// summarize the samples recorded so far
+	FRAME_STATS GetStats() const;
+
+	// print the summary on the console
+	void PrintSummary() const;
+	// write the summary and the attached values as a JSON file
+	bool WriteJSON(const char* filename) const;
+
+	// quote a string for JSON, escaping what needs it
+	static std::string QuoteJSON(const std::string& text);
+
+private:
+	std::vector<double> m_frameTimes;
+	std::chrono::steady_clock::time_point m_frameStart;
+	// names with values already formatted as JSON
+	std::vector<std::pair<std::string, std::string> > m_info;
+
+	void SetInfoText(const char* name, const std::string& json);
+};
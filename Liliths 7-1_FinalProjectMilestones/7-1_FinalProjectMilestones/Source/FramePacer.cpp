@@ -0,0 +1,456 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.cpp
+// ============
+// pace the presented frames and measure their input latency
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FramePacer.h"
+
+#include "GLFW/glfw3.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+// declaration of global variables
+namespace
+{
+	// same order as FramePacer::PRESENT_MODE
+	const char* g_ModeNames[] = { "uncapped", "vsync", "adaptive", "limit" };
+
+	// samples kept for the statistics
+	const int g_SampleCount = 4096;
+	// frames queued before the oldest is waited for when
+	// the frames ahead are not limited
+	const int g_MaxPendingFrames = 16;
+	// frames between two measurements of the GPU clock
+	const int g_CalibrationFrames = 120;
+	// least time left to the deadline that is slept instead of spun
+	const double g_MinSleepSeconds = 0.0005;
+
+	/***********************************************************
+	 *  GetPercentile()
+	 *
+	 *  This function is used to get one percentile of a sorted
+	 *  list of samples.
+	 ***********************************************************/
+	double GetPercentile(const std::vector<double>& sorted, double percentile)
+	{
+		if (sorted.empty())
+		{
+			return(0.0);
+		}
+		size_t index = static_cast<size_t>(percentile * (sorted.size() - 1) + 0.5);
+		return(sorted[std::min(index, sorted.size() - 1)]);
+	}
+}
+
+/***********************************************************
+ *  FramePacer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FramePacer::FramePacer()
+{
+	m_mode = PRESENT_VSYNC;
+	m_targetFps = 60.0;
+	m_maxFramesAhead = 2;
+	m_sleepSlack = 0.001;
+	m_startTime = Clock::now();
+	m_inputSeconds = 0.0;
+	m_lastPresentSeconds = -1.0;
+	m_nextDeadline = -1.0;
+	m_gpuToCpuSeconds = 0.0;
+	m_framesSinceCalibration = g_CalibrationFrames;
+	m_nextLatency = 0;
+	m_nextInterval = 0;
+}
+
+/***********************************************************
+ *  ~FramePacer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FramePacer::~FramePacer()
+{
+	// the GL objects must be freed with Release() while the
+	// context is still current
+}
+
+/***********************************************************
+ *  SetTargetFps()
+ *
+ *  This method is used for setting the frame rate the
+ *  limited mode holds.
+ ***********************************************************/
+void FramePacer::SetTargetFps(double fps)
+{
+	if (fps > 0.0)
+	{
+		m_targetFps = fps;
+		m_nextDeadline = -1.0;
+	}
+}
+
+/***********************************************************
+ *  GetModeName()
+ *
+ *  This method is used for getting the command line name of
+ *  a present mode.
+ ***********************************************************/
+const char* FramePacer::GetModeName(PRESENT_MODE mode)
+{
+	return(g_ModeNames[mode]);
+}
+
+/***********************************************************
+ *  ParseMode()
+ *
+ *  This method is used for looking up a present mode by its
+ *  command line name.
+ ***********************************************************/
+bool FramePacer::ParseMode(const char* name, PRESENT_MODE& mode)
+{
+	for (int i = 0; i <= PRESENT_LIMITED; i++)
+	{
+		if (strcmp(name, g_ModeNames[i]) == 0)
+		{
+			mode = static_cast<PRESENT_MODE>(i);
+			return(true);
+		}
+	}
+	return(false);
+}
+
+/***********************************************************
+ *  Apply()
+ *
+ *  This method is used for setting the swap interval of the
+ *  current context to match the present mode.
+ ***********************************************************/
+void FramePacer::Apply()
+{
+	int interval = 0;
+	switch (m_mode)
+	{
+	case PRESENT_VSYNC:
+		interval = 1;
+		break;
+	case PRESENT_ADAPTIVE:
+		// a negative interval is only allowed with tear control
+		if (glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+			glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+		{
+			interval = -1;
+		}
+		else
+		{
+			std::cout << "Adaptive vsync is not supported, using vsync" << std::endl;
+			m_mode = PRESENT_VSYNC;
+			interval = 1;
+		}
+		break;
+	default:
+		interval = 0;
+		break;
+	}
+	glfwSwapInterval(interval);
+
+	std::cout << "Present mode: " << GetModeName(m_mode);
+	if (PRESENT_LIMITED == m_mode)
+	{
+		std::cout << " at " << m_targetFps << " fps";
+	}
+	std::cout << ", up to " << m_maxFramesAhead << " frames ahead" << std::endl;
+
+	m_lastPresentSeconds = -1.0;
+	m_nextDeadline = -1.0;
+	m_framesSinceCalibration = g_CalibrationFrames;
+}
+
+/***********************************************************
+ *  InputSampled()
+ *
+ *  This method is used for noting when the input the next
+ *  frame is built from was polled.
+ ***********************************************************/
+void FramePacer::InputSampled()
+{
+	m_inputSeconds = Now();
+}
+
+/***********************************************************
+ *  FramePresented()
+ *
+ *  This method is used for marking the end of the frame that
+ *  was just swapped on the GPU, collecting the frames the
+ *  GPU has finished, and holding the CPU back until the next
+ *  frame may start.
+ ***********************************************************/
+void FramePacer::FramePresented()
+{
+	if (m_framesSinceCalibration >= g_CalibrationFrames)
+	{
+		CalibrateClock();
+	}
+	m_framesSinceCalibration++;
+
+	PENDING_FRAME frame;
+	if (m_freeQueries.empty())
+	{
+		glGenQueries(1, &frame.timestampQuery);
+	}
+	else
+	{
+		frame.timestampQuery = m_freeQueries.back();
+		m_freeQueries.pop_back();
+	}
+	glQueryCounter(frame.timestampQuery, GL_TIMESTAMP);
+	frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	frame.inputSeconds = m_inputSeconds;
+	m_pendingFrames.push_back(frame);
+
+	CollectFrames();
+
+	if (PRESENT_LIMITED == m_mode)
+	{
+		WaitForDeadline();
+	}
+
+	double presentSeconds = Now();
+	if (m_lastPresentSeconds >= 0.0)
+	{
+		AddSample(m_intervals, m_nextInterval, presentSeconds - m_lastPresentSeconds);
+	}
+	m_lastPresentSeconds = presentSeconds;
+}
+
+/***********************************************************
+ *  CollectFrames()
+ *
+ *  This method is used for recording the latency of every
+ *  frame the GPU has finished, waiting for the oldest ones
+ *  while more than the allowed number are still queued.
+ ***********************************************************/
+void FramePacer::CollectFrames()
+{
+	int maxPending = (m_maxFramesAhead > 0) ? m_maxFramesAhead : g_MaxPendingFrames;
+
+	while (!m_pendingFrames.empty())
+	{
+		PENDING_FRAME& frame = m_pendingFrames.front();
+		bool bMustWait = static_cast<int>(m_pendingFrames.size()) > maxPending;
+
+		if (bMustWait)
+		{
+			// the first wait flushes, later ones only poll
+			GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+			while (glClientWaitSync(frame.fence, flags, 100000000) == GL_TIMEOUT_EXPIRED)
+			{
+				flags = 0;
+			}
+		}
+		else if (glClientWaitSync(frame.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+		{
+			// finished in order, so the newer ones are not done either
+			break;
+		}
+
+		// the fence has signaled, so the timestamp is written
+		GLuint64 gpuNanoseconds = 0;
+		glGetQueryObjectui64v(frame.timestampQuery, GL_QUERY_RESULT, &gpuNanoseconds);
+		double doneSeconds = gpuNanoseconds * 1.0e-9 + m_gpuToCpuSeconds;
+		if (doneSeconds >= frame.inputSeconds)
+		{
+			AddSample(m_latencies, m_nextLatency, doneSeconds - frame.inputSeconds);
+		}
+
+		glDeleteSync(frame.fence);
+		m_freeQueries.push_back(frame.timestampQuery);
+		m_pendingFrames.pop_front();
+	}
+}
+
+/***********************************************************
+ *  WaitForDeadline()
+ *
+ *  This method is used for holding the limited mode to its
+ *  frame rate.  The thread sleeps until shortly before the
+ *  deadline, by as much as recent sleeps have overslept,
+ *  and spins the rest of the way.
+ ***********************************************************/
+void FramePacer::WaitForDeadline()
+{
+	const double period = 1.0 / m_targetFps;
+	double now = Now();
+
+	if ((m_nextDeadline < 0.0) || (now > m_nextDeadline + period))
+	{
+		// first frame, or too late to catch up without a burst
+		m_nextDeadline = now + period;
+	}
+
+	double sleepSeconds = m_nextDeadline - now - m_sleepSlack;
+	if (sleepSeconds > g_MinSleepSeconds)
+	{
+		std::this_thread::sleep_for(std::chrono::duration<double>(sleepSeconds));
+		double overslept = (Now() - now) - sleepSeconds;
+
+		// jump up to a late wake up at once, drift back down slowly
+		m_sleepSlack = std::max(overslept * 1.25, m_sleepSlack * 0.99);
+		m_sleepSlack = std::min(std::max(m_sleepSlack, 0.0005), period);
+	}
+
+	while (Now() < m_nextDeadline)
+	{
+		std::this_thread::yield();
+	}
+	m_nextDeadline += period;
+}
+
+/***********************************************************
+ *  CalibrateClock()
+ *
+ *  This method is used for measuring the offset between the
+ *  GPU timestamps and the CPU clock.
+ ***********************************************************/
+void FramePacer::CalibrateClock()
+{
+	GLint64 gpuNanoseconds = 0;
+	double before = Now();
+	glGetInteger64v(GL_TIMESTAMP, &gpuNanoseconds);
+	double after = Now();
+
+	m_gpuToCpuSeconds = (before + after) * 0.5 - gpuNanoseconds * 1.0e-9;
+	m_framesSinceCalibration = 0;
+}
+
+/***********************************************************
+ *  Now()
+ *
+ *  This method is used for getting the seconds since the
+ *  pacer was made.
+ ***********************************************************/
+double FramePacer::Now() const
+{
+	return(std::chrono::duration<double>(Clock::now() - m_startTime).count());
+}
+
+/***********************************************************
+ *  AddSample()
+ *
+ *  This method is used for keeping a sample, writing over
+ *  the oldest one once the list is full.
+ ***********************************************************/
+void FramePacer::AddSample(std::vector<double>& samples, int& next, double value)
+{
+	if (static_cast<int>(samples.size()) < g_SampleCount)
+	{
+		samples.push_back(value);
+	}
+	else
+	{
+		samples[next] = value;
+	}
+	next = (next + 1) % g_SampleCount;
+}
+
+/***********************************************************
+ *  GetStats()
+ *
+ *  This method is used for summing up the kept samples.
+ ***********************************************************/
+FramePacer::PACING_STATS FramePacer::GetStats() const
+{
+	PACING_STATS stats;
+	memset(&stats, 0, sizeof(stats));
+	stats.frameCount = static_cast<int>(m_latencies.size());
+
+	if (!m_intervals.empty())
+	{
+		double sum = 0.0;
+		for (double interval : m_intervals)
+		{
+			sum += interval;
+		}
+		double mean = sum / m_intervals.size();
+
+		double squares = 0.0;
+		for (double interval : m_intervals)
+		{
+			squares += (interval - mean) * (interval - mean);
+		}
+		stats.intervalMean = mean * 1000.0;
+		stats.intervalDeviation = sqrt(squares / m_intervals.size()) * 1000.0;
+	}
+
+	if (!m_latencies.empty())
+	{
+		std::vector<double> sorted(m_latencies);
+		std::sort(sorted.begin(), sorted.end());
+
+		double sum = 0.0;
+		for (double latency : sorted)
+		{
+			sum += latency;
+		}
+		stats.latencyMean = sum / sorted.size() * 1000.0;
+		stats.latencyP50 = GetPercentile(sorted, 0.50) * 1000.0;
+		stats.latencyP95 = GetPercentile(sorted, 0.95) * 1000.0;
+		stats.latencyP99 = GetPercentile(sorted, 0.99) * 1000.0;
+	}
+	return(stats);
+}
+
+/***********************************************************
+ *  PrintStats()
+ *
+ *  This method is used for printing the frame pacing and
+ *  latency of the present mode.
+ ***********************************************************/
+void FramePacer::PrintStats() const
+{
+	PACING_STATS stats = GetStats();
+	if (0 == stats.frameCount)
+	{
+		return;
+	}
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "Frame pacing over the latest " << stats.frameCount << " frames ("
+		<< GetModeName(m_mode) << "):" << std::endl;
+	std::cout << "  frame interval  mean " << stats.intervalMean
+		<< " ms (" << ((stats.intervalMean > 0.0) ? 1000.0 / stats.intervalMean : 0.0)
+		<< " fps), deviation " << stats.intervalDeviation << " ms" << std::endl;
+	std::cout << "  input latency   mean " << stats.latencyMean
+		<< " ms, p50 " << stats.latencyP50
+		<< " ms, p95 " << stats.latencyP95
+		<< " ms, p99 " << stats.latencyP99 << " ms" << std::endl;
+	std::cout << std::defaultfloat;
+}
+
+/***********************************************************
+ *  Release()
+ *
+ *  This method is used for freeing the fences and queries
+ *  of the frames still queued and the spare queries.
+ ***********************************************************/
+void FramePacer::Release()
+{
+	for (PENDING_FRAME& frame : m_pendingFrames)
+	{
+		glDeleteSync(frame.fence);
+		m_freeQueries.push_back(frame.timestampQuery);
+	}
+	m_pendingFrames.clear();
+
+	if (!m_freeQueries.empty())
+	{
+		glDeleteQueries(static_cast<GLsizei>(m_freeQueries.size()), m_freeQueries.data());
+		m_freeQueries.clear();
+	}
+}
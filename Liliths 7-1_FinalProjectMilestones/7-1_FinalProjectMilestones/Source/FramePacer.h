@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.h
+// ============
+// pace the presented frames and measure their input latency
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <deque>
+#include <vector>
+
+/***********************************************************
+ *  FramePacer
+ *
+ *  This class decides when the window loop starts its next
+ *  frame.  The present mode sets the swap interval: none,
+ *  every refresh, every refresh unless a frame is late, or
+ *  none with the frame rate held to a target by sleeping
+ *  and then spinning up to the exact deadline.
+ *
+ *  A fence after each presented frame lets the CPU queue
+ *  only a set number of frames ahead of the GPU.  A
+ *  timestamp query next to the fence tells when the GPU
+ *  finished the frame, and the time from the input poll
+ *  the frame was built from to that moment is kept as the
+ *  input to present latency of the frame.  The waits all
+ *  happen before the input is polled, so the next frame
+ *  is built from the newest input.
+ ***********************************************************/
+class FramePacer
+{
+public:
+	// constructor
+	FramePacer();
+	// destructor
+	~FramePacer();
+
+	// how presented frames are paced
+	enum PRESENT_MODE
+	{
+		// swap interval 0, as fast as the GPU goes
+		PRESENT_UNCAPPED,
+		// swap interval 1, one frame per refresh
+		PRESENT_VSYNC,
+		// swap interval -1, late frames present without waiting
+		PRESENT_ADAPTIVE,
+		// swap interval 0 with a frame rate limiter
+		PRESENT_LIMITED
+	};
+
+	// latency and frame interval statistics in milliseconds
+	struct PACING_STATS
+	{
+		int frameCount;
+		double intervalMean;
+		double intervalDeviation;
+		double latencyMean;
+		double latencyP50;
+		double latencyP95;
+		double latencyP99;
+	};
+
+	// choose before Apply()
+	void SetMode(PRESENT_MODE mode) { m_mode = mode; }
+	PRESENT_MODE GetMode() const { return m_mode; }
+	// frame rate of the limited mode
+	void SetTargetFps(double fps);
+	// frames queued on the GPU before the CPU waits, 0 for no limit
+	void SetMaxFramesAhead(int frameCount) { m_maxFramesAhead = (frameCount > 0) ? frameCount : 0; }
+	int GetMaxFramesAhead() const { return m_maxFramesAhead; }
+
+	static const char* GetModeName(PRESENT_MODE mode);
+	// mode by name, false for an unknown name
+	static bool ParseMode(const char* name, PRESENT_MODE& mode);
+
+	// set the swap interval of the current context, adaptive
+	// falls back to vsync without the tear control extension
+	void Apply();
+	// call right after the input events were polled
+	void InputSampled();
+	// call right after the swap, waits until the next frame may start
+	void FramePresented();
+
+	// statistics of the frames finished so far
+	PACING_STATS GetStats() const;
+	void PrintStats() const;
+	// free the fences and queries while the context is current
+	void Release();
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	// presented frame the GPU may not have finished
+	struct PENDING_FRAME
+	{
+		GLsync fence;
+		GLuint timestampQuery;
+		double inputSeconds;
+	};
+
+	PRESENT_MODE m_mode;
+	double m_targetFps;
+	int m_maxFramesAhead;
+	// how late a sleep has woken up lately, spun away instead
+	double m_sleepSlack;
+
+	Clock::time_point m_startTime;
+	double m_inputSeconds;
+	double m_lastPresentSeconds;
+	double m_nextDeadline;
+	// CPU seconds minus GPU seconds, measured now and then
+	double m_gpuToCpuSeconds;
+	int m_framesSinceCalibration;
+
+	std::deque<PENDING_FRAME> m_pendingFrames;
+	std::vector<GLuint> m_freeQueries;
+
+	// latest samples, used as rings once full
+	std::vector<double> m_latencies;
+	std::vector<double> m_intervals;
+	int m_nextLatency;
+	int m_nextInterval;
+
+	// seconds since the pacer was made
+	double Now() const;
+	// match the GPU clock to the CPU clock
+	void CalibrateClock();
+	// record the finished frames, waiting while too many are queued
+	void CollectFrames();
+	// sleep and spin until the next deadline of the limited mode
+	void WaitForDeadline();
+	// keep a sample in a ring of the latest ones
+	static void AddSample(std::vector<double>& samples, int& next, double value);
+};
@@ -0,0 +1,275 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustumculler.cpp
+// ============
+// test packed bounding boxes against the camera frustum
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrustumCuller.h"
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+#define FRUSTUMCULLER_SSE
+#include <xmmintrin.h>
+#endif
+
+/***********************************************************
+ *  FrustumCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrustumCuller::FrustumCuller()
+{
+	m_boxCount = 0;
+	for (int i = 0; i < 6; i++)
+	{
+		m_planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+/***********************************************************
+ *  ExtractPlanes()
+ *
+ *  This method is used for taking the clip planes out of a
+ *  view-projection matrix (Gribb and Hartmann).  A point p
+ *  is inside when dot(plane.xyz, p) + plane.w >= 0 for all
+ *  six planes.  The planes are normalized so the test also
+ *  gives distances.
+ ***********************************************************/
+void FrustumCuller::ExtractPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+	// glm is column major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+	{
+		rows[i] = glm::vec4(
+			viewProjection[0][i], viewProjection[1][i],
+			viewProjection[2][i], viewProjection[3][i]);
+	}
+
+	planes[0] = rows[3] + rows[0];	// left
+	planes[1] = rows[3] - rows[0];	// right
+	planes[2] = rows[3] + rows[1];	// bottom
+	planes[3] = rows[3] - rows[1];	// top
+	planes[4] = rows[3] + rows[2];	// near
+	planes[5] = rows[3] - rows[2];	// far
+
+	for (int i = 0; i < 6; i++)
+	{
+		float length = glm::length(glm::vec3(planes[i]));
+		if (length > 0.0f)
+		{
+			planes[i] /= length;
+		}
+	}
+}
+
+/***********************************************************
+ *  TransformBounds()
+ *
+ *  This method is used for fitting a world space box around
+ *  a local box, by moving its center and summing how far
+ *  each rotated and scaled half extent reaches along each
+ *  world axis.
+ ***********************************************************/
+void FrustumCuller::TransformBounds(
+	const glm::vec3& localMin,
+	const glm::vec3& localMax,
+	const glm::mat4& worldMatrix,
+	glm::vec3& center,
+	glm::vec3& extent)
+{
+	glm::vec3 localCenter = (localMin + localMax) * 0.5f;
+	glm::vec3 localExtent = (localMax - localMin) * 0.5f;
+
+	center = glm::vec3(worldMatrix * glm::vec4(localCenter, 1.0f));
+	extent =
+		glm::abs(glm::vec3(worldMatrix[0])) * localExtent.x +
+		glm::abs(glm::vec3(worldMatrix[1])) * localExtent.y +
+		glm::abs(glm::vec3(worldMatrix[2])) * localExtent.z;
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for setting the number of boxes.
+ ***********************************************************/
+void FrustumCuller::Resize(int boxCount)
+{
+	m_boxCount = (boxCount > 0) ? boxCount : 0;
+
+	size_t paddedCount = (static_cast<size_t>(m_boxCount) + 3) & ~static_cast<size_t>(3);
+	m_centerX.resize(paddedCount, 0.0f);
+	m_centerY.resize(paddedCount, 0.0f);
+	m_centerZ.resize(paddedCount, 0.0f);
+	m_extentX.resize(paddedCount, 0.0f);
+	m_extentY.resize(paddedCount, 0.0f);
+	m_extentZ.resize(paddedCount, 0.0f);
+}
+
+/***********************************************************
+ *  SetBox()
+ *
+ *  This method is used for storing one world space box.
+ ***********************************************************/
+void FrustumCuller::SetBox(int index, const glm::vec3& center, const glm::vec3& extent)
+{
+	if ((index < 0) || (index >= m_boxCount))
+	{
+		return;
+	}
+
+	m_centerX[index] = center.x;
+	m_centerY[index] = center.y;
+	m_centerZ[index] = center.z;
+	m_extentX[index] = extent.x;
+	m_extentY[index] = extent.y;
+	m_extentZ[index] = extent.z;
+}
+
+/***********************************************************
+ *  GetBox()
+ *
+ *  This method is used for reading back one stored box.
+ ***********************************************************/
+void FrustumCuller::GetBox(int index, glm::vec3& center, glm::vec3& extent) const
+{
+	if ((index < 0) || (index >= m_boxCount))
+	{
+		center = glm::vec3(0.0f);
+		extent = glm::vec3(0.0f);
+		return;
+	}
+
+	center = glm::vec3(m_centerX[index], m_centerY[index], m_centerZ[index]);
+	extent = glm::vec3(m_extentX[index], m_extentY[index], m_extentZ[index]);
+}
+
+/***********************************************************
+ *  SetFrustum()
+ *
+ *  This method is used for taking the planes of the camera
+ *  the next tests run against.
+ ***********************************************************/
+void FrustumCuller::SetFrustum(const glm::mat4& viewProjection)
+{
+	ExtractPlanes(viewProjection, m_planes);
+}
+
+/***********************************************************
+ *  CullScalar()
+ *
+ *  This method is used for testing the boxes one at a time.
+ ***********************************************************/
+int FrustumCuller::CullScalar(std::vector<unsigned char>& visible) const
+{
+	visible.resize(m_boxCount);
+	return(CullScalarRange(0, m_boxCount, visible));
+}
+
+/***********************************************************
+ *  CullScalarRange()
+ *
+ *  This method is used for testing a range of boxes one at
+ *  a time.  A box is outside when, for some plane, even its
+ *  corner furthest along the plane normal is behind the
+ *  plane.
+ ***********************************************************/
+int FrustumCuller::CullScalarRange(int first, int count, std::vector<unsigned char>& visible) const
+{
+	int visibleCount = 0;
+	const int end = ((first + count) < m_boxCount) ? (first + count) : m_boxCount;
+
+	for (int i = first; i < end; i++)
+	{
+		bool bInside = true;
+		for (int p = 0; (p < 6) && bInside; p++)
+		{
+			const glm::vec4& plane = m_planes[p];
+			float distance = plane.x * m_centerX[i] + plane.y * m_centerY[i] +
+				plane.z * m_centerZ[i] + plane.w;
+			float radius = fabsf(plane.x) * m_extentX[i] + fabsf(plane.y) * m_extentY[i] +
+				fabsf(plane.z) * m_extentZ[i];
+			bInside = (distance + radius >= 0.0f);
+		}
+
+		visible[i] = bInside ? 1 : 0;
+		visibleCount += visible[i];
+	}
+	return(visibleCount);
+}
+
+/***********************************************************
+ *  Cull()
+ *
+ *  This method is used for testing four boxes per step with
+ *  SSE, using the same test as CullScalar().
+ ***********************************************************/
+int FrustumCuller::Cull(std::vector<unsigned char>& visible) const
+{
+	visible.resize(m_boxCount);
+	return(CullRange(0, m_boxCount, visible));
+}
+
+/***********************************************************
+ *  CullRange()
+ *
+ *  This method is used for testing one range of boxes, four
+ *  per step where SSE is available.  The box arrays are
+ *  padded, so a range may end part way through a step.
+ ***********************************************************/
+int FrustumCuller::CullRange(int first, int count, std::vector<unsigned char>& visible) const
+{
+#ifdef FRUSTUMCULLER_SSE
+	int visibleCount = 0;
+	const int end = ((first + count) < m_boxCount) ? (first + count) : m_boxCount;
+
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	__m128 absX[6], absY[6], absZ[6];
+	for (int p = 0; p < 6; p++)
+	{
+		planeX[p] = _mm_set1_ps(m_planes[p].x);
+		planeY[p] = _mm_set1_ps(m_planes[p].y);
+		planeZ[p] = _mm_set1_ps(m_planes[p].z);
+		planeW[p] = _mm_set1_ps(m_planes[p].w);
+		absX[p] = _mm_set1_ps(fabsf(m_planes[p].x));
+		absY[p] = _mm_set1_ps(fabsf(m_planes[p].y));
+		absZ[p] = _mm_set1_ps(fabsf(m_planes[p].z));
+	}
+	const __m128 zero = _mm_setzero_ps();
+
+	for (int i = first; i < end; i += 4)
+	{
+		__m128 centerX = _mm_loadu_ps(&m_centerX[i]);
+		__m128 centerY = _mm_loadu_ps(&m_centerY[i]);
+		__m128 centerZ = _mm_loadu_ps(&m_centerZ[i]);
+		__m128 extentX = _mm_loadu_ps(&m_extentX[i]);
+		__m128 extentY = _mm_loadu_ps(&m_extentY[i]);
+		__m128 extentZ = _mm_loadu_ps(&m_extentZ[i]);
+
+		__m128 outside = _mm_setzero_ps();
+		for (int p = 0; p < 6; p++)
+		{
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(planeX[p], centerX), _mm_mul_ps(planeY[p], centerY)),
+				_mm_add_ps(_mm_mul_ps(planeZ[p], centerZ), planeW[p]));
+			__m128 radius = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(absX[p], extentX), _mm_mul_ps(absY[p], extentY)),
+				_mm_mul_ps(absZ[p], extentZ));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+		}
+
+		int outsideMask = _mm_movemask_ps(outside);
+		int stepCount = ((end - i) < 4) ? (end - i) : 4;
+		for (int j = 0; j < stepCount; j++)
+		{
+			visible[i + j] = ((outsideMask >> j) & 1) ? 0 : 1;
+			visibleCount += visible[i + j];
+		}
+	}
+	return(visibleCount);
+#else
+	return(CullScalarRange(first, count, visible));
+#endif
+}
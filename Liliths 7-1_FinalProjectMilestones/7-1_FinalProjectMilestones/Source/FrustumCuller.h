@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustumculler.h
+// ============
+// test packed bounding boxes against the camera frustum
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  FrustumCuller
+ *
+ *  This class keeps world space bounding boxes as centers
+ *  and half extents in separate packed arrays, and tests
+ *  them against the six planes of a view-projection matrix.
+ *  Where SSE is available four boxes are tested per step,
+ *  otherwise one at a time with the same math.  The planes
+ *  come from the combined matrix, so perspective and
+ *  orthographic projections are handled alike.
+ ***********************************************************/
+class FrustumCuller
+{
+public:
+	// constructor
+	FrustumCuller();
+
+	// planes of the passed in matrix, normals pointing inside
+	static void ExtractPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+	// world box around a local box moved by the passed in matrix
+	static void TransformBounds(
+		const glm::vec3& localMin,
+		const glm::vec3& localMax,
+		const glm::mat4& worldMatrix,
+		glm::vec3& center,
+		glm::vec3& extent);
+
+	// set the number of boxes, keeping the ones already set
+	void Resize(int boxCount);
+	void SetBox(int index, const glm::vec3& center, const glm::vec3& extent);
+	void GetBox(int index, glm::vec3& center, glm::vec3& extent) const;
+	int GetBoxCount() const { return m_boxCount; }
+
+	// take the planes of the current camera
+	void SetFrustum(const glm::mat4& viewProjection);
+
+	// flag every box touching the frustum, returns how many do
+	int Cull(std::vector<unsigned char>& visible) const;
+	// same test one box at a time
+	int CullScalar(std::vector<unsigned char>& visible) const;
+	// flag the boxes of one range, first a multiple of four, into
+	// flags already sized to the box count, so ranges can be
+	// tested on different threads
+	int CullRange(int first, int count, std::vector<unsigned char>& visible) const;
+
+private:
+	// the scalar test over one range
+	int CullScalarRange(int first, int count, std::vector<unsigned char>& visible) const;
+
+	glm::vec4 m_planes[6];
+	int m_boxCount;
+	// padded to a multiple of four boxes
+	std::vector<float> m_centerX;
+	std::vector<float> m_centerY;
+	std::vector<float> m_centerZ;
+	std::vector<float> m_extentX;
+	std::vector<float> m_extentY;
+	std::vector<float> m_extentZ;
+};
@@ -0,0 +1,380 @@
+///////////////////////////////////////////////////////////////////////////////
+// glstatecache.cpp
+// ============
+// shadow copy of the OpenGL state that drops redundant calls
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GLStateCache.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstring>
+
+/***********************************************************
+ *  GLStateCache()
+ *
+ *  The constructor for the class.  Nothing is known about
+ *  OpenGL yet, so the first call of every kind is forwarded.
+ ***********************************************************/
+GLStateCache::GLStateCache()
+{
+	m_capabilities[0] = GL_DEPTH_TEST;
+	m_capabilities[1] = GL_BLEND;
+	m_capabilities[2] = GL_CULL_FACE;
+	m_capabilities[3] = GL_SCISSOR_TEST;
+
+	ResetCounters(m_current);
+	ResetCounters(m_lastFrame);
+	Invalidate();
+}
+
+/***********************************************************
+ *  ResetCounters()
+ *
+ *  This method is used for zeroing a set of counters.
+ ***********************************************************/
+void GLStateCache::ResetCounters(FRAME_COUNTERS& counters)
+{
+	counters.uniformsSent = 0;
+	counters.uniformsElided = 0;
+	counters.bindsSent = 0;
+	counters.bindsElided = 0;
+	counters.stateSent = 0;
+	counters.stateElided = 0;
+	counters.drawCalls = 0;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for closing the counters of the last
+ *  frame and starting new ones.
+ ***********************************************************/
+void GLStateCache::BeginFrame()
+{
+	m_lastFrame = m_current;
+	ResetCounters(m_current);
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for forgetting all the tracked state,
+ *  for example after a shader was loaded with its own calls.
+ ***********************************************************/
+void GLStateCache::Invalidate()
+{
+	m_program = 0;
+	m_bProgramValid = false;
+	m_programUniforms.clear();
+	m_pUniforms = NULL;
+
+	m_activeUnit = -1;
+	for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		m_textureTargets[i] = 0;
+		m_textures[i] = 0;
+	}
+	for (int i = 0; i < MAX_CAPABILITIES; i++)
+	{
+		m_capabilityStates[i] = -1;
+	}
+
+	m_depthMask = -1;
+	m_blendSource = 0;
+	m_blendDestination = 0;
+	m_bBlendFuncValid = false;
+	m_bClearColorValid = false;
+}
+
+/***********************************************************
+ *  NameHash / NameEqual
+ *
+ *  FNV-1a hash and comparison of uniform names, so the same
+ *  name from different string literals shares one entry.
+ ***********************************************************/
+size_t GLStateCache::NameHash::operator()(const char* name) const
+{
+	size_t hash = 2166136261u;
+	while (*name != '\0')
+	{
+		hash ^= static_cast<unsigned char>(*name++);
+		hash *= 16777619u;
+	}
+	return(hash);
+}
+
+bool GLStateCache::NameEqual::operator()(const char* a, const char* b) const
+{
+	return((a == b) || (strcmp(a, b) == 0));
+}
+
+/***********************************************************
+ *  UseProgram()
+ *
+ *  This method is used for making a program current.
+ ***********************************************************/
+void GLStateCache::UseProgram(GLuint program)
+{
+	if (m_bProgramValid && (m_program == program))
+	{
+		m_current.bindsElided++;
+		return;
+	}
+
+	glUseProgram(program);
+	m_program = program;
+	m_bProgramValid = true;
+	m_pUniforms = &m_programUniforms[program];
+	m_current.bindsSent++;
+}
+
+/***********************************************************
+ *  UpdateUniform()
+ *
+ *  This method is used for comparing a uniform value with the
+ *  last value sent to the current program.  The location is
+ *  looked up the first time a name is seen in a program.
+ ***********************************************************/
+GLStateCache::UNIFORM_ENTRY* GLStateCache::UpdateUniform(
+	const char* name, const void* pValue, int size)
+{
+	// uniforms go to whatever program OpenGL has current
+	if (NULL == m_pUniforms)
+	{
+		GLint current = 0;
+		glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+		m_program = static_cast<GLuint>(current);
+		m_bProgramValid = true;
+		m_pUniforms = &m_programUniforms[m_program];
+	}
+
+	UNIFORM_MAP::iterator found = m_pUniforms->find(name);
+	if (found == m_pUniforms->end())
+	{
+		UNIFORM_ENTRY entry;
+		entry.location = glGetUniformLocation(m_program, name);
+		entry.size = 0;
+		entry.bValid = false;
+		found = m_pUniforms->insert(std::make_pair(name, entry)).first;
+	}
+
+	UNIFORM_ENTRY& entry = found->second;
+	if ((entry.location < 0) ||
+		(entry.bValid && (entry.size == size) && (memcmp(entry.value, pValue, size) == 0)))
+	{
+		m_current.uniformsElided++;
+		return(NULL);
+	}
+
+	memcpy(entry.value, pValue, size);
+	entry.size = size;
+	entry.bValid = true;
+	m_current.uniformsSent++;
+	return(&entry);
+}
+
+/***********************************************************
+ *  SetInt() ... SetMat4()
+ *
+ *  These methods are used for setting a uniform of the
+ *  current program when its value changed.
+ ***********************************************************/
+void GLStateCache::SetInt(const char* name, int value)
+{
+	UNIFORM_ENTRY* pEntry = UpdateUniform(name, &value, sizeof(value));
+	if (NULL != pEntry)
+	{
+		glUniform1i(pEntry->location, value);
+	}
+}
+
+void GLStateCache::SetFloat(const char* name, float value)
+{
+	UNIFORM_ENTRY* pEntry = UpdateUniform(name, &value, sizeof(value));
+	if (NULL != pEntry)
+	{
+		glUniform1f(pEntry->location, value);
+	}
+}
+
+void GLStateCache::SetVec2(const char* name, const glm::vec2& value)
+{
+	UNIFORM_ENTRY* pEntry = UpdateUniform(name, glm::value_ptr(value), sizeof(value));
+	if (NULL != pEntry)
+	{
+		glUniform2fv(pEntry->location, 1, glm::value_ptr(value));
+	}
+}
+
+void GLStateCache::SetVec3(const char* name, const glm::vec3& value)
+{
+	UNIFORM_ENTRY* pEntry = UpdateUniform(name, glm::value_ptr(value), sizeof(value));
+	if (NULL != pEntry)
+	{
+		glUniform3fv(pEntry->location, 1, glm::value_ptr(value));
+	}
+}
+
+void GLStateCache::SetVec4(const char* name, const glm::vec4& value)
+{
+	UNIFORM_ENTRY* pEntry = UpdateUniform(name, glm::value_ptr(value), sizeof(value));
+	if (NULL != pEntry)
+	{
+		glUniform4fv(pEntry->location, 1, glm::value_ptr(value));
+	}
+}
+
+void GLStateCache::SetMat4(const char* name, const glm::mat4& value)
+{
+	UNIFORM_ENTRY* pEntry = UpdateUniform(name, glm::value_ptr(value), sizeof(value));
+	if (NULL != pEntry)
+	{
+		glUniformMatrix4fv(pEntry->location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
+
+/***********************************************************
+ *  BindTexture()
+ *
+ *  This method is used for binding a texture to a texture
+ *  unit, switching the active unit only when needed.
+ ***********************************************************/
+void GLStateCache::BindTexture(int unit, GLenum target, GLuint texture)
+{
+	bool bTracked = (unit >= 0) && (unit < MAX_TEXTURE_UNITS);
+
+	if (bTracked && (m_textureTargets[unit] == target) && (m_textures[unit] == texture))
+	{
+		m_current.bindsElided++;
+		return;
+	}
+
+	if (m_activeUnit != unit)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		m_activeUnit = unit;
+		m_current.stateSent++;
+	}
+	glBindTexture(target, texture);
+	m_current.bindsSent++;
+
+	if (bTracked)
+	{
+		m_textureTargets[unit] = target;
+		m_textures[unit] = texture;
+	}
+}
+
+/***********************************************************
+ *  SetCapability()
+ *
+ *  This method is used for enabling or disabling one of the
+ *  tracked capabilities.  Others are always forwarded.
+ ***********************************************************/
+void GLStateCache::SetCapability(GLenum capability, bool bEnable)
+{
+	int index = -1;
+	for (int i = 0; i < MAX_CAPABILITIES; i++)
+	{
+		if (m_capabilities[i] == capability)
+		{
+			index = i;
+			break;
+		}
+	}
+
+	int state = bEnable ? 1 : 0;
+	if ((index >= 0) && (m_capabilityStates[index] == state))
+	{
+		m_current.stateElided++;
+		return;
+	}
+
+	if (bEnable)
+	{
+		glEnable(capability);
+	}
+	else
+	{
+		glDisable(capability);
+	}
+	m_current.stateSent++;
+
+	if (index >= 0)
+	{
+		m_capabilityStates[index] = state;
+	}
+}
+
+void GLStateCache::Enable(GLenum capability)
+{
+	SetCapability(capability, true);
+}
+
+void GLStateCache::Disable(GLenum capability)
+{
+	SetCapability(capability, false);
+}
+
+/***********************************************************
+ *  DepthMask()
+ *
+ *  This method is used for turning depth writes on and off.
+ ***********************************************************/
+void GLStateCache::DepthMask(GLboolean bWrite)
+{
+	int state = (bWrite == GL_TRUE) ? 1 : 0;
+	if (m_depthMask == state)
+	{
+		m_current.stateElided++;
+		return;
+	}
+
+	glDepthMask(bWrite);
+	m_depthMask = state;
+	m_current.stateSent++;
+}
+
+/***********************************************************
+ *  BlendFunc()
+ *
+ *  This method is used for setting the blend factors.
+ ***********************************************************/
+void GLStateCache::BlendFunc(GLenum sourceFactor, GLenum destinationFactor)
+{
+	if (m_bBlendFuncValid &&
+		(m_blendSource == sourceFactor) &&
+		(m_blendDestination == destinationFactor))
+	{
+		m_current.stateElided++;
+		return;
+	}
+
+	glBlendFunc(sourceFactor, destinationFactor);
+	m_blendSource = sourceFactor;
+	m_blendDestination = destinationFactor;
+	m_bBlendFuncValid = true;
+	m_current.stateSent++;
+}
+
+/***********************************************************
+ *  ClearColor()
+ *
+ *  This method is used for setting the color used by
+ *  glClear for the color buffer.
+ ***********************************************************/
+void GLStateCache::ClearColor(const glm::vec4& color)
+{
+	if (m_bClearColorValid && (m_clearColor == color))
+	{
+		m_current.stateElided++;
+		return;
+	}
+
+	glClearColor(color.r, color.g, color.b, color.a);
+	m_clearColor = color;
+	m_bClearColorValid = true;
+	m_current.stateSent++;
+}
@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////////////
+// glstatecache.h
+// ============
+// shadow copy of the OpenGL state that drops redundant calls
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <unordered_map>
+
+/***********************************************************
+ *  GLStateCache
+ *
+ *  This class sits between the scene/view managers and
+ *  OpenGL.  It remembers the current program, the uniform
+ *  values of each program, the bound textures, the depth
+ *  mask, the blend state and the clear color, and only
+ *  forwards a call when it changes something.  Uniform
+ *  locations are looked up once per program and name.
+ *
+ *  Uniform names are kept by pointer, so they must be string
+ *  literals or other strings that outlive the cache.
+ ***********************************************************/
+class GLStateCache
+{
+public:
+	// constructor
+	GLStateCache();
+
+	// calls forwarded to OpenGL and calls dropped, per frame
+	struct FRAME_COUNTERS
+	{
+		int uniformsSent;
+		int uniformsElided;
+		int bindsSent;
+		int bindsElided;
+		int stateSent;
+		int stateElided;
+		// draw calls reported by the renderers through CountDrawCalls()
+		int drawCalls;
+
+		int TotalSent() const { return uniformsSent + bindsSent + stateSent; }
+		int TotalElided() const { return uniformsElided + bindsElided + stateElided; }
+	};
+
+	// start counting a new frame
+	void BeginFrame();
+	// counters of the last finished frame and of the frame in progress
+	const FRAME_COUNTERS& GetLastFrameCounters() const { return m_lastFrame; }
+	const FRAME_COUNTERS& GetCurrentCounters() const { return m_current; }
+
+	// count draw calls issued directly, they are never elided
+	void CountDrawCalls(int count) { m_current.drawCalls += count; }
+
+	// forget everything after OpenGL was changed behind the cache
+	void Invalidate();
+
+	// programs
+	void UseProgram(GLuint program);
+	GLuint GetProgram() const { return m_program; }
+
+	// uniforms of the current program
+	void SetInt(const char* name, int value);
+	void SetFloat(const char* name, float value);
+	void SetVec2(const char* name, const glm::vec2& value);
+	void SetVec3(const char* name, const glm::vec3& value);
+	void SetVec4(const char* name, const glm::vec4& value);
+	void SetMat4(const char* name, const glm::mat4& value);
+
+	// textures
+	void BindTexture(int unit, GLenum target, GLuint texture);
+
+	// fixed function state
+	void Enable(GLenum capability);
+	void Disable(GLenum capability);
+	void DepthMask(GLboolean bWrite);
+	void BlendFunc(GLenum sourceFactor, GLenum destinationFactor);
+	void ClearColor(const glm::vec4& color);
+
+private:
+	// largest uniform value tracked, a mat4
+	static const int MAX_UNIFORM_BYTES = sizeof(glm::mat4);
+	// texture units tracked
+	static const int MAX_TEXTURE_UNITS = 32;
+	// capabilities tracked by Enable and Disable
+	static const int MAX_CAPABILITIES = 4;
+
+	struct UNIFORM_ENTRY
+	{
+		GLint location;
+		int size;
+		bool bValid;
+		unsigned char value[MAX_UNIFORM_BYTES];
+	};
+
+	// hash and compare uniform names by their characters
+	struct NameHash
+	{
+		size_t operator()(const char* name) const;
+	};
+	struct NameEqual
+	{
+		bool operator()(const char* a, const char* b) const;
+	};
+	typedef std::unordered_map<const char*, UNIFORM_ENTRY, NameHash, NameEqual> UNIFORM_MAP;
+
+	FRAME_COUNTERS m_current;
+	FRAME_COUNTERS m_lastFrame;
+
+	GLuint m_program;
+	bool m_bProgramValid;
+	// uniforms of every program used so far
+	std::unordered_map<GLuint, UNIFORM_MAP> m_programUniforms;
+	UNIFORM_MAP* m_pUniforms;
+
+	int m_activeUnit;
+	GLenum m_textureTargets[MAX_TEXTURE_UNITS];
+	GLuint m_textures[MAX_TEXTURE_UNITS];
+
+	GLenum m_capabilities[MAX_CAPABILITIES];
+	// 0 = disabled, 1 = enabled, -1 = unknown
+	int m_capabilityStates[MAX_CAPABILITIES];
+
+	int m_depthMask;
+	GLenum m_blendSource;
+	GLenum m_blendDestination;
+	bool m_bBlendFuncValid;
+	glm::vec4 m_clearColor;
+	bool m_bClearColorValid;
+
+	// find the cache entry of a uniform and copy in the new value,
+	// returns NULL when the value is unchanged or has no location
+	UNIFORM_ENTRY* UpdateUniform(const char* name, const void* pValue, int size);
+	// set a capability, true when the call was forwarded
+	void SetCapability(GLenum capability, bool bEnable);
+	static void ResetCounters(FRAME_COUNTERS& counters);
+};
@@ -0,0 +1,292 @@
+///////////////////////////////////////////////////////////////////////////////
+// indirectrenderer.cpp
+// ============
+// draw the whole scene with multi-draw indirect commands
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "IndirectRenderer.h"
+#include "MeshOptimizer.h"
+#include "UniformBlocks.h"
+
+// declaration of global variables
+namespace
+{
+	const char* g_UseTextureArrayName = "bUseTextureArray";
+	const char* g_PositionMinName = "positionMin";
+	const char* g_PositionExtentName = "positionExtent";
+}
+
+/***********************************************************
+ *  IndirectRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+IndirectRenderer::IndirectRenderer()
+{
+	for (int i = 0; i < PrimitiveMeshes::PRIMITIVE_COUNT; i++)
+	{
+		for (int level = 0; level < PrimitiveMeshes::LOD_LEVEL_COUNT; level++)
+		{
+			DRAW_COMMAND empty = { 0, 0, 0, 0, 0 };
+			m_primitiveRanges[i][level] = empty;
+		}
+	}
+	m_positionMin = glm::vec3(0.0f);
+	m_positionExtent = glm::vec3(1.0f);
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_commandBuffer = 0;
+	m_objectBuffer = 0;
+	m_commandCapacity = 0;
+	m_objectCapacity = 0;
+	m_objectCount = 0;
+	m_opaqueCommandCount = 0;
+	m_textureUnit = -1;
+	m_textureTarget = GL_TEXTURE_2D_ARRAY;
+	m_textureID = 0;
+}
+
+/***********************************************************
+ *  ~IndirectRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+IndirectRenderer::~IndirectRenderer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for copying the geometry of every
+ *  level of every primitive back to back into one vertex and
+ *  index buffer, so that all the commands can be drawn from
+ *  one vertex array object, and for creating the empty
+ *  command and object buffers.  Packed vertices share one
+ *  box, the box around every primitive.
+ ***********************************************************/
+void IndirectRenderer::Initialize(const PrimitiveMeshes* pMeshes)
+{
+	PrimitiveMeshes::MESH_GEOMETRY merged;
+	std::vector<PrimitiveMeshes::MESH_VERTEX>& vertices = merged.vertices;
+	std::vector<GLuint>& indices = merged.indices;
+
+	for (int i = 0; i < PrimitiveMeshes::PRIMITIVE_COUNT; i++)
+	{
+		for (int level = 0; level < PrimitiveMeshes::GetLevelCount(i); level++)
+		{
+			const PrimitiveMeshes::MESH_GEOMETRY& geometry = pMeshes->GetGeometry(i, level);
+			DRAW_COMMAND& range = m_primitiveRanges[i][level];
+
+			// indices stay relative to the primitive, the base vertex offsets them
+			range.count = static_cast<GLuint>(geometry.indices.size());
+			range.firstIndex = static_cast<GLuint>(indices.size());
+			range.baseVertex = static_cast<GLint>(vertices.size());
+
+			vertices.insert(vertices.end(), geometry.vertices.begin(), geometry.vertices.end());
+			indices.insert(indices.end(), geometry.indices.begin(), geometry.indices.end());
+		}
+	}
+
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+
+	glGenBuffers(1, &m_vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	if (PrimitiveMeshes::VERTEX_FORMAT_PACKED == pMeshes->GetVertexFormat())
+	{
+		glm::vec3 boundsMax;
+		std::vector<PrimitiveMeshes::PACKED_VERTEX> packed;
+		MeshOptimizer::GetBounds(merged, m_positionMin, boundsMax);
+		MeshOptimizer::PackVertices(merged, m_positionMin, boundsMax, packed);
+		m_positionExtent = boundsMax - m_positionMin;
+		glBufferData(GL_ARRAY_BUFFER,
+			packed.size() * sizeof(PrimitiveMeshes::PACKED_VERTEX),
+			packed.data(),
+			GL_STATIC_DRAW);
+	}
+	else
+	{
+		m_positionMin = glm::vec3(0.0f);
+		m_positionExtent = glm::vec3(1.0f);
+		glBufferData(GL_ARRAY_BUFFER,
+			vertices.size() * sizeof(PrimitiveMeshes::MESH_VERTEX),
+			vertices.data(),
+			GL_STATIC_DRAW);
+	}
+
+	glGenBuffers(1, &m_indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+		indices.size() * sizeof(GLuint),
+		indices.data(),
+		GL_STATIC_DRAW);
+
+	// same attribute locations as the primitive meshes
+	PrimitiveMeshes::SetVertexAttributes(pMeshes->GetVertexFormat());
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glGenBuffers(1, &m_commandBuffer);
+	glGenBuffers(1, &m_objectBuffer);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the buffers.
+ ***********************************************************/
+void IndirectRenderer::Destroy()
+{
+	if (0 != m_vao)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		glDeleteBuffers(1, &m_vertexBuffer);
+		glDeleteBuffers(1, &m_indexBuffer);
+		glDeleteBuffers(1, &m_commandBuffer);
+		glDeleteBuffers(1, &m_objectBuffer);
+	}
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_commandBuffer = 0;
+	m_objectBuffer = 0;
+	m_commandCapacity = 0;
+	m_objectCapacity = 0;
+	m_objectCount = 0;
+	m_commands.clear();
+	m_opaqueCommandCount = 0;
+}
+
+/***********************************************************
+ *  SetDraws()
+ *
+ *  This method is used for turning the batches into draw
+ *  commands and uploading them with the object data.  The
+ *  objects of a batch are consecutive, so the base instance
+ *  of its command is the index of its first object.  Both
+ *  buffers only grow; smaller uploads reuse the storage.
+ ***********************************************************/
+void IndirectRenderer::SetDraws(
+	const std::vector<InstancedRenderer::INSTANCE_DATA>& objects,
+	const std::vector<InstancedRenderer::INSTANCE_BATCH>& batches)
+{
+	m_commands.clear();
+	m_opaqueCommandCount = 0;
+	m_textureUnit = -1;
+	m_textureID = 0;
+
+	for (const InstancedRenderer::INSTANCE_BATCH& batch : batches)
+	{
+		if (batch.instanceCount <= 0)
+		{
+			continue;
+		}
+
+		DRAW_COMMAND command = m_primitiveRanges[batch.primitive][batch.level];
+		command.instanceCount = static_cast<GLuint>(batch.instanceCount);
+		command.baseInstance = static_cast<GLuint>(batch.firstInstance);
+		m_commands.push_back(command);
+
+		if (batch.depthWrite)
+		{
+			m_opaqueCommandCount++;
+		}
+		if ((batch.textureUnit >= 0) && (0 == m_textureID))
+		{
+			m_textureUnit = batch.textureUnit;
+			m_textureTarget = batch.textureTarget;
+			m_textureID = batch.textureID;
+		}
+	}
+
+	int commandCount = static_cast<int>(m_commands.size());
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	if (commandCount > m_commandCapacity)
+	{
+		m_commandCapacity = commandCount;
+		glBufferData(GL_DRAW_INDIRECT_BUFFER,
+			m_commandCapacity * sizeof(DRAW_COMMAND),
+			m_commands.data(),
+			GL_DYNAMIC_DRAW);
+	}
+	else if (commandCount > 0)
+	{
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
+			commandCount * sizeof(DRAW_COMMAND),
+			m_commands.data());
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	m_objectCount = static_cast<int>(objects.size());
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectBuffer);
+	if (m_objectCount > m_objectCapacity)
+	{
+		m_objectCapacity = m_objectCount;
+		glBufferData(GL_SHADER_STORAGE_BUFFER,
+			m_objectCapacity * sizeof(InstancedRenderer::INSTANCE_DATA),
+			objects.data(),
+			GL_DYNAMIC_DRAW);
+	}
+	else if (m_objectCount > 0)
+	{
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
+			m_objectCount * sizeof(InstancedRenderer::INSTANCE_DATA),
+			objects.data());
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used for drawing every command, the opaque
+ *  ones with one call and the overlays without depth writes
+ *  with another.
+ ***********************************************************/
+void IndirectRenderer::Draw(GLStateCache* pStateCache)
+{
+	if ((NULL == pStateCache) || m_commands.empty())
+	{
+		return;
+	}
+
+	if (m_textureUnit >= 0)
+	{
+		pStateCache->BindTexture(m_textureUnit, m_textureTarget, m_textureID);
+		pStateCache->SetInt(g_UseTextureArrayName, GL_TEXTURE_2D_ARRAY == m_textureTarget);
+	}
+
+	pStateCache->SetVec3(g_PositionMinName, m_positionMin);
+	pStateCache->SetVec3(g_PositionExtentName, m_positionExtent);
+
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BUFFER_BINDING, m_objectBuffer);
+
+	pStateCache->DepthMask(GL_TRUE);
+	if (m_opaqueCommandCount > 0)
+	{
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+			NULL, m_opaqueCommandCount, 0);
+		pStateCache->CountDrawCalls(1);
+	}
+
+	int overlayCommandCount = static_cast<int>(m_commands.size()) - m_opaqueCommandCount;
+	if (overlayCommandCount > 0)
+	{
+		pStateCache->DepthMask(GL_FALSE);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+			reinterpret_cast<void*>(m_opaqueCommandCount * sizeof(DRAW_COMMAND)),
+			overlayCommandCount, 0);
+		pStateCache->CountDrawCalls(1);
+		pStateCache->DepthMask(GL_TRUE);
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
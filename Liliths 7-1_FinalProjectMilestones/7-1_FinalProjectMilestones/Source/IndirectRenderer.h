@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////
+// indirectrenderer.h
+// ============
+// draw the whole scene with multi-draw indirect commands
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "InstancedRenderer.h"
+
+#include <vector>
+
+/***********************************************************
+ *  IndirectRenderer
+ *
+ *  This class keeps every primitive in one shared vertex and
+ *  index buffer, the data of every object in a storage
+ *  buffer, and one indirect draw command per batch of the
+ *  instanced path in a draw indirect buffer.  The scene is
+ *  then drawn with one glMultiDrawElementsIndirect call for
+ *  the opaque batches and one for the overlays, and the
+ *  shader finds its object from the base instance of the
+ *  command.  The buffers are only rewritten by SetDraws().
+ *
+ *  All the batches share one texture binding, so textured
+ *  batches must use the texture array.
+ ***********************************************************/
+class IndirectRenderer
+{
+public:
+	// constructor
+	IndirectRenderer();
+	// destructor
+	~IndirectRenderer();
+
+	// layout of one command in the draw indirect buffer
+	struct DRAW_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// merge the primitive meshes and create the buffers
+	void Initialize(const PrimitiveMeshes* pMeshes);
+	// free the buffers
+	void Destroy();
+
+	// rewrite the objects and commands, batches as built for
+	// the instanced path with the opaque ones first
+	void SetDraws(
+		const std::vector<InstancedRenderer::INSTANCE_DATA>& objects,
+		const std::vector<InstancedRenderer::INSTANCE_BATCH>& batches);
+
+	// issue the commands with the program that is current
+	void Draw(GLStateCache* pStateCache);
+
+	int GetCommandCount() const { return static_cast<int>(m_commands.size()); }
+	int GetObjectCount() const { return m_objectCount; }
+
+private:
+	// where each level of each primitive sits in the shared buffers
+	DRAW_COMMAND m_primitiveRanges[PrimitiveMeshes::PRIMITIVE_COUNT][PrimitiveMeshes::LOD_LEVEL_COUNT];
+
+	// box the packed positions of every primitive are decoded into
+	glm::vec3 m_positionMin;
+	glm::vec3 m_positionExtent;
+
+	GLuint m_vao;
+	GLuint m_vertexBuffer;
+	GLuint m_indexBuffer;
+	GLuint m_commandBuffer;
+	GLuint m_objectBuffer;
+	// capacities of the command and object buffers, in entries
+	int m_commandCapacity;
+	int m_objectCapacity;
+	int m_objectCount;
+
+	std::vector<DRAW_COMMAND> m_commands;
+	// commands that write depth come first
+	int m_opaqueCommandCount;
+	// texture shared by the textured commands
+	int m_textureUnit;
+	GLenum m_textureTarget;
+	GLuint m_textureID;
+};
@@ -0,0 +1,207 @@
+///////////////////////////////////////////////////////////////////////////////
+// instancedrenderer.cpp
+// ============
+// draw groups of primitives with one instanced draw call per group
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "InstancedRenderer.h"
+
+#include <cstddef>
+
+// declaration of global variables
+namespace
+{
+	// first attribute location used by the instance data
+	const GLuint g_InstanceModelLocation = 3;
+	const GLuint g_InstanceColorLocation = 7;
+	const GLuint g_InstanceParamsLocation = 8;
+
+	const char* g_TextureValueName = "objectTexture";
+	const char* g_UseTextureArrayName = "bUseTextureArray";
+	// box the packed positions of the mesh are decoded into
+	const char* g_PositionMinName = "positionMin";
+	const char* g_PositionExtentName = "positionExtent";
+}
+
+/***********************************************************
+ *  InstancedRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+InstancedRenderer::InstancedRenderer()
+{
+	m_pMeshes = NULL;
+	m_instanceBuffer = 0;
+	m_instanceCapacity = 0;
+	m_instanceCount = 0;
+}
+
+/***********************************************************
+ *  ~InstancedRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+InstancedRenderer::~InstancedRenderer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the instance buffer and
+ *  enabling the per-instance attributes on the vertex array
+ *  object of every level of every primitive mesh.
+ ***********************************************************/
+void InstancedRenderer::Initialize(const PrimitiveMeshes* pMeshes)
+{
+	m_pMeshes = pMeshes;
+
+	glGenBuffers(1, &m_instanceBuffer);
+
+	for (int i = 0; i < PrimitiveMeshes::PRIMITIVE_COUNT; i++)
+	{
+		for (int level = 0; level < PrimitiveMeshes::GetLevelCount(i); level++)
+		{
+			glBindVertexArray(m_pMeshes->GetMesh(i, level).vao);
+			glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+
+			// a mat4 attribute takes four consecutive vec4 locations
+			for (GLuint column = 0; column < 4; column++)
+			{
+				glEnableVertexAttribArray(g_InstanceModelLocation + column);
+				glVertexAttribDivisor(g_InstanceModelLocation + column, 1);
+			}
+			glEnableVertexAttribArray(g_InstanceColorLocation);
+			glVertexAttribDivisor(g_InstanceColorLocation, 1);
+			glEnableVertexAttribArray(g_InstanceParamsLocation);
+			glVertexAttribDivisor(g_InstanceParamsLocation, 1);
+
+			SetInstanceOffset(0);
+		}
+	}
+
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the instance buffer.
+ ***********************************************************/
+void InstancedRenderer::Destroy()
+{
+	if (0 != m_instanceBuffer)
+	{
+		glDeleteBuffers(1, &m_instanceBuffer);
+		m_instanceBuffer = 0;
+	}
+	m_instanceCapacity = 0;
+	m_instanceCount = 0;
+	m_batches.clear();
+}
+
+/***********************************************************
+ *  SetInstances()
+ *
+ *  This method is used for uploading the instance data.  The
+ *  buffer only grows; a smaller upload reuses the storage.
+ ***********************************************************/
+void InstancedRenderer::SetInstances(
+	const std::vector<INSTANCE_DATA>& instances,
+	const std::vector<INSTANCE_BATCH>& batches)
+{
+	m_batches = batches;
+	m_instanceCount = static_cast<int>(instances.size());
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	if (m_instanceCount > m_instanceCapacity)
+	{
+		m_instanceCapacity = m_instanceCount;
+		glBufferData(GL_ARRAY_BUFFER,
+			m_instanceCapacity * sizeof(INSTANCE_DATA),
+			instances.data(),
+			GL_DYNAMIC_DRAW);
+	}
+	else if (m_instanceCount > 0)
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, 0,
+			m_instanceCount * sizeof(INSTANCE_DATA),
+			instances.data());
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  SetInstanceOffset()
+ *
+ *  This method is used for pointing the instance attributes
+ *  of the bound vertex array object at the first instance of
+ *  a batch.  This works without base-instance draw support.
+ ***********************************************************/
+void InstancedRenderer::SetInstanceOffset(GLint firstInstance)
+{
+	const GLsizei stride = sizeof(INSTANCE_DATA);
+	const size_t base = static_cast<size_t>(firstInstance) * sizeof(INSTANCE_DATA);
+
+	for (GLuint column = 0; column < 4; column++)
+	{
+		glVertexAttribPointer(g_InstanceModelLocation + column, 4, GL_FLOAT, GL_FALSE, stride,
+			reinterpret_cast<void*>(base + offsetof(INSTANCE_DATA, modelMatrix) + column * sizeof(glm::vec4)));
+	}
+	glVertexAttribPointer(g_InstanceColorLocation, 4, GL_FLOAT, GL_FALSE, stride,
+		reinterpret_cast<void*>(base + offsetof(INSTANCE_DATA, color)));
+	glVertexAttribPointer(g_InstanceParamsLocation, 4, GL_FLOAT, GL_FALSE, stride,
+		reinterpret_cast<void*>(base + offsetof(INSTANCE_DATA, params)));
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used for drawing every batch in order with
+ *  one instanced draw call each.
+ ***********************************************************/
+void InstancedRenderer::Draw(GLStateCache* pStateCache)
+{
+	if ((NULL == m_pMeshes) || (NULL == pStateCache))
+	{
+		return;
+	}
+
+	for (const INSTANCE_BATCH& batch : m_batches)
+	{
+		const PrimitiveMeshes::GPU_MESH& mesh = m_pMeshes->GetMesh(batch.primitive, batch.level);
+
+		if (batch.textureUnit >= 0)
+		{
+			pStateCache->BindTexture(batch.textureUnit, batch.textureTarget, batch.textureID);
+			if (GL_TEXTURE_2D_ARRAY == batch.textureTarget)
+			{
+				// the array sampler keeps its own unit
+				pStateCache->SetInt(g_UseTextureArrayName, true);
+			}
+			else
+			{
+				pStateCache->SetInt(g_UseTextureArrayName, false);
+				pStateCache->SetInt(g_TextureValueName, batch.textureUnit);
+			}
+		}
+
+		pStateCache->SetVec3(g_PositionMinName, mesh.positionMin);
+		pStateCache->SetVec3(g_PositionExtentName, mesh.positionExtent);
+
+		glBindVertexArray(mesh.vao);
+		glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+		SetInstanceOffset(batch.firstInstance);
+
+		pStateCache->DepthMask(batch.depthWrite ? GL_TRUE : GL_FALSE);
+		glDrawElementsInstanced(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT,
+			NULL, batch.instanceCount);
+		pStateCache->CountDrawCalls(1);
+	}
+
+	pStateCache->DepthMask(GL_TRUE);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
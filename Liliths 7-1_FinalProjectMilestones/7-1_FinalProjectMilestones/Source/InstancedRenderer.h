@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+// instancedrenderer.h
+// ============
+// draw groups of primitives with one instanced draw call per group
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PrimitiveMeshes.h"
+#include "GLStateCache.h"
+
+#include <vector>
+
+/***********************************************************
+ *  InstancedRenderer
+ *
+ *  This class keeps one instance buffer holding the model
+ *  matrix, color, UV scale and texture of every object, and
+ *  draws each batch of objects that share a primitive and
+ *  texture with a single instanced draw call.
+ ***********************************************************/
+class InstancedRenderer
+{
+public:
+	// constructor
+	InstancedRenderer();
+	// destructor
+	~InstancedRenderer();
+
+	// per-instance attributes, locations 3-6, 7 and 8
+	struct INSTANCE_DATA
+	{
+		glm::mat4 modelMatrix;
+		glm::vec4 color;
+		// UV scale in xy, texture layer in z (-1 untextured), material in w
+		glm::vec4 params;
+	};
+
+	// contiguous range of instances drawn by one call
+	struct INSTANCE_BATCH
+	{
+		int primitive;
+		// level of detail of the primitive mesh
+		int level;
+		// texture unit and texture of the batch, -1 and 0 when untextured
+		int textureUnit;
+		GLuint textureID;
+		// GL_TEXTURE_2D, or GL_TEXTURE_2D_ARRAY when the instances
+		// pick their layer of an array texture
+		GLenum textureTarget;
+		bool depthWrite;
+		GLint firstInstance;
+		GLsizei instanceCount;
+	};
+
+	// attach the instance attributes to every primitive mesh
+	void Initialize(const PrimitiveMeshes* pMeshes);
+	// free the instance buffer
+	void Destroy();
+
+	// replace the instances and the batches that reference them
+	void SetInstances(
+		const std::vector<INSTANCE_DATA>& instances,
+		const std::vector<INSTANCE_BATCH>& batches);
+
+	// issue one instanced draw per batch with the program that is current
+	void Draw(GLStateCache* pStateCache);
+
+	int GetBatchCount() const { return static_cast<int>(m_batches.size()); }
+	int GetInstanceCount() const { return m_instanceCount; }
+
+private:
+	const PrimitiveMeshes* m_pMeshes;
+	GLuint m_instanceBuffer;
+	// capacity of the instance buffer in instances
+	int m_instanceCapacity;
+	int m_instanceCount;
+	std::vector<INSTANCE_BATCH> m_batches;
+
+	// point the instance attributes of the bound VAO at one batch
+	void SetInstanceOffset(GLint firstInstance);
+};
@@ -0,0 +1,263 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.cpp
+// ============
+// split loops over the scene across worker threads that steal work
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+
+// declaration of global variables
+namespace
+{
+	// ranges per thread, so a thread that finishes early
+	// has something left to steal
+	const int g_RangesPerThread = 4;
+}
+
+/***********************************************************
+ *  JobSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+JobSystem::JobSystem()
+{
+	m_queuedCount = 0;
+	m_remainingCount = 0;
+	m_bStopping = false;
+	m_queues.push_back(std::unique_ptr<JOB_QUEUE>(new JOB_QUEUE()));
+}
+
+/***********************************************************
+ *  ~JobSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+JobSystem::~JobSystem()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting the worker threads.
+ ***********************************************************/
+void JobSystem::Start(int workerCount)
+{
+	if (!m_workers.empty())
+	{
+		return;
+	}
+
+	if (workerCount <= 0)
+	{
+		workerCount = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+		if (workerCount < 0)
+		{
+			workerCount = 0;
+		}
+	}
+
+	m_bStopping = false;
+	for (int i = 0; i < workerCount; i++)
+	{
+		m_queues.push_back(std::unique_ptr<JOB_QUEUE>(new JOB_QUEUE()));
+	}
+	for (int i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&JobSystem::WorkerLoop, this, i + 1));
+	}
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for stopping the worker threads.
+ *  ParallelFor() never returns with jobs left, so they are
+ *  idle whenever the caller gets here.
+ ***********************************************************/
+void JobSystem::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_bStopping = true;
+	}
+	m_jobReady.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+	m_queues.resize(1);
+}
+
+/***********************************************************
+ *  GetRangeSize()
+ *
+ *  This method is used for sizing the ranges of a loop to
+ *  a few per thread, in whole multiples of the grain.
+ ***********************************************************/
+int JobSystem::GetRangeSize(int count, int grain) const
+{
+	if (grain < 1)
+	{
+		grain = 1;
+	}
+
+	int threadCount = GetThreadCount();
+	int targetCount = (threadCount > 1) ? threadCount * g_RangesPerThread : 1;
+	int grainCount = (count + grain - 1) / grain;
+	int grainsPerRange = (grainCount + targetCount - 1) / targetCount;
+	if (grainsPerRange < 1)
+	{
+		grainsPerRange = 1;
+	}
+	return(grainsPerRange * grain);
+}
+
+/***********************************************************
+ *  GetRangeCount()
+ *
+ *  This method is used for getting how many ranges a loop
+ *  is cut into, so the caller can size its range buffers.
+ ***********************************************************/
+int JobSystem::GetRangeCount(int count, int grain) const
+{
+	if (count <= 0)
+	{
+		return(0);
+	}
+
+	int rangeSize = GetRangeSize(count, grain);
+	return((count + rangeSize - 1) / rangeSize);
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for dealing the ranges of a loop
+ *  over the queues and working through them with the
+ *  workers until the last one is done.
+ ***********************************************************/
+void JobSystem::Run(int count, int grain, RANGE_FUNCTION pFunction, const void* pContext)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	const int rangeSize = GetRangeSize(count, grain);
+	const int rangeCount = (count + rangeSize - 1) / rangeSize;
+
+	if ((rangeCount == 1) || m_workers.empty())
+	{
+		for (int range = 0; range < rangeCount; range++)
+		{
+			int first = range * rangeSize;
+			int rangeItems = ((count - first) < rangeSize) ? (count - first) : rangeSize;
+			pFunction(pContext, range, first, rangeItems);
+		}
+		return;
+	}
+
+	m_remainingCount = rangeCount;
+	const int queueCount = static_cast<int>(m_queues.size());
+	for (int range = 0; range < rangeCount; range++)
+	{
+		JOB job;
+		job.pFunction = pFunction;
+		job.pContext = pContext;
+		job.range = range;
+		job.first = range * rangeSize;
+		job.count = ((count - job.first) < rangeSize) ? (count - job.first) : rangeSize;
+
+		JOB_QUEUE& queue = *m_queues[range % queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+	m_queuedCount += rangeCount;
+	{
+		// taken so a worker checking for jobs cannot miss the wake up
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_jobReady.notify_all();
+
+	while (m_remainingCount > 0)
+	{
+		JOB job;
+		if (TakeJob(0, job))
+		{
+			job.pFunction(job.pContext, job.range, job.first, job.count);
+			m_remainingCount--;
+		}
+		else
+		{
+			// the last ranges are running on the workers
+			std::this_thread::yield();
+		}
+	}
+}
+
+/***********************************************************
+ *  TakeJob()
+ *
+ *  This method is used for taking the newest job of the
+ *  thread's own queue, whose data is most likely still in
+ *  its cache, or else stealing the oldest job of another.
+ ***********************************************************/
+bool JobSystem::TakeJob(int queueIndex, JOB& job)
+{
+	const int queueCount = static_cast<int>(m_queues.size());
+	for (int i = 0; i < queueCount; i++)
+	{
+		JOB_QUEUE& queue = *m_queues[(queueIndex + i) % queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty())
+		{
+			continue;
+		}
+
+		if (0 == i)
+		{
+			job = queue.jobs.back();
+			queue.jobs.pop_back();
+		}
+		else
+		{
+			job = queue.jobs.front();
+			queue.jobs.pop_front();
+		}
+		m_queuedCount--;
+		return(true);
+	}
+	return(false);
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used for running jobs, sleeping while
+ *  none are queued, until the system stops.
+ ***********************************************************/
+void JobSystem::WorkerLoop(int queueIndex)
+{
+	for (;;)
+	{
+		JOB job;
+		if (TakeJob(queueIndex, job))
+		{
+			job.pFunction(job.pContext, job.range, job.first, job.count);
+			m_remainingCount--;
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_jobReady.wait(lock, [this] { return m_bStopping || (m_queuedCount > 0); });
+		if (m_bStopping)
+		{
+			return;
+		}
+	}
+}
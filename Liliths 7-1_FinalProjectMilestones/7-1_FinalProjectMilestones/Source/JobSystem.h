@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.h
+// ============
+// split loops over the scene across worker threads that steal work
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  This class keeps a pool of worker threads, each with its
+ *  own queue of jobs.  ParallelFor() cuts a loop into ranges
+ *  and deals them over the queues; every thread runs the
+ *  newest job of its own queue and, once that is empty,
+ *  steals the oldest job of another, so a thread that was
+ *  handed slow ranges is helped by the ones that finished.
+ *  The calling thread works through the ranges as well and
+ *  returns when all of them are done.
+ *
+ *  The loop body is told which range it runs, so results
+ *  can go to one buffer per range and be merged in range
+ *  order afterwards, giving the same result however the
+ *  ranges were shared out.  Without workers, or when the
+ *  loop fits in one range, the body runs on the caller.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	// constructor
+	JobSystem();
+	// destructor
+	~JobSystem();
+
+	// start the workers, 0 picks one per spare core
+	void Start(int workerCount = 0);
+	// stop the workers once they are idle
+	void Stop();
+	// threads sharing a loop, the caller included
+	int GetThreadCount() const { return static_cast<int>(m_workers.size()) + 1; }
+
+	// ranges a loop of count items is cut into, each a multiple
+	// of grain items except the last
+	int GetRangeCount(int count, int grain) const;
+	// run func(range, first, count) over the ranges of [0, count),
+	// only from the thread that started the workers
+	template <typename FUNCTION>
+	void ParallelFor(int count, int grain, const FUNCTION& func)
+	{
+		Run(count, grain, &CallRange<FUNCTION>, &func);
+	}
+
+private:
+	typedef void (*RANGE_FUNCTION)(const void* pContext, int range, int first, int count);
+
+	struct JOB
+	{
+		RANGE_FUNCTION pFunction;
+		const void* pContext;
+		int range;
+		int first;
+		int count;
+	};
+
+	struct JOB_QUEUE
+	{
+		std::mutex mutex;
+		std::deque<JOB> jobs;
+	};
+
+	// queue 0 belongs to the calling thread, queue i to worker i - 1
+	std::vector<std::unique_ptr<JOB_QUEUE>> m_queues;
+	std::vector<std::thread> m_workers;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_jobReady;
+	std::atomic<int> m_queuedCount;
+	std::atomic<int> m_remainingCount;
+	bool m_bStopping;
+
+	template <typename FUNCTION>
+	static void CallRange(const void* pContext, int range, int first, int count)
+	{
+		(*static_cast<const FUNCTION*>(pContext))(range, first, count);
+	}
+
+	// cut the loop into jobs, queue them and help until they are done
+	void Run(int count, int grain, RANGE_FUNCTION pFunction, const void* pContext);
+	// newest job of the thread's own queue, or the oldest of another
+	bool TakeJob(int queueIndex, JOB& job);
+	// run jobs until the system stops
+	void WorkerLoop(int queueIndex);
+	// size of every range but the last
+	int GetRangeSize(int count, int grain) const;
+};
@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////////////
+// lodselector.cpp
+// ============
+// pick a level of detail per draw from its size on screen
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LodSelector.h"
+
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// fraction of the screen height below which level i + 1
+	// replaces level i
+	const float g_LevelThresholds[] = { 0.20f, 0.07f, 0.025f };
+	const int g_ThresholdCount = sizeof(g_LevelThresholds) / sizeof(g_LevelThresholds[0]);
+
+	const float g_DefaultHysteresis = 0.15f;
+
+	/***********************************************************
+	 *  PickLevel()
+	 *
+	 *  Level of an object covering the passed in fraction of
+	 *  the screen height, starting from the level it had.
+	 *  Without hysteresis this is simply the number of
+	 *  thresholds the size is below.
+	 ***********************************************************/
+	int PickLevel(float screenSize, int level, int levelCount, float hysteresis)
+	{
+		int lastLevel = levelCount - 1;
+		if (lastLevel > g_ThresholdCount)
+		{
+			lastLevel = g_ThresholdCount;
+		}
+		if (level > lastLevel)
+		{
+			level = lastLevel;
+		}
+
+		while ((level > 0) && (screenSize > g_LevelThresholds[level - 1] * (1.0f + hysteresis)))
+		{
+			level--;
+		}
+		while ((level < lastLevel) && (screenSize < g_LevelThresholds[level] * (1.0f - hysteresis)))
+		{
+			level++;
+		}
+		return(level);
+	}
+}
+
+/***********************************************************
+ *  LodSelector()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LodSelector::LodSelector()
+{
+	m_hysteresis = g_DefaultHysteresis;
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for setting the number of draws.
+ ***********************************************************/
+void LodSelector::Resize(int drawCount)
+{
+	m_spheres.resize(drawCount, glm::vec4(0.0f));
+	m_levelCounts.resize(drawCount, 1);
+	m_levels.resize(drawCount, 0);
+}
+
+/***********************************************************
+ *  SetBounds()
+ *
+ *  This method is used for storing the world bounding sphere
+ *  of one draw and how many levels its mesh has.
+ ***********************************************************/
+void LodSelector::SetBounds(int index, const glm::vec3& center, float radius, int levelCount)
+{
+	m_spheres[index] = glm::vec4(center, radius);
+	m_levelCounts[index] = static_cast<unsigned char>((levelCount > 1) ? levelCount : 1);
+	if (m_levels[index] >= m_levelCounts[index])
+	{
+		m_levels[index] = 0;
+	}
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for picking the level of every
+ *  visible draw with more than one level.  A sphere of
+ *  radius r at distance d covers r * P[1][1] / d of the
+ *  screen height for a perspective projection P, and
+ *  r * P[1][1] for an orthographic one.
+ ***********************************************************/
+int LodSelector::Update(
+	const glm::vec3& viewPosition,
+	const glm::mat4& projection,
+	const std::vector<unsigned char>& visible,
+	const std::vector<unsigned char>& lastVisible)
+{
+	return(UpdateRange(0, static_cast<int>(m_levels.size()),
+		viewPosition, projection, visible, lastVisible));
+}
+
+/***********************************************************
+ *  UpdateRange()
+ *
+ *  This method is used for picking the levels of the draws
+ *  from first to first + count the way Update() does.
+ ***********************************************************/
+int LodSelector::UpdateRange(
+	int first,
+	int count,
+	const glm::vec3& viewPosition,
+	const glm::mat4& projection,
+	const std::vector<unsigned char>& visible,
+	const std::vector<unsigned char>& lastVisible)
+{
+	const float focalScale = std::fabs(projection[1][1]);
+	// the w row of a perspective projection takes -z
+	const bool bPerspective = (projection[2][3] != 0.0f);
+
+	int changedCount = 0;
+	const int drawCount = static_cast<int>(m_levels.size());
+	const int end = ((first + count) < drawCount) ? (first + count) : drawCount;
+	for (int i = first; i < end; i++)
+	{
+		if ((m_levelCounts[i] <= 1) || ((i < static_cast<int>(visible.size())) && !visible[i]))
+		{
+			continue;
+		}
+
+		const glm::vec4& sphere = m_spheres[i];
+		float screenSize = sphere.w * focalScale;
+		if (bPerspective)
+		{
+			float distance = glm::length(glm::vec3(sphere) - viewPosition);
+			// the camera inside the sphere sees it fill the screen
+			screenSize = (distance > sphere.w) ? screenSize / distance : 1.0f;
+		}
+
+		bool bWasVisible = (i < static_cast<int>(lastVisible.size())) && lastVisible[i];
+		int level = PickLevel(screenSize, m_levels[i], m_levelCounts[i],
+			bWasVisible ? m_hysteresis : 0.0f);
+		if (level != m_levels[i])
+		{
+			m_levels[i] = static_cast<unsigned char>(level);
+			changedCount++;
+		}
+	}
+
+	return(changedCount);
+}
@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////////////
+// lodselector.h
+// ============
+// pick a level of detail per draw from its size on screen
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  LodSelector
+ *
+ *  This class keeps a bounding sphere and a level of detail
+ *  for every draw, and picks the levels each frame from the
+ *  fraction of the screen height the spheres cover.  A draw
+ *  only moves to a finer level once it is clearly larger
+ *  than the threshold between the two, and back to a coarser
+ *  one once it is clearly smaller, so an object resting near
+ *  a threshold does not pop between levels every frame.
+ ***********************************************************/
+class LodSelector
+{
+public:
+	// constructor
+	LodSelector();
+
+	// set the number of draws, keeping the ones already set,
+	// new draws start at level 0
+	void Resize(int drawCount);
+	// world bounding sphere and number of levels of one draw
+	void SetBounds(int index, const glm::vec3& center, float radius, int levelCount);
+	int GetDrawCount() const { return static_cast<int>(m_levels.size()); }
+
+	// fraction of a threshold an object must pass it by, 0.15 by default
+	void SetHysteresis(float hysteresis) { m_hysteresis = hysteresis; }
+
+	// pick the level of the visible draws, returns how many changed;
+	// draws that just became visible take their level directly
+	int Update(
+		const glm::vec3& viewPosition,
+		const glm::mat4& projection,
+		const std::vector<unsigned char>& visible,
+		const std::vector<unsigned char>& lastVisible);
+	// the same for the draws of one range, which only touches
+	// their own levels so ranges can run on different threads
+	int UpdateRange(
+		int first,
+		int count,
+		const glm::vec3& viewPosition,
+		const glm::mat4& projection,
+		const std::vector<unsigned char>& visible,
+		const std::vector<unsigned char>& lastVisible);
+
+	int GetLevel(int index) const { return m_levels[index]; }
+
+private:
+	// center in xyz and radius in w
+	std::vector<glm::vec4> m_spheres;
+	std::vector<unsigned char> m_levelCounts;
+	std::vector<unsigned char> m_levels;
+	float m_hysteresis;
+};
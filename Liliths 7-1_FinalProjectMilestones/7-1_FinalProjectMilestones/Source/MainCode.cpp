@@ -2,6 +2,13 @@
 
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
+#include <chrono>           // headless texture wait
+#include <cstdio>           // snprintf
+#include <algorithm>        // path comparison
+#include <filesystem>       // generated scene cleanup
+#include <string>
+#include <vector>
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -15,6 +22,15 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "GLStateCache.h"
+#include "OffscreenContext.h"
+#include "RenderTarget.h"
+#include "FrameBenchmark.h"
+#include "ScalingBenchmark.h"
+#include "Profiler.h"
+#include "ProgramCache.h"
+#include "FramePacer.h"
+#include "ResolutionScaler.h"
 
 // Namespace for declaring global variables
 namespace
@@ -31,12 +47,111 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// shadow copy of the OpenGL state shared by the managers
+	GLStateCache* g_StateCache = nullptr;
+	// context used instead of the window in headless runs
+	OffscreenContext* g_OffscreenContext = nullptr;
+	// scope timings, only created when asked for
+	Profiler* g_Profiler = nullptr;
+	// paces the window frames and measures their latency
+	FramePacer* g_FramePacer = nullptr;
+	// draws the window frames at a resolution that holds the GPU budget
+	ResolutionScaler* g_ResolutionScaler = nullptr;
+
+	// frames the CPU may run ahead of the GPU in headless runs,
+	// matching a double buffered swap chain
+	const int g_FramesInFlight = 2;
+	// longest wait for the streamed textures before measuring
+	const double g_TextureWaitSeconds = 30.0;
+
+	// same order as SceneManager::RENDER_PATH
+	const char* g_RenderPathNames[] = { "immediate", "instanced", "indirect" };
+
+	// scenes the sweep generates, removed afterwards; the scene in
+	// use stays mapped and Windows cannot replace a mapped file, so
+	// the sizes alternate between two files
+	const char* g_StressScenePaths[2] = { "stress-a.sceneb", "stress-b.sceneb" };
+	// unmeasured frames after each scene change of the sweep
+	const int g_SweepWarmupFrames = 5;
+
+	// channel difference a pixel may have between the render paths
+	// in --compare-paths, and the part of the pixels beyond it
+	const int g_CompareTolerance = 8;
+	const double g_CompareMaxFraction = 0.01;
+
+	// GL calls counted since the last report, printed as the
+	// average per frame every g_CounterReportFrames frames
+	struct COUNTER_TOTALS
+	{
+		int frameCount;
+		long long callsSent;
+		long long callsElided;
+		long long drawCalls;
+		long long uniformsSent;
+	};
+	COUNTER_TOTALS g_CounterTotals = {};
+	const int g_CounterReportFrames = 120;
+
+	// command line options, filled by ParseOptions()
+	struct PROGRAM_OPTIONS
+	{
+		// runs that exit without opening a window
+		bool bCookTextures;
+		bool bCompileScene;
+		int generateCopies;
+		const char* generatePath;
+		const char* scenePath;
+
+		// how the scene is drawn
+		SceneManager::RENDER_PATH renderPath;
+		SceneManager::TEXTURE_BACKEND textureBackend;
+		PrimitiveMeshes::VERTEX_FORMAT vertexFormat;
+		bool bCulling;
+		bool bOcclusionCulling;
+		bool bSortDraws;
+		bool bLevelOfDetail;
+		bool bStaticBatching;
+		bool bProgramCaching;
+		int threadCount;
+		int tickRate;
+
+		// window pacing and dynamic resolution
+		FramePacer::PRESENT_MODE presentMode;
+		double targetFps;
+		int framesAhead;
+		bool bDynamicResolution;
+		double gpuBudgetMs;
+		float minRenderScale;
+		float fixedRenderScale;
+
+		// headless runs and their reports
+		bool bHeadless;
+		int frameCount;
+		int warmupFrames;
+		const char* jsonPath;
+		bool bProfile;
+		const char* tracePath;
+		bool bSweep;
+		int sweepMaxCopies;
+		double sweepBudgetMs;
+		int sweepFrames;
+		bool bComparePaths;
+	};
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
+bool ParseOptions(int argc, char* argv[], PROGRAM_OPTIONS& options);
 bool InitializeGLFW();
-bool InitializeGLEW();
+bool InitializeGLEW(bool bHeadless);
+void RenderFrame();
+void ReportFrameCounters();
+void SetScriptedCamera(float progress);
+void WaitForFrameSlot(GLsync& fence);
+int WaitForStreamedTextures();
+int RunHeadless(int frameCount, int warmupFrames, const char* jsonPath);
+int RunSweep(const char* templatePath, int maxCopies, double budgetMs, int frameCount, const char* jsonPath);
+int ComparePaths(const char* scenePath);
 
 
 /***********************************************************
@@ -47,60 +162,206 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// command line options
+	PROGRAM_OPTIONS options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		return(EXIT_FAILURE);
+	}
+
+	if (options.bCookTextures)
+	{
+		return((SceneManager::CookSceneTextures() > 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	if (options.bCompileScene)
+	{
+		return(SceneManager::CompileSceneFile(options.scenePath) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+	if (NULL != options.generatePath)
+	{
+		return(SceneManager::GenerateStressScene(
+			options.scenePath, options.generateCopies, options.generatePath) ?
+			EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	if (options.bProfile)
+	{
+		g_Profiler = new Profiler();
+		Profiler::SetActive(g_Profiler);
+		if (NULL != options.tracePath)
+		{
+			g_Profiler->BeginCapture();
+		}
+	}
+
+	if (options.bHeadless)
+	{
+		// no window, so no display server is needed
+		g_OffscreenContext = new OffscreenContext();
+		if (!g_OffscreenContext->Create(3, 3))
+		{
+			return(EXIT_FAILURE);
+		}
+	}
 	// if GLFW fails initialization, then terminate the application
-	if (InitializeGLFW() == false)
+	else if (InitializeGLFW() == false)
 	{
 		return(EXIT_FAILURE);
 	}
 
 	// try to create a new shader manager object
 	g_ShaderManager = new ShaderManager();
+	// create the OpenGL state cache shared by the managers
+	g_StateCache = new GLStateCache();
 	// try to create a new view manager object
 	g_ViewManager = new ViewManager(
-		g_ShaderManager);
+		g_ShaderManager, g_StateCache);
+	g_ViewManager->SetTickRate(options.tickRate);
 
 	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	if (!options.bHeadless)
+	{
+		g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	}
 
 	// if GLEW fails initialization, then terminate the application
-	if (InitializeGLEW() == false)
+	if (InitializeGLEW(options.bHeadless) == false)
 	{
 		return(EXIT_FAILURE);
 	}
 
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"../../Utilities/shaders/vertexShader.glsl",
-		"../../Utilities/shaders/fragmentShader.glsl");
-	g_ShaderManager->use();
+	// load the shader code from the external GLSL files, or the
+	// program binary the driver made from them on an earlier run
+	{
+		ScopedCpuTimer timer("LoadShaders");
+		ProgramCache programCache;
+		if (options.bProgramCaching)
+		{
+			programCache.SetCacheFolder("../../Utilities/shaders/cache/");
+		}
+		if (!programCache.LoadProgram(g_ShaderManager,
+			"../../Utilities/shaders/vertexShader.glsl",
+			"../../Utilities/shaders/fragmentShader.glsl"))
+		{
+			std::cout << "Could not load the scene shaders" << std::endl;
+		}
+	}
+	g_StateCache->UseProgram(g_ShaderManager->m_programID);
 
 	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager = new SceneManager(g_ShaderManager, g_StateCache);
+	g_SceneManager->SetRenderPath(options.renderPath);
+	g_SceneManager->SetTextureBackend(options.textureBackend);
+	g_SceneManager->SetVertexFormat(options.vertexFormat);
+	g_SceneManager->SetFrustumCulling(options.bCulling);
+	g_SceneManager->SetOcclusionCulling(options.bOcclusionCulling);
+	g_SceneManager->SetThreadCount(options.threadCount);
+	g_SceneManager->SetDrawSorting(options.bSortDraws);
+	g_SceneManager->SetLevelOfDetail(options.bLevelOfDetail);
+	g_SceneManager->SetStaticBatching(options.bStaticBatching);
+	g_SceneManager->SetProgramCaching(options.bProgramCaching);
+	g_SceneManager->SetSceneFile(options.scenePath);
 	g_SceneManager->PrepareScene();
 
-	// loop will keep running until the application is closed 
-	// or until an error has occurred
-	while (!glfwWindowShouldClose(g_Window))
+	if (NULL != g_Window)
 	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
+		g_FramePacer = new FramePacer();
+		g_FramePacer->SetMode(options.presentMode);
+		g_FramePacer->SetTargetFps(options.targetFps);
+		g_FramePacer->SetMaxFramesAhead(options.framesAhead);
+		g_FramePacer->Apply();
+		g_FramePacer->InputSampled();
 
-		// Clear the frame and z buffers
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		if (options.bDynamicResolution)
+		{
+			g_ResolutionScaler = new ResolutionScaler();
+			g_ResolutionScaler->SetGpuBudget(options.gpuBudgetMs);
+			g_ResolutionScaler->SetMinScale(options.minRenderScale);
+			if (options.fixedRenderScale > 0.0f)
+			{
+				g_ResolutionScaler->SetFixedScale(options.fixedRenderScale);
+			}
+		}
+	}
 
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
+	int exitCode = EXIT_SUCCESS;
+	if (options.bSweep)
+	{
+		exitCode = RunSweep(options.scenePath, options.sweepMaxCopies,
+			options.sweepBudgetMs, options.sweepFrames, options.jsonPath);
+	}
+	else if (options.bComparePaths)
+	{
+		exitCode = ComparePaths(options.scenePath);
+	}
+	else if (options.bHeadless)
+	{
+		exitCode = RunHeadless(options.frameCount, options.warmupFrames, options.jsonPath);
+	}
 
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
+	// loop will keep running until the application is closed 
+	// or until an error has occurred
+	while ((NULL != g_Window) && !glfwWindowShouldClose(g_Window))
+	{
+		// nothing to draw into while the window is minimized
+		if ((g_ViewManager->GetViewWidth() <= 0) || (g_ViewManager->GetViewHeight() <= 0))
+		{
+			glfwWaitEvents();
+			g_FramePacer->InputSampled();
+			continue;
+		}
 
+		if (NULL != g_Profiler)
+		{
+			g_Profiler->BeginFrame();
+		}
+
+		RenderFrame();
+		ReportFrameCounters();
 
 		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
+		{
+			ScopedCpuTimer timer("SwapBuffers");
+			glfwSwapBuffers(g_Window);
+		}
+
+		// hold the CPU back before the input is polled, so the
+		// next frame is built from the newest input
+		{
+			ScopedCpuTimer timer("FramePacing");
+			g_FramePacer->FramePresented();
+		}
 
 		// query the latest GLFW events
 		glfwPollEvents();
+		g_FramePacer->InputSampled();
+
+		if (NULL != g_Profiler)
+		{
+			g_Profiler->EndFrame();
+		}
+	}
+
+	if (NULL != g_Profiler)
+	{
+		g_Profiler->EndCapture();
+		g_Profiler->PrintStats();
+		if ((NULL != options.tracePath) && !g_Profiler->WriteChromeTrace(options.tracePath))
+		{
+			exitCode = EXIT_FAILURE;
+		}
+		g_Profiler->ReleaseQueries();
+	}
+	if (NULL != g_FramePacer)
+	{
+		g_FramePacer->PrintStats();
+		g_FramePacer->Release();
+	}
+	if (NULL != g_ResolutionScaler)
+	{
+		g_ResolutionScaler->PrintStats();
+		g_ResolutionScaler->Release();
 	}
 
 	// clear the allocated manager objects from memory
@@ -119,9 +380,910 @@ int main(int argc, char* argv[])
 		delete g_ShaderManager;
 		g_ShaderManager = NULL;
 	}
+	if (NULL != g_StateCache)
+	{
+		// report how much the cache saved on the last frame
+		const GLStateCache::FRAME_COUNTERS& counters = g_StateCache->GetLastFrameCounters();
+		std::cout << "GL calls in the last frame: " << counters.TotalSent()
+			<< " sent, " << counters.TotalElided() << " elided" << std::endl;
+
+		delete g_StateCache;
+		g_StateCache = NULL;
+	}
+	if (NULL != g_Profiler)
+	{
+		delete g_Profiler;
+		g_Profiler = NULL;
+	}
+	if (NULL != g_FramePacer)
+	{
+		delete g_FramePacer;
+		g_FramePacer = NULL;
+	}
+	if (NULL != g_ResolutionScaler)
+	{
+		delete g_ResolutionScaler;
+		g_ResolutionScaler = NULL;
+	}
+	if (NULL != g_OffscreenContext)
+	{
+		delete g_OffscreenContext;
+		g_OffscreenContext = NULL;
+	}
 
-	// Terminates the program successfully
-	exit(EXIT_SUCCESS); 
+	// Terminates the program
+	exit(exitCode); 
+}
+
+/***********************************************************
+ *  ParseOptions()
+ *
+ *  This function is used to fill the options from the
+ *  command line.  It returns false, after printing why, for
+ *  an unknown option, a bad value, or options that cannot
+ *  be used together.
+ ***********************************************************/
+bool ParseOptions(int argc, char* argv[], PROGRAM_OPTIONS& options)
+{
+	options.bCookTextures = false;
+	options.renderPath = SceneManager::RENDER_PATH_IMMEDIATE;
+	options.textureBackend = SceneManager::TEXTURE_BACKEND_UNITS;
+	options.vertexFormat = PrimitiveMeshes::VERTEX_FORMAT_FLOAT;
+	options.bHeadless = false;
+	options.frameCount = 600;
+	options.warmupFrames = 30;
+	options.jsonPath = NULL;
+	options.bProfile = false;
+	options.tracePath = NULL;
+	options.bCulling = true;
+	options.bOcclusionCulling = true;
+	options.threadCount = 0;
+	options.tickRate = 120;
+	options.presentMode = FramePacer::PRESENT_VSYNC;
+	options.targetFps = 60.0;
+	options.framesAhead = 2;
+	options.bDynamicResolution = true;
+	options.gpuBudgetMs = 14.0;
+	options.minRenderScale = 0.5f;
+	options.fixedRenderScale = 0.0f;
+	options.bSortDraws = true;
+	options.bLevelOfDetail = true;
+	options.bStaticBatching = false;
+	options.bProgramCaching = true;
+	options.scenePath = NULL;
+	options.bCompileScene = false;
+	options.generateCopies = 0;
+	options.generatePath = NULL;
+	options.bSweep = false;
+	options.bComparePaths = false;
+	options.sweepMaxCopies = 1000000;
+	options.sweepBudgetMs = 1000.0;
+	options.sweepFrames = 30;
+
+	// options given explicitly, for the checks below
+	bool bRenderPathSet = false;
+	bool bPresentSet = false;
+	bool bFpsSet = false;
+	bool bRenderScaleSet = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const bool bHasValue = (i + 1 < argc);
+
+		// --cook-textures fills the texture cache and exits
+		if (strcmp(argv[i], "--cook-textures") == 0)
+		{
+			options.bCookTextures = true;
+		}
+
+		// --scene file loads a .scene source or a compiled scene,
+		// --compile-scene compiles the scene source and exits
+		else if ((strcmp(argv[i], "--scene") == 0) && bHasValue)
+		{
+			options.scenePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--compile-scene") == 0)
+		{
+			options.bCompileScene = true;
+		}
+
+		// --generate-scene N file writes N copies of the scene in a
+		// grid as a compiled scene and exits
+		else if ((strcmp(argv[i], "--generate-scene") == 0) && (i + 2 < argc))
+		{
+			options.generateCopies = atoi(argv[++i]);
+			options.generatePath = argv[++i];
+		}
+
+		// --sweep renders headless grids of 1, 3, 10, 30, ... copies of
+		// the scene up to --sweep-max N, stopping once submitting a frame
+		// takes longer than --sweep-budget MS, --sweep-frames N frames each
+		else if (strcmp(argv[i], "--sweep") == 0)
+		{
+			options.bSweep = true;
+			options.bHeadless = true;
+		}
+		else if ((strcmp(argv[i], "--sweep-max") == 0) && bHasValue)
+		{
+			options.sweepMaxCopies = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--sweep-budget") == 0) && bHasValue)
+		{
+			options.sweepBudgetMs = atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--sweep-frames") == 0) && bHasValue)
+		{
+			options.sweepFrames = atoi(argv[++i]);
+		}
+
+		// --compare-paths renders the first headless frame with the
+		// immediate and the instanced paths and compares the images
+		else if (strcmp(argv[i], "--compare-paths") == 0)
+		{
+			options.bComparePaths = true;
+			options.bHeadless = true;
+		}
+
+		// --render-path immediate|instanced|indirect
+		else if ((strcmp(argv[i], "--render-path") == 0) && bHasValue)
+		{
+			i++;
+			bRenderPathSet = true;
+			if (strcmp(argv[i], "instanced") == 0)
+			{
+				options.renderPath = SceneManager::RENDER_PATH_INSTANCED;
+			}
+			else if (strcmp(argv[i], "indirect") == 0)
+			{
+				options.renderPath = SceneManager::RENDER_PATH_INDIRECT;
+			}
+			else if (strcmp(argv[i], "immediate") == 0)
+			{
+				options.renderPath = SceneManager::RENDER_PATH_IMMEDIATE;
+			}
+			else
+			{
+				std::cerr << "Unknown render path: " << argv[i] << std::endl;
+				return(false);
+			}
+		}
+
+		// --texture-array keeps the textures as layers of one array
+		else if (strcmp(argv[i], "--texture-array") == 0)
+		{
+			options.textureBackend = SceneManager::TEXTURE_BACKEND_ARRAY;
+		}
+
+		// --packed-vertices uploads the instanced meshes as 12 byte vertices
+		else if (strcmp(argv[i], "--packed-vertices") == 0)
+		{
+			options.vertexFormat = PrimitiveMeshes::VERTEX_FORMAT_PACKED;
+		}
+
+		// --no-cull draws every object, even outside the view
+		else if (strcmp(argv[i], "--no-cull") == 0)
+		{
+			options.bCulling = false;
+		}
+
+		// --threads N shares the scene work over N threads, 1 keeps
+		// it all on the main thread, by default one per core
+		else if ((strcmp(argv[i], "--threads") == 0) && bHasValue)
+		{
+			options.threadCount = atoi(argv[++i]);
+		}
+
+		// --tick-rate N moves the camera in N fixed steps per second
+		else if ((strcmp(argv[i], "--tick-rate") == 0) && bHasValue)
+		{
+			options.tickRate = atoi(argv[++i]);
+		}
+
+		// --present uncapped|vsync|adaptive|limit paces the window,
+		// --fps N limits it to N frames per second,
+		// --frames-ahead N lets the CPU queue N frames, 0 for any
+		else if ((strcmp(argv[i], "--present") == 0) && bHasValue)
+		{
+			i++;
+			bPresentSet = true;
+			if (!FramePacer::ParseMode(argv[i], options.presentMode))
+			{
+				std::cerr << "Unknown present mode: " << argv[i] << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--fps") == 0) && bHasValue)
+		{
+			bFpsSet = true;
+			options.targetFps = atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--frames-ahead") == 0) && bHasValue)
+		{
+			options.framesAhead = atoi(argv[++i]);
+		}
+
+		// --gpu-budget MS scales the window resolution to hold the GPU
+		// time of a frame, down to --min-render-scale S of each axis,
+		// --render-scale S holds one scale, --no-dynamic-resolution
+		// draws straight into the window
+		else if ((strcmp(argv[i], "--gpu-budget") == 0) && bHasValue)
+		{
+			options.gpuBudgetMs = atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--min-render-scale") == 0) && bHasValue)
+		{
+			options.minRenderScale = static_cast<float>(atof(argv[++i]));
+		}
+		else if ((strcmp(argv[i], "--render-scale") == 0) && bHasValue)
+		{
+			bRenderScaleSet = true;
+			options.fixedRenderScale = static_cast<float>(atof(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--no-dynamic-resolution") == 0)
+		{
+			options.bDynamicResolution = false;
+		}
+
+		// --no-occlusion draws the objects hidden behind the occluders
+		else if (strcmp(argv[i], "--no-occlusion") == 0)
+		{
+			options.bOcclusionCulling = false;
+		}
+
+		// --no-lod draws every cylinder and sphere at full detail
+		else if (strcmp(argv[i], "--no-lod") == 0)
+		{
+			options.bLevelOfDetail = false;
+		}
+
+		// --no-sort draws in source order instead of by state and depth
+		else if (strcmp(argv[i], "--no-sort") == 0)
+		{
+			options.bSortDraws = false;
+		}
+
+		// --static-batch merges the static objects of the per-object
+		// path, drawn from the primitive meshes instead of ShapeMeshes
+		else if (strcmp(argv[i], "--static-batch") == 0)
+		{
+			options.bStaticBatching = true;
+		}
+
+		// --no-program-cache compiles every shader program from source
+		else if (strcmp(argv[i], "--no-program-cache") == 0)
+		{
+			options.bProgramCaching = false;
+		}
+
+		// --headless renders offscreen along a scripted camera and exits,
+		// --frames N and --warmup N set the measured and skipped frames,
+		// --json file writes the frame time percentiles
+		else if (strcmp(argv[i], "--headless") == 0)
+		{
+			options.bHeadless = true;
+		}
+		else if ((strcmp(argv[i], "--frames") == 0) && bHasValue)
+		{
+			options.frameCount = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--warmup") == 0) && bHasValue)
+		{
+			options.warmupFrames = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--json") == 0) && bHasValue)
+		{
+			options.jsonPath = argv[++i];
+		}
+
+		// --profile prints the scope timings on exit,
+		// --trace file also writes them as a Chrome trace
+		else if (strcmp(argv[i], "--profile") == 0)
+		{
+			options.bProfile = true;
+		}
+		else if ((strcmp(argv[i], "--trace") == 0) && bHasValue)
+		{
+			options.bProfile = true;
+			options.tracePath = argv[++i];
+		}
+
+		else
+		{
+			std::cerr << "Unknown option or missing value: " << argv[i] << std::endl;
+			return(false);
+		}
+	}
+
+	// --fps picks the limited mode, any other mode has no rate
+	if (bFpsSet)
+	{
+		if (bPresentSet && (options.presentMode != FramePacer::PRESENT_LIMITED))
+		{
+			std::cerr << "--fps only applies to --present limit" << std::endl;
+			return(false);
+		}
+		options.presentMode = FramePacer::PRESENT_LIMITED;
+	}
+
+	if (bRenderScaleSet && !options.bDynamicResolution)
+	{
+		std::cerr << "--render-scale needs the scaled target, not --no-dynamic-resolution" << std::endl;
+		return(false);
+	}
+
+	// the per-draw shader reads neither the array nor packed vertices,
+	// and the batches only replace its per-object draws
+	if (options.renderPath == SceneManager::RENDER_PATH_IMMEDIATE)
+	{
+		if (options.textureBackend == SceneManager::TEXTURE_BACKEND_ARRAY)
+		{
+			std::cerr << "--texture-array needs --render-path instanced or indirect" << std::endl;
+			return(false);
+		}
+		if (options.vertexFormat == PrimitiveMeshes::VERTEX_FORMAT_PACKED)
+		{
+			std::cerr << "--packed-vertices needs --render-path instanced or indirect" << std::endl;
+			return(false);
+		}
+	}
+	else if (options.bStaticBatching)
+	{
+		std::cerr << "--static-batch only applies to --render-path immediate" << std::endl;
+		return(false);
+	}
+
+	// the comparison picks its own render paths
+	if (options.bComparePaths && bRenderPathSet)
+	{
+		std::cerr << "--compare-paths draws both paths, drop --render-path" << std::endl;
+		return(false);
+	}
+
+	// each of these runs instead of the others
+	int modeCount = (options.bCookTextures ? 1 : 0) + (options.bCompileScene ? 1 : 0) +
+		((NULL != options.generatePath) ? 1 : 0) + (options.bSweep ? 1 : 0) +
+		(options.bComparePaths ? 1 : 0);
+	if (modeCount > 1)
+	{
+		std::cerr << "Only one of --cook-textures, --compile-scene, --generate-scene, "
+			<< "--sweep and --compare-paths can be given" << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  RenderFrame()
+ *
+ *  This function is used to draw one frame into the window,
+ *  through the scaled target when there is one, or into
+ *  whatever framebuffer the headless runs have bound.
+ ***********************************************************/
+void RenderFrame()
+{
+	// start counting the GL calls of this frame
+	g_StateCache->BeginFrame();
+
+	// window frames go through the scaled target, or straight
+	// into the window at its current size; headless runs have
+	// bound their own target
+	const int viewWidth = g_ViewManager->GetViewWidth();
+	const int viewHeight = g_ViewManager->GetViewHeight();
+	bool bScaled = false;
+	if (NULL != g_ResolutionScaler)
+	{
+		bScaled = g_ResolutionScaler->BeginFrame(viewWidth, viewHeight);
+	}
+	if (!bScaled && (NULL != g_Window))
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, viewWidth, viewHeight);
+	}
+
+	// Enable z-depth
+	g_StateCache->Enable(GL_DEPTH_TEST);
+
+	// Clear the frame and z buffers
+	{
+		ScopedGpuTimer gpuTimer("Clear");
+		g_StateCache->ClearColor(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
+
+	// convert from 3D object space to 2D view
+	{
+		ScopedCpuTimer timer("PrepareSceneView");
+		g_ViewManager->PrepareSceneView();
+		g_SceneManager->SetViewState(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix(),
+			g_ViewManager->GetCameraPosition());
+	}
+
+	// refresh the 3D scene
+	{
+		ScopedCpuTimer timer("RenderScene");
+		g_SceneManager->RenderScene();
+	}
+
+	// stretch the scaled frame over the window
+	if (bScaled)
+	{
+		ScopedGpuTimer gpuTimer("Upscale");
+		g_ResolutionScaler->EndFrame();
+	}
+}
+
+/***********************************************************
+ *  ReportFrameCounters()
+ *
+ *  This function is used to add the GL calls of the frame
+ *  just drawn to the running totals, and print them as the
+ *  average per frame once enough frames are counted.
+ ***********************************************************/
+void ReportFrameCounters()
+{
+	const GLStateCache::FRAME_COUNTERS& counters = g_StateCache->GetCurrentCounters();
+	g_CounterTotals.frameCount++;
+	g_CounterTotals.callsSent += counters.TotalSent();
+	g_CounterTotals.callsElided += counters.TotalElided();
+	g_CounterTotals.drawCalls += counters.drawCalls;
+	g_CounterTotals.uniformsSent += counters.uniformsSent;
+	if (g_CounterTotals.frameCount < g_CounterReportFrames)
+	{
+		return;
+	}
+
+	const double frameCount = g_CounterTotals.frameCount;
+	std::cout << "GL calls per frame over the last " << g_CounterTotals.frameCount << " frames: "
+		<< (g_CounterTotals.callsSent / frameCount) << " sent, "
+		<< (g_CounterTotals.callsElided / frameCount) << " elided, "
+		<< (g_CounterTotals.drawCalls / frameCount) << " draw calls, "
+		<< (g_CounterTotals.uniformsSent / frameCount) << " uniforms" << std::endl;
+	g_CounterTotals = COUNTER_TOTALS();
+}
+
+/***********************************************************
+ *  SetScriptedCamera()
+ *
+ *  This function is used to place the camera on an arc in
+ *  front of the desk, swinging left and back to the right
+ *  once as progress goes from 0 to 1.  The path only
+ *  depends on progress, so every run sees the same frames.
+ ***********************************************************/
+void SetScriptedCamera(float progress)
+{
+	const glm::vec3 target(0.0f, 0.45f, -0.1f);
+	const float radius = 1.9f;
+	const float height = 0.6f;
+	const float swingDegrees = 60.0f;
+
+	float angle = glm::radians(swingDegrees) * sinf(glm::radians(360.0f) * progress);
+	glm::vec3 position(
+		target.x + radius * sinf(angle),
+		height,
+		target.z + radius * cosf(angle));
+
+	g_ViewManager->SetScriptedCamera(position, target);
+}
+
+/***********************************************************
+ *  WaitForFrameSlot()
+ *
+ *  This function is used to wait until the GPU is done
+ *  with the frame that last used this slot, so headless
+ *  runs cannot queue up more work than a window would.
+ ***********************************************************/
+void WaitForFrameSlot(GLsync& fence)
+{
+	if (NULL == fence)
+	{
+		return;
+	}
+
+	// the first wait flushes, later ones only poll
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	while (glClientWaitSync(fence, flags, 100000000) == GL_TIMEOUT_EXPIRED)
+	{
+		flags = 0;
+	}
+	glDeleteSync(fence);
+	fence = NULL;
+}
+
+/***********************************************************
+ *  WaitForStreamedTextures()
+ *
+ *  This function is used to render frames until every
+ *  streamed texture is resident, or the wait times out.  It
+ *  returns the number of frames rendered.
+ ***********************************************************/
+int WaitForStreamedTextures()
+{
+	int loadFrames = 0;
+	std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+	while (g_SceneManager->GetPendingTextureCount() > 0)
+	{
+		std::chrono::duration<double> waited = std::chrono::steady_clock::now() - waitStart;
+		if (waited.count() > g_TextureWaitSeconds)
+		{
+			std::cout << "Measuring with " << g_SceneManager->GetPendingTextureCount()
+				<< " textures still streaming" << std::endl;
+			break;
+		}
+		if (NULL != g_Profiler)
+		{
+			g_Profiler->BeginFrame();
+		}
+		SetScriptedCamera(0.0f);
+		RenderFrame();
+		glFinish();
+		if (NULL != g_Profiler)
+		{
+			g_Profiler->EndFrame();
+		}
+		loadFrames++;
+	}
+	return(loadFrames);
+}
+
+/***********************************************************
+ *  RunHeadless()
+ *
+ *  This function is used to render the passed in number of
+ *  frames into an offscreen target along the scripted
+ *  camera, and report the CPU frame times.  Frames are not
+ *  measured until the streamed textures are resident and
+ *  the warmup frames are done.
+ ***********************************************************/
+int RunHeadless(int frameCount, int warmupFrames, const char* jsonPath)
+{
+	RenderTarget renderTarget;
+	if ((frameCount <= 0) ||
+		!renderTarget.Create(g_ViewManager->GetViewWidth(), g_ViewManager->GetViewHeight()))
+	{
+		return(EXIT_FAILURE);
+	}
+	renderTarget.Bind();
+	g_ViewManager->PrepareOffscreenView();
+
+	// let the textures finish streaming so every measured frame
+	// draws the same scene
+	int loadFrames = WaitForStreamedTextures();
+
+	FrameBenchmark benchmark;
+	benchmark.Reset(frameCount);
+	GLsync fences[g_FramesInFlight] = {};
+
+	for (int frame = -warmupFrames; frame < frameCount; frame++)
+	{
+		benchmark.BeginFrame();
+		if (NULL != g_Profiler)
+		{
+			g_Profiler->BeginFrame();
+		}
+
+		float progress = (frame > 0) ? static_cast<float>(frame) / frameCount : 0.0f;
+		SetScriptedCamera(progress);
+		RenderFrame();
+		if (frame >= 0)
+		{
+			ReportFrameCounters();
+		}
+
+		GLsync& fence = fences[(frame + warmupFrames) % g_FramesInFlight];
+		WaitForFrameSlot(fence);
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		if (NULL != g_Profiler)
+		{
+			g_Profiler->EndFrame();
+		}
+		if (frame >= 0)
+		{
+			benchmark.EndFrame();
+		}
+	}
+
+	for (GLsync& fence : fences)
+	{
+		WaitForFrameSlot(fence);
+	}
+
+	// a checksum of the last frame shows when the picture changes
+	std::vector<unsigned char> pixels;
+	unsigned int imageHash = 2166136261u;
+	if (renderTarget.ReadPixels(pixels))
+	{
+		for (unsigned char pixel : pixels)
+		{
+			imageHash = (imageHash ^ pixel) * 16777619u;
+		}
+	}
+	char imageHashText[16];
+	snprintf(imageHashText, sizeof(imageHashText), "%08x", imageHash);
+
+	const GLStateCache::FRAME_COUNTERS& counters = g_StateCache->GetLastFrameCounters();
+	benchmark.SetInfo("renderer", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+	benchmark.SetInfo("glVersion", reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+	benchmark.SetInfo("renderPath", g_RenderPathNames[g_SceneManager->GetRenderPath()]);
+	benchmark.SetInfo("textureBackend",
+		(g_SceneManager->GetTextureBackend() == SceneManager::TEXTURE_BACKEND_ARRAY) ? "array" : "units");
+	benchmark.SetInfo("vertexFormat",
+		(g_SceneManager->GetVertexFormat() == PrimitiveMeshes::VERTEX_FORMAT_PACKED) ? "packed" : "float");
+	benchmark.SetInfo("width", renderTarget.GetWidth());
+	benchmark.SetInfo("height", renderTarget.GetHeight());
+	benchmark.SetInfo("warmupFrames", warmupFrames);
+	benchmark.SetInfo("textureLoadFrames", loadFrames);
+	benchmark.SetInfo("glCallsSent", counters.TotalSent());
+	benchmark.SetInfo("glCallsElided", counters.TotalElided());
+	benchmark.SetInfo("imageHash", imageHashText);
+	benchmark.SetInfo("drawObjects", g_SceneManager->GetDrawCount());
+	benchmark.SetInfo("visibleObjects", g_SceneManager->GetVisibleCount());
+	benchmark.SetInfo("threads", g_SceneManager->GetThreadCount());
+	benchmark.SetInfo("occlusionCulling", g_SceneManager->GetOcclusionCulling() ? "on" : "off");
+	benchmark.SetInfo("occluders", g_SceneManager->GetOccluderCount());
+	benchmark.SetInfo("occludedObjects", g_SceneManager->GetOccludedCount());
+	benchmark.SetInfo("staticBatches", g_SceneManager->GetStaticBatchCount());
+	benchmark.SetInfo("levelOfDetail", g_SceneManager->GetLevelOfDetail() ? "on" : "off");
+
+	// state changes of the last queue in source order and as drawn
+	const RenderQueue::QUEUE_STATS& queueStats = g_SceneManager->GetRenderQueueStats();
+	benchmark.SetInfo("drawSorting", g_SceneManager->GetDrawSorting() ? "on" : "off");
+	benchmark.SetInfo("stateChangesUnsorted", queueStats.unsortedStateChanges);
+	benchmark.SetInfo("stateChangesSorted", queueStats.sortedStateChanges);
+	std::cout << "State changes over " << queueStats.drawCount << " draws: "
+		<< queueStats.unsortedStateChanges << " in source order, "
+		<< queueStats.sortedStateChanges << " sorted" << std::endl;
+
+	// rolling averages of the timed scopes over the last frames
+	if (NULL != g_Profiler)
+	{
+		for (const Profiler::SCOPE_STATS& stats : g_Profiler->GetAllStats())
+		{
+			std::string name = std::string(stats.bGpu ? "gpuMs." : "cpuMs.") + stats.name;
+			benchmark.SetInfo(name.c_str(), stats.average);
+		}
+	}
+
+	benchmark.PrintSummary();
+	if ((NULL != jsonPath) && !benchmark.WriteJSON(jsonPath))
+	{
+		return(EXIT_FAILURE);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	return(EXIT_SUCCESS);
+}
+
+/***********************************************************
+ *  ComparePaths()
+ *
+ *  This function is used to render the first frame of the
+ *  scripted camera with the immediate and the instanced
+ *  render paths, and compare the two images.  Both draw at
+ *  full detail without static batches.  It fails when more
+ *  than a small part of the pixels differ.
+ ***********************************************************/
+int ComparePaths(const char* scenePath)
+{
+	RenderTarget renderTarget;
+	if (!renderTarget.Create(g_ViewManager->GetViewWidth(), g_ViewManager->GetViewHeight()))
+	{
+		return(EXIT_FAILURE);
+	}
+	renderTarget.Bind();
+	g_ViewManager->PrepareOffscreenView();
+
+	const SceneManager::RENDER_PATH renderPaths[2] =
+		{ SceneManager::RENDER_PATH_IMMEDIATE, SceneManager::RENDER_PATH_INSTANCED };
+	std::vector<unsigned char> images[2];
+	for (int i = 0; i < 2; i++)
+	{
+		// each path gets a scene manager of its own
+		delete g_SceneManager;
+		g_StateCache->Invalidate();
+		g_StateCache->UseProgram(g_ShaderManager->m_programID);
+		g_SceneManager = new SceneManager(g_ShaderManager, g_StateCache);
+		g_SceneManager->SetRenderPath(renderPaths[i]);
+		g_SceneManager->SetLevelOfDetail(false);
+		g_SceneManager->SetSceneFile(scenePath);
+		g_SceneManager->PrepareScene();
+		if (g_SceneManager->GetRenderPath() != renderPaths[i])
+		{
+			std::cout << "Cannot compare, the " << g_RenderPathNames[renderPaths[i]]
+				<< " render path is unavailable" << std::endl;
+			return(EXIT_FAILURE);
+		}
+
+		WaitForStreamedTextures();
+		SetScriptedCamera(0.0f);
+		RenderFrame();
+		glFinish();
+		if (!renderTarget.ReadPixels(images[i]))
+		{
+			return(EXIT_FAILURE);
+		}
+	}
+
+	// a pixel differs when any channel is off by more than the
+	// tolerance, small differences come from the shading order
+	size_t differentPixels = 0;
+	double differenceSum = 0.0;
+	int largestDifference = 0;
+	const size_t pixelCount = images[0].size() / 4;
+	for (size_t pixel = 0; pixel < pixelCount; pixel++)
+	{
+		int pixelDifference = 0;
+		for (size_t channel = 0; channel < 3; channel++)
+		{
+			int difference = abs(images[0][pixel * 4 + channel] - images[1][pixel * 4 + channel]);
+			pixelDifference = std::max(pixelDifference, difference);
+			differenceSum += difference;
+		}
+		largestDifference = std::max(largestDifference, pixelDifference);
+		if (pixelDifference > g_CompareTolerance)
+		{
+			differentPixels++;
+		}
+	}
+
+	const double differentFraction = (pixelCount > 0) ?
+		static_cast<double>(differentPixels) / pixelCount : 1.0;
+	std::cout << "Immediate and instanced paths: " << differentPixels << " of " << pixelCount
+		<< " pixels differ by more than " << g_CompareTolerance
+		<< ", mean channel difference " << ((pixelCount > 0) ? differenceSum / (pixelCount * 3) : 0.0)
+		<< ", largest " << largestDifference << std::endl;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	return((differentFraction <= g_CompareMaxFraction) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/***********************************************************
+ *  RunSweep()
+ *
+ *  This function is used to measure how the selected render
+ *  path scales.  For each size a grid of copies of the scene
+ *  is generated and swapped in, then rendered headless along
+ *  the scripted camera.  The CPU time of building and
+ *  submitting each frame is measured apart from the waits on
+ *  the GPU, and the draw calls and uniform uploads of the
+ *  last frame and the memory in use are reported with it.
+ ***********************************************************/
+int RunSweep(const char* templatePath, int maxCopies, double budgetMs, int frameCount, const char* jsonPath)
+{
+	RenderTarget renderTarget;
+	if ((frameCount <= 0) || (maxCopies <= 0) ||
+		!renderTarget.Create(g_ViewManager->GetViewWidth(), g_ViewManager->GetViewHeight()))
+	{
+		return(EXIT_FAILURE);
+	}
+	renderTarget.Bind();
+	g_ViewManager->PrepareOffscreenView();
+	WaitForStreamedTextures();
+
+	ScalingBenchmark report;
+	report.SetInfo("renderer", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+	report.SetInfo("renderPath", g_RenderPathNames[g_SceneManager->GetRenderPath()]);
+	report.SetInfo("textureBackend",
+		(g_SceneManager->GetTextureBackend() == SceneManager::TEXTURE_BACKEND_ARRAY) ? "array" : "units");
+	report.SetInfo("vertexFormat",
+		(g_SceneManager->GetVertexFormat() == PrimitiveMeshes::VERTEX_FORMAT_PACKED) ? "packed" : "float");
+	report.SetInfo("levelOfDetail", g_SceneManager->GetLevelOfDetail() ? "on" : "off");
+	report.SetInfo("occlusionCulling", g_SceneManager->GetOcclusionCulling() ? "on" : "off");
+	report.SetInfo("threads", std::to_string(g_SceneManager->GetThreadCount()));
+	ScalingBenchmark::PrintHeader();
+
+	// 1, 3, 10, 30, ... and the maximum itself
+	std::vector<int> copyCounts;
+	for (long long decade = 1; decade <= maxCopies; decade *= 10)
+	{
+		copyCounts.push_back(static_cast<int>(decade));
+		if (decade * 3 <= maxCopies)
+		{
+			copyCounts.push_back(static_cast<int>(decade * 3));
+		}
+	}
+	if (copyCounts.back() != maxCopies)
+	{
+		copyCounts.push_back(maxCopies);
+	}
+
+	for (size_t stepIndex = 0; stepIndex < copyCounts.size(); stepIndex++)
+	{
+		const int copyCount = copyCounts[stepIndex];
+		const char* stressScenePath = g_StressScenePaths[stepIndex % 2];
+		ScalingBenchmark::SCALING_STEP step = {};
+		step.copyCount = copyCount;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (!SceneManager::GenerateStressScene(templatePath, copyCount, stressScenePath))
+		{
+			std::cout << "Could not generate " << copyCount << " copies" << std::endl;
+			break;
+		}
+		std::chrono::steady_clock::time_point generated = std::chrono::steady_clock::now();
+		if (!g_SceneManager->ChangeScene(stressScenePath))
+		{
+			break;
+		}
+		std::chrono::steady_clock::time_point loaded = std::chrono::steady_clock::now();
+		step.generateMs = std::chrono::duration<double, std::milli>(generated - start).count();
+		step.loadMs = std::chrono::duration<double, std::milli>(loaded - generated).count();
+
+		std::error_code error;
+		step.sceneBytes = std::filesystem::file_size(stressScenePath, error);
+
+		FrameBenchmark submitTimes;
+		FrameBenchmark frameTimes;
+		submitTimes.Reset(frameCount);
+		frameTimes.Reset(frameCount);
+		GLsync fences[g_FramesInFlight] = {};
+
+		for (int frame = -g_SweepWarmupFrames; frame < frameCount; frame++)
+		{
+			frameTimes.BeginFrame();
+			submitTimes.BeginFrame();
+
+			float progress = (frame > 0) ? static_cast<float>(frame) / frameCount : 0.0f;
+			SetScriptedCamera(progress);
+			RenderFrame();
+			if (frame >= 0)
+			{
+				submitTimes.EndFrame();
+			}
+
+			GLsync& fence = fences[(frame + g_SweepWarmupFrames) % g_FramesInFlight];
+			WaitForFrameSlot(fence);
+			fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			if (frame >= 0)
+			{
+				frameTimes.EndFrame();
+			}
+		}
+		for (GLsync& fence : fences)
+		{
+			WaitForFrameSlot(fence);
+		}
+
+		// the counters of the frame just rendered
+		const GLStateCache::FRAME_COUNTERS& counters = g_StateCache->GetCurrentCounters();
+		FrameBenchmark::FRAME_STATS submitStats = submitTimes.GetStats();
+		step.drawObjects = g_SceneManager->GetDrawCount();
+		step.visibleObjects = g_SceneManager->GetVisibleCount();
+		step.drawCalls = counters.drawCalls;
+		step.uniformUploads = counters.uniformsSent;
+		step.glCallsSent = counters.TotalSent();
+		step.submitMeanMs = submitStats.mean;
+		step.submitP95Ms = submitStats.p95;
+		step.frameMeanMs = frameTimes.GetStats().mean;
+		step.residentBytes = ScalingBenchmark::GetResidentBytes();
+		report.AddStep(step);
+
+		if (submitStats.mean > budgetMs)
+		{
+			std::cout << "Stopped at " << copyCount << " copies, submitting a frame took "
+				<< submitStats.mean << " ms of the " << budgetMs << " ms budget" << std::endl;
+			break;
+		}
+	}
+
+	// back to the template scene, so neither file is mapped
+	g_SceneManager->ChangeScene(templatePath);
+	for (const char* stressScenePath : g_StressScenePaths)
+	{
+		std::error_code error;
+		std::filesystem::remove(stressScenePath, error);
+	}
+
+	if ((NULL != jsonPath) && !report.WriteJSON(jsonPath))
+	{
+		return(EXIT_FAILURE);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	return(EXIT_SUCCESS);
 }
 
 /***********************************************************
@@ -156,14 +1318,25 @@ bool InitializeGLFW()
  *
  *  This function is used to initialize the GLEW library.
  ***********************************************************/
-bool InitializeGLEW()
+bool InitializeGLEW(bool bHeadless)
 {
 	// GLEW: initialize
 	// -----------------------------------------
 	GLenum GLEWInitResult = GLEW_OK;
 
+	// core contexts need the entry points loaded without the
+	// extension string GLEW normally checks first
+	glewExperimental = GL_TRUE;
+
 	// try to initialize the GLEW library
 	GLEWInitResult = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	// the GL entry points are loaded, only GLX is missing under EGL
+	if (bHeadless && (GLEW_ERROR_NO_GLX_DISPLAY == GLEWInitResult))
+	{
+		GLEWInitResult = GLEW_OK;
+	}
+#endif
 	if (GLEW_OK != GLEWInitResult)
 	{
 		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
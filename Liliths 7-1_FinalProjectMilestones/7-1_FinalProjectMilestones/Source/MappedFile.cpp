@@ -0,0 +1,193 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.cpp
+// ============
+// read-only memory mapping of a whole file
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/***********************************************************
+ *  MappedFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MappedFile::MappedFile()
+{
+	m_pData = NULL;
+	m_size = 0;
+#ifdef _WIN32
+	m_hFile = NULL;
+	m_hMapping = NULL;
+#endif
+}
+
+/***********************************************************
+ *  ~MappedFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  MappedFile(MappedFile&&) / operator=(MappedFile&&)
+ *
+ *  Move the mapping from another object.
+ ***********************************************************/
+MappedFile::MappedFile(MappedFile&& other)
+{
+	m_pData = NULL;
+	m_size = 0;
+#ifdef _WIN32
+	m_hFile = NULL;
+	m_hMapping = NULL;
+#endif
+	TakeFrom(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other)
+{
+	if (this != &other)
+	{
+		Close();
+		TakeFrom(other);
+	}
+	return(*this);
+}
+
+/***********************************************************
+ *  TakeFrom()
+ *
+ *  This method is used for taking over the mapping of
+ *  another object, which is left closed.
+ ***********************************************************/
+void MappedFile::TakeFrom(MappedFile& other)
+{
+	m_pData = other.m_pData;
+	m_size = other.m_size;
+	other.m_pData = NULL;
+	other.m_size = 0;
+#ifdef _WIN32
+	m_hFile = other.m_hFile;
+	m_hMapping = other.m_hMapping;
+	other.m_hFile = NULL;
+	other.m_hMapping = NULL;
+#endif
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping a whole file read-only.
+ ***********************************************************/
+bool MappedFile::Open(const char* path)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (INVALID_HANDLE_VALUE == hFile)
+	{
+		return(false);
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(hFile, &fileSize) || (0 == fileSize.QuadPart))
+	{
+		CloseHandle(hFile);
+		return(false);
+	}
+
+	HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (NULL == hMapping)
+	{
+		CloseHandle(hFile);
+		return(false);
+	}
+
+	void* pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (NULL == pView)
+	{
+		CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return(false);
+	}
+
+	m_hFile = hFile;
+	m_hMapping = hMapping;
+	m_pData = static_cast<const unsigned char*>(pView);
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return(false);
+	}
+
+	struct stat fileInfo;
+	if ((fstat(fd, &fileInfo) != 0) || (fileInfo.st_size <= 0))
+	{
+		close(fd);
+		return(false);
+	}
+
+	size_t size = static_cast<size_t>(fileInfo.st_size);
+	void* pView = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping stays valid after the descriptor is closed
+	close(fd);
+	if (MAP_FAILED == pView)
+	{
+		return(false);
+	}
+
+	m_pData = static_cast<const unsigned char*>(pView);
+	m_size = size;
+#endif
+
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for releasing the mapping.
+ ***********************************************************/
+void MappedFile::Close()
+{
+	if (NULL == m_pData)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_pData);
+	CloseHandle(static_cast<HANDLE>(m_hMapping));
+	CloseHandle(static_cast<HANDLE>(m_hFile));
+	m_hMapping = NULL;
+	m_hFile = NULL;
+#else
+	munmap(const_cast<unsigned char*>(m_pData), m_size);
+#endif
+
+	m_pData = NULL;
+	m_size = 0;
+}
@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.h
+// ============
+// read-only memory mapping of a whole file
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+/***********************************************************
+ *  MappedFile
+ *
+ *  This class maps a file into memory for reading, with
+ *  mmap() on POSIX systems and a file mapping object on
+ *  Windows.  The mapping is released when the object is
+ *  closed or destroyed.  Objects can be moved but not
+ *  copied.
+ ***********************************************************/
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+	// destructor
+	~MappedFile();
+
+	MappedFile(MappedFile&& other);
+	MappedFile& operator=(MappedFile&& other);
+
+	// map the whole file, false if it is missing or empty
+	bool Open(const char* path);
+	// release the mapping
+	void Close();
+
+	bool IsOpen() const { return m_pData != NULL; }
+	const unsigned char* GetData() const { return m_pData; }
+	size_t GetSize() const { return m_size; }
+
+private:
+	const unsigned char* m_pData;
+	size_t m_size;
+#ifdef _WIN32
+	// file and mapping handles
+	void* m_hFile;
+	void* m_hMapping;
+#endif
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	// take the mapping of another object, leaving it closed
+	void TakeFrom(MappedFile& other);
+};
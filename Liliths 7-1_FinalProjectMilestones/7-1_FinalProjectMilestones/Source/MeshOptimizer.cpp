@@ -0,0 +1,459 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshoptimizer.cpp
+// ============
+// reorder primitive geometry for the GPU caches and pack its vertices
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshOptimizer.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// vertex scoring of Tom Forsyth's linear-speed vertex cache
+	// optimization, with his published weights
+	const float g_LastTriangleScore = 0.75f;
+	const float g_CacheDecayPower = 1.5f;
+	const float g_ValenceBoostScale = 2.0f;
+	const float g_ValenceBoostPower = 0.5f;
+	// most cache size the scoring supports
+	const int g_MaxCacheSize = 64;
+
+	// highest value of the normalized unsigned short positions
+	const float g_PositionScale = 65535.0f;
+	// the octahedral bytes use 0 to 254 so that 127 is exactly 0
+	const float g_OctahedralScale = 127.0f;
+
+	/***********************************************************
+	 *  ScoreVertex()
+	 *
+	 *  Score of a vertex from its place in the simulated cache,
+	 *  -1 when it is not cached, and the number of triangles
+	 *  still to be added that use it.  Recently used vertices
+	 *  score high, and so do vertices with few triangles left,
+	 *  which lets them leave the cache for good.
+	 ***********************************************************/
+	float ScoreVertex(int cachePosition, int remainingTriangles, int cacheSize)
+	{
+		if (remainingTriangles <= 0)
+		{
+			return(-1.0f);
+		}
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+			{
+				// the last triangle used it, which favours strips
+				score = g_LastTriangleScore;
+			}
+			else
+			{
+				float scaler = 1.0f / static_cast<float>(cacheSize - 3);
+				score = std::pow(1.0f - (cachePosition - 3) * scaler, g_CacheDecayPower);
+			}
+		}
+
+		score += g_ValenceBoostScale *
+			std::pow(static_cast<float>(remainingTriangles), -g_ValenceBoostPower);
+		return(score);
+	}
+}
+
+/***********************************************************
+ *  Optimize()
+ *
+ *  This method is used for reordering a geometry for the
+ *  vertex cache first and then for the vertex fetch, since
+ *  the fetch order follows the triangle order.
+ ***********************************************************/
+void MeshOptimizer::Optimize(PrimitiveMeshes::MESH_GEOMETRY& geometry)
+{
+	OptimizeVertexCache(geometry.indices, static_cast<int>(geometry.vertices.size()));
+	OptimizeVertexFetch(geometry);
+}
+
+/***********************************************************
+ *  OptimizeVertexCache()
+ *
+ *  This method is used for reordering the triangles of an
+ *  index list.  A least recently used cache is simulated and
+ *  each step adds the unadded triangle whose vertices score
+ *  highest.  Only the triangles of the cached vertices are
+ *  rescored after a step, and the whole list is only
+ *  searched when none of them is left.
+ ***********************************************************/
+void MeshOptimizer::OptimizeVertexCache(std::vector<GLuint>& indices, int vertexCount, int cacheSize)
+{
+	const int triangleCount = static_cast<int>(indices.size() / 3);
+	if ((triangleCount == 0) || (vertexCount <= 0))
+	{
+		return;
+	}
+	if (cacheSize > g_MaxCacheSize)
+	{
+		cacheSize = g_MaxCacheSize;
+	}
+	if (cacheSize < 4)
+	{
+		cacheSize = 4;
+	}
+
+	// triangles of each vertex, packed in one array
+	std::vector<int> remaining(vertexCount, 0);
+	for (GLuint index : indices)
+	{
+		remaining[index]++;
+	}
+	std::vector<int> firstTriangle(vertexCount + 1, 0);
+	for (int v = 0; v < vertexCount; v++)
+	{
+		firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+	}
+	std::vector<int> vertexTriangles(indices.size());
+	std::vector<int> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+	for (int t = 0; t < triangleCount; t++)
+	{
+		for (int corner = 0; corner < 3; corner++)
+		{
+			vertexTriangles[fill[indices[t * 3 + corner]]++] = t;
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (int v = 0; v < vertexCount; v++)
+	{
+		vertexScore[v] = ScoreVertex(-1, remaining[v], cacheSize);
+	}
+
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<unsigned char> added(triangleCount, 0);
+	for (int t = 0; t < triangleCount; t++)
+	{
+		triangleScore[t] = vertexScore[indices[t * 3]] +
+			vertexScore[indices[t * 3 + 1]] +
+			vertexScore[indices[t * 3 + 2]];
+	}
+
+	// three extra slots hold the vertices pushed out by a step
+	int cache[g_MaxCacheSize + 3];
+	int cacheCount = 0;
+
+	std::vector<GLuint> ordered;
+	ordered.reserve(indices.size());
+
+	int bestTriangle = 0;
+	for (int t = 1; t < triangleCount; t++)
+	{
+		if (triangleScore[t] > triangleScore[bestTriangle])
+		{
+			bestTriangle = t;
+		}
+	}
+
+	for (int step = 0; step < triangleCount; step++)
+	{
+		if (bestTriangle < 0)
+		{
+			// nothing in the cache has triangles left
+			float bestScore = -1.0f;
+			for (int t = 0; t < triangleCount; t++)
+			{
+				if (!added[t] && (triangleScore[t] > bestScore))
+				{
+					bestScore = triangleScore[t];
+					bestTriangle = t;
+				}
+			}
+		}
+
+		added[bestTriangle] = 1;
+		int newCache[g_MaxCacheSize + 3];
+		int newCount = 0;
+		for (int corner = 0; corner < 3; corner++)
+		{
+			int v = static_cast<int>(indices[bestTriangle * 3 + corner]);
+			ordered.push_back(static_cast<GLuint>(v));
+			newCache[newCount++] = v;
+
+			// take the triangle off the list of the vertex
+			remaining[v]--;
+			int* pTriangles = &vertexTriangles[firstTriangle[v]];
+			for (int i = 0; i <= remaining[v]; i++)
+			{
+				if (pTriangles[i] == bestTriangle)
+				{
+					pTriangles[i] = pTriangles[remaining[v]];
+					break;
+				}
+			}
+		}
+		for (int i = 0; i < cacheCount; i++)
+		{
+			int v = cache[i];
+			if ((v != newCache[0]) && (v != newCache[1]) && (v != newCache[2]))
+			{
+				newCache[newCount++] = v;
+			}
+		}
+
+		// rescore what is in the cache and what just fell out of it
+		for (int i = 0; i < newCount; i++)
+		{
+			int v = newCache[i];
+			cachePosition[v] = (i < cacheSize) ? i : -1;
+			float newScore = ScoreVertex(cachePosition[v], remaining[v], cacheSize);
+			float delta = newScore - vertexScore[v];
+			vertexScore[v] = newScore;
+			for (int j = 0; j < remaining[v]; j++)
+			{
+				triangleScore[vertexTriangles[firstTriangle[v] + j]] += delta;
+			}
+		}
+		cacheCount = (newCount < cacheSize) ? newCount : cacheSize;
+		memcpy(cache, newCache, cacheCount * sizeof(int));
+
+		// the next triangle is one of the cached vertices
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (int i = 0; i < cacheCount; i++)
+		{
+			int v = cache[i];
+			for (int j = 0; j < remaining[v]; j++)
+			{
+				int t = vertexTriangles[firstTriangle[v] + j];
+				if (triangleScore[t] > bestScore)
+				{
+					bestScore = triangleScore[t];
+					bestTriangle = t;
+				}
+			}
+		}
+	}
+
+	indices.swap(ordered);
+}
+
+/***********************************************************
+ *  OptimizeVertexFetch()
+ *
+ *  This method is used for renumbering the vertices in the
+ *  order the index list first uses them.  Vertices that no
+ *  triangle uses are dropped.
+ ***********************************************************/
+void MeshOptimizer::OptimizeVertexFetch(PrimitiveMeshes::MESH_GEOMETRY& geometry)
+{
+	const GLuint unused = static_cast<GLuint>(-1);
+	std::vector<GLuint> remap(geometry.vertices.size(), unused);
+	std::vector<PrimitiveMeshes::MESH_VERTEX> vertices;
+	vertices.reserve(geometry.vertices.size());
+
+	for (GLuint& index : geometry.indices)
+	{
+		if (remap[index] == unused)
+		{
+			remap[index] = static_cast<GLuint>(vertices.size());
+			vertices.push_back(geometry.vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	geometry.vertices.swap(vertices);
+}
+
+/***********************************************************
+ *  GetTransformsPerTriangle()
+ *
+ *  This method is used for measuring an index list with a
+ *  first in, first out cache, the kind most GPUs have.
+ ***********************************************************/
+float MeshOptimizer::GetTransformsPerTriangle(const std::vector<GLuint>& indices, int cacheSize)
+{
+	if (indices.size() < 3)
+	{
+		return(0.0f);
+	}
+
+	std::vector<GLuint> cache;
+	size_t next = 0;
+	int transforms = 0;
+	for (GLuint index : indices)
+	{
+		bool bCached = false;
+		for (GLuint cached : cache)
+		{
+			if (cached == index)
+			{
+				bCached = true;
+				break;
+			}
+		}
+		if (bCached)
+		{
+			continue;
+		}
+
+		transforms++;
+		if (static_cast<int>(cache.size()) < cacheSize)
+		{
+			cache.push_back(index);
+		}
+		else
+		{
+			cache[next] = index;
+			next = (next + 1) % cache.size();
+		}
+	}
+
+	return(static_cast<float>(transforms) / static_cast<float>(indices.size() / 3));
+}
+
+/***********************************************************
+ *  GetBounds()
+ *
+ *  This method is used for measuring the box around the
+ *  positions of a geometry.
+ ***********************************************************/
+void MeshOptimizer::GetBounds(
+	const PrimitiveMeshes::MESH_GEOMETRY& geometry,
+	glm::vec3& boundsMin,
+	glm::vec3& boundsMax)
+{
+	boundsMin = glm::vec3(0.0f);
+	boundsMax = glm::vec3(0.0f);
+	for (size_t i = 0; i < geometry.vertices.size(); i++)
+	{
+		const glm::vec3& position = geometry.vertices[i].position;
+		boundsMin = (i == 0) ? position : glm::min(boundsMin, position);
+		boundsMax = (i == 0) ? position : glm::max(boundsMax, position);
+	}
+}
+
+/***********************************************************
+ *  PackVertices()
+ *
+ *  This method is used for converting the vertices of a
+ *  geometry to the packed layout.  Each position axis is
+ *  stored as a fraction of the box, so the corners of the
+ *  box come back exactly.
+ ***********************************************************/
+void MeshOptimizer::PackVertices(
+	const PrimitiveMeshes::MESH_GEOMETRY& geometry,
+	const glm::vec3& boundsMin,
+	const glm::vec3& boundsMax,
+	std::vector<PrimitiveMeshes::PACKED_VERTEX>& packed)
+{
+	const glm::vec3 extent = boundsMax - boundsMin;
+
+	packed.resize(geometry.vertices.size());
+	for (size_t i = 0; i < geometry.vertices.size(); i++)
+	{
+		const PrimitiveMeshes::MESH_VERTEX& vertex = geometry.vertices[i];
+		PrimitiveMeshes::PACKED_VERTEX& target = packed[i];
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float fraction = (extent[axis] > 0.0f) ?
+				(vertex.position[axis] - boundsMin[axis]) / extent[axis] : 0.0f;
+			fraction = glm::clamp(fraction, 0.0f, 1.0f);
+			target.position[axis] = static_cast<GLushort>(std::floor(fraction * g_PositionScale + 0.5f));
+		}
+
+		EncodeOctahedral(vertex.normal, target.normal);
+		target.uv[0] = FloatToHalf(vertex.uv.x);
+		target.uv[1] = FloatToHalf(vertex.uv.y);
+	}
+}
+
+/***********************************************************
+ *  EncodeOctahedral()
+ *
+ *  This method is used for projecting a unit normal onto the
+ *  octahedron |x| + |y| + |z| = 1 and unfolding the lower
+ *  half over the upper one, which leaves two values in -1 to
+ *  1 that are stored as bytes.  The axis directions come
+ *  back exactly.
+ ***********************************************************/
+void MeshOptimizer::EncodeOctahedral(const glm::vec3& normal, unsigned char encoded[2])
+{
+	float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+	glm::vec2 octahedral(0.0f, 0.0f);
+	if (length > 0.0f)
+	{
+		octahedral = glm::vec2(normal.x, normal.y) / length;
+		if (normal.z < 0.0f)
+		{
+			glm::vec2 folded(1.0f - std::fabs(octahedral.y), 1.0f - std::fabs(octahedral.x));
+			octahedral.x = (octahedral.x >= 0.0f) ? folded.x : -folded.x;
+			octahedral.y = (octahedral.y >= 0.0f) ? folded.y : -folded.y;
+		}
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		float value = glm::clamp(octahedral[i], -1.0f, 1.0f);
+		encoded[i] = static_cast<unsigned char>(std::floor((value + 1.0f) * g_OctahedralScale + 0.5f));
+	}
+}
+
+/***********************************************************
+ *  FloatToHalf()
+ *
+ *  This method is used for converting a float to the 16 bit
+ *  float format of GL_HALF_FLOAT, rounding to nearest even.
+ ***********************************************************/
+unsigned short MeshOptimizer::FloatToHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	const uint32_t sign = (bits >> 16) & 0x8000u;
+	const uint32_t magnitude = bits & 0x7FFFFFFFu;
+	if (magnitude > 0x7F800000u)
+	{
+		return(static_cast<unsigned short>(sign | 0x7E00u));
+	}
+
+	int exponent = static_cast<int>(magnitude >> 23) - 127 + 15;
+	uint32_t mantissa = magnitude & 0x007FFFFFu;
+	if (exponent >= 31)
+	{
+		return(static_cast<unsigned short>(sign | 0x7C00u));
+	}
+
+	uint32_t half = 0;
+	uint32_t dropped = 0;
+	uint32_t halfway = 0;
+	if (exponent <= 0)
+	{
+		// too small for a normal half, stored as a subnormal
+		if (exponent < -10)
+		{
+			return(static_cast<unsigned short>(sign));
+		}
+		mantissa |= 0x00800000u;
+		int shift = 14 - exponent;
+		half = mantissa >> shift;
+		dropped = mantissa & ((1u << shift) - 1u);
+		halfway = 1u << (shift - 1);
+	}
+	else
+	{
+		half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+		dropped = mantissa & 0x1FFFu;
+		halfway = 0x1000u;
+	}
+
+	// a carry out of the mantissa correctly steps the exponent
+	if ((dropped > halfway) || ((dropped == halfway) && (half & 1u)))
+	{
+		half++;
+	}
+	return(static_cast<unsigned short>(sign | half));
+}
@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshoptimizer.h
+// ============
+// reorder primitive geometry for the GPU caches and pack its vertices
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PrimitiveMeshes.h"
+
+#include <vector>
+
+/***********************************************************
+ *  MeshOptimizer
+ *
+ *  This class prepares the generated primitive geometry for
+ *  drawing.  The triangles are reordered so that vertices
+ *  are reused while they are still in the post-transform
+ *  cache, then the vertices are renumbered in the order the
+ *  triangles first use them so the fetches walk the vertex
+ *  buffer forwards.  Neither step changes what is drawn.
+ *
+ *  It also packs vertices into PrimitiveMeshes::PACKED_VERTEX,
+ *  with the positions quantized inside a bounding box, the
+ *  normals octahedral encoded and the UVs as half floats.
+ ***********************************************************/
+class MeshOptimizer
+{
+public:
+	// reorder the triangles and then the vertices
+	static void Optimize(PrimitiveMeshes::MESH_GEOMETRY& geometry);
+	// reorder the triangles for a post-transform cache of the passed in size
+	static void OptimizeVertexCache(std::vector<GLuint>& indices, int vertexCount, int cacheSize = 32);
+	// renumber the vertices in the order the indices first use them
+	static void OptimizeVertexFetch(PrimitiveMeshes::MESH_GEOMETRY& geometry);
+	// vertices transformed per triangle by a FIFO cache, 0.5 is ideal
+	static float GetTransformsPerTriangle(const std::vector<GLuint>& indices, int cacheSize = 16);
+
+	// box around the positions of a geometry
+	static void GetBounds(
+		const PrimitiveMeshes::MESH_GEOMETRY& geometry,
+		glm::vec3& boundsMin,
+		glm::vec3& boundsMax);
+	// pack the vertices with their positions quantized inside the box
+	static void PackVertices(
+		const PrimitiveMeshes::MESH_GEOMETRY& geometry,
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax,
+		std::vector<PrimitiveMeshes::PACKED_VERTEX>& packed);
+
+	// unit normal to the two bytes the vertex shaders decode
+	static void EncodeOctahedral(const glm::vec3& normal, unsigned char encoded[2]);
+	// float to IEEE half with round to nearest even
+	static unsigned short FloatToHalf(float value);
+};
@@ -0,0 +1,651 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.cpp
+// ============
+// hide the boxes behind large occluders with a software depth buffer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionCuller.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+#define OCCLUSIONCULLER_SSE
+#include <xmmintrin.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// corners of a box are numbered with x in bit 0, y in bit 1
+	// and z in bit 2, and each face is two triangles wound
+	// counterclockwise seen from outside
+	const int g_BoxTriangles[12][3] =
+	{
+		{ 0, 4, 6 }, { 0, 6, 2 },	// -x
+		{ 1, 3, 7 }, { 1, 7, 5 },	// +x
+		{ 0, 1, 5 }, { 0, 5, 4 },	// -y
+		{ 2, 6, 7 }, { 2, 7, 3 },	// +y
+		{ 0, 2, 3 }, { 0, 3, 1 },	// -z
+		{ 4, 5, 7 }, { 4, 7, 6 }	// +z
+	};
+
+	// clip w below which a corner counts as at the camera
+	const float g_MinClipW = 1.0e-5f;
+	// occluders covering fewer pixels than this are not drawn
+	const float g_MinOccluderArea = 4.0f;
+}
+
+/***********************************************************
+ *  OcclusionCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OcclusionCuller::OcclusionCuller()
+{
+	m_rasterizedCount = 0;
+	m_hiddenCount = 0;
+	m_viewProjection = glm::mat4(1.0f);
+	m_pBoxes = NULL;
+	m_bWorkPending = false;
+	m_bStopping = false;
+
+	// halve each side down to a single texel
+	int width = DEPTH_WIDTH;
+	int height = DEPTH_HEIGHT;
+	for (;;)
+	{
+		DEPTH_LEVEL level;
+		level.width = width;
+		level.height = height;
+		level.depth.assign(static_cast<size_t>(width) * height, 1.0f);
+		m_levels.push_back(level);
+		if ((width == 1) && (height == 1))
+		{
+			break;
+		}
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+	}
+}
+
+/***********************************************************
+ *  ~OcclusionCuller()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+OcclusionCuller::~OcclusionCuller()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting the worker thread.
+ ***********************************************************/
+void OcclusionCuller::Start()
+{
+	if (m_worker.joinable())
+	{
+		return;
+	}
+
+	m_bStopping = false;
+	m_bWorkPending = false;
+	m_worker = std::thread(&OcclusionCuller::WorkerLoop, this);
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for stopping the worker thread once
+ *  the pass it is running has finished.
+ ***********************************************************/
+void OcclusionCuller::Stop()
+{
+	if (!m_worker.joinable())
+	{
+		return;
+	}
+
+	Wait();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_workReady.notify_one();
+	m_worker.join();
+}
+
+/***********************************************************
+ *  ClearOccluders()
+ *
+ *  This method is used for forgetting the occluders.
+ ***********************************************************/
+void OcclusionCuller::ClearOccluders()
+{
+	Wait();
+	m_occluders.clear();
+}
+
+/***********************************************************
+ *  AddOccluder()
+ *
+ *  This method is used for storing the world corners of one
+ *  occluder, so moving it means adding it again.
+ ***********************************************************/
+void OcclusionCuller::AddOccluder(
+	int boxIndex,
+	const glm::vec3& localMin,
+	const glm::vec3& localMax,
+	const glm::mat4& worldMatrix)
+{
+	OCCLUDER occluder;
+	occluder.boxIndex = boxIndex;
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec3 corner(
+			(i & 1) ? localMax.x : localMin.x,
+			(i & 2) ? localMax.y : localMin.y,
+			(i & 4) ? localMax.z : localMin.z);
+		occluder.corners[i] = glm::vec3(worldMatrix * glm::vec4(corner, 1.0f));
+	}
+	m_occluders.push_back(occluder);
+}
+
+/***********************************************************
+ *  Begin()
+ *
+ *  This method is used for handing a pass to the worker
+ *  thread, starting the thread the first time.
+ ***********************************************************/
+void OcclusionCuller::Begin(const glm::mat4& viewProjection, const FrustumCuller& boxes)
+{
+	Start();
+	Wait();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_viewProjection = viewProjection;
+		m_pBoxes = &boxes;
+		m_bWorkPending = true;
+	}
+	m_workReady.notify_one();
+}
+
+/***********************************************************
+ *  Finish()
+ *
+ *  This method is used for waiting for the pass handed to
+ *  the worker and merging its result into the visible flags.
+ ***********************************************************/
+int OcclusionCuller::Finish(std::vector<unsigned char>& visible)
+{
+	Wait();
+
+	int hiddenCount = 0;
+	size_t count = std::min(visible.size(), m_hidden.size());
+	for (size_t i = 0; i < count; i++)
+	{
+		if (visible[i] && m_hidden[i])
+		{
+			visible[i] = 0;
+			hiddenCount++;
+		}
+	}
+	return(hiddenCount);
+}
+
+/***********************************************************
+ *  Wait()
+ *
+ *  This method is used for blocking until the worker has
+ *  no pass left to run.
+ ***********************************************************/
+void OcclusionCuller::Wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_workDone.wait(lock, [this] { return !m_bWorkPending; });
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used for running the passes handed over
+ *  by Begin() until the culler stops.
+ ***********************************************************/
+void OcclusionCuller::WorkerLoop()
+{
+	for (;;)
+	{
+		glm::mat4 viewProjection;
+		const FrustumCuller* pBoxes = NULL;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_workReady.wait(lock, [this] { return m_bStopping || m_bWorkPending; });
+			if (m_bStopping)
+			{
+				return;
+			}
+			viewProjection = m_viewProjection;
+			pBoxes = m_pBoxes;
+		}
+
+		RunPass(viewProjection, *pBoxes);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_bWorkPending = false;
+		}
+		m_workDone.notify_all();
+	}
+}
+
+/***********************************************************
+ *  RunPass()
+ *
+ *  This method is used for drawing the occluders, building
+ *  the pyramid and testing the boxes on the calling thread.
+ ***********************************************************/
+void OcclusionCuller::RunPass(const glm::mat4& viewProjection, const FrustumCuller& boxes)
+{
+	ScopedCpuTimer timer("OcclusionPass");
+
+	m_viewProjection = viewProjection;
+	m_pBoxes = &boxes;
+
+	RasterizeOccluders();
+	BuildPyramid();
+	TestBoxes();
+}
+
+/***********************************************************
+ *  RasterizeOccluders()
+ *
+ *  This method is used for clearing the depth buffer and
+ *  drawing the occluders into it.  Only the faces wound
+ *  counterclockwise on screen are drawn, which for a closed
+ *  box cover its whole outline.  An occluder with a corner
+ *  in front of the near plane is skipped rather than
+ *  clipped, as drawing less only hides less.
+ ***********************************************************/
+void OcclusionCuller::RasterizeOccluders()
+{
+	std::vector<float>& depth = m_levels[0].depth;
+	std::fill(depth.begin(), depth.end(), 1.0f);
+	m_rasterizedCount = 0;
+
+	for (const OCCLUDER& occluder : m_occluders)
+	{
+		SCREEN_VERTEX vertices[8];
+		bool bInFront = true;
+		float minX = static_cast<float>(DEPTH_WIDTH);
+		float maxX = 0.0f;
+		float minY = static_cast<float>(DEPTH_HEIGHT);
+		float maxY = 0.0f;
+		for (int i = 0; (i < 8) && bInFront; i++)
+		{
+			glm::vec4 clip = m_viewProjection * glm::vec4(occluder.corners[i], 1.0f);
+			if ((clip.w < g_MinClipW) || (clip.z < -clip.w))
+			{
+				bInFront = false;
+				break;
+			}
+
+			float inverseW = 1.0f / clip.w;
+			vertices[i].x = (clip.x * inverseW * 0.5f + 0.5f) * DEPTH_WIDTH;
+			vertices[i].y = (clip.y * inverseW * 0.5f + 0.5f) * DEPTH_HEIGHT;
+			vertices[i].z = clip.z * inverseW * 0.5f + 0.5f;
+			minX = std::min(minX, vertices[i].x);
+			maxX = std::max(maxX, vertices[i].x);
+			minY = std::min(minY, vertices[i].y);
+			maxY = std::max(maxY, vertices[i].y);
+		}
+
+		// off screen or too small to hide anything
+		if (!bInFront || (minX >= maxX) || (minY >= maxY) ||
+			((maxX - minX) * (maxY - minY) < g_MinOccluderArea))
+		{
+			continue;
+		}
+
+		for (int t = 0; t < 12; t++)
+		{
+			RasterizeTriangle(
+				vertices[g_BoxTriangles[t][0]],
+				vertices[g_BoxTriangles[t][1]],
+				vertices[g_BoxTriangles[t][2]]);
+		}
+		m_rasterizedCount++;
+	}
+}
+
+/***********************************************************
+ *  RasterizeTriangleScalar()
+ *
+ *  This method is used for drawing one triangle a pixel at a
+ *  time.  A pixel is covered when its center is on the inner
+ *  side of all three edges, and its depth comes from the
+ *  plane of the triangle, which is linear on screen.
+ ***********************************************************/
+void OcclusionCuller::RasterizeTriangleScalar(
+	const SCREEN_VERTEX& v0,
+	const SCREEN_VERTEX& v1,
+	const SCREEN_VERTEX& v2)
+{
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+	if (area <= 0.0f)
+	{
+		return;
+	}
+
+	// pixels whose centers may be inside
+	int minX = std::max(0, static_cast<int>(std::ceil(std::min(v0.x, std::min(v1.x, v2.x)) - 0.5f)));
+	int maxX = std::min(DEPTH_WIDTH - 1, static_cast<int>(std::floor(std::max(v0.x, std::max(v1.x, v2.x)) - 0.5f)));
+	int minY = std::max(0, static_cast<int>(std::ceil(std::min(v0.y, std::min(v1.y, v2.y)) - 0.5f)));
+	int maxY = std::min(DEPTH_HEIGHT - 1, static_cast<int>(std::floor(std::max(v0.y, std::max(v1.y, v2.y)) - 0.5f)));
+	if ((minX > maxX) || (minY > maxY))
+	{
+		return;
+	}
+
+	// edge i runs from vertex i to the next, e = a * x + b * y + c
+	const SCREEN_VERTEX* v[3] = { &v0, &v1, &v2 };
+	float edgeA[3], edgeB[3], edgeC[3];
+	for (int i = 0; i < 3; i++)
+	{
+		const SCREEN_VERTEX& from = *v[i];
+		const SCREEN_VERTEX& to = *v[(i + 1) % 3];
+		edgeA[i] = from.y - to.y;
+		edgeB[i] = to.x - from.x;
+		edgeC[i] = -(edgeA[i] * from.x + edgeB[i] * from.y);
+	}
+	float depthX = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+	float depthY = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+	float depthC = v0.z - depthX * v0.x - depthY * v0.y;
+
+	std::vector<float>& depth = m_levels[0].depth;
+	for (int y = minY; y <= maxY; y++)
+	{
+		float centerY = y + 0.5f;
+		float* pRow = &depth[static_cast<size_t>(y) * DEPTH_WIDTH];
+		for (int x = minX; x <= maxX; x++)
+		{
+			float centerX = x + 0.5f;
+			bool bInside = true;
+			for (int i = 0; (i < 3) && bInside; i++)
+			{
+				bInside = (edgeA[i] * centerX + edgeB[i] * centerY + edgeC[i] >= 0.0f);
+			}
+			if (bInside)
+			{
+				float z = depthX * centerX + depthY * centerY + depthC;
+				pRow[x] = std::min(pRow[x], z);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  RasterizeTriangle()
+ *
+ *  This method is used for drawing one triangle four pixels
+ *  per step with SSE, using the same test and depth as
+ *  RasterizeTriangleScalar().  The rows start on a multiple
+ *  of four pixels, which the buffer width is too.
+ ***********************************************************/
+void OcclusionCuller::RasterizeTriangle(
+	const SCREEN_VERTEX& v0,
+	const SCREEN_VERTEX& v1,
+	const SCREEN_VERTEX& v2)
+{
+#ifdef OCCLUSIONCULLER_SSE
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+	if (area <= 0.0f)
+	{
+		return;
+	}
+
+	int minX = std::max(0, static_cast<int>(std::ceil(std::min(v0.x, std::min(v1.x, v2.x)) - 0.5f)));
+	int maxX = std::min(DEPTH_WIDTH - 1, static_cast<int>(std::floor(std::max(v0.x, std::max(v1.x, v2.x)) - 0.5f)));
+	int minY = std::max(0, static_cast<int>(std::ceil(std::min(v0.y, std::min(v1.y, v2.y)) - 0.5f)));
+	int maxY = std::min(DEPTH_HEIGHT - 1, static_cast<int>(std::floor(std::max(v0.y, std::max(v1.y, v2.y)) - 0.5f)));
+	if ((minX > maxX) || (minY > maxY))
+	{
+		return;
+	}
+	minX &= ~3;
+
+	const SCREEN_VERTEX* v[3] = { &v0, &v1, &v2 };
+	__m128 edgeStepX[3];
+	__m128 edgeRowStart[3];
+	__m128 edgeStepY[3];
+	const __m128 pixelOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+	const __m128 firstX = _mm_add_ps(_mm_set1_ps(static_cast<float>(minX)), pixelOffsets);
+	const float firstY = minY + 0.5f;
+	for (int i = 0; i < 3; i++)
+	{
+		const SCREEN_VERTEX& from = *v[i];
+		const SCREEN_VERTEX& to = *v[(i + 1) % 3];
+		float a = from.y - to.y;
+		float b = to.x - from.x;
+		float c = -(a * from.x + b * from.y);
+		edgeStepX[i] = _mm_set1_ps(a * 4.0f);
+		edgeStepY[i] = _mm_set1_ps(b);
+		edgeRowStart[i] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a), firstX), _mm_set1_ps(b * firstY + c));
+	}
+	float depthX = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+	float depthY = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+	float depthC = v0.z - depthX * v0.x - depthY * v0.y;
+	const __m128 depthStepX = _mm_set1_ps(depthX * 4.0f);
+	const __m128 depthStepY = _mm_set1_ps(depthY);
+	__m128 depthRowStart = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depthX), firstX), _mm_set1_ps(depthY * firstY + depthC));
+	const __m128 zero = _mm_setzero_ps();
+
+	std::vector<float>& depth = m_levels[0].depth;
+	for (int y = minY; y <= maxY; y++)
+	{
+		float* pRow = &depth[static_cast<size_t>(y) * DEPTH_WIDTH];
+		__m128 edge0 = edgeRowStart[0];
+		__m128 edge1 = edgeRowStart[1];
+		__m128 edge2 = edgeRowStart[2];
+		__m128 z = depthRowStart;
+		for (int x = minX; x <= maxX; x += 4)
+		{
+			__m128 inside = _mm_and_ps(
+				_mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)),
+				_mm_cmpge_ps(edge2, zero));
+			if (_mm_movemask_ps(inside) != 0)
+			{
+				__m128 old = _mm_loadu_ps(pRow + x);
+				__m128 nearest = _mm_min_ps(old, z);
+				_mm_storeu_ps(pRow + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+			}
+			edge0 = _mm_add_ps(edge0, edgeStepX[0]);
+			edge1 = _mm_add_ps(edge1, edgeStepX[1]);
+			edge2 = _mm_add_ps(edge2, edgeStepX[2]);
+			z = _mm_add_ps(z, depthStepX);
+		}
+		for (int i = 0; i < 3; i++)
+		{
+			edgeRowStart[i] = _mm_add_ps(edgeRowStart[i], edgeStepY[i]);
+		}
+		depthRowStart = _mm_add_ps(depthRowStart, depthStepY);
+	}
+#else
+	RasterizeTriangleScalar(v0, v1, v2);
+#endif
+}
+
+/***********************************************************
+ *  BuildPyramid()
+ *
+ *  This method is used for filling each level with the
+ *  farthest depth of the 2x2 texels below it.  A level one
+ *  texel wide or high folds only the other direction.
+ ***********************************************************/
+void OcclusionCuller::BuildPyramid()
+{
+	for (size_t l = 1; l < m_levels.size(); l++)
+	{
+		const DEPTH_LEVEL& below = m_levels[l - 1];
+		DEPTH_LEVEL& level = m_levels[l];
+		for (int y = 0; y < level.height; y++)
+		{
+			int y0 = std::min(y * 2, below.height - 1);
+			int y1 = std::min(y * 2 + 1, below.height - 1);
+			const float* pRow0 = &below.depth[static_cast<size_t>(y0) * below.width];
+			const float* pRow1 = &below.depth[static_cast<size_t>(y1) * below.width];
+			float* pOut = &level.depth[static_cast<size_t>(y) * level.width];
+			for (int x = 0; x < level.width; x++)
+			{
+				int x0 = std::min(x * 2, below.width - 1);
+				int x1 = std::min(x * 2 + 1, below.width - 1);
+				pOut[x] = std::max(std::max(pRow0[x0], pRow0[x1]), std::max(pRow1[x0], pRow1[x1]));
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  TestBoxes()
+ *
+ *  This method is used for flagging the boxes hidden behind
+ *  the pyramid.  The corners of a box give its rectangle on
+ *  screen and its nearest depth, and the level where the
+ *  rectangle spans at most 2x2 texels gives the farthest
+ *  occluder depth over it.  Boxes reaching the camera and
+ *  the occluders themselves are never hidden.
+ ***********************************************************/
+void OcclusionCuller::TestBoxes()
+{
+	const int boxCount = (NULL != m_pBoxes) ? m_pBoxes->GetBoxCount() : 0;
+	m_hidden.assign(boxCount, 0);
+	m_hiddenCount = 0;
+	if (0 == m_rasterizedCount)
+	{
+		return;
+	}
+
+	m_isOccluder.assign(boxCount, 0);
+	for (const OCCLUDER& occluder : m_occluders)
+	{
+		if ((occluder.boxIndex >= 0) && (occluder.boxIndex < boxCount))
+		{
+			m_isOccluder[occluder.boxIndex] = 1;
+		}
+	}
+
+	const int lastLevel = static_cast<int>(m_levels.size()) - 1;
+	for (int b = 0; b < boxCount; b++)
+	{
+		if (m_isOccluder[b])
+		{
+			continue;
+		}
+
+		glm::vec3 center;
+		glm::vec3 extent;
+		m_pBoxes->GetBox(b, center, extent);
+
+		// the corners are the center plus or minus each axis
+		glm::vec4 clipCenter = m_viewProjection * glm::vec4(center, 1.0f);
+		glm::vec4 axisX = m_viewProjection[0] * extent.x;
+		glm::vec4 axisY = m_viewProjection[1] * extent.y;
+		glm::vec4 axisZ = m_viewProjection[2] * extent.z;
+
+		bool bInFront = true;
+		float minX = 0.0f, maxX = 0.0f, minY = 0.0f, maxY = 0.0f, minZ = 0.0f;
+		for (int i = 0; (i < 8) && bInFront; i++)
+		{
+			glm::vec4 clip = clipCenter +
+				((i & 1) ? axisX : -axisX) +
+				((i & 2) ? axisY : -axisY) +
+				((i & 4) ? axisZ : -axisZ);
+			if ((clip.w < g_MinClipW) || (clip.z < -clip.w))
+			{
+				bInFront = false;
+				break;
+			}
+
+			float inverseW = 1.0f / clip.w;
+			float x = (clip.x * inverseW * 0.5f + 0.5f) * DEPTH_WIDTH;
+			float y = (clip.y * inverseW * 0.5f + 0.5f) * DEPTH_HEIGHT;
+			float z = clip.z * inverseW * 0.5f + 0.5f;
+			if (0 == i)
+			{
+				minX = maxX = x;
+				minY = maxY = y;
+				minZ = z;
+			}
+			else
+			{
+				minX = std::min(minX, x);
+				maxX = std::max(maxX, x);
+				minY = std::min(minY, y);
+				maxY = std::max(maxY, y);
+				minZ = std::min(minZ, z);
+			}
+		}
+
+		// left to the frustum test when not fully on the buffer's side of the camera
+		if (!bInFront || (maxX < 0.0f) || (maxY < 0.0f) ||
+			(minX >= DEPTH_WIDTH) || (minY >= DEPTH_HEIGHT))
+		{
+			continue;
+		}
+
+		int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+		int x1 = std::min(DEPTH_WIDTH - 1, static_cast<int>(std::floor(maxX)));
+		int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+		int y1 = std::min(DEPTH_HEIGHT - 1, static_cast<int>(std::floor(maxY)));
+
+		int level = 0;
+		while ((level < lastLevel) &&
+			(((x1 >> level) - (x0 >> level) > 1) || ((y1 >> level) - (y0 >> level) > 1)))
+		{
+			level++;
+		}
+
+		float farthest = 0.0f;
+		for (int y = (y0 >> level); y <= (y1 >> level); y++)
+		{
+			for (int x = (x0 >> level); x <= (x1 >> level); x++)
+			{
+				farthest = std::max(farthest, GetDepth(level, x, y));
+			}
+		}
+
+		if (minZ > farthest)
+		{
+			m_hidden[b] = 1;
+			m_hiddenCount++;
+		}
+	}
+}
+
+/***********************************************************
+ *  GetDepth()
+ *
+ *  This method is used for reading one texel of the pyramid,
+ *  clamped to the level.
+ ***********************************************************/
+float OcclusionCuller::GetDepth(int level, int x, int y) const
+{
+	const DEPTH_LEVEL& depthLevel = m_levels[level];
+	x = std::min(std::max(x, 0), depthLevel.width - 1);
+	y = std::min(std::max(y, 0), depthLevel.height - 1);
+	return(depthLevel.depth[static_cast<size_t>(y) * depthLevel.width + x]);
+}
+
+/***********************************************************
+ *  IsHidden()
+ *
+ *  This method is used for reading the result of one box.
+ ***********************************************************/
+bool OcclusionCuller::IsHidden(int boxIndex) const
+{
+	return((boxIndex >= 0) && (boxIndex < static_cast<int>(m_hidden.size())) && m_hidden[boxIndex]);
+}
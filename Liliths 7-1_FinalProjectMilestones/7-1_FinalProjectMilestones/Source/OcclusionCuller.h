@@ -0,0 +1,141 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.h
+// ============
+// hide the boxes behind large occluders with a software depth buffer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FrustumCuller.h"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  OcclusionCuller
+ *
+ *  This class rasterizes a few flagged occluder boxes into a
+ *  small depth buffer on the CPU, four pixels per step where
+ *  SSE is available, and reduces it to a pyramid where each
+ *  texel holds the farthest depth of the 2x2 texels below
+ *  it.  A bounding box is hidden when its nearest point is
+ *  behind the farthest depth of the pyramid texels covering
+ *  its rectangle on screen, which takes at most four reads.
+ *
+ *  The pass runs on a worker thread.  Begin() hands it the
+ *  camera of the frame and returns at once, so it overlaps
+ *  with the frustum test on the main thread and with the GPU
+ *  still drawing the previous frame, and Finish() collects
+ *  the result.  Depths are sampled at pixel centers, so an
+ *  object seen only through a gap narrower than a pixel of
+ *  the small buffer may be hidden.
+ ***********************************************************/
+class OcclusionCuller
+{
+public:
+	// constructor
+	OcclusionCuller();
+	// destructor
+	~OcclusionCuller();
+
+	// size of the depth buffer, the width a multiple of four
+	static const int DEPTH_WIDTH = 256;
+	static const int DEPTH_HEIGHT = 128;
+
+	// start and stop the worker thread, Begin() starts it as needed
+	void Start();
+	void Stop();
+
+	// forget the occluders, waits for a pass still running
+	void ClearOccluders();
+	// add the local box moved by the passed in matrix as an
+	// occluder, the box with the same index is never hidden
+	void AddOccluder(
+		int boxIndex,
+		const glm::vec3& localMin,
+		const glm::vec3& localMax,
+		const glm::mat4& worldMatrix);
+	int GetOccluderCount() const { return static_cast<int>(m_occluders.size()); }
+
+	// start testing the boxes of the culler against the occluders
+	// seen by the passed in matrix, the boxes must not change
+	// until Finish() returns
+	void Begin(const glm::mat4& viewProjection, const FrustumCuller& boxes);
+	// wait for the pass and clear the visible flag of the hidden
+	// boxes, returns how many were hidden
+	int Finish(std::vector<unsigned char>& visible);
+
+	// occluders drawn and boxes hidden by the last pass
+	int GetRasterizedCount() const { return m_rasterizedCount; }
+	int GetHiddenCount() const { return m_hiddenCount; }
+
+	// the same pass on the calling thread, for tests and timing
+	void RunPass(const glm::mat4& viewProjection, const FrustumCuller& boxes);
+	// farthest depth of one pyramid texel, 0 to 1
+	float GetDepth(int level, int x, int y) const;
+	int GetLevelCount() const { return static_cast<int>(m_levels.size()); }
+	// whether one box of the last pass was hidden
+	bool IsHidden(int boxIndex) const;
+
+private:
+	struct OCCLUDER
+	{
+		int boxIndex;
+		glm::vec3 corners[8];
+	};
+
+	struct DEPTH_LEVEL
+	{
+		int width;
+		int height;
+		std::vector<float> depth;
+	};
+
+	// screen position in pixels and depth of one box corner
+	struct SCREEN_VERTEX
+	{
+		float x;
+		float y;
+		float z;
+	};
+
+	std::vector<OCCLUDER> m_occluders;
+	// level 0 is the rasterized buffer
+	std::vector<DEPTH_LEVEL> m_levels;
+	// per box, 1 when hidden
+	std::vector<unsigned char> m_hidden;
+	std::vector<unsigned char> m_isOccluder;
+	int m_rasterizedCount;
+	int m_hiddenCount;
+
+	// the pass handed to the worker
+	glm::mat4 m_viewProjection;
+	const FrustumCuller* m_pBoxes;
+
+	std::thread m_worker;
+	std::mutex m_mutex;
+	std::condition_variable m_workReady;
+	std::condition_variable m_workDone;
+	bool m_bWorkPending;
+	bool m_bStopping;
+
+	// run passes until the culler stops
+	void WorkerLoop();
+	// wait until no pass is running
+	void Wait();
+
+	// draw the front faces of every occluder in front of the camera
+	void RasterizeOccluders();
+	// draw one triangle keeping the nearest depth
+	void RasterizeTriangle(const SCREEN_VERTEX& v0, const SCREEN_VERTEX& v1, const SCREEN_VERTEX& v2);
+	void RasterizeTriangleScalar(const SCREEN_VERTEX& v0, const SCREEN_VERTEX& v1, const SCREEN_VERTEX& v2);
+	// fill the levels above 0 from the ones below
+	void BuildPyramid();
+	// flag every box behind the pyramid
+	void TestBoxes();
+};
@@ -0,0 +1,277 @@
+///////////////////////////////////////////////////////////////////////////////
+// offscreencontext.cpp
+// ============
+// OpenGL context without a display window, for headless runs
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OffscreenContext.h"
+
+#include <iostream>
+#include <cstring>
+
+#if defined(__linux__)
+#include <EGL/eglext.h>
+#endif
+
+namespace
+{
+	// newest core versions tried before the requested one
+	const int g_PreferredVersions[][2] = { { 4, 6 }, { 4, 5 } };
+
+#if defined(__linux__)
+	/***********************************************************
+	 *  HasExtension()
+	 *
+	 *  Look for a whole word in an EGL extension string.
+	 ***********************************************************/
+	bool HasExtension(const char* extensions, const char* name)
+	{
+		if ((NULL == extensions) || (NULL == name))
+		{
+			return(false);
+		}
+
+		size_t length = strlen(name);
+		const char* found = strstr(extensions, name);
+		while (NULL != found)
+		{
+			bool bStart = (found == extensions) || (found[-1] == ' ');
+			bool bEnd = (found[length] == ' ') || (found[length] == '\0');
+			if (bStart && bEnd)
+			{
+				return(true);
+			}
+			found = strstr(found + length, name);
+		}
+		return(false);
+	}
+
+	/***********************************************************
+	 *  OpenDisplay()
+	 *
+	 *  Open the surfaceless Mesa platform when the client
+	 *  supports it, otherwise the default display.
+	 ***********************************************************/
+	EGLDisplay OpenDisplay()
+	{
+		const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+		if (HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+		{
+			PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+				reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+					eglGetProcAddress("eglGetPlatformDisplayEXT"));
+			if (NULL != getPlatformDisplay)
+			{
+				EGLDisplay display = getPlatformDisplay(
+					EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+				if (EGL_NO_DISPLAY != display)
+				{
+					return(display);
+				}
+			}
+		}
+		return(eglGetDisplay(EGL_DEFAULT_DISPLAY));
+	}
+#endif
+}
+
+/***********************************************************
+ *  OffscreenContext()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OffscreenContext::OffscreenContext()
+{
+	m_bCreated = false;
+#if defined(__linux__)
+	m_display = EGL_NO_DISPLAY;
+	m_context = EGL_NO_CONTEXT;
+#else
+	m_pWindow = NULL;
+#endif
+}
+
+/***********************************************************
+ *  ~OffscreenContext()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+OffscreenContext::~OffscreenContext()
+{
+	Destroy();
+}
+
+#if defined(__linux__)
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating a core profile context
+ *  through EGL and making it current with no surface.  The
+ *  newest known versions are tried first, down to the
+ *  passed in one.
+ ***********************************************************/
+bool OffscreenContext::Create(int majorVersion, int minorVersion)
+{
+	EGLint eglMajor = 0;
+	EGLint eglMinor = 0;
+
+	Destroy();
+
+	m_display = OpenDisplay();
+	if ((EGL_NO_DISPLAY == m_display) ||
+		!eglInitialize(m_display, &eglMajor, &eglMinor))
+	{
+		std::cout << "Failed to initialize EGL" << std::endl;
+		m_display = EGL_NO_DISPLAY;
+		return(false);
+	}
+
+	const char* extensions = eglQueryString(m_display, EGL_EXTENSIONS);
+	if (!HasExtension(extensions, "EGL_KHR_surfaceless_context") ||
+		!HasExtension(extensions, "EGL_KHR_create_context") ||
+		!eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cout << "EGL " << eglMajor << "." << eglMinor
+			<< " cannot create a surfaceless OpenGL context" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	// any config will do when the context never gets a surface
+	EGLConfig config = EGL_NO_CONFIG_KHR;
+	if (!HasExtension(extensions, "EGL_KHR_no_config_context"))
+	{
+		const EGLint configAttributes[] = {
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_NONE };
+		EGLint configCount = 0;
+		if (!eglChooseConfig(m_display, configAttributes, &config, 1, &configCount) ||
+			(configCount < 1))
+		{
+			std::cout << "No EGL config supports OpenGL" << std::endl;
+			Destroy();
+			return(false);
+		}
+	}
+
+	int versionCount = static_cast<int>(sizeof(g_PreferredVersions) / sizeof(g_PreferredVersions[0]));
+	for (int i = 0; (i <= versionCount) && (EGL_NO_CONTEXT == m_context); i++)
+	{
+		int major = (i < versionCount) ? g_PreferredVersions[i][0] : majorVersion;
+		int minor = (i < versionCount) ? g_PreferredVersions[i][1] : minorVersion;
+		if ((major < majorVersion) || ((major == majorVersion) && (minor < minorVersion)))
+		{
+			continue;
+		}
+
+		const EGLint contextAttributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, major,
+			EGL_CONTEXT_MINOR_VERSION, minor,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE };
+		m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, contextAttributes);
+	}
+
+	if ((EGL_NO_CONTEXT == m_context) ||
+		!eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context))
+	{
+		std::cout << "Failed to create an OpenGL " << majorVersion << "." << minorVersion
+			<< " core context, EGL error 0x" << std::hex << eglGetError() << std::dec << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	m_bCreated = true;
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for releasing the context and the
+ *  EGL display.
+ ***********************************************************/
+void OffscreenContext::Destroy()
+{
+	if (EGL_NO_DISPLAY != m_display)
+	{
+		eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (EGL_NO_CONTEXT != m_context)
+		{
+			eglDestroyContext(m_display, m_context);
+		}
+		eglTerminate(m_display);
+	}
+	m_display = EGL_NO_DISPLAY;
+	m_context = EGL_NO_CONTEXT;
+	m_bCreated = false;
+}
+#else
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating a core profile context
+ *  in a hidden GLFW window, trying the newest known
+ *  versions first, down to the passed in one.
+ ***********************************************************/
+bool OffscreenContext::Create(int majorVersion, int minorVersion)
+{
+	Destroy();
+
+	if (!glfwInit())
+	{
+		std::cout << "Failed to initialize GLFW" << std::endl;
+		return(false);
+	}
+
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+	int versionCount = static_cast<int>(sizeof(g_PreferredVersions) / sizeof(g_PreferredVersions[0]));
+	for (int i = 0; (i <= versionCount) && (NULL == m_pWindow); i++)
+	{
+		int major = (i < versionCount) ? g_PreferredVersions[i][0] : majorVersion;
+		int minor = (i < versionCount) ? g_PreferredVersions[i][1] : minorVersion;
+		if ((major < majorVersion) || ((major == majorVersion) && (minor < minorVersion)))
+		{
+			continue;
+		}
+
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
+		m_pWindow = glfwCreateWindow(1, 1, "offscreen", NULL, NULL);
+	}
+
+	if (NULL == m_pWindow)
+	{
+		std::cout << "Failed to create an OpenGL " << majorVersion << "." << minorVersion
+			<< " core context" << std::endl;
+		glfwTerminate();
+		return(false);
+	}
+
+	glfwMakeContextCurrent(m_pWindow);
+	m_bCreated = true;
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for releasing the hidden window.
+ ***********************************************************/
+void OffscreenContext::Destroy()
+{
+	if (NULL != m_pWindow)
+	{
+		glfwDestroyWindow(m_pWindow);
+		glfwTerminate();
+		m_pWindow = NULL;
+	}
+	m_bCreated = false;
+}
+#endif
@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////////////
+// offscreencontext.h
+// ============
+// OpenGL context without a display window, for headless runs
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#if defined(__linux__)
+#include <EGL/egl.h>
+#else
+#include "GLFW/glfw3.h"
+#endif
+
+/***********************************************************
+ *  OffscreenContext
+ *
+ *  This class makes an OpenGL core context current without
+ *  opening a window.  On Linux it uses EGL, preferring the
+ *  Mesa surfaceless platform so it also runs on llvmpipe
+ *  with no display server.  Elsewhere it falls back to a
+ *  hidden GLFW window.  Nothing is ever presented, so the
+ *  caller renders into a RenderTarget instead of the
+ *  default framebuffer.
+ ***********************************************************/
+class OffscreenContext
+{
+public:
+	// constructor
+	OffscreenContext();
+	// destructor
+	~OffscreenContext();
+
+	// create a core context of at least the passed in version
+	bool Create(int majorVersion, int minorVersion);
+	// release the context
+	void Destroy();
+
+	bool IsCreated() const { return m_bCreated; }
+
+private:
+	bool m_bCreated;
+#if defined(__linux__)
+	EGLDisplay m_display;
+	EGLContext m_context;
+#else
+	GLFWwindow* m_pWindow;
+#endif
+};
@@ -0,0 +1,474 @@
+///////////////////////////////////////////////////////////////////////////////
+// primitivemeshes.cpp
+// ============
+// CPU side geometry and GPU buffers for the basic shape primitives
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PrimitiveMeshes.h"
+#include "MeshOptimizer.h"
+
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// tessellation of the curved primitives at each level of
+	// detail, level 0 matches the ShapeMeshes primitives
+	const int g_CylinderSlices[PrimitiveMeshes::LOD_LEVEL_COUNT] = { 36, 20, 12, 8 };
+	const int g_SphereSlices[PrimitiveMeshes::LOD_LEVEL_COUNT] = { 36, 24, 14, 8 };
+	const int g_SphereStacks[PrimitiveMeshes::LOD_LEVEL_COUNT] = { 18, 12, 7, 4 };
+
+	const float g_Pi = 3.14159265358979f;
+
+	// append one quad of the geometry as two triangles
+	void AddQuad(
+		PrimitiveMeshes::MESH_GEOMETRY& geometry,
+		GLuint a, GLuint b, GLuint c, GLuint d)
+	{
+		geometry.indices.push_back(a);
+		geometry.indices.push_back(b);
+		geometry.indices.push_back(c);
+		geometry.indices.push_back(a);
+		geometry.indices.push_back(c);
+		geometry.indices.push_back(d);
+	}
+
+	// append one vertex to the geometry and return its index
+	GLuint AddVertex(
+		PrimitiveMeshes::MESH_GEOMETRY& geometry,
+		glm::vec3 position,
+		glm::vec3 normal,
+		glm::vec2 uv)
+	{
+		PrimitiveMeshes::MESH_VERTEX vertex;
+		vertex.position = position;
+		vertex.normal = normal;
+		vertex.uv = uv;
+		geometry.vertices.push_back(vertex);
+		return(static_cast<GLuint>(geometry.vertices.size() - 1));
+	}
+}
+
+/***********************************************************
+ *  PrimitiveMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+PrimitiveMeshes::PrimitiveMeshes()
+{
+	for (int i = 0; i < PRIMITIVE_COUNT; i++)
+	{
+		for (int level = 0; level < LOD_LEVEL_COUNT; level++)
+		{
+			m_meshes[i][level].vao = 0;
+			m_meshes[i][level].vbo = 0;
+			m_meshes[i][level].ibo = 0;
+			m_meshes[i][level].indexCount = 0;
+			m_meshes[i][level].positionMin = glm::vec3(0.0f);
+			m_meshes[i][level].positionExtent = glm::vec3(1.0f);
+		}
+	}
+	m_vertexFormat = VERTEX_FORMAT_FLOAT;
+}
+
+/***********************************************************
+ *  ~PrimitiveMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+PrimitiveMeshes::~PrimitiveMeshes()
+{
+	DestroyMeshes();
+}
+
+/***********************************************************
+ *  BuildBox()
+ *
+ *  This method is used for generating a 1x1x1 box centered
+ *  on the origin, with each face mapped to the full texture.
+ ***********************************************************/
+void PrimitiveMeshes::BuildBox(MESH_GEOMETRY& geometry)
+{
+	// outward normal, then the face's U and V directions
+	const glm::vec3 faces[6][3] =
+	{
+		{ glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) },
+		{ glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) }
+	};
+
+	geometry.vertices.clear();
+	geometry.indices.clear();
+
+	for (int face = 0; face < 6; face++)
+	{
+		const glm::vec3& n = faces[face][0];
+		const glm::vec3& u = faces[face][1];
+		const glm::vec3& v = faces[face][2];
+		glm::vec3 center = n * 0.5f;
+
+		GLuint a = AddVertex(geometry, center - u * 0.5f - v * 0.5f, n, glm::vec2(0.0f, 0.0f));
+		GLuint b = AddVertex(geometry, center + u * 0.5f - v * 0.5f, n, glm::vec2(1.0f, 0.0f));
+		GLuint c = AddVertex(geometry, center + u * 0.5f + v * 0.5f, n, glm::vec2(1.0f, 1.0f));
+		GLuint d = AddVertex(geometry, center - u * 0.5f + v * 0.5f, n, glm::vec2(0.0f, 1.0f));
+		AddQuad(geometry, a, b, c, d);
+	}
+}
+
+/***********************************************************
+ *  BuildPlane()
+ *
+ *  This method is used for generating a plane on the XZ axes
+ *  spanning -1 to 1, facing up.
+ ***********************************************************/
+void PrimitiveMeshes::BuildPlane(MESH_GEOMETRY& geometry)
+{
+	const glm::vec3 up(0.0f, 1.0f, 0.0f);
+
+	geometry.vertices.clear();
+	geometry.indices.clear();
+
+	GLuint a = AddVertex(geometry, glm::vec3(-1.0f, 0.0f, 1.0f), up, glm::vec2(0.0f, 0.0f));
+	GLuint b = AddVertex(geometry, glm::vec3(1.0f, 0.0f, 1.0f), up, glm::vec2(1.0f, 0.0f));
+	GLuint c = AddVertex(geometry, glm::vec3(1.0f, 0.0f, -1.0f), up, glm::vec2(1.0f, 1.0f));
+	GLuint d = AddVertex(geometry, glm::vec3(-1.0f, 0.0f, -1.0f), up, glm::vec2(0.0f, 1.0f));
+	AddQuad(geometry, a, b, c, d);
+}
+
+/***********************************************************
+ *  BuildCylinder()
+ *
+ *  This method is used for generating a cylinder of radius 1
+ *  whose base sits on the origin and whose top is at Y = 1,
+ *  with capped ends.
+ ***********************************************************/
+void PrimitiveMeshes::BuildCylinder(MESH_GEOMETRY& geometry, int slices)
+{
+	geometry.vertices.clear();
+	geometry.indices.clear();
+
+	if (slices < 3)
+	{
+		slices = 3;
+	}
+
+	// sides, the seam is duplicated so U runs cleanly from 0 to 1
+	GLuint sideStart = static_cast<GLuint>(geometry.vertices.size());
+	for (int i = 0; i <= slices; i++)
+	{
+		float u = static_cast<float>(i) / static_cast<float>(slices);
+		float angle = u * 2.0f * g_Pi;
+		glm::vec3 normal(std::cos(angle), 0.0f, -std::sin(angle));
+
+		AddVertex(geometry, glm::vec3(normal.x, 0.0f, normal.z), normal, glm::vec2(u, 0.0f));
+		AddVertex(geometry, glm::vec3(normal.x, 1.0f, normal.z), normal, glm::vec2(u, 1.0f));
+	}
+	for (int i = 0; i < slices; i++)
+	{
+		GLuint bottom0 = sideStart + i * 2;
+		GLuint top0 = bottom0 + 1;
+		GLuint bottom1 = bottom0 + 2;
+		GLuint top1 = bottom0 + 3;
+		AddQuad(geometry, bottom0, bottom1, top1, top0);
+	}
+
+	// top and bottom caps as triangle fans around a center vertex
+	for (int cap = 0; cap < 2; cap++)
+	{
+		float y = (cap == 0) ? 1.0f : 0.0f;
+		glm::vec3 normal(0.0f, (cap == 0) ? 1.0f : -1.0f, 0.0f);
+		GLuint center = AddVertex(geometry, glm::vec3(0.0f, y, 0.0f), normal, glm::vec2(0.5f, 0.5f));
+
+		for (int i = 0; i <= slices; i++)
+		{
+			float angle = static_cast<float>(i) / static_cast<float>(slices) * 2.0f * g_Pi;
+			float x = std::cos(angle);
+			float z = -std::sin(angle);
+			AddVertex(geometry, glm::vec3(x, y, z), normal,
+				glm::vec2(0.5f + x * 0.5f, 0.5f - z * 0.5f));
+		}
+		for (int i = 0; i < slices; i++)
+		{
+			GLuint rim0 = center + 1 + i;
+			GLuint rim1 = rim0 + 1;
+			geometry.indices.push_back(center);
+			// keep the winding counter-clockwise when seen from outside
+			geometry.indices.push_back((cap == 0) ? rim0 : rim1);
+			geometry.indices.push_back((cap == 0) ? rim1 : rim0);
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildSphere()
+ *
+ *  This method is used for generating a UV sphere of
+ *  radius 1 centered on the origin.
+ ***********************************************************/
+void PrimitiveMeshes::BuildSphere(MESH_GEOMETRY& geometry, int slices, int stacks)
+{
+	geometry.vertices.clear();
+	geometry.indices.clear();
+
+	if (slices < 3)
+	{
+		slices = 3;
+	}
+	if (stacks < 2)
+	{
+		stacks = 2;
+	}
+
+	for (int stack = 0; stack <= stacks; stack++)
+	{
+		float v = static_cast<float>(stack) / static_cast<float>(stacks);
+		float phi = v * g_Pi;
+		float y = -std::cos(phi);
+		float ring = std::sin(phi);
+
+		for (int slice = 0; slice <= slices; slice++)
+		{
+			float u = static_cast<float>(slice) / static_cast<float>(slices);
+			float theta = u * 2.0f * g_Pi;
+			glm::vec3 normal(ring * std::cos(theta), y, -ring * std::sin(theta));
+
+			AddVertex(geometry, normal, normal, glm::vec2(u, v));
+		}
+	}
+
+	GLuint rowLength = static_cast<GLuint>(slices + 1);
+	for (int stack = 0; stack < stacks; stack++)
+	{
+		for (int slice = 0; slice < slices; slice++)
+		{
+			GLuint a = stack * rowLength + slice;
+			GLuint b = a + 1;
+			GLuint c = b + rowLength;
+			GLuint d = a + rowLength;
+			AddQuad(geometry, a, b, c, d);
+		}
+	}
+}
+
+/***********************************************************
+ *  GetLevelCount()
+ *
+ *  This method is used for getting how many levels of
+ *  detail the passed in primitive is built at.
+ ***********************************************************/
+int PrimitiveMeshes::GetLevelCount(int primitive)
+{
+	if ((PRIMITIVE_CYLINDER == primitive) || (PRIMITIVE_SPHERE == primitive))
+	{
+		return(LOD_LEVEL_COUNT);
+	}
+	return(1);
+}
+
+/***********************************************************
+ *  BuildPrimitive()
+ *
+ *  This method is used for generating the passed in
+ *  primitive at a level of detail, 0 being the detail of
+ *  the ShapeMeshes primitives.
+ ***********************************************************/
+void PrimitiveMeshes::BuildPrimitive(int primitive, MESH_GEOMETRY& geometry, int level)
+{
+	if ((level < 0) || (level >= GetLevelCount(primitive)))
+	{
+		level = 0;
+	}
+
+	switch (primitive)
+	{
+	case PRIMITIVE_BOX:
+		BuildBox(geometry);
+		break;
+	case PRIMITIVE_CYLINDER:
+		BuildCylinder(geometry, g_CylinderSlices[level]);
+		break;
+	case PRIMITIVE_SPHERE:
+		BuildSphere(geometry, g_SphereSlices[level], g_SphereStacks[level]);
+		break;
+	case PRIMITIVE_PLANE:
+		BuildPlane(geometry);
+		break;
+	}
+}
+
+/***********************************************************
+ *  GetLocalBounds()
+ *
+ *  This method is used for measuring the box around the
+ *  vertices of one primitive.  The coarser levels sit
+ *  inside the box of level 0.
+ ***********************************************************/
+void PrimitiveMeshes::GetLocalBounds(int primitive, glm::vec3& boundsMin, glm::vec3& boundsMax)
+{
+	MESH_GEOMETRY geometry;
+	BuildPrimitive(primitive, geometry);
+	MeshOptimizer::GetBounds(geometry, boundsMin, boundsMax);
+}
+
+/***********************************************************
+ *  SetVertexAttributes()
+ *
+ *  This method is used for pointing attribute locations 0, 1
+ *  and 2 of the bound vertex array object at the bound
+ *  vertex buffer.  The packed positions and normals are read
+ *  as normalized values, leaving the shader to scale them
+ *  into the mesh box and to unfold the octahedral normal.
+ ***********************************************************/
+void PrimitiveMeshes::SetVertexAttributes(VERTEX_FORMAT format)
+{
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+
+	if (VERTEX_FORMAT_PACKED == format)
+	{
+		const GLsizei stride = sizeof(PACKED_VERTEX);
+		glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+			reinterpret_cast<void*>(offsetof(PACKED_VERTEX, position)));
+		glVertexAttribPointer(1, 2, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+			reinterpret_cast<void*>(offsetof(PACKED_VERTEX, normal)));
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+			reinterpret_cast<void*>(offsetof(PACKED_VERTEX, uv)));
+		return;
+	}
+
+	const GLsizei stride = sizeof(MESH_VERTEX);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride,
+		reinterpret_cast<void*>(offsetof(MESH_VERTEX, position)));
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
+		reinterpret_cast<void*>(offsetof(MESH_VERTEX, normal)));
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
+		reinterpret_cast<void*>(offsetof(MESH_VERTEX, uv)));
+}
+
+/***********************************************************
+ *  LoadMeshes()
+ *
+ *  This method is used for generating every level of every
+ *  primitive, reordering it for the vertex cache and fetch,
+ *  and uploading each into its own vertex array object.
+ *  Render paths share the meshes, so a second call keeps the
+ *  ones already loaded.
+ ***********************************************************/
+void PrimitiveMeshes::LoadMeshes()
+{
+	if (0 != m_meshes[0][0].vao)
+	{
+		return;
+	}
+
+	float transformsBefore = 0.0f;
+	float transformsAfter = 0.0f;
+	int triangleCount = 0;
+	for (int i = 0; i < PRIMITIVE_COUNT; i++)
+	{
+		for (int level = 0; level < GetLevelCount(i); level++)
+		{
+			MESH_GEOMETRY& geometry = m_geometry[i][level];
+			BuildPrimitive(i, geometry, level);
+
+			int triangles = static_cast<int>(geometry.indices.size() / 3);
+			transformsBefore += MeshOptimizer::GetTransformsPerTriangle(geometry.indices) * triangles;
+			MeshOptimizer::Optimize(geometry);
+			transformsAfter += MeshOptimizer::GetTransformsPerTriangle(geometry.indices) * triangles;
+			triangleCount += triangles;
+
+			UploadMesh(geometry, m_meshes[i][level]);
+		}
+	}
+
+	std::cout << "Primitive meshes transform " << transformsBefore / triangleCount
+		<< " vertices per triangle, " << transformsAfter / triangleCount
+		<< " after reordering" << std::endl;
+}
+
+/***********************************************************
+ *  UploadMesh()
+ *
+ *  This method is used for creating the vertex array object
+ *  and buffers of one mesh in the selected vertex format.
+ *  Attribute locations 0, 1 and 2 match the ShapeMeshes
+ *  layout used by the shaders.
+ ***********************************************************/
+void PrimitiveMeshes::UploadMesh(const MESH_GEOMETRY& geometry, GPU_MESH& mesh)
+{
+	glGenVertexArrays(1, &mesh.vao);
+	glBindVertexArray(mesh.vao);
+
+	glGenBuffers(1, &mesh.vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+	if (VERTEX_FORMAT_PACKED == m_vertexFormat)
+	{
+		glm::vec3 boundsMax;
+		std::vector<PACKED_VERTEX> packed;
+		MeshOptimizer::GetBounds(geometry, mesh.positionMin, boundsMax);
+		MeshOptimizer::PackVertices(geometry, mesh.positionMin, boundsMax, packed);
+		mesh.positionExtent = boundsMax - mesh.positionMin;
+		glBufferData(GL_ARRAY_BUFFER,
+			packed.size() * sizeof(PACKED_VERTEX),
+			packed.data(),
+			GL_STATIC_DRAW);
+	}
+	else
+	{
+		mesh.positionMin = glm::vec3(0.0f);
+		mesh.positionExtent = glm::vec3(1.0f);
+		glBufferData(GL_ARRAY_BUFFER,
+			geometry.vertices.size() * sizeof(MESH_VERTEX),
+			geometry.vertices.data(),
+			GL_STATIC_DRAW);
+	}
+
+	glGenBuffers(1, &mesh.ibo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+		geometry.indices.size() * sizeof(GLuint),
+		geometry.indices.data(),
+		GL_STATIC_DRAW);
+
+	SetVertexAttributes(m_vertexFormat);
+
+	glBindVertexArray(0);
+
+	mesh.indexCount = static_cast<GLsizei>(geometry.indices.size());
+}
+
+/***********************************************************
+ *  DestroyMeshes()
+ *
+ *  This method is used for freeing the GPU buffers of every
+ *  loaded primitive.
+ ***********************************************************/
+void PrimitiveMeshes::DestroyMeshes()
+{
+	for (int i = 0; i < PRIMITIVE_COUNT; i++)
+	{
+		for (int level = 0; level < LOD_LEVEL_COUNT; level++)
+		{
+			GPU_MESH& mesh = m_meshes[i][level];
+			if (0 != mesh.vao)
+			{
+				glDeleteVertexArrays(1, &mesh.vao);
+				glDeleteBuffers(1, &mesh.vbo);
+				glDeleteBuffers(1, &mesh.ibo);
+			}
+			mesh.vao = 0;
+			mesh.vbo = 0;
+			mesh.ibo = 0;
+			mesh.indexCount = 0;
+			mesh.positionMin = glm::vec3(0.0f);
+			mesh.positionExtent = glm::vec3(1.0f);
+		}
+	}
+}
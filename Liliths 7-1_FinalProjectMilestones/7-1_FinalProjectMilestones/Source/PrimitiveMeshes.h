@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+// primitivemeshes.h
+// ============
+// CPU side geometry and GPU buffers for the basic shape primitives
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  PrimitiveMeshes
+ *
+ *  This class generates the box, cylinder, sphere and plane
+ *  primitives with the same dimensions and vertex layout as
+ *  ShapeMeshes (position, normal, texture coordinate), but
+ *  keeps both the CPU geometry and the GPU buffers available
+ *  so that other render paths can attach extra attributes.
+ *
+ *  The cylinder and sphere are also built at coarser levels
+ *  of detail, level 0 being the full tessellation, for
+ *  objects that only cover a few pixels.  The box and plane
+ *  have a single level.
+ *
+ *  Loaded meshes are reordered by MeshOptimizer, and can be
+ *  uploaded in a packed 12 byte vertex format instead of the
+ *  32 byte float one.  The vertex shaders of the instanced
+ *  paths decode both, see SetVertexAttributes().
+ ***********************************************************/
+class PrimitiveMeshes
+{
+public:
+	// constructor
+	PrimitiveMeshes();
+	// destructor
+	~PrimitiveMeshes();
+
+	// primitive types, same order as SceneManager::SHAPE_MESH
+	enum PRIMITIVE
+	{
+		PRIMITIVE_BOX,
+		PRIMITIVE_CYLINDER,
+		PRIMITIVE_SPHERE,
+		PRIMITIVE_PLANE,
+		PRIMITIVE_COUNT
+	};
+
+	// most levels of detail of any primitive
+	enum
+	{
+		LOD_LEVEL_COUNT = 4
+	};
+
+	struct MESH_VERTEX
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 uv;
+	};
+
+	// vertex layouts the meshes can be uploaded in
+	enum VERTEX_FORMAT
+	{
+		// MESH_VERTEX as is
+		VERTEX_FORMAT_FLOAT,
+		// PACKED_VERTEX
+		VERTEX_FORMAT_PACKED
+	};
+
+	struct PACKED_VERTEX
+	{
+		// fraction of the mesh box, decoded with the mesh bounds
+		GLushort position[3];
+		// octahedral normal, 0 to 254 for -1 to 1
+		GLubyte normal[2];
+		// half floats
+		GLushort uv[2];
+	};
+
+	struct MESH_GEOMETRY
+	{
+		std::vector<MESH_VERTEX> vertices;
+		std::vector<GLuint> indices;
+	};
+
+	struct GPU_MESH
+	{
+		GLuint vao;
+		GLuint vbo;
+		GLuint ibo;
+		GLsizei indexCount;
+		// position = positionMin + attribute * positionExtent, which
+		// is 0 and 1 for the float format
+		glm::vec3 positionMin;
+		glm::vec3 positionExtent;
+	};
+
+	// generators, unit sized like the ShapeMeshes primitives
+	static void BuildBox(MESH_GEOMETRY& geometry);
+	static void BuildPlane(MESH_GEOMETRY& geometry);
+	static void BuildCylinder(MESH_GEOMETRY& geometry, int slices);
+	static void BuildSphere(MESH_GEOMETRY& geometry, int slices, int stacks);
+	// levels of detail the passed in primitive is built at
+	static int GetLevelCount(int primitive);
+	// generate one primitive at a level of detail
+	static void BuildPrimitive(int primitive, MESH_GEOMETRY& geometry, int level = 0);
+	// local box around one primitive, no GL needed
+	static void GetLocalBounds(int primitive, glm::vec3& boundsMin, glm::vec3& boundsMax);
+
+	// select the vertex layout of the uploads, before LoadMeshes()
+	void SetVertexFormat(VERTEX_FORMAT format) { m_vertexFormat = format; }
+	VERTEX_FORMAT GetVertexFormat() const { return m_vertexFormat; }
+	// point attributes 0-2 of the bound VAO at the bound vertex buffer
+	static void SetVertexAttributes(VERTEX_FORMAT format);
+
+	// generate every level of every primitive and upload each into
+	// its own VAO, does nothing when already loaded
+	void LoadMeshes();
+	// free the GPU buffers
+	void DestroyMeshes();
+
+	const MESH_GEOMETRY& GetGeometry(int primitive, int level = 0) const { return m_geometry[primitive][level]; }
+	const GPU_MESH& GetMesh(int primitive, int level = 0) const { return m_meshes[primitive][level]; }
+
+private:
+	// levels past the level count of a primitive stay empty
+	MESH_GEOMETRY m_geometry[PRIMITIVE_COUNT][LOD_LEVEL_COUNT];
+	GPU_MESH m_meshes[PRIMITIVE_COUNT][LOD_LEVEL_COUNT];
+	VERTEX_FORMAT m_vertexFormat;
+
+	// upload one geometry into a new VAO with attributes 0-2
+	void UploadMesh(const MESH_GEOMETRY& geometry, GPU_MESH& mesh);
+};
@@ -0,0 +1,465 @@
+///////////////////////////////////////////////////////////////////////////////
+// profiler.cpp
+// ============
+// CPU and GPU timing of named scopes, with Chrome trace export
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+	// samples kept per scope for the rolling statistics
+	const int g_HistorySize = 120;
+	// most GPU passes waiting for results, older ones are dropped
+	const size_t g_MaxPendingQueries = 256;
+	// most events one capture keeps
+	const size_t g_MaxTraceEvents = 1 << 20;
+	// trace thread the GPU passes are drawn on
+	const int g_GpuThreadIndex = -1;
+}
+
+Profiler* Profiler::s_pActive = NULL;
+
+/***********************************************************
+ *  Profiler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Profiler::Profiler()
+{
+	m_startTime = Clock::now();
+	m_frameStart = m_startTime;
+	m_bCapturing = false;
+	m_gpuScopeDepth = 0;
+	m_droppedQueries = 0;
+
+	// the profiler is made on the main thread, which gets the first track
+	m_threads.push_back(std::this_thread::get_id());
+}
+
+/***********************************************************
+ *  ~Profiler()
+ *
+ *  The destructor for the class, ReleaseQueries() has to
+ *  be called first while the GL context still exists.
+ ***********************************************************/
+Profiler::~Profiler()
+{
+	if (s_pActive == this)
+	{
+		s_pActive = NULL;
+	}
+}
+
+/***********************************************************
+ *  ToMicroseconds()
+ *
+ *  This method is used for converting a clock time into
+ *  microseconds since the profiler was created.
+ ***********************************************************/
+double Profiler::ToMicroseconds(Clock::time_point time) const
+{
+	std::chrono::duration<double, std::micro> elapsed = time - m_startTime;
+	return(elapsed.count());
+}
+
+/***********************************************************
+ *  FindThreadIndex()
+ *
+ *  This method is used for numbering the threads in the
+ *  order they first report a scope.  The mutex must be
+ *  held.
+ ***********************************************************/
+int Profiler::FindThreadIndex(std::thread::id threadID)
+{
+	for (size_t i = 0; i < m_threads.size(); i++)
+	{
+		if (m_threads[i] == threadID)
+		{
+			return(static_cast<int>(i));
+		}
+	}
+	m_threads.push_back(threadID);
+	return(static_cast<int>(m_threads.size()) - 1);
+}
+
+/***********************************************************
+ *  AddSample()
+ *
+ *  This method is used for adding one timing to the
+ *  history of its scope, and to the capture if one is
+ *  running.
+ ***********************************************************/
+void Profiler::AddSample(const char* name, bool bGpu, double startMicroseconds, double durationMicroseconds)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	SCOPE_HISTORY* pHistory = NULL;
+	for (SCOPE_HISTORY& history : m_scopes)
+	{
+		if ((history.bGpu == bGpu) &&
+			((history.name == name) || (strcmp(history.name, name) == 0)))
+		{
+			pHistory = &history;
+			break;
+		}
+	}
+	if (NULL == pHistory)
+	{
+		SCOPE_HISTORY history;
+		history.name = name;
+		history.bGpu = bGpu;
+		history.samples.resize(g_HistorySize, 0.0);
+		history.nextSample = 0;
+		history.sampleCount = 0;
+		history.last = 0.0;
+		m_scopes.push_back(history);
+		pHistory = &m_scopes.back();
+	}
+
+	double milliseconds = durationMicroseconds / 1000.0;
+	pHistory->samples[pHistory->nextSample] = milliseconds;
+	pHistory->nextSample = (pHistory->nextSample + 1) % g_HistorySize;
+	pHistory->sampleCount = std::min(pHistory->sampleCount + 1, g_HistorySize);
+	pHistory->last = milliseconds;
+
+	if (m_bCapturing && (m_events.size() < g_MaxTraceEvents))
+	{
+		TRACE_EVENT event;
+		event.name = name;
+		event.bGpu = bGpu;
+		event.threadIndex = bGpu ? g_GpuThreadIndex : FindThreadIndex(std::this_thread::get_id());
+		event.startMicroseconds = startMicroseconds;
+		event.durationMicroseconds = durationMicroseconds;
+		m_events.push_back(event);
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a frame, reading the
+ *  GPU passes of earlier frames that have finished.
+ ***********************************************************/
+void Profiler::BeginFrame()
+{
+	CollectQueries();
+	m_frameStart = Clock::now();
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for recording the whole frame as a
+ *  scope of its own.
+ ***********************************************************/
+void Profiler::EndFrame()
+{
+	AddCpuScope("Frame", m_frameStart, Clock::now());
+}
+
+/***********************************************************
+ *  CollectQueries()
+ *
+ *  This method is used for reading the finished queries
+ *  without waiting on the GPU.  Queries finish in the
+ *  order they were issued, so reading stops at the first
+ *  one that is not available yet.
+ ***********************************************************/
+void Profiler::CollectQueries()
+{
+	while (!m_pendingQueries.empty())
+	{
+		const PENDING_QUERY& query = m_pendingQueries.front();
+
+		GLint available = 0;
+		glGetQueryObjectiv(query.queryID, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			break;
+		}
+
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(query.queryID, GL_QUERY_RESULT, &nanoseconds);
+
+		// a pass cannot take longer than the time since it was issued,
+		// some drivers report garbage for the first query
+		double microseconds = nanoseconds / 1000.0;
+		if (microseconds <= ToMicroseconds(Clock::now()) - query.startMicroseconds)
+		{
+			AddSample(query.name, true, query.startMicroseconds, microseconds);
+		}
+		else
+		{
+			m_droppedQueries++;
+		}
+
+		m_freeQueries.push_back(query.queryID);
+		m_pendingQueries.pop_front();
+	}
+}
+
+/***********************************************************
+ *  AddCpuScope()
+ *
+ *  This method is used for recording a CPU scope that ran
+ *  from start to end on the calling thread.
+ ***********************************************************/
+void Profiler::AddCpuScope(
+	const char* name,
+	std::chrono::steady_clock::time_point start,
+	std::chrono::steady_clock::time_point end)
+{
+	std::chrono::duration<double, std::micro> duration = end - start;
+	AddSample(name, false, ToMicroseconds(start), duration.count());
+}
+
+/***********************************************************
+ *  BeginGpuScope()
+ *
+ *  This method is used for starting a timer query around
+ *  the GL commands that follow.  GL_TIME_ELAPSED queries
+ *  cannot nest, so a pass begun inside another one is
+ *  counted as part of the outer pass.
+ ***********************************************************/
+void Profiler::BeginGpuScope(const char* name)
+{
+	if (m_gpuScopeDepth++ > 0)
+	{
+		return;
+	}
+
+	// a GPU far behind gives up its oldest results instead of
+	// growing the pool without bound
+	if (m_pendingQueries.size() >= g_MaxPendingQueries)
+	{
+		m_freeQueries.push_back(m_pendingQueries.front().queryID);
+		m_pendingQueries.pop_front();
+		m_droppedQueries++;
+	}
+
+	PENDING_QUERY query;
+	query.name = name;
+	if (m_freeQueries.empty())
+	{
+		glGenQueries(1, &query.queryID);
+	}
+	else
+	{
+		query.queryID = m_freeQueries.back();
+		m_freeQueries.pop_back();
+	}
+	// the trace places the pass where the CPU issued it
+	query.startMicroseconds = ToMicroseconds(Clock::now());
+	m_pendingQueries.push_back(query);
+
+	glBeginQuery(GL_TIME_ELAPSED, query.queryID);
+}
+
+/***********************************************************
+ *  EndGpuScope()
+ *
+ *  This method is used for ending the outermost open timer
+ *  query.
+ ***********************************************************/
+void Profiler::EndGpuScope()
+{
+	if (m_gpuScopeDepth == 0)
+	{
+		return;
+	}
+	if (--m_gpuScopeDepth == 0)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+	}
+}
+
+/***********************************************************
+ *  GetScopeStats()
+ *
+ *  This method is used for summarizing the latest samples
+ *  of the named scope.
+ ***********************************************************/
+bool Profiler::GetScopeStats(const char* name, bool bGpu, SCOPE_STATS& stats) const
+{
+	std::vector<SCOPE_STATS> allStats = GetAllStats();
+	for (const SCOPE_STATS& scopeStats : allStats)
+	{
+		if ((scopeStats.bGpu == bGpu) && (strcmp(scopeStats.name, name) == 0))
+		{
+			stats = scopeStats;
+			return(true);
+		}
+	}
+	return(false);
+}
+
+/***********************************************************
+ *  GetAllStats()
+ *
+ *  This method is used for summarizing the latest samples
+ *  of every scope, in the order they first ran.
+ ***********************************************************/
+std::vector<Profiler::SCOPE_STATS> Profiler::GetAllStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::vector<SCOPE_STATS> allStats;
+	allStats.reserve(m_scopes.size());
+	for (const SCOPE_HISTORY& history : m_scopes)
+	{
+		SCOPE_STATS stats;
+		stats.name = history.name;
+		stats.bGpu = history.bGpu;
+		stats.sampleCount = history.sampleCount;
+		stats.last = history.last;
+		stats.average = 0.0;
+		stats.min = history.samples[0];
+		stats.max = history.samples[0];
+		for (int i = 0; i < history.sampleCount; i++)
+		{
+			stats.average += history.samples[i];
+			stats.min = std::min(stats.min, history.samples[i]);
+			stats.max = std::max(stats.max, history.samples[i]);
+		}
+		if (history.sampleCount > 0)
+		{
+			stats.average /= history.sampleCount;
+		}
+		allStats.push_back(stats);
+	}
+	return(allStats);
+}
+
+/***********************************************************
+ *  PrintStats()
+ *
+ *  This method is used for printing the rolling averages
+ *  of every scope.
+ ***********************************************************/
+void Profiler::PrintStats() const
+{
+	std::vector<SCOPE_STATS> allStats = GetAllStats();
+	if (allStats.empty())
+	{
+		return;
+	}
+
+	std::cout << "Scope timings over the latest " << g_HistorySize << " samples (ms):" << std::endl;
+	std::cout << std::fixed << std::setprecision(3);
+	for (const SCOPE_STATS& stats : allStats)
+	{
+		std::cout << "  " << (stats.bGpu ? "gpu " : "cpu ") << std::left << std::setw(20) << stats.name
+			<< std::right << " avg " << stats.average << "  min " << stats.min
+			<< "  max " << stats.max << "  (" << stats.sampleCount << ")" << std::endl;
+	}
+	if (m_droppedQueries > 0)
+	{
+		std::cout << "  " << m_droppedQueries << " GPU results were dropped as late or invalid" << std::endl;
+	}
+	std::cout << std::defaultfloat;
+}
+
+/***********************************************************
+ *  BeginCapture() / EndCapture()
+ *
+ *  These methods are used for starting a fresh capture and
+ *  stopping it, keeping the events for WriteChromeTrace().
+ ***********************************************************/
+void Profiler::BeginCapture()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_events.clear();
+	m_bCapturing = true;
+}
+
+void Profiler::EndCapture()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_bCapturing = false;
+}
+
+/***********************************************************
+ *  WriteChromeTrace()
+ *
+ *  This method is used for writing the captured events as
+ *  complete ("X") events of the Chrome trace-event format,
+ *  one track per CPU thread and one for the GPU passes.
+ *  Scope names are code literals and are written as is.
+ ***********************************************************/
+bool Profiler::WriteChromeTrace(const char* filename) const
+{
+	std::ofstream file(filename);
+	if (!file)
+	{
+		std::cout << "Could not write the trace to " << filename << std::endl;
+		return(false);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// the GPU track comes first, threads follow in order of appearance
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+	for (size_t i = 0; i < m_threads.size(); i++)
+	{
+		file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << (i + 1)
+			<< ",\"args\":{\"name\":\"";
+		if (i == 0)
+		{
+			file << "Main";
+		}
+		else
+		{
+			file << "Worker " << i;
+		}
+		file << "\"}}";
+	}
+
+	file << std::fixed << std::setprecision(3);
+	for (const TRACE_EVENT& event : m_events)
+	{
+		file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"" << (event.bGpu ? "gpu" : "cpu")
+			<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (event.threadIndex + 1)
+			<< ",\"ts\":" << event.startMicroseconds
+			<< ",\"dur\":" << event.durationMicroseconds << "}";
+	}
+	file << "\n]}\n";
+
+	std::cout << "Wrote " << m_events.size() << " trace events to " << filename << std::endl;
+	return(file.good());
+}
+
+/***********************************************************
+ *  ReleaseQueries()
+ *
+ *  This method is used for deleting the query objects,
+ *  dropping any results not read yet.
+ ***********************************************************/
+void Profiler::ReleaseQueries()
+{
+	if (m_gpuScopeDepth > 0)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		m_gpuScopeDepth = 0;
+	}
+
+	for (const PENDING_QUERY& query : m_pendingQueries)
+	{
+		m_freeQueries.push_back(query.queryID);
+	}
+	m_pendingQueries.clear();
+
+	if (!m_freeQueries.empty())
+	{
+		glDeleteQueries(static_cast<GLsizei>(m_freeQueries.size()), m_freeQueries.data());
+	}
+	m_freeQueries.clear();
+}
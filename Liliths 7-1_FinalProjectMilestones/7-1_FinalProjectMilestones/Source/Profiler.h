@@ -0,0 +1,201 @@
+///////////////////////////////////////////////////////////////////////////////
+// profiler.h
+// ============
+// CPU and GPU timing of named scopes, with Chrome trace export
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  Profiler
+ *
+ *  This class times named scopes on the CPU with a steady
+ *  clock and render passes on the GPU with GL_TIME_ELAPSED
+ *  queries.  Query results are read back in issue order at
+ *  the start of later frames, and only once available, so
+ *  timing never stalls the pipeline.
+ *
+ *  Every scope keeps rolling statistics over its latest
+ *  samples, and while a capture is running every sample is
+ *  also kept as a trace event that can be written in the
+ *  Chrome trace-event format.
+ *
+ *  Code times itself through ScopedCpuTimer and
+ *  ScopedGpuTimer, which go to the active profiler and do
+ *  nothing when there is none.
+ ***********************************************************/
+class Profiler
+{
+public:
+	// rolling statistics of one scope, in milliseconds
+	struct SCOPE_STATS
+	{
+		const char* name;
+		bool bGpu;
+		int sampleCount;
+		double last;
+		double average;
+		double min;
+		double max;
+	};
+
+	// constructor
+	Profiler();
+	// destructor
+	~Profiler();
+
+	// profiler the scoped timers report to, or NULL
+	static Profiler* GetActive() { return s_pActive; }
+	static void SetActive(Profiler* pProfiler) { s_pActive = pProfiler; }
+
+	// mark the frame boundaries, and collect finished GPU queries
+	void BeginFrame();
+	void EndFrame();
+
+	// record a CPU scope from any thread, names must outlive the profiler
+	void AddCpuScope(
+		const char* name,
+		std::chrono::steady_clock::time_point start,
+		std::chrono::steady_clock::time_point end);
+	// time a GPU pass, inner passes are folded into the outer one
+	void BeginGpuScope(const char* name);
+	void EndGpuScope();
+
+	// rolling statistics, false when the scope never ran
+	bool GetScopeStats(const char* name, bool bGpu, SCOPE_STATS& stats) const;
+	std::vector<SCOPE_STATS> GetAllStats() const;
+	// print the average of every scope on the console
+	void PrintStats() const;
+
+	// keep trace events between these calls
+	void BeginCapture();
+	void EndCapture();
+	bool IsCapturing() const { return m_bCapturing; }
+	// write the captured events as Chrome trace-event JSON
+	bool WriteChromeTrace(const char* filename) const;
+
+	// release the query objects while the context is current
+	void ReleaseQueries();
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	// latest samples of one scope
+	struct SCOPE_HISTORY
+	{
+		const char* name;
+		bool bGpu;
+		std::vector<double> samples;
+		int nextSample;
+		int sampleCount;
+		double last;
+	};
+
+	// one complete event of the trace
+	struct TRACE_EVENT
+	{
+		const char* name;
+		bool bGpu;
+		int threadIndex;
+		double startMicroseconds;
+		double durationMicroseconds;
+	};
+
+	// GPU pass waiting for its query result
+	struct PENDING_QUERY
+	{
+		const char* name;
+		GLuint queryID;
+		double startMicroseconds;
+	};
+
+	static Profiler* s_pActive;
+
+	Clock::time_point m_startTime;
+	Clock::time_point m_frameStart;
+	mutable std::mutex m_mutex;
+	std::vector<SCOPE_HISTORY> m_scopes;
+	std::vector<TRACE_EVENT> m_events;
+	std::vector<std::thread::id> m_threads;
+	bool m_bCapturing;
+
+	// GPU passes in issue order, and query objects free for reuse
+	std::deque<PENDING_QUERY> m_pendingQueries;
+	std::vector<GLuint> m_freeQueries;
+	int m_gpuScopeDepth;
+	int m_droppedQueries;
+
+	double ToMicroseconds(Clock::time_point time) const;
+	int FindThreadIndex(std::thread::id threadID);
+	void AddSample(const char* name, bool bGpu, double startMicroseconds, double durationMicroseconds);
+	void CollectQueries();
+};
+
+/***********************************************************
+ *  ScopedCpuTimer
+ *
+ *  Times the enclosing block on the CPU.
+ ***********************************************************/
+class ScopedCpuTimer
+{
+public:
+	explicit ScopedCpuTimer(const char* name)
+	{
+		m_pProfiler = Profiler::GetActive();
+		m_name = name;
+		if (NULL != m_pProfiler)
+		{
+			m_start = std::chrono::steady_clock::now();
+		}
+	}
+	~ScopedCpuTimer()
+	{
+		if (NULL != m_pProfiler)
+		{
+			m_pProfiler->AddCpuScope(m_name, m_start, std::chrono::steady_clock::now());
+		}
+	}
+
+private:
+	Profiler* m_pProfiler;
+	const char* m_name;
+	std::chrono::steady_clock::time_point m_start;
+};
+
+/***********************************************************
+ *  ScopedGpuTimer
+ *
+ *  Times the GL commands of the enclosing block on the GPU.
+ ***********************************************************/
+class ScopedGpuTimer
+{
+public:
+	explicit ScopedGpuTimer(const char* name)
+	{
+		m_pProfiler = Profiler::GetActive();
+		if (NULL != m_pProfiler)
+		{
+			m_pProfiler->BeginGpuScope(name);
+		}
+	}
+	~ScopedGpuTimer()
+	{
+		if (NULL != m_pProfiler)
+		{
+			m_pProfiler->EndGpuScope();
+		}
+	}
+
+private:
+	Profiler* m_pProfiler;
+};
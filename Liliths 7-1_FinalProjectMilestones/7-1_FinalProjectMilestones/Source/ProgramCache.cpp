@@ -0,0 +1,454 @@
+///////////////////////////////////////////////////////////////////////////////
+// programcache.cpp
+// ============
+// linked shader programs kept as driver binaries between runs
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ProgramCache.h"
+#include "MappedFile.h"
+#include "ShaderManager.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// bump when the file layout or the hashed inputs change
+	const uint32_t g_BinaryVersion = 1;
+	const char g_BinaryMagic[4] = { 'G', 'L', 'P', '1' };
+	const char* g_BinaryExtension = ".glpb";
+
+	// binary file layout, header then the driver's bytes
+	struct BINARY_HEADER
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t programHash;
+		uint32_t binaryFormat;
+		uint32_t binarySize;
+	};
+
+	static_assert(sizeof(BINARY_HEADER) == 24, "BINARY_HEADER layout");
+
+	/***********************************************************
+	 *  HashBytes()
+	 *
+	 *  Continue an FNV-1a hash over the passed in bytes and a
+	 *  terminating zero, so neighbouring strings cannot shift
+	 *  bytes between them and hash the same.
+	 ***********************************************************/
+	uint64_t HashBytes(uint64_t hash, const void* pData, size_t size)
+	{
+		const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= pBytes[i];
+			hash *= 1099511628211ull;
+		}
+		hash *= 1099511628211ull;
+		return(hash);
+	}
+
+	uint64_t HashString(uint64_t hash, const char* text)
+	{
+		if (NULL == text)
+		{
+			text = "";
+		}
+		return(HashBytes(hash, text, strlen(text)));
+	}
+}
+
+/***********************************************************
+ *  ProgramCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ProgramCache::ProgramCache()
+{
+	m_loadedCount = 0;
+	m_compiledCount = 0;
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking that the driver has
+ *  program binaries and offers at least one format.
+ ***********************************************************/
+bool ProgramCache::IsSupported()
+{
+	if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+	{
+		return(false);
+	}
+
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	return(formatCount > 0);
+}
+
+/***********************************************************
+ *  LoadProgram()
+ *
+ *  This method is used for giving the shader manager the
+ *  program of the two shader files, from the cached binary
+ *  when the driver takes it, or else compiled from source
+ *  and stored for the next run.
+ ***********************************************************/
+bool ProgramCache::LoadProgram(
+	ShaderManager* pShader,
+	const char* vertexFile,
+	const char* fragmentFile,
+	const char* defines)
+{
+	std::string vertexSource;
+	std::string fragmentSource;
+
+	if ((NULL == pShader) || !ReadSource(vertexFile, vertexSource) || !ReadSource(fragmentFile, fragmentSource))
+	{
+		return(false);
+	}
+	if (NULL == defines)
+	{
+		defines = "";
+	}
+
+	const bool bCaching = !m_cacheFolder.empty() && IsSupported();
+	uint64_t programHash = 0;
+	std::string binaryPath;
+	GLuint program = 0;
+
+	if (bCaching)
+	{
+		programHash = HashProgram(vertexSource, fragmentSource, defines);
+		binaryPath = GetBinaryPath(vertexFile, fragmentFile, defines, programHash);
+		program = LoadBinary(binaryPath, programHash);
+	}
+
+	if (0 != program)
+	{
+		m_loadedCount++;
+	}
+	else
+	{
+		program = CompileProgram(vertexSource, fragmentSource, defines, bCaching);
+		if (0 == program)
+		{
+			return(false);
+		}
+		m_compiledCount++;
+
+		if (bCaching && !WriteBinary(binaryPath, program, programHash))
+		{
+			std::cout << "Could not cache the program binary " << binaryPath << std::endl;
+		}
+	}
+
+	if (0 != pShader->m_programID)
+	{
+		glDeleteProgram(pShader->m_programID);
+	}
+	pShader->m_programID = program;
+	return(true);
+}
+
+/***********************************************************
+ *  GetBinaryPath()
+ *
+ *  This method is used for naming the binary after the two
+ *  shader files, the defines and the full program hash.
+ ***********************************************************/
+std::string ProgramCache::GetBinaryPath(
+	const char* vertexFile,
+	const char* fragmentFile,
+	const char* defines,
+	uint64_t programHash) const
+{
+	namespace fs = std::filesystem;
+
+	// variants of the same files differ in the defines part, so
+	// storing one never removes the binary of another
+	char hashText[26];
+	snprintf(hashText, sizeof(hashText), "%08x-%016llx",
+		static_cast<unsigned int>(HashString(14695981039346656037ull, defines)),
+		static_cast<unsigned long long>(programHash));
+
+	return(m_cacheFolder +
+		fs::path(vertexFile).stem().string() + "+" +
+		fs::path(fragmentFile).stem().string() + "-" +
+		hashText + g_BinaryExtension);
+}
+
+/***********************************************************
+ *  LoadBinary()
+ *
+ *  This method is used for handing a cached binary to the
+ *  driver.  The driver may reject a binary it made itself,
+ *  after an update for instance, which is reported as a
+ *  link failure and returns 0.
+ ***********************************************************/
+GLuint ProgramCache::LoadBinary(const std::string& path, uint64_t programHash)
+{
+	MappedFile file;
+	if (!file.Open(path.c_str()) || (file.GetSize() < sizeof(BINARY_HEADER)))
+	{
+		return(0);
+	}
+
+	BINARY_HEADER header;
+	memcpy(&header, file.GetData(), sizeof(header));
+	if ((memcmp(header.magic, g_BinaryMagic, sizeof(header.magic)) != 0) ||
+		(header.version != g_BinaryVersion) ||
+		(header.programHash != programHash) ||
+		(header.binarySize == 0) ||
+		(header.binarySize > file.GetSize() - sizeof(header)))
+	{
+		return(0);
+	}
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.binaryFormat, file.GetData() + sizeof(header),
+		static_cast<GLsizei>(header.binarySize));
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (GL_TRUE != linked)
+	{
+		std::cout << "Program binary " << path << " was rejected, compiling from source" << std::endl;
+		glDeleteProgram(program);
+		return(0);
+	}
+	return(program);
+}
+
+/***********************************************************
+ *  WriteBinary()
+ *
+ *  This method is used for storing the binary of a linked
+ *  program, written to a temporary file first so a crash
+ *  never leaves half a binary behind, and removing the
+ *  binaries of the same files and defines that are stale.
+ ***********************************************************/
+bool ProgramCache::WriteBinary(const std::string& path, GLuint program, uint64_t programHash) const
+{
+	namespace fs = std::filesystem;
+	std::error_code error;
+
+	GLint binarySize = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+	if (binarySize <= 0)
+	{
+		return(false);
+	}
+
+	std::vector<unsigned char> bytes(sizeof(BINARY_HEADER) + binarySize);
+	GLenum binaryFormat = 0;
+	GLsizei writtenSize = 0;
+	glGetProgramBinary(program, binarySize, &writtenSize, &binaryFormat, bytes.data() + sizeof(BINARY_HEADER));
+	if (writtenSize <= 0)
+	{
+		return(false);
+	}
+
+	BINARY_HEADER header;
+	memcpy(header.magic, g_BinaryMagic, sizeof(header.magic));
+	header.version = g_BinaryVersion;
+	header.programHash = programHash;
+	header.binaryFormat = binaryFormat;
+	header.binarySize = static_cast<uint32_t>(writtenSize);
+	memcpy(bytes.data(), &header, sizeof(header));
+	bytes.resize(sizeof(header) + writtenSize);
+
+	fs::create_directories(m_cacheFolder, error);
+
+	std::string temporaryPath = path + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			return(false);
+		}
+		file.write(reinterpret_cast<const char*>(bytes.data()),
+			static_cast<std::streamsize>(bytes.size()));
+		if (!file)
+		{
+			file.close();
+			fs::remove(temporaryPath, error);
+			return(false);
+		}
+	}
+
+	fs::rename(temporaryPath, path, error);
+	if (error)
+	{
+		fs::remove(temporaryPath, error);
+		return(false);
+	}
+
+	// binaries of these files and defines with other hashes are
+	// stale now, the name ends in the 16 digit program hash
+	std::string current = fs::path(path).filename().string();
+	std::string prefix = current.substr(0, current.size() - strlen(g_BinaryExtension) - 16);
+	for (const fs::directory_entry& entry : fs::directory_iterator(m_cacheFolder, error))
+	{
+		std::string name = entry.path().filename().string();
+		if ((name != current) &&
+			(name.compare(0, prefix.size(), prefix) == 0) &&
+			(entry.path().extension() == g_BinaryExtension) &&
+			(name.size() == current.size()))
+		{
+			std::error_code removeError;
+			fs::remove(entry.path(), removeError);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  HashProgram()
+ *
+ *  This method is used for hashing everything the binary of
+ *  a program depends on.  The driver strings stand in for
+ *  the driver build, since a binary is only good for the
+ *  driver that made it.
+ ***********************************************************/
+uint64_t ProgramCache::HashProgram(
+	const std::string& vertexSource,
+	const std::string& fragmentSource,
+	const char* defines)
+{
+	uint64_t hash = 14695981039346656037ull ^ g_BinaryVersion;
+	hash = HashString(hash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+	hash = HashString(hash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+	hash = HashString(hash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+	hash = HashBytes(hash, vertexSource.data(), vertexSource.size());
+	hash = HashBytes(hash, fragmentSource.data(), fragmentSource.size());
+	hash = HashString(hash, defines);
+	return(hash);
+}
+
+/***********************************************************
+ *  CompileProgram()
+ *
+ *  This method is used for compiling and linking the two
+ *  shaders, asking the driver to keep the program
+ *  retrievable as a binary when it is going to be cached.
+ ***********************************************************/
+GLuint ProgramCache::CompileProgram(
+	const std::string& vertexSource,
+	const std::string& fragmentSource,
+	const char* defines,
+	bool bRetrievable)
+{
+	GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSource, defines);
+	GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSource, defines);
+	if ((0 == vertexShader) || (0 == fragmentShader))
+	{
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		return(0);
+	}
+
+	GLuint program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	if (bRetrievable)
+	{
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	glLinkProgram(program);
+
+	glDetachShader(program, vertexShader);
+	glDetachShader(program, fragmentShader);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (GL_TRUE != linked)
+	{
+		char infoLog[1024];
+		glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+		glDeleteProgram(program);
+		return(0);
+	}
+	return(program);
+}
+
+/***********************************************************
+ *  CompileShader()
+ *
+ *  This method is used for compiling one shader with the
+ *  defines placed after its #version line, which has to
+ *  stay first.  A #line keeps the error line numbers those
+ *  of the file.
+ ***********************************************************/
+GLuint ProgramCache::CompileShader(GLenum type, const std::string& source, const char* defines)
+{
+	std::string head;
+	std::string body = source;
+	if (source.compare(0, 8, "#version") == 0)
+	{
+		size_t lineEnd = source.find('\n');
+		if (std::string::npos == lineEnd)
+		{
+			lineEnd = source.size() - 1;
+		}
+		head = source.substr(0, lineEnd + 1);
+		body = source.substr(lineEnd + 1);
+	}
+
+	std::string prologue;
+	if ('\0' != defines[0])
+	{
+		prologue = std::string(defines) + "\n#line " + (head.empty() ? "1" : "2") + "\n";
+	}
+
+	const GLchar* strings[3] = { head.c_str(), prologue.c_str(), body.c_str() };
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 3, strings, NULL);
+	glCompileShader(shader);
+
+	GLint compiled = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+	if (GL_TRUE != compiled)
+	{
+		char infoLog[1024];
+		glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+		std::cout << "ERROR::SHADER::" << ((GL_VERTEX_SHADER == type) ? "VERTEX" : "FRAGMENT")
+			<< "::COMPILATION_FAILED\n" << infoLog << std::endl;
+		glDeleteShader(shader);
+		return(0);
+	}
+	return(shader);
+}
+
+/***********************************************************
+ *  ReadSource()
+ *
+ *  This method is used for reading a whole shader file.
+ ***********************************************************/
+bool ProgramCache::ReadSource(const char* path, std::string& source)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ " << path << std::endl;
+		return(false);
+	}
+
+	std::stringstream stream;
+	stream << file.rdbuf();
+	source = stream.str();
+	return(true);
+}
@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+// programcache.h
+// ============
+// linked shader programs kept as driver binaries between runs
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <string>
+
+class ShaderManager;
+
+/***********************************************************
+ *  ProgramCache
+ *
+ *  This class links shader programs for a ShaderManager and
+ *  keeps each one in a cache folder as the binary the driver
+ *  hands out with glGetProgramBinary().  A binary is named
+ *  after a hash of the shader sources, the defines, and the
+ *  vendor, renderer and version strings of the driver, so
+ *  an edited shader or a driver update no longer matches
+ *  and the program is compiled from source again.
+ *
+ *  A missing binary, or one the driver rejects, falls back
+ *  to compiling the sources, and the freshly linked program
+ *  replaces the binary.  Without program binary support, or
+ *  without a cache folder, every program is compiled.
+ ***********************************************************/
+class ProgramCache
+{
+public:
+	// constructor
+	ProgramCache();
+
+	// folder the binaries are kept in, empty to always compile
+	void SetCacheFolder(const std::string& folder) { m_cacheFolder = folder; }
+	const std::string& GetCacheFolder() const { return m_cacheFolder; }
+
+	// link the program of the two shader files into the shader
+	// manager, defines are lines inserted after the #version line
+	bool LoadProgram(
+		ShaderManager* pShader,
+		const char* vertexFile,
+		const char* fragmentFile,
+		const char* defines = "");
+
+	// programs loaded from binaries and compiled from source
+	int GetLoadedCount() const { return m_loadedCount; }
+	int GetCompiledCount() const { return m_compiledCount; }
+
+	// whether the driver can hand out program binaries
+	static bool IsSupported();
+
+private:
+	std::string m_cacheFolder;
+	int m_loadedCount;
+	int m_compiledCount;
+
+	// path of the binary for the passed in shader files and hash
+	std::string GetBinaryPath(
+		const char* vertexFile,
+		const char* fragmentFile,
+		const char* defines,
+		uint64_t programHash) const;
+	// program made from a binary file, 0 if missing or rejected
+	static GLuint LoadBinary(const std::string& path, uint64_t programHash);
+	// write the binary of a linked program and remove the ones of
+	// older sources or drivers
+	bool WriteBinary(const std::string& path, GLuint program, uint64_t programHash) const;
+
+	// hash of the sources, the defines and the driver strings
+	static uint64_t HashProgram(
+		const std::string& vertexSource,
+		const std::string& fragmentSource,
+		const char* defines);
+	// compile and link the sources, 0 on failure
+	static GLuint CompileProgram(
+		const std::string& vertexSource,
+		const std::string& fragmentSource,
+		const char* defines,
+		bool bRetrievable);
+	static GLuint CompileShader(GLenum type, const std::string& source, const char* defines);
+	static bool ReadSource(const char* path, std::string& source);
+};
@@ -0,0 +1,206 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.cpp
+// ============
+// order draws by a packed 64-bit state and depth key
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderQueue.h"
+
+#include <cstring>
+
+namespace
+{
+	// key fields from the top bit down, shift and width
+	const int PASS_SHIFT = 62;
+	const int VARIANT_SHIFT = 60;
+	const int VARIANT_BITS = 2;
+	const int TEXTURE_SHIFT = 48;
+	const int TEXTURE_BITS = 12;
+	const int MATERIAL_SHIFT = 38;
+	const int MATERIAL_BITS = 10;
+	const int MESH_SHIFT = 32;
+	const int MESH_BITS = 6;
+
+	// every field above the depth, which is not state
+	const uint64_t STATE_MASK = ~static_cast<uint64_t>(0xFFFFFFFF);
+
+	/***********************************************************
+	 *  PackField()
+	 *
+	 *  Clamp a value to the width of its field and shift it
+	 *  into place.
+	 ***********************************************************/
+	uint64_t PackField(int value, int bits, int shift)
+	{
+		uint64_t maxValue = (static_cast<uint64_t>(1) << bits) - 1;
+		uint64_t field = (value > 0) ? static_cast<uint64_t>(value) : 0;
+		if (field > maxValue)
+		{
+			field = maxValue;
+		}
+		return(field << shift);
+	}
+}
+
+/***********************************************************
+ *  RenderQueue()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderQueue::RenderQueue()
+{
+	m_stats.drawCount = 0;
+	m_stats.unsortedStateChanges = 0;
+	m_stats.sortedStateChanges = 0;
+}
+
+/***********************************************************
+ *  MakeKey()
+ *
+ *  This method is used for packing the sort key of a draw.
+ *  Texture and material handles are stored one higher so
+ *  that draws without one come first.  The depth is kept as
+ *  the bits of a positive float, which sort the same way as
+ *  the float values do.
+ ***********************************************************/
+uint64_t RenderQueue::MakeKey(
+	PASS pass,
+	int shaderVariant,
+	int textureHandle,
+	int materialHandle,
+	int mesh,
+	float viewDepth)
+{
+	uint64_t key = static_cast<uint64_t>(pass) << PASS_SHIFT;
+	key |= PackField(shaderVariant, VARIANT_BITS, VARIANT_SHIFT);
+	key |= PackField(textureHandle + 1, TEXTURE_BITS, TEXTURE_SHIFT);
+	key |= PackField(materialHandle + 1, MATERIAL_BITS, MATERIAL_SHIFT);
+	key |= PackField(mesh, MESH_BITS, MESH_SHIFT);
+
+	// behind the eye or NaN counts as nearest
+	if (!(viewDepth > 0.0f))
+	{
+		viewDepth = 0.0f;
+	}
+	uint32_t depthBits;
+	memcpy(&depthBits, &viewDepth, sizeof(depthBits));
+	key |= depthBits;
+
+	return(key);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for dropping the queued draws.
+ ***********************************************************/
+void RenderQueue::Clear()
+{
+	m_items.clear();
+}
+
+/***********************************************************
+ *  Push()
+ *
+ *  This method is used for queueing one draw.
+ ***********************************************************/
+void RenderQueue::Push(uint64_t key, int index)
+{
+	QUEUE_ITEM item;
+	item.key = key;
+	item.index = index;
+	m_items.push_back(item);
+}
+
+/***********************************************************
+ *  Sort()
+ *
+ *  This method is used for sorting the queue by key with a
+ *  least significant byte first radix sort.  The counts of
+ *  all eight bytes are taken in one pass over the keys, and
+ *  bytes that are the same in every key are skipped, which
+ *  is most of the state bytes for a small scene.
+ ***********************************************************/
+void RenderQueue::Sort()
+{
+	UpdateStats();
+
+	size_t count = m_items.size();
+	if (count < 2)
+	{
+		m_stats.sortedStateChanges = m_stats.unsortedStateChanges;
+		return;
+	}
+
+	uint32_t histograms[8][256];
+	memset(histograms, 0, sizeof(histograms));
+	for (const QUEUE_ITEM& item : m_items)
+	{
+		for (int b = 0; b < 8; b++)
+		{
+			histograms[b][(item.key >> (b * 8)) & 0xFF]++;
+		}
+	}
+
+	m_scratch.resize(count);
+	for (int b = 0; b < 8; b++)
+	{
+		uint32_t* histogram = histograms[b];
+		int shift = b * 8;
+		if (histogram[(m_items[0].key >> shift) & 0xFF] == count)
+		{
+			continue;
+		}
+
+		// turn the counts into the first slot of every byte value
+		uint32_t offset = 0;
+		for (int v = 0; v < 256; v++)
+		{
+			uint32_t bucketCount = histogram[v];
+			histogram[v] = offset;
+			offset += bucketCount;
+		}
+
+		for (const QUEUE_ITEM& item : m_items)
+		{
+			m_scratch[histogram[(item.key >> shift) & 0xFF]++] = item;
+		}
+		m_items.swap(m_scratch);
+	}
+
+	m_stats.sortedStateChanges = CountStateChanges();
+}
+
+/***********************************************************
+ *  UpdateStats()
+ *
+ *  This method is used for counting the state changes of
+ *  the queue as it was pushed.
+ ***********************************************************/
+void RenderQueue::UpdateStats()
+{
+	m_stats.drawCount = static_cast<int>(m_items.size());
+	m_stats.unsortedStateChanges = CountStateChanges();
+	m_stats.sortedStateChanges = m_stats.unsortedStateChanges;
+}
+
+/***********************************************************
+ *  CountStateChanges()
+ *
+ *  This method is used for counting the draws that need a
+ *  different pass, variant, texture, material or mesh than
+ *  the draw before them.  The first draw counts as one.
+ ***********************************************************/
+int RenderQueue::CountStateChanges() const
+{
+	int changes = 0;
+	for (size_t i = 0; i < m_items.size(); i++)
+	{
+		if ((i == 0) || ((m_items[i].key & STATE_MASK) != (m_items[i - 1].key & STATE_MASK)))
+		{
+			changes++;
+		}
+	}
+	return(changes);
+}
@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.h
+// ============
+// order draws by a packed 64-bit state and depth key
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  RenderQueue
+ *
+ *  This class collects the draws of one frame, each as a
+ *  64-bit key and the index of the draw it stands for, and
+ *  sorts them by key with a radix sort.  From the top bit
+ *  down the key holds the pass, the shader variant, the
+ *  texture, the material, the mesh and the view depth, so
+ *  sorted draws are grouped by the state they need and the
+ *  draws sharing all of it go front to back.
+ *
+ *  The sort is stable, so draws pushed with equal keys keep
+ *  the order they were pushed in.
+ ***********************************************************/
+class RenderQueue
+{
+public:
+	// passes drawn in order, opaque before the overlays
+	enum PASS
+	{
+		PASS_OPAQUE = 0,
+		PASS_OVERLAY = 1
+	};
+
+	// one queued draw
+	struct QUEUE_ITEM
+	{
+		uint64_t key;
+		int index;
+	};
+
+	// state changes of the queue in push order and in sorted order
+	struct QUEUE_STATS
+	{
+		int drawCount;
+		int unsortedStateChanges;
+		int sortedStateChanges;
+	};
+
+	// constructor
+	RenderQueue();
+
+	// pack the sort key of a draw, handles of -1 mean none
+	static uint64_t MakeKey(
+		PASS pass,
+		int shaderVariant,
+		int textureHandle,
+		int materialHandle,
+		int mesh,
+		float viewDepth);
+
+	// forget the queued draws, keeping the memory
+	void Clear();
+	void Push(uint64_t key, int index);
+	// sort by key, and count the state changes on both sides
+	void Sort();
+	// only count the state changes, keeping the push order
+	void UpdateStats();
+
+	int GetCount() const { return static_cast<int>(m_items.size()); }
+	const QUEUE_ITEM& GetItem(int i) const { return m_items[i]; }
+	const QUEUE_STATS& GetStats() const { return m_stats; }
+
+private:
+	std::vector<QUEUE_ITEM> m_items;
+	// second buffer of the radix sort passes
+	std::vector<QUEUE_ITEM> m_scratch;
+	QUEUE_STATS m_stats;
+
+	// neighbours needing different state, in the current order
+	int CountStateChanges() const;
+};
@@ -0,0 +1,169 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertarget.cpp
+// ============
+// framebuffer object with color and depth attachments
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderTarget.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  RenderTarget()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderTarget::RenderTarget()
+{
+	m_framebufferID = 0;
+	m_colorBufferID = 0;
+	m_depthBufferID = 0;
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  ~RenderTarget()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderTarget::~RenderTarget()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for allocating the framebuffer and
+ *  its attachments, and checking that the driver accepts
+ *  the combination.
+ ***********************************************************/
+bool RenderTarget::Create(int width, int height)
+{
+	Destroy();
+
+	if ((width <= 0) || (height <= 0))
+	{
+		return(false);
+	}
+
+	glGenRenderbuffers(1, &m_colorBufferID);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &m_depthBufferID);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBufferID);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (GL_FRAMEBUFFER_COMPLETE != status)
+	{
+		std::cout << "Render target " << width << "x" << height
+			<< " is incomplete, status 0x" << std::hex << status << std::dec << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	m_width = width;
+	m_height = height;
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the framebuffer and its
+ *  attachments.
+ ***********************************************************/
+void RenderTarget::Destroy()
+{
+	if (0 != m_framebufferID)
+	{
+		glDeleteFramebuffers(1, &m_framebufferID);
+		m_framebufferID = 0;
+	}
+	if (0 != m_colorBufferID)
+	{
+		glDeleteRenderbuffers(1, &m_colorBufferID);
+		m_colorBufferID = 0;
+	}
+	if (0 != m_depthBufferID)
+	{
+		glDeleteRenderbuffers(1, &m_depthBufferID);
+		m_depthBufferID = 0;
+	}
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for directing draws into the target
+ *  and covering it with the viewport.
+ ***********************************************************/
+void RenderTarget::Bind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glViewport(0, 0, m_width, m_height);
+}
+
+/***********************************************************
+ *  BindRegion()
+ *
+ *  This method is used for directing draws into a corner of
+ *  the target, so it can be drawn at a reduced size without
+ *  reallocating the attachments.
+ ***********************************************************/
+void RenderTarget::BindRegion(int width, int height) const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glViewport(0, 0, (width < m_width) ? width : m_width, (height < m_height) ? height : m_height);
+}
+
+/***********************************************************
+ *  BlitToWindow()
+ *
+ *  This method is used for scaling the drawn corner of the
+ *  target up to the window, filtered unless the sizes match.
+ ***********************************************************/
+void RenderTarget::BlitToWindow(int width, int height, int windowWidth, int windowHeight) const
+{
+	GLenum filter = ((width == windowWidth) && (height == windowHeight)) ? GL_NEAREST : GL_LINEAR;
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebufferID);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT, filter);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, windowWidth, windowHeight);
+}
+
+/***********************************************************
+ *  ReadPixels()
+ *
+ *  This method is used for reading back the color
+ *  attachment, bottom row first.  It waits for the frame
+ *  to finish, so it is meant for checks, not every frame.
+ ***********************************************************/
+bool RenderTarget::ReadPixels(std::vector<unsigned char>& pixels) const
+{
+	if (!IsCreated())
+	{
+		return(false);
+	}
+
+	pixels.resize(static_cast<size_t>(m_width) * m_height * 4);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebufferID);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	return(true);
+}
@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertarget.h
+// ============
+// framebuffer object with color and depth attachments
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/***********************************************************
+ *  RenderTarget
+ *
+ *  This class owns a framebuffer object with an RGBA8 color
+ *  renderbuffer and a 24 bit depth renderbuffer, for
+ *  rendering where there is no window to draw into, or at
+ *  a lower resolution than the window is shown at.
+ ***********************************************************/
+class RenderTarget
+{
+public:
+	// constructor
+	RenderTarget();
+	// destructor
+	~RenderTarget();
+
+	// allocate the attachments at the passed in size
+	bool Create(int width, int height);
+	// free the framebuffer and its attachments
+	void Destroy();
+
+	// draw into the target over its whole area
+	void Bind() const;
+	// draw into the lower left width x height corner only
+	void BindRegion(int width, int height) const;
+	// stretch the lower left corner over the window framebuffer
+	// and leave the window framebuffer bound
+	void BlitToWindow(int width, int height, int windowWidth, int windowHeight) const;
+	// copy the color attachment into the passed in RGBA buffer
+	bool ReadPixels(std::vector<unsigned char>& pixels) const;
+
+	bool IsCreated() const { return m_framebufferID != 0; }
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+
+private:
+	GLuint m_framebufferID;
+	GLuint m_colorBufferID;
+	GLuint m_depthBufferID;
+	int m_width;
+	int m_height;
+};
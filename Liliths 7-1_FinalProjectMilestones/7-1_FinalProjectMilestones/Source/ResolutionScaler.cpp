@@ -0,0 +1,339 @@
+///////////////////////////////////////////////////////////////////////////////
+// resolutionscaler.cpp
+// ============
+// draw the scene at the resolution that holds a GPU time budget
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ResolutionScaler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// weight of the newest result in the smoothed GPU time
+	const double g_SmoothingWeight = 0.2;
+	// results after a scale change before the next one, so the
+	// frames drawn at the old scale have been read
+	const int g_SettleResults = 8;
+	// fraction of the budget aimed for when dropping the scale
+	const double g_TargetFraction = 0.9;
+	// fraction of the budget a frame must stay under to raise it
+	const double g_RaiseFraction = 0.75;
+	// largest raise of the scale in one change
+	const float g_RaiseStep = 0.05f;
+	// scales are kept to multiples of this, so tiny changes
+	// do not blur the frame without saving any time
+	const float g_ScaleQuantum = 1.0f / 32.0f;
+	// frames whose timings may wait to be read before the
+	// oldest are given up on
+	const int g_MaxPendingFrames = 8;
+}
+
+/***********************************************************
+ *  ResolutionScaler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ResolutionScaler::ResolutionScaler()
+{
+	m_budgetMs = 14.0;
+	m_minScale = 0.5f;
+	m_scale = 1.0f;
+	m_bFixedScale = false;
+	m_windowWidth = 0;
+	m_windowHeight = 0;
+	m_renderWidth = 0;
+	m_renderHeight = 0;
+	m_beginQuery = 0;
+	m_smoothedMs = -1.0;
+	m_resultsSinceChange = 0;
+	m_frameCount = 0;
+	m_scaleChanges = 0;
+	m_scaleSum = 0.0;
+	m_gpuMsSum = 0.0;
+	m_gpuResultCount = 0;
+	m_lowestScale = 1.0f;
+}
+
+/***********************************************************
+ *  ~ResolutionScaler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ResolutionScaler::~ResolutionScaler()
+{
+	// the GL objects must be freed with Release() while the
+	// context is still current
+}
+
+/***********************************************************
+ *  SetGpuBudget()
+ *
+ *  This method is used for setting the GPU time a frame is
+ *  held to.
+ ***********************************************************/
+void ResolutionScaler::SetGpuBudget(double milliseconds)
+{
+	if (milliseconds > 0.0)
+	{
+		m_budgetMs = milliseconds;
+	}
+}
+
+/***********************************************************
+ *  SetMinScale()
+ *
+ *  This method is used for setting how far the scale of
+ *  each axis may drop.
+ ***********************************************************/
+void ResolutionScaler::SetMinScale(float scale)
+{
+	m_minScale = std::min(std::max(scale, 0.1f), 1.0f);
+	m_scale = std::max(m_scale, m_minScale);
+}
+
+/***********************************************************
+ *  SetFixedScale()
+ *
+ *  This method is used for drawing at one scale whatever
+ *  the frames cost.
+ ***********************************************************/
+void ResolutionScaler::SetFixedScale(float scale)
+{
+	m_scale = std::min(std::max(scale, 0.1f), 1.0f);
+	m_bFixedScale = true;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for sizing the target to the window,
+ *  binding the scaled corner of it, and starting the timing
+ *  of the frame.
+ ***********************************************************/
+bool ResolutionScaler::BeginFrame(int windowWidth, int windowHeight)
+{
+	if ((windowWidth <= 0) || (windowHeight <= 0))
+	{
+		return(false);
+	}
+
+	if ((windowWidth != m_target.GetWidth()) || (windowHeight != m_target.GetHeight()))
+	{
+		if (!m_target.Create(windowWidth, windowHeight))
+		{
+			return(false);
+		}
+	}
+
+	CollectResults();
+
+	m_windowWidth = windowWidth;
+	m_windowHeight = windowHeight;
+	m_renderWidth = std::max(1, static_cast<int>(windowWidth * m_scale + 0.5f));
+	m_renderHeight = std::max(1, static_cast<int>(windowHeight * m_scale + 0.5f));
+	m_target.BindRegion(m_renderWidth, m_renderHeight);
+
+	m_beginQuery = TakeQuery();
+	glQueryCounter(m_beginQuery, GL_TIMESTAMP);
+	return(true);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for stretching the frame over the
+ *  window and ending its timing, the stretch included.
+ ***********************************************************/
+void ResolutionScaler::EndFrame()
+{
+	m_target.BlitToWindow(m_renderWidth, m_renderHeight, m_windowWidth, m_windowHeight);
+
+	PENDING_FRAME frame;
+	frame.beginQuery = m_beginQuery;
+	frame.endQuery = TakeQuery();
+	glQueryCounter(frame.endQuery, GL_TIMESTAMP);
+	m_pendingFrames.push_back(frame);
+	m_beginQuery = 0;
+
+	// a driver that holds results back must not grow the list
+	while (static_cast<int>(m_pendingFrames.size()) > g_MaxPendingFrames)
+	{
+		m_freeQueries.push_back(m_pendingFrames.front().beginQuery);
+		m_freeQueries.push_back(m_pendingFrames.front().endQuery);
+		m_pendingFrames.pop_front();
+	}
+
+	m_frameCount++;
+	m_scaleSum += m_scale;
+	m_lowestScale = std::min(m_lowestScale, m_scale);
+}
+
+/***********************************************************
+ *  TakeQuery()
+ *
+ *  This method is used for reusing a query whose result was
+ *  read, or making a new one.
+ ***********************************************************/
+GLuint ResolutionScaler::TakeQuery()
+{
+	GLuint query = 0;
+	if (m_freeQueries.empty())
+	{
+		glGenQueries(1, &query);
+	}
+	else
+	{
+		query = m_freeQueries.back();
+		m_freeQueries.pop_back();
+	}
+	return(query);
+}
+
+/***********************************************************
+ *  CollectResults()
+ *
+ *  This method is used for reading the timings the GPU has
+ *  finished, oldest first, without waiting for the others.
+ ***********************************************************/
+void ResolutionScaler::CollectResults()
+{
+	while (!m_pendingFrames.empty())
+	{
+		PENDING_FRAME& frame = m_pendingFrames.front();
+
+		// the end timestamp is written after the begin one
+		GLint available = 0;
+		glGetQueryObjectiv(frame.endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			break;
+		}
+
+		GLuint64 beginNanoseconds = 0;
+		GLuint64 endNanoseconds = 0;
+		glGetQueryObjectui64v(frame.beginQuery, GL_QUERY_RESULT, &beginNanoseconds);
+		glGetQueryObjectui64v(frame.endQuery, GL_QUERY_RESULT, &endNanoseconds);
+		if (endNanoseconds >= beginNanoseconds)
+		{
+			double gpuMs = (endNanoseconds - beginNanoseconds) * 1.0e-6;
+			m_gpuMsSum += gpuMs;
+			m_gpuResultCount++;
+			UpdateScale(gpuMs);
+		}
+
+		m_freeQueries.push_back(frame.beginQuery);
+		m_freeQueries.push_back(frame.endQuery);
+		m_pendingFrames.pop_front();
+	}
+}
+
+/***********************************************************
+ *  UpdateScale()
+ *
+ *  This method is used for folding one GPU time into the
+ *  smoothed time and picking the scale expected to bring
+ *  it within the budget.
+ ***********************************************************/
+void ResolutionScaler::UpdateScale(double gpuMs)
+{
+	if (m_smoothedMs < 0.0)
+	{
+		m_smoothedMs = gpuMs;
+	}
+	else
+	{
+		m_smoothedMs += (gpuMs - m_smoothedMs) * g_SmoothingWeight;
+	}
+	m_resultsSinceChange++;
+
+	if (m_bFixedScale || (m_resultsSinceChange < g_SettleResults) || (m_smoothedMs <= 0.0))
+	{
+		return;
+	}
+
+	// the pixel count goes with the square of the scale
+	float fitScale = m_scale * static_cast<float>(sqrt(m_budgetMs * g_TargetFraction / m_smoothedMs));
+	float newScale = m_scale;
+	if (m_smoothedMs > m_budgetMs)
+	{
+		newScale = fitScale;
+	}
+	else if (m_smoothedMs < m_budgetMs * g_RaiseFraction)
+	{
+		newScale = std::min(fitScale, m_scale + g_RaiseStep);
+	}
+
+	newScale = floor(newScale / g_ScaleQuantum) * g_ScaleQuantum;
+	newScale = std::min(std::max(newScale, m_minScale), 1.0f);
+	if (newScale == m_scale)
+	{
+		return;
+	}
+
+	// expect the time to follow the pixel count until measured
+	m_smoothedMs *= (newScale * newScale) / (m_scale * m_scale);
+	m_scale = newScale;
+	m_resultsSinceChange = 0;
+	m_scaleChanges++;
+}
+
+/***********************************************************
+ *  PrintStats()
+ *
+ *  This method is used for printing the scales the frames
+ *  were drawn at and their GPU time.
+ ***********************************************************/
+void ResolutionScaler::PrintStats() const
+{
+	if (0 == m_frameCount)
+	{
+		return;
+	}
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "Dynamic resolution over " << m_frameCount << " frames, "
+		<< m_budgetMs << " ms GPU budget:" << std::endl;
+	std::cout << "  scale mean " << (m_scaleSum / m_frameCount)
+		<< ", lowest " << m_lowestScale
+		<< ", last " << m_scale
+		<< ", " << m_scaleChanges << " changes" << std::endl;
+	if (m_gpuResultCount > 0)
+	{
+		std::cout << "  GPU frame time mean " << (m_gpuMsSum / m_gpuResultCount) << " ms" << std::endl;
+	}
+	std::cout << std::defaultfloat;
+}
+
+/***********************************************************
+ *  Release()
+ *
+ *  This method is used for freeing the render target and
+ *  every query.
+ ***********************************************************/
+void ResolutionScaler::Release()
+{
+	for (const PENDING_FRAME& frame : m_pendingFrames)
+	{
+		m_freeQueries.push_back(frame.beginQuery);
+		m_freeQueries.push_back(frame.endQuery);
+	}
+	m_pendingFrames.clear();
+	if (0 != m_beginQuery)
+	{
+		m_freeQueries.push_back(m_beginQuery);
+		m_beginQuery = 0;
+	}
+
+	if (!m_freeQueries.empty())
+	{
+		glDeleteQueries(static_cast<GLsizei>(m_freeQueries.size()), m_freeQueries.data());
+		m_freeQueries.clear();
+	}
+	m_target.Destroy();
+}
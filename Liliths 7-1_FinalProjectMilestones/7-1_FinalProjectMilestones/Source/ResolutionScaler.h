@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+// resolutionscaler.h
+// ============
+// draw the scene at the resolution that holds a GPU time budget
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RenderTarget.h"
+
+#include <GL/glew.h>
+
+#include <deque>
+#include <vector>
+
+/***********************************************************
+ *  ResolutionScaler
+ *
+ *  This class draws the window frames into a render target
+ *  and stretches them over the window.  The target is kept
+ *  at the window size and the frame is drawn into a corner
+ *  of it, scaled down on both axes, so changing the scale
+ *  never reallocates anything; only a resize does.
+ *
+ *  A pair of timestamp queries around each frame measures
+ *  its GPU time.  The results are read a few frames late,
+ *  when they are ready, so the CPU never waits on them.
+ *  The GPU time is taken as growing with the pixel count:
+ *  a frame over the budget drops the scale at once to the
+ *  size that should fit, while one well under it raises
+ *  the scale a small step at a time.  After every change
+ *  the scale settles for a few results before the next.
+ ***********************************************************/
+class ResolutionScaler
+{
+public:
+	// constructor
+	ResolutionScaler();
+	// destructor
+	~ResolutionScaler();
+
+	// GPU time a frame may take
+	void SetGpuBudget(double milliseconds);
+	double GetGpuBudget() const { return m_budgetMs; }
+	// lowest scale of each axis, the highest is 1
+	void SetMinScale(float scale);
+	// hold one scale instead of following the budget
+	void SetFixedScale(float scale);
+
+	// bind the target for a frame shown at the passed in size,
+	// false when the window is minimized and nothing is drawn
+	bool BeginFrame(int windowWidth, int windowHeight);
+	// stretch the frame over the window and end its timing
+	void EndFrame();
+
+	float GetScale() const { return m_scale; }
+	int GetRenderWidth() const { return m_renderWidth; }
+	int GetRenderHeight() const { return m_renderHeight; }
+
+	// scale and GPU time over the run
+	void PrintStats() const;
+	// free the target and the queries while the context is current
+	void Release();
+
+private:
+	// timestamps around one frame whose results are not read yet
+	struct PENDING_FRAME
+	{
+		GLuint beginQuery;
+		GLuint endQuery;
+	};
+
+	RenderTarget m_target;
+	double m_budgetMs;
+	float m_minScale;
+	float m_scale;
+	bool m_bFixedScale;
+
+	// size of the current frame in the window and in the target
+	int m_windowWidth;
+	int m_windowHeight;
+	int m_renderWidth;
+	int m_renderHeight;
+	GLuint m_beginQuery;
+
+	std::deque<PENDING_FRAME> m_pendingFrames;
+	std::vector<GLuint> m_freeQueries;
+
+	// smoothed GPU time at the current scale, below 0 for none yet
+	double m_smoothedMs;
+	int m_resultsSinceChange;
+
+	// run totals for PrintStats()
+	int m_frameCount;
+	int m_scaleChanges;
+	double m_scaleSum;
+	double m_gpuMsSum;
+	int m_gpuResultCount;
+	float m_lowestScale;
+
+	// query from the free list, or a new one
+	GLuint TakeQuery();
+	// read the finished timings and adjust the scale
+	void CollectResults();
+	// move the scale toward the GPU time of the latest result
+	void UpdateScale(double gpuMs);
+};
@@ -0,0 +1,175 @@
+///////////////////////////////////////////////////////////////////////////////
+// scalingbenchmark.cpp
+// ============
+// collect how the frame cost grows with the size of the scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ScalingBenchmark.h"
+#include "FrameBenchmark.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+/***********************************************************
+ *  SetInfo()
+ *
+ *  This method is used for attaching a named string to the
+ *  JSON report.
+ ***********************************************************/
+void ScalingBenchmark::SetInfo(const char* name, const std::string& value)
+{
+	std::string json = FrameBenchmark::QuoteJSON(value);
+	for (std::pair<std::string, std::string>& info : m_info)
+	{
+		if (info.first == name)
+		{
+			info.second = json;
+			return;
+		}
+	}
+	m_info.push_back(std::make_pair(std::string(name), json));
+}
+
+/***********************************************************
+ *  PrintHeader()
+ *
+ *  This method is used for printing the column names.
+ ***********************************************************/
+void ScalingBenchmark::PrintHeader()
+{
+	std::cout << std::setw(9) << "copies"
+		<< std::setw(11) << "objects"
+		<< std::setw(11) << "visible"
+		<< std::setw(9) << "draws"
+		<< std::setw(10) << "uniforms"
+		<< std::setw(12) << "submit ms"
+		<< std::setw(12) << "p95 ms"
+		<< std::setw(12) << "frame ms"
+		<< std::setw(11) << "load ms"
+		<< std::setw(11) << "scene MB"
+		<< std::setw(10) << "RSS MB" << std::endl;
+}
+
+/***********************************************************
+ *  AddStep()
+ *
+ *  This method is used for recording the measurements of
+ *  one scene size and printing them as a row.
+ ***********************************************************/
+void ScalingBenchmark::AddStep(const SCALING_STEP& step)
+{
+	m_steps.push_back(step);
+
+	const double megabyte = 1024.0 * 1024.0;
+	std::cout << std::fixed << std::setprecision(3)
+		<< std::setw(9) << step.copyCount
+		<< std::setw(11) << step.drawObjects
+		<< std::setw(11) << step.visibleObjects
+		<< std::setw(9) << step.drawCalls
+		<< std::setw(10) << step.uniformUploads
+		<< std::setw(12) << step.submitMeanMs
+		<< std::setw(12) << step.submitP95Ms
+		<< std::setw(12) << step.frameMeanMs
+		<< std::setw(11) << step.loadMs
+		<< std::setprecision(1)
+		<< std::setw(11) << step.sceneBytes / megabyte
+		<< std::setw(10) << step.residentBytes / megabyte
+		<< std::defaultfloat << std::endl;
+}
+
+/***********************************************************
+ *  WriteJSON()
+ *
+ *  This method is used for writing the attached values and
+ *  one object per step to the passed in file.
+ ***********************************************************/
+bool ScalingBenchmark::WriteJSON(const char* filename) const
+{
+	std::ofstream file(filename);
+	if (!file)
+	{
+		std::cout << "Could not write benchmark results to " << filename << std::endl;
+		return(false);
+	}
+
+	file << "{\n";
+	for (const std::pair<std::string, std::string>& info : m_info)
+	{
+		file << "  " << FrameBenchmark::QuoteJSON(info.first) << ": " << info.second << ",\n";
+	}
+
+	file << std::fixed << std::setprecision(4) << "  \"steps\": [";
+	for (size_t i = 0; i < m_steps.size(); i++)
+	{
+		const SCALING_STEP& step = m_steps[i];
+		file << ((i > 0) ? ",\n" : "\n")
+			<< "    {"
+			<< " \"copies\": " << step.copyCount
+			<< ", \"drawObjects\": " << step.drawObjects
+			<< ", \"visibleObjects\": " << step.visibleObjects
+			<< ", \"drawCalls\": " << step.drawCalls
+			<< ", \"uniformUploads\": " << step.uniformUploads
+			<< ", \"glCallsSent\": " << step.glCallsSent
+			<< ", \"generateMs\": " << step.generateMs
+			<< ", \"loadMs\": " << step.loadMs
+			<< ", \"submitMeanMs\": " << step.submitMeanMs
+			<< ", \"submitP95Ms\": " << step.submitP95Ms
+			<< ", \"frameMeanMs\": " << step.frameMeanMs
+			<< ", \"sceneBytes\": " << step.sceneBytes
+			<< ", \"residentBytes\": " << step.residentBytes
+			<< " }";
+	}
+	file << "\n  ]\n}\n";
+
+	return(file.good());
+}
+
+/***********************************************************
+ *  GetResidentBytes()
+ *
+ *  This method is used for reading the resident set size
+ *  of the process, the working set on Windows.
+ ***********************************************************/
+uint64_t ScalingBenchmark::GetResidentBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return(static_cast<uint64_t>(counters.WorkingSetSize));
+	}
+	return(0);
+#else
+	// the second field of statm is the resident page count
+	FILE* pFile = fopen("/proc/self/statm", "r");
+	if (NULL == pFile)
+	{
+		return(0);
+	}
+	unsigned long long totalPages = 0;
+	unsigned long long residentPages = 0;
+	int fieldCount = fscanf(pFile, "%llu %llu", &totalPages, &residentPages);
+	fclose(pFile);
+	if (fieldCount != 2)
+	{
+		return(0);
+	}
+	return(static_cast<uint64_t>(residentPages) * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)));
+#endif
+}
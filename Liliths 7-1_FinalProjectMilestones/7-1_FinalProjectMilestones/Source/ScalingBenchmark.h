@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////////////
+// scalingbenchmark.h
+// ============
+// collect how the frame cost grows with the size of the scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/***********************************************************
+ *  ScalingBenchmark
+ *
+ *  This class collects one row of measurements for each
+ *  scene size of a sweep, prints the rows as a table while
+ *  the sweep runs and writes them all as JSON at the end.
+ ***********************************************************/
+class ScalingBenchmark
+{
+public:
+	// measurements of one scene size
+	struct SCALING_STEP
+	{
+		int copyCount;
+		int drawObjects;
+		int visibleObjects;
+		// calls of the last measured frame
+		int drawCalls;
+		int uniformUploads;
+		int glCallsSent;
+		// time to write and to load the generated scene
+		double generateMs;
+		double loadMs;
+		// CPU time spent building and submitting a frame
+		double submitMeanMs;
+		double submitP95Ms;
+		// whole frame including waits on the GPU
+		double frameMeanMs;
+		uint64_t sceneBytes;
+		uint64_t residentBytes;
+	};
+
+	// attach a value to the report, replacing any of the same name
+	void SetInfo(const char* name, const std::string& value);
+
+	// record a step and print it as a table row
+	void AddStep(const SCALING_STEP& step);
+	const std::vector<SCALING_STEP>& GetSteps() const { return m_steps; }
+
+	// print the column names of the rows AddStep() prints
+	static void PrintHeader();
+	// write the attached values and every step as a JSON file
+	bool WriteJSON(const char* filename) const;
+
+	// memory the process has resident, or 0 when unknown
+	static uint64_t GetResidentBytes();
+
+private:
+	std::vector<SCALING_STEP> m_steps;
+	// names with values already formatted as JSON
+	std::vector<std::pair<std::string, std::string> > m_info;
+};
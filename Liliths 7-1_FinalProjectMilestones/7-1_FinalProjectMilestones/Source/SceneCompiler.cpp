@@ -0,0 +1,752 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenecompiler.cpp
+// ============
+// compile the text scene description into the binary scene format
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneCompiler.h"
+#include "SceneFile.h"
+#include "PrimitiveMeshes.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// every table of a compiled scene starts on this alignment
+	const size_t g_TableAlignment = 8;
+
+	const char* g_RootName = "root";
+
+	// shape keywords and the primitives they draw
+	struct SHAPE_KEYWORD
+	{
+		const char* keyword;
+		PrimitiveMeshes::PRIMITIVE primitive;
+	};
+	const SHAPE_KEYWORD g_ShapeKeywords[] = {
+		{ "box", PrimitiveMeshes::PRIMITIVE_BOX },
+		{ "cylinder", PrimitiveMeshes::PRIMITIVE_CYLINDER },
+		{ "sphere", PrimitiveMeshes::PRIMITIVE_SPHERE },
+		{ "plane", PrimitiveMeshes::PRIMITIVE_PLANE }
+	};
+
+	size_t AlignTable(size_t offset)
+	{
+		return((offset + g_TableAlignment - 1) & ~(g_TableAlignment - 1));
+	}
+
+	/***********************************************************
+	 *  SceneSource
+	 *
+	 *  Parse state of one source file: the defined constants,
+	 *  colors and node names, and the tables being filled.
+	 ***********************************************************/
+	struct SceneSource
+	{
+		std::string path;
+		int line = 0;
+
+		std::map<std::string, float> constants;
+		std::map<std::string, std::vector<float>> colors;
+		std::map<std::string, int> nodeNames;
+
+		SceneCompiler::SCENE_TABLES tables;
+
+		bool Error(const std::string& message) const
+		{
+			std::cout << path << ":" << line << ": " << message << std::endl;
+			return(false);
+		}
+
+		// index of a tag in a texture or material table, added on first use
+		int32_t FindOrAddTag(std::vector<uint32_t>& table, const std::string& tag)
+		{
+			for (size_t i = 0; i < table.size(); i++)
+			{
+				if (tag == tables.strings.c_str() + table[i])
+				{
+					return(static_cast<int32_t>(i));
+				}
+			}
+			table.push_back(tables.AddString(tag));
+			return(static_cast<int32_t>(table.size() - 1));
+		}
+	};
+
+	/***********************************************************
+	 *  ExpressionParser
+	 *
+	 *  Recursive descent over one expression.  Operators of
+	 *  the same precedence group from the left, so the result
+	 *  rounds exactly like the same expression written with
+	 *  float literals in C++.
+	 ***********************************************************/
+	struct ExpressionParser
+	{
+		const SceneSource& source;
+		const char* pText;
+		std::string error;
+
+		void SkipSpaces()
+		{
+			while (isspace(static_cast<unsigned char>(*pText)))
+			{
+				pText++;
+			}
+		}
+
+		bool ParseSum(float& value)
+		{
+			if (!ParseProduct(value))
+			{
+				return(false);
+			}
+			for (;;)
+			{
+				SkipSpaces();
+				char op = *pText;
+				if ((op != '+') && (op != '-'))
+				{
+					return(true);
+				}
+				pText++;
+				float right = 0.0f;
+				if (!ParseProduct(right))
+				{
+					return(false);
+				}
+				value = (op == '+') ? value + right : value - right;
+			}
+		}
+
+		bool ParseProduct(float& value)
+		{
+			if (!ParseUnary(value))
+			{
+				return(false);
+			}
+			for (;;)
+			{
+				SkipSpaces();
+				char op = *pText;
+				if ((op != '*') && (op != '/'))
+				{
+					return(true);
+				}
+				pText++;
+				float right = 0.0f;
+				if (!ParseUnary(right))
+				{
+					return(false);
+				}
+				value = (op == '*') ? value * right : value / right;
+			}
+		}
+
+		bool ParseUnary(float& value)
+		{
+			SkipSpaces();
+			if (*pText == '-')
+			{
+				pText++;
+				if (!ParseUnary(value))
+				{
+					return(false);
+				}
+				value = -value;
+				return(true);
+			}
+			if (*pText == '+')
+			{
+				pText++;
+				return(ParseUnary(value));
+			}
+			return(ParsePrimary(value));
+		}
+
+		bool ParsePrimary(float& value)
+		{
+			SkipSpaces();
+			if (*pText == '(')
+			{
+				pText++;
+				if (!ParseSum(value))
+				{
+					return(false);
+				}
+				SkipSpaces();
+				if (*pText != ')')
+				{
+					error = "missing ')'";
+					return(false);
+				}
+				pText++;
+				return(true);
+			}
+
+			if (isdigit(static_cast<unsigned char>(*pText)) || (*pText == '.'))
+			{
+				// only decimal literals, so names like "inf" stay constants
+				const char* pStart = pText;
+				while (isdigit(static_cast<unsigned char>(*pText)) || (*pText == '.'))
+				{
+					pText++;
+				}
+				if ((*pText == 'e') || (*pText == 'E'))
+				{
+					const char* pExponent = pText + 1;
+					if ((*pExponent == '+') || (*pExponent == '-'))
+					{
+						pExponent++;
+					}
+					if (isdigit(static_cast<unsigned char>(*pExponent)))
+					{
+						pText = pExponent;
+						while (isdigit(static_cast<unsigned char>(*pText)))
+						{
+							pText++;
+						}
+					}
+				}
+
+				std::string literal(pStart, pText);
+				char* pEnd = NULL;
+				value = strtof(literal.c_str(), &pEnd);
+				if (*pEnd != '\0')
+				{
+					error = "bad number '" + literal + "'";
+					return(false);
+				}
+				return(true);
+			}
+
+			if (isalpha(static_cast<unsigned char>(*pText)) || (*pText == '_'))
+			{
+				const char* pStart = pText;
+				while (isalnum(static_cast<unsigned char>(*pText)) || (*pText == '_'))
+				{
+					pText++;
+				}
+				std::string name(pStart, pText);
+				auto constant = source.constants.find(name);
+				if (constant == source.constants.end())
+				{
+					error = "unknown constant '" + name + "'";
+					return(false);
+				}
+				value = constant->second;
+				return(true);
+			}
+
+			error = (*pText == '\0') ? "expression ends early" :
+				std::string("unexpected '") + *pText + "'";
+			return(false);
+		}
+	};
+
+	/***********************************************************
+	 *  ParseExpression()
+	 *
+	 *  Evaluate one whole expression.
+	 ***********************************************************/
+	bool ParseExpression(const SceneSource& source, const std::string& text, float& value)
+	{
+		ExpressionParser parser = { source, text.c_str(), std::string() };
+		if (!parser.ParseSum(value))
+		{
+			return(source.Error(parser.error + " in '" + text + "'"));
+		}
+		parser.SkipSpaces();
+		if (*parser.pText != '\0')
+		{
+			return(source.Error("unexpected '" + std::string(parser.pText) + "' in '" + text + "'"));
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ParseVector()
+	 *
+	 *  Evaluate a comma separated list of exactly count
+	 *  expressions.
+	 ***********************************************************/
+	bool ParseVector(const SceneSource& source, const std::string& text, int count, float* pValues)
+	{
+		std::vector<std::string> parts;
+		size_t start = 0;
+		for (;;)
+		{
+			size_t comma = text.find(',', start);
+			parts.push_back(text.substr(start, comma - start));
+			if (comma == std::string::npos)
+			{
+				break;
+			}
+			start = comma + 1;
+		}
+
+		if (static_cast<int>(parts.size()) != count)
+		{
+			return(source.Error("expected " + std::to_string(count) + " values in '" + text + "'"));
+		}
+		for (int i = 0; i < count; i++)
+		{
+			if (!ParseExpression(source, parts[i], pValues[i]))
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+
+	bool IsIdentifier(const std::string& text)
+	{
+		if (text.empty() || isdigit(static_cast<unsigned char>(text[0])))
+		{
+			return(false);
+		}
+		for (char c : text)
+		{
+			if (!isalnum(static_cast<unsigned char>(c)) && (c != '_'))
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  DefineNode()
+	 *
+	 *  Append a node under a parent name, and register its own
+	 *  name when it has one.
+	 ***********************************************************/
+	bool DefineNode(SceneSource& source, const std::string& parentName,
+		const std::string& name, const SceneFile::SCENE_NODE& local, uint32_t& node)
+	{
+		SceneFile::SCENE_NODE entry = local;
+		entry.parent = -1;
+		if (parentName != g_RootName)
+		{
+			auto parent = source.nodeNames.find(parentName);
+			if (parent == source.nodeNames.end())
+			{
+				return(source.Error("unknown parent '" + parentName + "'"));
+			}
+			entry.parent = parent->second;
+		}
+
+		node = static_cast<uint32_t>(source.tables.nodes.size());
+		source.tables.nodes.push_back(entry);
+
+		if (!name.empty())
+		{
+			if (!IsIdentifier(name) || (name == g_RootName))
+			{
+				return(source.Error("bad node name '" + name + "'"));
+			}
+			if (!source.nodeNames.emplace(name, static_cast<int>(node)).second)
+			{
+				return(source.Error("node '" + name + "' is already defined"));
+			}
+			SceneFile::SCENE_NAME named = { source.tables.AddString(name), node };
+			source.tables.names.push_back(named);
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ParseShape()
+	 *
+	 *  Parse the key=value tokens of a shape line into a node
+	 *  and a draw.
+	 ***********************************************************/
+	bool ParseShape(SceneSource& source, PrimitiveMeshes::PRIMITIVE primitive,
+		const std::vector<std::string>& tokens)
+	{
+		if (tokens.size() < 2)
+		{
+			return(source.Error("expected a parent after '" + tokens[0] + "'"));
+		}
+
+		SceneFile::SCENE_NODE node = {};
+		node.scale[0] = node.scale[1] = node.scale[2] = 1.0f;
+		SceneFile::SCENE_DRAW draw = {};
+		draw.mesh = static_cast<uint32_t>(primitive);
+		draw.texture = -1;
+		draw.material = -1;
+		draw.uvScale[0] = draw.uvScale[1] = 1.0f;
+
+		std::string name;
+		std::string texture;
+		bool bHasColor = false;
+		bool bHasScale = false;
+		bool bHasPosition = false;
+		bool bHasUV = false;
+		bool bHasAlpha = false;
+		float alpha = 1.0f;
+
+		for (size_t i = 2; i < tokens.size(); i++)
+		{
+			const std::string& token = tokens[i];
+			size_t equals = token.find('=');
+			if (equals == std::string::npos)
+			{
+				if (token == "overlay")
+				{
+					draw.flags |= SceneFile::DRAW_FLAG_OVERLAY;
+				}
+				else if (token == "movable")
+				{
+					draw.flags |= SceneFile::DRAW_FLAG_MOVABLE;
+				}
+				else if (token == "occluder")
+				{
+					draw.flags |= SceneFile::DRAW_FLAG_OCCLUDER;
+				}
+				else
+				{
+					return(source.Error("unknown flag '" + token + "'"));
+				}
+				continue;
+			}
+
+			std::string key = token.substr(0, equals);
+			std::string value = token.substr(equals + 1);
+			bool bParsed = true;
+			if (key == "name")
+			{
+				name = value;
+			}
+			else if (key == "scale")
+			{
+				bParsed = ParseVector(source, value, 3, node.scale);
+				bHasScale = true;
+			}
+			else if (key == "rot")
+			{
+				bParsed = ParseVector(source, value, 3, node.rotationDegrees);
+			}
+			else if (key == "pos")
+			{
+				bParsed = ParseVector(source, value, 3, node.position);
+				bHasPosition = true;
+			}
+			else if (key == "color")
+			{
+				auto color = source.colors.find(value);
+				if (color != source.colors.end())
+				{
+					memcpy(draw.color, color->second.data(), sizeof(draw.color));
+				}
+				else
+				{
+					bParsed = ParseVector(source, value, 4, draw.color);
+				}
+				bHasColor = true;
+			}
+			else if (key == "texture")
+			{
+				texture = value;
+			}
+			else if (key == "uv")
+			{
+				bParsed = ParseVector(source, value, 2, draw.uvScale);
+				bHasUV = true;
+			}
+			else if (key == "alpha")
+			{
+				bParsed = ParseExpression(source, value, alpha);
+				bHasAlpha = true;
+			}
+			else if (key == "material")
+			{
+				draw.material = source.FindOrAddTag(source.tables.materials, value);
+			}
+			else
+			{
+				return(source.Error("unknown key '" + key + "'"));
+			}
+
+			if (!bParsed)
+			{
+				return(false);
+			}
+		}
+
+		if (!bHasScale || !bHasPosition)
+		{
+			return(source.Error("a shape needs scale= and pos="));
+		}
+		if (texture.empty() == !bHasColor)
+		{
+			return(source.Error("a shape needs exactly one of color= or texture="));
+		}
+		if (texture.empty() && (bHasUV || bHasAlpha))
+		{
+			return(source.Error("uv= and alpha= only apply to textured shapes"));
+		}
+
+		// textured draws are tinted white, only their alpha is kept
+		if (!texture.empty())
+		{
+			draw.texture = source.FindOrAddTag(source.tables.textures, texture);
+			draw.color[0] = draw.color[1] = draw.color[2] = 1.0f;
+			draw.color[3] = alpha;
+		}
+
+		if (!DefineNode(source, tokens[1], name, node, draw.node))
+		{
+			return(false);
+		}
+		source.tables.draws.push_back(draw);
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ParseLine()
+	 *
+	 *  Parse one statement.  Blank lines have no tokens.
+	 ***********************************************************/
+	bool ParseLine(SceneSource& source, const std::string& text)
+	{
+		std::istringstream stream(text.substr(0, text.find('#')));
+		std::vector<std::string> tokens;
+		std::string token;
+		while (stream >> token)
+		{
+			tokens.push_back(token);
+		}
+		if (tokens.empty())
+		{
+			return(true);
+		}
+
+		const std::string& keyword = tokens[0];
+		if (keyword == "const")
+		{
+			if ((tokens.size() < 3) || !IsIdentifier(tokens[1]))
+			{
+				return(source.Error("expected 'const NAME EXPR'"));
+			}
+			std::string expression;
+			for (size_t i = 2; i < tokens.size(); i++)
+			{
+				expression += tokens[i];
+			}
+			float value = 0.0f;
+			if (!ParseExpression(source, expression, value))
+			{
+				return(false);
+			}
+			source.constants[tokens[1]] = value;
+			return(true);
+		}
+
+		if (keyword == "color")
+		{
+			if ((tokens.size() != 3) || !IsIdentifier(tokens[1]))
+			{
+				return(source.Error("expected 'color NAME r,g,b,a'"));
+			}
+			std::vector<float> color(4);
+			if (!ParseVector(source, tokens[2], 4, color.data()))
+			{
+				return(false);
+			}
+			source.colors[tokens[1]] = color;
+			return(true);
+		}
+
+		if (keyword == "anchor")
+		{
+			if ((tokens.size() != 4) || (tokens[3].compare(0, 4, "pos=") != 0))
+			{
+				return(source.Error("expected 'anchor NAME PARENT pos=x,y,z'"));
+			}
+			SceneFile::SCENE_NODE node = {};
+			node.scale[0] = node.scale[1] = node.scale[2] = 1.0f;
+			if (!ParseVector(source, tokens[3].substr(4), 3, node.position))
+			{
+				return(false);
+			}
+			uint32_t index = 0;
+			return(DefineNode(source, tokens[2], tokens[1], node, index));
+		}
+
+		for (const SHAPE_KEYWORD& shape : g_ShapeKeywords)
+		{
+			if (keyword == shape.keyword)
+			{
+				return(ParseShape(source, shape.primitive, tokens));
+			}
+		}
+
+		return(source.Error("unknown statement '" + keyword + "'"));
+	}
+
+	/***********************************************************
+	 *  WriteTable()
+	 *
+	 *  Pad the file to the table alignment and write the
+	 *  entries, returning where they start.
+	 ***********************************************************/
+	template <typename T>
+	uint64_t WriteTable(std::ofstream& file, uint64_t& offset, const T* pEntries, size_t count)
+	{
+		static const char padding[g_TableAlignment] = {};
+		uint64_t start = AlignTable(offset);
+		file.write(padding, static_cast<std::streamsize>(start - offset));
+		file.write(reinterpret_cast<const char*>(pEntries),
+			static_cast<std::streamsize>(count * sizeof(T)));
+		offset = start + count * sizeof(T);
+		return(start);
+	}
+}
+
+/***********************************************************
+ *  AddString()
+ *
+ *  This method is used for appending a string to the string
+ *  table.
+ ***********************************************************/
+uint32_t SceneCompiler::SCENE_TABLES::AddString(const std::string& text)
+{
+	uint32_t offset = static_cast<uint32_t>(strings.size());
+	strings.append(text);
+	strings.push_back('\0');
+	return(offset);
+}
+
+/***********************************************************
+ *  Compile()
+ *
+ *  This method is used for parsing a scene source and
+ *  writing its compiled tables.
+ ***********************************************************/
+bool SceneCompiler::Compile(const char* sourcePath, const char* targetPath)
+{
+	std::ifstream file(sourcePath);
+	if (!file)
+	{
+		std::cout << "Could not open scene source " << sourcePath << std::endl;
+		return(false);
+	}
+
+	SceneSource source;
+	source.path = sourcePath;
+	std::string text;
+	while (std::getline(file, text))
+	{
+		source.line++;
+		if (!text.empty() && (text.back() == '\r'))
+		{
+			text.pop_back();
+		}
+		if (!ParseLine(source, text))
+		{
+			return(false);
+		}
+	}
+
+	return(Write(source.tables, targetPath));
+}
+
+/***********************************************************
+ *  Write()
+ *
+ *  This method is used for writing the tables straight to
+ *  the file, without gathering them in one buffer first.
+ *  The header is written last, once the offsets are known.
+ *  The file is written under a temporary name and renamed
+ *  so that a running loader never maps a half written file.
+ ***********************************************************/
+bool SceneCompiler::Write(const SCENE_TABLES& tables, const char* targetPath)
+{
+	namespace fs = std::filesystem;
+	std::error_code error;
+
+	SceneFile::SCENE_HEADER header = {};
+	memcpy(header.magic, SceneFile::MAGIC, sizeof(header.magic));
+	header.version = SceneFile::VERSION;
+	header.nodeCount = static_cast<uint32_t>(tables.nodes.size());
+	header.drawCount = static_cast<uint32_t>(tables.draws.size());
+	header.nameCount = static_cast<uint32_t>(tables.names.size());
+	header.textureCount = static_cast<uint32_t>(tables.textures.size());
+	header.materialCount = static_cast<uint32_t>(tables.materials.size());
+	header.stringSize = static_cast<uint32_t>(tables.strings.size());
+
+	fs::path target(targetPath);
+	if (target.has_parent_path())
+	{
+		fs::create_directories(target.parent_path(), error);
+	}
+
+	std::string temporaryPath = std::string(targetPath) + ".tmp";
+	{
+		std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+		uint64_t offset = sizeof(header);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		header.nodeOffset = WriteTable(out, offset, tables.nodes.data(), tables.nodes.size());
+		header.drawOffset = WriteTable(out, offset, tables.draws.data(), tables.draws.size());
+		header.nameOffset = WriteTable(out, offset, tables.names.data(), tables.names.size());
+		header.textureOffset = WriteTable(out, offset, tables.textures.data(), tables.textures.size());
+		header.materialOffset = WriteTable(out, offset, tables.materials.data(), tables.materials.size());
+		header.stringOffset = WriteTable(out, offset, tables.strings.data(), tables.strings.size());
+		out.seekp(0);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		if (!out)
+		{
+			out.close();
+			fs::remove(temporaryPath, error);
+			std::cout << "Could not write compiled scene " << targetPath << std::endl;
+			return(false);
+		}
+	}
+
+	fs::rename(temporaryPath, target, error);
+	if (error)
+	{
+		fs::remove(temporaryPath, error);
+		std::cout << "Could not write compiled scene " << targetPath << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  IsStale()
+ *
+ *  This method is used for checking whether a compiled
+ *  scene has to be rebuilt from its source.
+ ***********************************************************/
+bool SceneCompiler::IsStale(const char* sourcePath, const char* targetPath)
+{
+	namespace fs = std::filesystem;
+	std::error_code error;
+
+	fs::file_time_type targetTime = fs::last_write_time(targetPath, error);
+	if (error)
+	{
+		return(true);
+	}
+	fs::file_time_type sourceTime = fs::last_write_time(sourcePath, error);
+	if (error)
+	{
+		// without a source the compiled scene is all there is
+		return(false);
+	}
+	return(sourceTime > targetTime);
+}
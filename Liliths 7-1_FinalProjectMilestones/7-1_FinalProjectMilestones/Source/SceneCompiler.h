@@ -0,0 +1,60 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenecompiler.h
+// ============
+// compile the text scene description into the binary scene format
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneFile.h"
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  SceneCompiler
+ *
+ *  This class turns a human editable .scene source into the
+ *  binary layout read by SceneFile.  The source is line
+ *  based, '#' starts a comment, and each line holds one of:
+ *
+ *    const NAME EXPR
+ *    color NAME r,g,b,a
+ *    anchor NAME PARENT pos=x,y,z
+ *    SHAPE PARENT [name=NAME] scale=x,y,z [rot=x,y,z] pos=x,y,z
+ *        (color=NAME|color=r,g,b,a | texture=TAG [uv=u,v] [alpha=a])
+ *        [material=TAG] [overlay] [movable] [occluder]
+ *
+ *  SHAPE is box, cylinder, sphere or plane and PARENT is
+ *  "root" or a name defined on an earlier line.  Values are
+ *  expressions of numbers and constants with + - * / and
+ *  parentheses, evaluated in single precision from left to
+ *  right the same way the equivalent C++ float code is.
+ ***********************************************************/
+class SceneCompiler
+{
+public:
+	// contents of a compiled scene before it is written
+	struct SCENE_TABLES
+	{
+		std::vector<SceneFile::SCENE_NODE> nodes;
+		std::vector<SceneFile::SCENE_DRAW> draws;
+		std::vector<SceneFile::SCENE_NAME> names;
+		// offsets of the tags in the string table
+		std::vector<uint32_t> textures;
+		std::vector<uint32_t> materials;
+		// NUL terminated strings back to back
+		std::string strings;
+
+		// append a string and return its offset
+		uint32_t AddString(const std::string& text);
+	};
+
+	// compile a source file, errors are printed as file:line
+	static bool Compile(const char* sourcePath, const char* targetPath);
+	// true when the target is missing or older than the source
+	static bool IsStale(const char* sourcePath, const char* targetPath);
+	// write tables built in memory as a compiled scene
+	static bool Write(const SCENE_TABLES& tables, const char* targetPath);
+};
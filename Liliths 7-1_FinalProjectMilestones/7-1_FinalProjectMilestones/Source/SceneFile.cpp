@@ -0,0 +1,211 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// compiled binary scene description, read in place from a mapping
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+#include "PrimitiveMeshes.h"
+
+#include <cstring>
+#include <iostream>
+
+static_assert(sizeof(SceneFile::SCENE_HEADER) == 80, "SCENE_HEADER layout");
+static_assert(sizeof(SceneFile::SCENE_NODE) == 40, "SCENE_NODE layout");
+static_assert(sizeof(SceneFile::SCENE_DRAW) == 48, "SCENE_DRAW layout");
+static_assert(sizeof(SceneFile::SCENE_NAME) == 8, "SCENE_NAME layout");
+
+const char SceneFile::MAGIC[4] = { 'S', 'C', 'N', '1' };
+
+/***********************************************************
+ *  SceneFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneFile::SceneFile()
+{
+	m_pHeader = NULL;
+	m_pNodes = NULL;
+	m_pDraws = NULL;
+	m_pNames = NULL;
+	m_pTextures = NULL;
+	m_pMaterials = NULL;
+	m_pStrings = NULL;
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping a compiled scene and
+ *  pointing the tables into the mapping.  Everything is
+ *  checked here so that reading the tables later needs no
+ *  bounds checks.
+ ***********************************************************/
+bool SceneFile::Open(const char* path)
+{
+	Close();
+
+	if (!m_file.Open(path))
+	{
+		return(false);
+	}
+
+	const unsigned char* pData = m_file.GetData();
+	const SCENE_HEADER* pHeader = reinterpret_cast<const SCENE_HEADER*>(pData);
+	if ((m_file.GetSize() < sizeof(SCENE_HEADER)) ||
+		(memcmp(pHeader->magic, MAGIC, sizeof(MAGIC)) != 0) ||
+		(pHeader->version != VERSION))
+	{
+		std::cout << "Not a compiled scene of this version: " << path << std::endl;
+		m_file.Close();
+		return(false);
+	}
+
+	m_pHeader = pHeader;
+	if (!IsTableValid(pHeader->nodeOffset, pHeader->nodeCount, sizeof(SCENE_NODE)) ||
+		!IsTableValid(pHeader->drawOffset, pHeader->drawCount, sizeof(SCENE_DRAW)) ||
+		!IsTableValid(pHeader->nameOffset, pHeader->nameCount, sizeof(SCENE_NAME)) ||
+		!IsTableValid(pHeader->textureOffset, pHeader->textureCount, sizeof(uint32_t)) ||
+		!IsTableValid(pHeader->materialOffset, pHeader->materialCount, sizeof(uint32_t)) ||
+		!IsTableValid(pHeader->stringOffset, pHeader->stringSize, 1))
+	{
+		std::cout << "Compiled scene tables out of range: " << path << std::endl;
+		Close();
+		return(false);
+	}
+
+	m_pNodes = reinterpret_cast<const SCENE_NODE*>(pData + pHeader->nodeOffset);
+	m_pDraws = reinterpret_cast<const SCENE_DRAW*>(pData + pHeader->drawOffset);
+	m_pNames = reinterpret_cast<const SCENE_NAME*>(pData + pHeader->nameOffset);
+	m_pTextures = reinterpret_cast<const uint32_t*>(pData + pHeader->textureOffset);
+	m_pMaterials = reinterpret_cast<const uint32_t*>(pData + pHeader->materialOffset);
+	m_pStrings = reinterpret_cast<const char*>(pData + pHeader->stringOffset);
+
+	if (!Validate())
+	{
+		std::cout << "Compiled scene is corrupt: " << path << std::endl;
+		Close();
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for releasing the mapping.
+ ***********************************************************/
+void SceneFile::Close()
+{
+	m_file.Close();
+	m_pHeader = NULL;
+	m_pNodes = NULL;
+	m_pDraws = NULL;
+	m_pNames = NULL;
+	m_pTextures = NULL;
+	m_pMaterials = NULL;
+	m_pStrings = NULL;
+}
+
+/***********************************************************
+ *  FindNode()
+ *
+ *  This method is used for finding the node of a name.
+ ***********************************************************/
+int SceneFile::FindNode(const char* name) const
+{
+	if ((NULL == m_pHeader) || (NULL == name))
+	{
+		return(-1);
+	}
+
+	for (uint32_t i = 0; i < m_pHeader->nameCount; i++)
+	{
+		if (strcmp(m_pStrings + m_pNames[i].stringOffset, name) == 0)
+		{
+			return(static_cast<int>(m_pNames[i].node));
+		}
+	}
+	return(-1);
+}
+
+/***********************************************************
+ *  IsTableValid()
+ *
+ *  This method is used for checking that a table starts on
+ *  an 8 byte boundary and ends inside the file.
+ ***********************************************************/
+bool SceneFile::IsTableValid(uint64_t offset, uint64_t count, size_t entrySize) const
+{
+	uint64_t fileSize = m_file.GetSize();
+	if ((offset % 8 != 0) || (offset > fileSize))
+	{
+		return(false);
+	}
+	return(count <= (fileSize - offset) / entrySize);
+}
+
+/***********************************************************
+ *  Validate()
+ *
+ *  This method is used for checking every parent, node,
+ *  mesh and string reference of the mapped tables.
+ ***********************************************************/
+bool SceneFile::Validate() const
+{
+	const SCENE_HEADER& header = *m_pHeader;
+
+	// every string must end inside the string data, which only
+	// matters when something refers to a string
+	bool bStringsValid = (header.stringSize > 0) && (m_pStrings[header.stringSize - 1] == '\0');
+	if (!bStringsValid && (header.textureCount + header.materialCount + header.nameCount > 0))
+	{
+		return(false);
+	}
+
+	for (uint32_t i = 0; i < header.nodeCount; i++)
+	{
+		if ((m_pNodes[i].parent < -1) || (m_pNodes[i].parent >= static_cast<int32_t>(i)))
+		{
+			return(false);
+		}
+	}
+
+	for (uint32_t i = 0; i < header.drawCount; i++)
+	{
+		const SCENE_DRAW& draw = m_pDraws[i];
+		if ((draw.node >= header.nodeCount) ||
+			(draw.mesh >= static_cast<uint32_t>(PrimitiveMeshes::PRIMITIVE_COUNT)) ||
+			(draw.texture < -1) || (draw.texture >= static_cast<int32_t>(header.textureCount)) ||
+			(draw.material < -1) || (draw.material >= static_cast<int32_t>(header.materialCount)))
+		{
+			return(false);
+		}
+	}
+
+	for (uint32_t i = 0; i < header.nameCount; i++)
+	{
+		if ((m_pNames[i].node >= header.nodeCount) || (m_pNames[i].stringOffset >= header.stringSize))
+		{
+			return(false);
+		}
+	}
+	for (uint32_t i = 0; i < header.textureCount; i++)
+	{
+		if (m_pTextures[i] >= header.stringSize)
+		{
+			return(false);
+		}
+	}
+	for (uint32_t i = 0; i < header.materialCount; i++)
+	{
+		if (m_pMaterials[i] >= header.stringSize)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
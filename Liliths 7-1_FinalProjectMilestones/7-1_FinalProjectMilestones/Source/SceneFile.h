@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// compiled binary scene description, read in place from a mapping
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/***********************************************************
+ *  SceneFile
+ *
+ *  This class maps a compiled scene and checks its layout
+ *  once, after which the nodes, draws and string tables are
+ *  read straight out of the mapping.  The file is little
+ *  endian and every table starts on an 8 byte boundary:
+ *
+ *    SCENE_HEADER
+ *    SCENE_NODE[nodeCount]       parents before children
+ *    SCENE_DRAW[drawCount]
+ *    SCENE_NAME[nameCount]       named nodes
+ *    uint32_t[textureCount]      texture tag offsets
+ *    uint32_t[materialCount]     material tag offsets
+ *    char[]                      NUL terminated strings
+ *
+ *  SceneCompiler writes these files from the text format.
+ ***********************************************************/
+class SceneFile
+{
+public:
+	// bump when the layout changes
+	static const uint32_t VERSION = 1;
+
+	// draw flags
+	enum DRAW_FLAG
+	{
+		// drawn after the opaque draws without writing depth
+		DRAW_FLAG_OVERLAY = 1,
+		// may move at runtime, kept out of static batches
+		DRAW_FLAG_MOVABLE = 2,
+		// large solid box or plane that hides what is behind it
+		DRAW_FLAG_OCCLUDER = 4
+	};
+
+	struct SCENE_HEADER
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t nodeCount;
+		uint32_t drawCount;
+		uint32_t nameCount;
+		uint32_t textureCount;
+		uint32_t materialCount;
+		uint32_t stringSize;
+		uint64_t nodeOffset;
+		uint64_t drawOffset;
+		uint64_t nameOffset;
+		uint64_t textureOffset;
+		uint64_t materialOffset;
+		uint64_t stringOffset;
+	};
+
+	// local transform of one node, -1 parent for a root node
+	struct SCENE_NODE
+	{
+		int32_t parent;
+		float scale[3];
+		float rotationDegrees[3];
+		float position[3];
+	};
+
+	// one draw of a primitive placed by a node
+	struct SCENE_DRAW
+	{
+		uint32_t node;
+		// PrimitiveMeshes::PRIMITIVE
+		uint32_t mesh;
+		// index into the texture or material table, or -1
+		int32_t texture;
+		int32_t material;
+		float color[4];
+		float uvScale[2];
+		uint32_t flags;
+		uint32_t reserved;
+	};
+
+	// name of a node, for finding it at runtime
+	struct SCENE_NAME
+	{
+		uint32_t stringOffset;
+		uint32_t node;
+	};
+
+	// constructor
+	SceneFile();
+
+	// map a compiled scene, false if it is missing or malformed
+	bool Open(const char* path);
+	void Close();
+	bool IsOpen() const { return m_pHeader != NULL; }
+
+	int GetNodeCount() const { return static_cast<int>(m_pHeader->nodeCount); }
+	int GetDrawCount() const { return static_cast<int>(m_pHeader->drawCount); }
+	int GetTextureCount() const { return static_cast<int>(m_pHeader->textureCount); }
+	int GetMaterialCount() const { return static_cast<int>(m_pHeader->materialCount); }
+	int GetNameCount() const { return static_cast<int>(m_pHeader->nameCount); }
+	const SCENE_NODE* GetNodes() const { return m_pNodes; }
+	const SCENE_DRAW* GetDraws() const { return m_pDraws; }
+	const SCENE_NAME* GetNames() const { return m_pNames; }
+	const char* GetString(uint32_t stringOffset) const { return m_pStrings + stringOffset; }
+	const char* GetTexture(int index) const { return m_pStrings + m_pTextures[index]; }
+	const char* GetMaterial(int index) const { return m_pStrings + m_pMaterials[index]; }
+	// node of a name, or -1
+	int FindNode(const char* name) const;
+
+	// magic at the start of every compiled scene
+	static const char MAGIC[4];
+
+private:
+	MappedFile m_file;
+	const SCENE_HEADER* m_pHeader;
+	const SCENE_NODE* m_pNodes;
+	const SCENE_DRAW* m_pDraws;
+	const SCENE_NAME* m_pNames;
+	const uint32_t* m_pTextures;
+	const uint32_t* m_pMaterials;
+	const char* m_pStrings;
+
+	// check that a table lies inside the file on an 8 byte boundary
+	bool IsTableValid(uint64_t offset, uint64_t count, size_t entrySize) const;
+	// check every index of the mapped tables
+	bool Validate() const;
+};
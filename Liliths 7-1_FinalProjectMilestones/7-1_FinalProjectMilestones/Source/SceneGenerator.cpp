@@ -0,0 +1,214 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegenerator.cpp
+// ============
+// tile copies of a compiled scene into a large stress scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneGenerator.h"
+#include "SceneCompiler.h"
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// the desk carpet is 8 units square, so copies this far
+	// apart tile the floor without overlapping
+	const float g_DefaultSpacing = 8.0f;
+	const unsigned int g_DefaultSeed = 12345;
+
+	// multipliers for the flat colors of a copy
+	const float g_TintPalette[][3] =
+	{
+		{ 1.00f, 1.00f, 1.00f },
+		{ 0.85f, 0.90f, 1.00f },
+		{ 1.00f, 0.90f, 0.80f },
+		{ 0.80f, 1.00f, 0.85f }
+	};
+	const int g_TintCount = sizeof(g_TintPalette) / sizeof(g_TintPalette[0]);
+
+	// how far the movable objects of a copy are slid and turned
+	const float g_MovableOffset = 0.05f;
+	const float g_MovableTurnDegrees = 25.0f;
+
+	/***********************************************************
+	 *  NextRandom()
+	 *
+	 *  Xorshift step.  The standard distributions differ
+	 *  between library vendors, so the generator does its own
+	 *  to write the same scene on every platform.
+	 ***********************************************************/
+	uint32_t NextRandom(uint32_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return(state);
+	}
+
+	/***********************************************************
+	 *  RandomRange()
+	 *
+	 *  Uniform value between low and high from the top 24 bits
+	 *  of the next xorshift step.
+	 ***********************************************************/
+	float RandomRange(uint32_t& state, float low, float high)
+	{
+		float unit = static_cast<float>(NextRandom(state) >> 8) * (1.0f / 16777216.0f);
+		return(low + (high - low) * unit);
+	}
+
+	/***********************************************************
+	 *  ColumnCell()
+	 *
+	 *  Grid cell of a column.  The offsets run 0, 1, -1, 2,
+	 *  -2, ... so copy 0 stays in the middle of the grid.
+	 ***********************************************************/
+	int ColumnCell(int column)
+	{
+		return((column % 2 == 1) ? (column + 1) / 2 : -(column / 2));
+	}
+}
+
+/***********************************************************
+ *  GetDefaultSettings()
+ *
+ *  This method is used for getting the settings of a stress
+ *  scene made of the passed in number of desks.
+ ***********************************************************/
+SceneGenerator::GENERATOR_SETTINGS SceneGenerator::GetDefaultSettings(int copyCount)
+{
+	GENERATOR_SETTINGS settings;
+	settings.copyCount = copyCount;
+	settings.seed = g_DefaultSeed;
+	settings.spacing = g_DefaultSpacing;
+	return(settings);
+}
+
+/***********************************************************
+ *  Generate()
+ *
+ *  This method is used for building the tables of the grid
+ *  of copies and writing them as a compiled scene.  The
+ *  texture and material tables of the template are shared
+ *  by every copy.
+ ***********************************************************/
+bool SceneGenerator::Generate(
+	const SceneFile& templateScene,
+	const GENERATOR_SETTINGS& settings,
+	const char* targetPath)
+{
+	if (!templateScene.IsOpen() || (settings.copyCount <= 0))
+	{
+		return(false);
+	}
+
+	const int templateNodes = templateScene.GetNodeCount();
+	const int templateDraws = templateScene.GetDrawCount();
+	const SceneFile::SCENE_NODE* pNodes = templateScene.GetNodes();
+	const SceneFile::SCENE_DRAW* pDraws = templateScene.GetDraws();
+
+	// every copy adds a root node in front of the template nodes
+	const uint64_t nodeCount = static_cast<uint64_t>(settings.copyCount) * (templateNodes + 1);
+	const uint64_t drawCount = static_cast<uint64_t>(settings.copyCount) * templateDraws;
+	if ((nodeCount > static_cast<uint64_t>(std::numeric_limits<int>::max())) ||
+		(drawCount > static_cast<uint64_t>(std::numeric_limits<int>::max())))
+	{
+		std::cout << "Too many copies for one scene: " << settings.copyCount << std::endl;
+		return(false);
+	}
+
+	SceneCompiler::SCENE_TABLES tables;
+	tables.nodes.reserve(static_cast<size_t>(nodeCount));
+	tables.draws.reserve(static_cast<size_t>(drawCount));
+
+	for (int i = 0; i < templateScene.GetTextureCount(); i++)
+	{
+		tables.textures.push_back(tables.AddString(templateScene.GetTexture(i)));
+	}
+	for (int i = 0; i < templateScene.GetMaterialCount(); i++)
+	{
+		tables.materials.push_back(tables.AddString(templateScene.GetMaterial(i)));
+	}
+
+	// the movable objects of each copy move together
+	std::vector<unsigned char> movableNodes(templateNodes, 0);
+	for (int i = 0; i < templateDraws; i++)
+	{
+		if (pDraws[i].flags & SceneFile::DRAW_FLAG_MOVABLE)
+		{
+			movableNodes[pDraws[i].node] = 1;
+		}
+	}
+
+	uint32_t state = settings.seed ^ 0x9E3779B9u;
+	if (0 == state)
+	{
+		state = 1;
+	}
+
+	const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(settings.copyCount))));
+	for (int copy = 0; copy < settings.copyCount; copy++)
+	{
+		const int32_t root = static_cast<int32_t>(tables.nodes.size());
+		const uint32_t firstNode = static_cast<uint32_t>(root + 1);
+
+		SceneFile::SCENE_NODE rootNode = {};
+		rootNode.parent = -1;
+		rootNode.scale[0] = rootNode.scale[1] = rootNode.scale[2] = 1.0f;
+		rootNode.rotationDegrees[1] = 90.0f * static_cast<float>(NextRandom(state) % 4);
+		rootNode.position[0] = settings.spacing * ColumnCell(copy % columns);
+		rootNode.position[2] = -settings.spacing * (copy / columns);
+		// copy 0 is left as the template is, where the camera looks
+		if (0 == copy)
+		{
+			rootNode.rotationDegrees[1] = 0.0f;
+		}
+		tables.nodes.push_back(rootNode);
+
+		const float* pTint = g_TintPalette[NextRandom(state) % g_TintCount];
+		const float slideX = RandomRange(state, -g_MovableOffset, g_MovableOffset);
+		const float slideZ = RandomRange(state, -g_MovableOffset, g_MovableOffset);
+		const float turn = RandomRange(state, -g_MovableTurnDegrees, g_MovableTurnDegrees);
+
+		for (int i = 0; i < templateNodes; i++)
+		{
+			SceneFile::SCENE_NODE node = pNodes[i];
+			node.parent = (node.parent < 0) ? root : static_cast<int32_t>(firstNode) + node.parent;
+			if (movableNodes[i] && (copy > 0))
+			{
+				node.position[0] += slideX;
+				node.position[2] += slideZ;
+				node.rotationDegrees[1] += turn;
+			}
+			tables.nodes.push_back(node);
+		}
+
+		for (int i = 0; i < templateDraws; i++)
+		{
+			SceneFile::SCENE_DRAW draw = pDraws[i];
+			draw.node += firstNode;
+			if ((draw.texture < 0) && (copy > 0))
+			{
+				draw.color[0] *= pTint[0];
+				draw.color[1] *= pTint[1];
+				draw.color[2] *= pTint[2];
+			}
+			tables.draws.push_back(draw);
+		}
+	}
+
+	// only the first copy is named, so FindSceneNode() finds it
+	for (int i = 0; i < templateScene.GetNameCount(); i++)
+	{
+		const SceneFile::SCENE_NAME& name = templateScene.GetNames()[i];
+		SceneFile::SCENE_NAME named = { tables.AddString(templateScene.GetString(name.stringOffset)), name.node + 1 };
+		tables.names.push_back(named);
+	}
+
+	return(SceneCompiler::Write(tables, targetPath));
+}
@@ -0,0 +1,49 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegenerator.h
+// ============
+// tile copies of a compiled scene into a large stress scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneFile.h"
+
+/***********************************************************
+ *  SceneGenerator
+ *
+ *  This class writes a compiled scene holding a grid of
+ *  copies of a template scene, for measuring how the render
+ *  paths scale with the object count.  Each copy hangs off
+ *  its own root node, so the template keeps its hierarchy.
+ *  Copy 0 sits at the origin and keeps the template node
+ *  names; the columns alternate left and right of it and
+ *  the rows go back away from the camera.
+ *
+ *  The copies vary with a seeded generator, so the same
+ *  settings always write the same scene:
+ *    - each copy faces one of the four quarter turns
+ *    - flat colors are tinted from a small palette, which
+ *      keeps the number of distinct draw states bounded
+ *    - the movable objects are slid and turned a little
+ ***********************************************************/
+class SceneGenerator
+{
+public:
+	struct GENERATOR_SETTINGS
+	{
+		int copyCount;
+		unsigned int seed;
+		// distance between neighbouring copies
+		float spacing;
+	};
+
+	// settings for a count of copies of the desk scene
+	static GENERATOR_SETTINGS GetDefaultSettings(int copyCount);
+
+	// write the grid of copies as a compiled scene
+	static bool Generate(
+		const SceneFile& templateScene,
+		const GENERATOR_SETTINGS& settings,
+		const char* targetPath);
+};
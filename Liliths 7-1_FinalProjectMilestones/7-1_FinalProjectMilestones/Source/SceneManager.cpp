@@ -8,6 +8,9 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "Profiler.h"
+#include "SceneCompiler.h"
+#include "SceneGenerator.h"
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -15,7 +18,7 @@
 #include <glm/gtx/transform.hpp>
 #include <filesystem>
 
-static std::string FindTexturesBase()
+static std::string FindAssetBase(const char* folder, const char* probeFile)
 {
 	namespace fs = std::filesystem;
 
@@ -26,24 +29,73 @@ static std::string FindTexturesBase()
 		printed = true;
 	}
 
-	// Try a few likely bases (first that contains wood_oak.jpg wins)
+	// Try a few likely bases (first that contains the probe file wins)
 	const char* candidates[] = {
-		"../Utilities/textures/",
-		"../../Utilities/textures/",
-		"./Utilities/textures/",
-		"./textures/",
-		"../textures/",
-		"../../../Utilities/textures/"
+		"../Utilities/",
+		"../../Utilities/",
+		"./Utilities/",
+		"./",
+		"../",
+		"../../../Utilities/"
 	};
 
-	for (auto base : candidates)
+	for (auto prefix : candidates)
 	{
-		if (fs::exists(fs::path(base) / "wood_oak.jpg"))
+		std::string base = std::string(prefix) + folder + "/";
+		if (fs::exists(fs::path(base) / probeFile))
 			return base;
 	}
 
-	std::cout << "Could not locate textures folder from CWD" << std::endl;
-	return ""; // fall through; CreateGLTexture will then print errors
+	std::cout << "Could not locate " << folder << " folder from CWD" << std::endl;
+	return ""; // fall through; the loaders will then print errors
+}
+
+static std::string FindTexturesBase()
+{
+	return FindAssetBase("textures", "wood_oak.jpg");
+}
+
+static std::string FindTextureCacheFolder(const std::string& texturesBase)
+{
+	return texturesBase.empty() ? std::string() : texturesBase + "cache/";
+}
+
+static std::string FindSceneSource(const std::string& scenePath)
+{
+	if (!scenePath.empty())
+		return scenePath;
+
+	const std::string base = FindAssetBase("scenes", "desk.scene");
+	return base.empty() ? std::string() : base + "desk.scene";
+}
+
+// scenes/desk.scene compiles to scenes/cache/desk.sceneb
+static std::string GetCompiledScenePath(const std::string& sourcePath)
+{
+	namespace fs = std::filesystem;
+
+	fs::path source(sourcePath);
+	if (source.extension() == ".sceneb")
+		return sourcePath;
+	return (source.parent_path() / "cache" / source.stem()).string() + ".sceneb";
+}
+
+// compile the scene source when it is newer than the compiled
+// scene, returns the compiled path or empty on failure
+static std::string UpdateCompiledScene(const std::string& scenePath)
+{
+	const std::string source = FindSceneSource(scenePath);
+	if (source.empty())
+		return "";
+
+	const std::string compiled = GetCompiledScenePath(source);
+	if ((compiled != source) && SceneCompiler::IsStale(source.c_str(), compiled.c_str()))
+	{
+		if (!SceneCompiler::Compile(source.c_str(), compiled.c_str()))
+			return "";
+		std::cout << "Compiled scene: " << compiled << std::endl;
+	}
+	return compiled;
 }
 
 // declaration of global variables
@@ -54,6 +106,46 @@ namespace
 	const char* g_TextureValueName = "objectTexture";
 	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+	const char* g_MaterialIndexName = "materialIndex";
+	const char* g_UVScaleName = "UVscale";
+
+	// most texture units the loaded textures are spread over, the
+	// last one is kept for the texture array
+	const int g_MaxTextureUnits = 16;
+	const int g_TextureArrayUnit = g_MaxTextureUnits - 1;
+	const char* g_TextureArrayName = "objectTextureArray";
+	// set when the primitive meshes are packed
+	const char* g_OctahedralNormalsName = "bOctahedralNormals";
+	// mid grey shown until a streamed texture is resident
+	const unsigned char g_PlaceholderPixel[4] = { 128, 128, 128, 255 };
+
+	// image files of the scene and the tags they are loaded under
+	struct SCENE_TEXTURE
+	{
+		const char* filename;
+		const char* tag;
+	};
+	const SCENE_TEXTURE g_SceneTextures[] =
+	{
+		{ "wood_oak.jpg", "TEX_WOOD" },
+		{ "black_plastic.jpg", "TEX_PLASTIC" },
+		{ "fabric_dark.jpg", "TEX_FABRIC" },
+		{ "paint_wall.jpg", "TEX_WALL" },
+		{ "carpet.jpg", "TEX_CARPET" },
+		{ "monitor_bezel.png", "TEX_BEZEL" },
+		{ "monitor_screen.jpg", "TEX_SCREEN" },
+		{ "gloss_reflection.png", "TEX_GLOSS" }
+	};
+
+	// records per job of the loops over the draw list, a
+	// multiple of the four boxes the frustum test takes per step
+	const int g_RecordsPerJob = 256;
+
+	// shaders of the instanced render path
+	const char* g_InstancedVertexShader = "instancedVertexShader.glsl";
+	const char* g_InstancedFragmentShader = "instancedFragmentShader.glsl";
+	// the indirect path only has a vertex shader of its own
+	const char* g_IndirectVertexShader = "indirectVertexShader.glsl";
 }
 
 /***********************************************************
@@ -61,11 +153,41 @@ namespace
  *
  *  The constructor for the class
  ***********************************************************/
-SceneManager::SceneManager(ShaderManager* pShaderManager)
+SceneManager::SceneManager(ShaderManager* pShaderManager, GLStateCache* pStateCache)
 {
 	m_pShaderManager = pShaderManager;
+	m_pStateCache = pStateCache;
 	m_basicMeshes = new ShapeMeshes();
-	m_loadedTextures = 0;        // <<< add this
+	m_textureUnitCount = 1;
+	m_textureStreamer.SetTextureCache(&m_textureCache);
+	m_textureBackend = TEXTURE_BACKEND_UNITS;
+	m_textureLayerSize = 512;
+	m_pInstancedShader = NULL;
+	m_pIndirectShader = NULL;
+	m_renderPath = RENDER_PATH_IMMEDIATE;
+	m_bInstancesDirty = true;
+	m_bMaterialBlockBound = false;
+	m_bMaterialUniforms = false;
+	m_lastMaterialIndex = -1;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_viewPosition = glm::vec3(0.0f, 0.0f, 0.0f);
+	m_threadCount = 0;
+	m_bBoundsDirty = true;
+	m_bCulling = true;
+	m_visibleCount = 0;
+	m_bOcclusionCulling = true;
+	m_occludedCount = 0;
+	m_bLevelOfDetail = true;
+	m_bSortDraws = true;
+	m_bStaticBatching = false;
+	m_bProgramCaching = true;
+
+	// the ShapeMeshes primitives have the same dimensions
+	for (int i = 0; i < PrimitiveMeshes::PRIMITIVE_COUNT; i++)
+	{
+		PrimitiveMeshes::GetLocalBounds(i, m_meshBoundsMin[i], m_meshBoundsMax[i]);
+	}
 }
 
 /***********************************************************
@@ -76,39 +198,63 @@ SceneManager::SceneManager(ShaderManager* pShaderManager)
 SceneManager::~SceneManager()
 {
 	m_pShaderManager = NULL;
+	m_pStateCache = NULL;
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+	if (NULL != m_pInstancedShader)
+	{
+		glDeleteProgram(m_pInstancedShader->m_programID);
+		delete m_pInstancedShader;
+		m_pInstancedShader = NULL;
+	}
+	if (NULL != m_pIndirectShader)
+	{
+		glDeleteProgram(m_pIndirectShader->m_programID);
+		delete m_pIndirectShader;
+		m_pIndirectShader = NULL;
+	}
 }
 
 /***********************************************************
- *  CreateGLTexture()
+ *  LoadGLTextureAsync()
  *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
+ *  This method is used for registering a texture right away
+ *  with a one pixel placeholder image, and queuing the image
+ *  file to be decoded on a worker thread.  The decoded image
+ *  replaces the placeholder in the same texture object, so
+ *  the handle and texture ID never change.  While the array
+ *  backend has free layers the texture takes the next one.
  ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+bool SceneManager::LoadGLTextureAsync(const char* filename, const char* tag)
 {
-	int width = 0, height = 0, colorChannels = 0;
 	GLuint textureID = 0;
 
-	stbi_set_flip_vertically_on_load(true);
-
-	// Force-convert to RGBA to avoid CMYK/odd formats
-	unsigned char* image = stbi_load(filename, &width, &height, &colorChannels, STBI_rgb_alpha);
-	if (!image)
+	if (TagRegistry::INVALID_HANDLE != m_textureTags.Find(tag))
 	{
-		std::cout << "Could not load image:" << filename
-			<< "  reason: " << stbi_failure_reason() << std::endl;
+		std::cout << "Texture tag '" << tag << "' is already loaded" << std::endl;
 		return false;
 	}
 
-	std::cout << "Loaded image: " << filename
-		<< "  w:" << width << " h:" << height << " -> RGBA\n";
+	int textureHandle = m_textureTags.Register(tag);
+
+	if (m_textureArray.IsCreated() && (textureHandle < m_textureArray.GetLayerCount()))
+	{
+		// the array layers start out with the placeholder color
+		TEXTURE_INFO texture;
+		texture.ID = m_textureArray.GetTextureID();
+		texture.tag = tag;
+		texture.layer = textureHandle;
+		m_textures.push_back(texture);
+
+		m_textureStreamer.RequestLayer(filename, texture.ID,
+			m_textureArray.GetTextureUnit(), texture.layer, m_textureArray.GetLayerSize());
+		return true;
+	}
+
+	int textureUnit = textureHandle % m_textureUnitCount;
 
 	glGenTextures(1, &textureID);
-	glBindTexture(GL_TEXTURE_2D, textureID);
+	m_pStateCache->BindTexture(textureUnit, GL_TEXTURE_2D, textureID);
 
 	// Wrapping
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -117,20 +263,17 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-	// Upload always as RGBA now
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0,
-		GL_RGBA, GL_UNSIGNED_BYTE, image);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	// a 1x1 image is a complete mipmap chain on its own
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0,
+		GL_RGBA, GL_UNSIGNED_BYTE, g_PlaceholderPixel);
 
-	stbi_image_free(image);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	TEXTURE_INFO texture;
+	texture.ID = textureID;
+	texture.tag = tag;
+	texture.layer = -1;
+	m_textures.push_back(texture);
 
-	// Register
-	m_textureIDs[m_loadedTextures].ID = textureID;
-	m_textureIDs[m_loadedTextures].tag = tag;
-	std::cout << "Registered texture '" << tag << "' in slot "
-		<< m_loadedTextures << ", GL id " << textureID << "\n";
-	m_loadedTextures++;
+	m_textureStreamer.Request(filename, textureID, textureUnit);
 	return true;
 }
 
@@ -138,81 +281,104 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
  *  BindGLTextures()
  *
  *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
+ *  OpenGL texture units.  Textures beyond the available
+ *  units share them and are bound when they are drawn.
  ***********************************************************/
 void SceneManager::BindGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	for (size_t i = 0; i < m_textures.size(); i++)
 	{
-		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+		BindTextureHandle(static_cast<int>(i));
 	}
 }
 
 /***********************************************************
- *  DestroyGLTextures()
+ *  BindTextureHandle()
  *
- *  This method is used for freeing the memory in all the
- *  used texture memory slots.
+ *  This method is used for making sure the texture of the
+ *  passed in handle is bound, and returns its texture unit.
  ***********************************************************/
-void SceneManager::DestroyGLTextures()
+int SceneManager::BindTextureHandle(int textureHandle)
 {
-	for (int i = 0; i < m_loadedTextures; ++i)
-		glDeleteTextures(1, &m_textureIDs[i].ID);  // <<< fix
-	m_loadedTextures = 0;
+	if ((textureHandle < 0) ||
+		(textureHandle >= static_cast<int>(m_textures.size())))
+	{
+		return(-1);
+	}
+
+	if (m_textures[textureHandle].layer >= 0)
+	{
+		m_pStateCache->BindTexture(g_TextureArrayUnit, GL_TEXTURE_2D_ARRAY,
+			m_textures[textureHandle].ID);
+		return(g_TextureArrayUnit);
+	}
+
+	int textureUnit = textureHandle % m_textureUnitCount;
+	m_pStateCache->BindTexture(textureUnit, GL_TEXTURE_2D, m_textures[textureHandle].ID);
+
+	return(textureUnit);
 }
 
 /***********************************************************
- *  FindTextureID()
+ *  DestroyGLTextures()
  *
- *  This method is used for getting an ID for the previously
- *  loaded texture bitmap associated with the passed in tag.
+ *  This method is used for freeing the memory in all the
+ *  used texture memory slots, after cancelling the images
+ *  still being streamed into them.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+void SceneManager::DestroyGLTextures()
 {
-	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
+	if (m_textures.empty() && !m_textureArray.IsCreated())
+	{
+		return;
+	}
+
+	// images still decoding would be uploaded into deleted names,
+	// the streamer starts again with the next request
+	m_textureStreamer.Stop();
 
-	while ((index < m_loadedTextures) && (bFound == false))
+	for (const TEXTURE_INFO& texture : m_textures)
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
+		// array layers go with the array
+		if (texture.layer < 0)
 		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
+			glDeleteTextures(1, &texture.ID);
 		}
-		else
-			index++;
 	}
+	m_textures.clear();
+	m_textureTags.Clear();
+	m_textureArray.Destroy();
 
-	return(textureID);
+	// the cache may still list the deleted texture names as bound
+	m_pStateCache->Invalidate();
 }
 
 /***********************************************************
- *  FindTextureSlot()
+ *  FindTextureID()
  *
- *  This method is used for getting a slot index for the previously
+ *  This method is used for getting an ID for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+int SceneManager::FindTextureID(const char* tag)
 {
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
+	int textureHandle = m_textureTags.Find(tag);
+	if (TagRegistry::INVALID_HANDLE == textureHandle)
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureSlot = index;
-			bFound = true;
-		}
-		else
-			index++;
+		return(-1);
 	}
 
-	return(textureSlot);
+	return(static_cast<int>(m_textures[textureHandle].ID));
+}
+
+/***********************************************************
+ *  FindTextureHandle()
+ *
+ *  This method is used for getting the handle of the previously
+ *  loaded texture bitmap associated with the passed in tag.
+ ***********************************************************/
+int SceneManager::FindTextureHandle(const char* tag)
+{
+	return(m_textureTags.Find(tag));
 }
 
 /***********************************************************
@@ -221,49 +387,87 @@ int SceneManager::FindTextureSlot(std::string tag)
  *  This method is used for getting a material from the previously
  *  defined materials list that is associated with the passed in tag.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+bool SceneManager::FindMaterial(const char* tag, OBJECT_MATERIAL& material)
 {
-	if (m_objectMaterials.size() == 0)
+	int materialHandle = m_materialTags.Find(tag);
+	if (TagRegistry::INVALID_HANDLE == materialHandle)
 	{
 		return(false);
 	}
 
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
+	material = m_objectMaterials[materialHandle];
+	return(true);
+}
+
+/***********************************************************
+ *  FindMaterialHandle()
+ *
+ *  This method is used for getting the handle of a previously
+ *  defined material associated with the passed in tag.
+ ***********************************************************/
+int SceneManager::FindMaterialHandle(const char* tag)
+{
+	return(m_materialTags.Find(tag));
+}
+
+/***********************************************************
+ *  AddObjectMaterial()
+ *
+ *  This method is used for adding a material to the defined
+ *  materials.  A material with a tag that is already defined
+ *  replaces the earlier one and keeps its handle.
+ ***********************************************************/
+int SceneManager::AddObjectMaterial(const OBJECT_MATERIAL& material)
+{
+	int materialHandle = m_materialTags.Register(material.tag.c_str());
+
+	if (materialHandle < static_cast<int>(m_objectMaterials.size()))
 	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.ambientColor = m_objectMaterials[index].ambientColor;
-			material.ambientStrength = m_objectMaterials[index].ambientStrength;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
-		{
-			index++;
-		}
+		m_objectMaterials[materialHandle] = material;
+	}
+	else
+	{
+		m_objectMaterials.push_back(material);
 	}
 
-	return(true);
+	return(materialHandle);
 }
 
 void SceneManager::LoadSceneTextures()
 {
-	m_loadedTextures = 0;
+	ScopedCpuTimer timer("LoadSceneTextures");
+
+	DestroyGLTextures();
+
+	GLint textureUnits = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &textureUnits);
+	m_textureUnitCount = glm::clamp(static_cast<int>(textureUnits), 1, g_MaxTextureUnits) - 1;
+	if (m_textureUnitCount < 1)
+	{
+		m_textureUnitCount = 1;
+	}
 
 	const std::string base = FindTexturesBase();
+	m_textureCache.SetCacheFolder(FindTextureCacheFolder(base));
+
+	// every scene texture gets a layer, others fall back to 2D textures
+	if (m_textureBackend == TEXTURE_BACKEND_ARRAY)
+	{
+		int layerCount = static_cast<int>(sizeof(g_SceneTextures) / sizeof(g_SceneTextures[0]));
+		if (!m_textureArray.Create(m_pStateCache, g_TextureArrayUnit,
+			m_textureLayerSize, layerCount, g_PlaceholderPixel))
+		{
+			std::cout << "Texture array unavailable, binding 2D textures to units" << std::endl;
+			m_textureBackend = TEXTURE_BACKEND_UNITS;
+		}
+	}
 
-	CreateGLTexture((base + "wood_oak.jpg").c_str(), "TEX_WOOD");
-	CreateGLTexture((base + "black_plastic.jpg").c_str(), "TEX_PLASTIC");
-	CreateGLTexture((base + "fabric_dark.jpg").c_str(), "TEX_FABRIC");
-	CreateGLTexture((base + "paint_wall.jpg").c_str(), "TEX_WALL");
-	CreateGLTexture((base + "carpet.jpg").c_str(), "TEX_CARPET");
-	CreateGLTexture((base + "monitor_bezel.png").c_str(), "TEX_BEZEL");
-	CreateGLTexture((base + "monitor_screen.jpg").c_str(), "TEX_SCREEN");
-	CreateGLTexture((base + "gloss_reflection.png").c_str(), "TEX_GLOSS");
+	// images are loaded on worker threads while the rest of the
+	// scene is prepared, and uploaded by RenderScene() when ready
+	for (const SCENE_TEXTURE& texture : g_SceneTextures)
+	{
+		LoadGLTextureAsync((base + texture.filename).c_str(), texture.tag);
+	}
 
 	BindGLTextures();
 }
@@ -281,28 +485,14 @@ void SceneManager::SetTransformations(
 	float ZrotationDegrees,
 	glm::vec3 positionXYZ)
 {
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
+	glm::mat4 modelView = TransformGraph::ComposeMatrix(
+		scaleXYZ,
+		glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees),
+		positionXYZ);
 
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
-
-	modelView = translation * rotationX * rotationY * rotationZ * scale;
-
-	if (NULL != m_pShaderManager)
+	if (NULL != m_pStateCache)
 	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		m_pStateCache->SetMat4(g_ModelName, modelView);
 	}
 }
 
@@ -326,10 +516,10 @@ void SceneManager::SetShaderColor(
 	currentColor.b = blueColorValue;
 	currentColor.a = alphaValue;
 
-	if (NULL != m_pShaderManager)
+	if (NULL != m_pStateCache)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		m_pStateCache->SetInt(g_UseTextureName, false);
+		m_pStateCache->SetVec4(g_ColorValueName, currentColor);
 	}
 }
 
@@ -337,18 +527,20 @@ void SceneManager::SetShaderColor(
  *  SetShaderTexture()
  *
  *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  associated with the passed in handle into the shader.
  ***********************************************************/
 void SceneManager::SetShaderTexture(
-	std::string textureTag)
+	int textureHandle)
 {
-	if (NULL != m_pShaderManager)
+	if (NULL != m_pStateCache)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
-
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+		int textureUnit = BindTextureHandle(textureHandle);
+		// array layers are picked per instance, not through this sampler
+		if ((textureUnit >= 0) && (textureUnit != g_TextureArrayUnit))
+		{
+			m_pStateCache->SetInt(g_UseTextureName, true);
+			m_pStateCache->SetInt(g_TextureValueName, textureUnit);
+		}
 	}
 }
 
@@ -360,195 +552,1340 @@ void SceneManager::SetShaderTexture(
  ***********************************************************/
 void SceneManager::SetTextureUVScale(float u, float v)
 {
-	if (NULL != m_pShaderManager)
+	if (NULL != m_pStateCache)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+		m_pStateCache->SetVec2(g_UVScaleName, glm::vec2(u, v));
 	}
 }
 
 /***********************************************************
  *  SetShaderMaterial()
  *
- *  This method is used for passing the material values
- *  into the shader.
+ *  This method is used for passing the material of the
+ *  passed in handle into the shader.  Shaders that declare
+ *  the material block only receive the handle as an index,
+ *  and unlit shaders without the block receive nothing.
  ***********************************************************/
 void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+	int materialHandle)
 {
-	if (m_objectMaterials.size() > 0)
+	if ((materialHandle < 0) ||
+		(materialHandle >= static_cast<int>(m_objectMaterials.size())))
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
+		return;
+	}
 
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
-		{
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
-		}
+	// the shader reads the values from the material table block
+	if (m_bMaterialBlockBound)
+	{
+		m_pStateCache->SetInt(g_MaterialIndexName, materialHandle);
+	}
+	else if (m_bMaterialUniforms)
+	{
+		const OBJECT_MATERIAL& material = m_objectMaterials[materialHandle];
+
+		m_pStateCache->SetVec3("material.ambientColor", material.ambientColor);
+		m_pStateCache->SetFloat("material.ambientStrength", material.ambientStrength);
+		m_pStateCache->SetVec3("material.diffuseColor", material.diffuseColor);
+		m_pStateCache->SetVec3("material.specularColor", material.specularColor);
+		m_pStateCache->SetFloat("material.shininess", material.shininess);
 	}
 }
 
-/**************************************************************/
-/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
-/*** preparing and rendering their own 3D replicated scenes.***/
-/*** Please refer to the code in the OpenGL sample project  ***/
-/*** for assistance.                                        ***/
-/**************************************************************/
+/***********************************************************
+ *  DrawShapeMesh()
+ *
+ *  This method is used for issuing the draw command for the
+ *  passed in basic shape mesh.
+ ***********************************************************/
+void SceneManager::DrawShapeMesh(SHAPE_MESH mesh)
+{
+	switch (mesh)
+	{
+	case MESH_BOX:
+		m_basicMeshes->DrawBoxMesh();
+		break;
+	case MESH_CYLINDER:
+		m_basicMeshes->DrawCylinderMesh();
+		break;
+	case MESH_SPHERE:
+		m_basicMeshes->DrawSphereMesh();
+		break;
+	case MESH_PLANE:
+		m_basicMeshes->DrawPlaneMesh();
+		break;
+	}
+}
 
+/***********************************************************
+ *  SetRenderPath()
+ *
+ *  This method is used for selecting how the draw list is
+ *  submitted.  It must be called before PrepareScene().
+ ***********************************************************/
+void SceneManager::SetRenderPath(RENDER_PATH renderPath)
+{
+	m_renderPath = renderPath;
+}
 
 /***********************************************************
- *  PrepareScene()
+ *  SetTextureBackend()
  *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene 
- *  rendering
+ *  This method is used for selecting whether the textures
+ *  are kept as separate 2D textures or as layers of one
+ *  array texture of the passed in layer size.
  ***********************************************************/
-void SceneManager::PrepareScene()
+void SceneManager::SetTextureBackend(TEXTURE_BACKEND textureBackend, int layerSize)
 {
-	// Load each primitive once; reuse in RenderScene
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadBoxMesh();
-	m_basicMeshes->LoadCylinderMesh();
-	m_basicMeshes->LoadSphereMesh();
-	LoadSceneTextures();
+	m_textureBackend = textureBackend;
+	m_textureLayerSize = layerSize;
 }
 
 /***********************************************************
- *  RenderScene()
+ *  SetViewState()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for passing the camera matrices that
+ *  the view manager prepared for the current frame, so that
+ *  render paths with their own shaders can use them.
  ***********************************************************/
-void SceneManager::RenderScene()
+void SceneManager::SetViewState(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const glm::vec3& viewPosition)
 {
-	// ---------- helpers ----------
-	auto DrawBox = [&](glm::vec3 S, glm::vec3 Rdeg, glm::vec3 T, glm::vec4 RGBA)
-		{ SetTransformations(S, Rdeg.x, Rdeg.y, Rdeg.z, T); SetShaderColor(RGBA.r, RGBA.g, RGBA.b, RGBA.a); m_basicMeshes->DrawBoxMesh(); };
-	auto DrawCyl = [&](glm::vec3 S, glm::vec3 Rdeg, glm::vec3 T, glm::vec4 RGBA)
-		{ SetTransformations(S, Rdeg.x, Rdeg.y, Rdeg.z, T); SetShaderColor(RGBA.r, RGBA.g, RGBA.b, RGBA.a); m_basicMeshes->DrawCylinderMesh(); };
-	auto DrawSphere = [&](glm::vec3 S, glm::vec3 Rdeg, glm::vec3 T, glm::vec4 RGBA)
-		{ SetTransformations(S, Rdeg.x, Rdeg.y, Rdeg.z, T); SetShaderColor(RGBA.r, RGBA.g, RGBA.b, RGBA.a); m_basicMeshes->DrawSphereMesh(); };
-	auto DrawPlane = [&](glm::vec3 S, glm::vec3 Rdeg, glm::vec3 T, glm::vec4 RGBA)
-		{ SetTransformations(S, Rdeg.x, Rdeg.y, Rdeg.z, T); SetShaderColor(RGBA.r, RGBA.g, RGBA.b, RGBA.a); m_basicMeshes->DrawPlaneMesh(); };
-
-	// ------ texture helpers (no dimension changes) ------
-	auto DrawBoxTex = [&](glm::vec3 S, glm::vec3 Rdeg, glm::vec3 T,
-		const char* tag, glm::vec2 uv = { 1,1 }, float a = 1.0f)
-		{
-			SetTransformations(S, Rdeg.x, Rdeg.y, Rdeg.z, T);
-			SetTextureUVScale(uv.x, uv.y);
-			SetShaderColor(1, 1, 1, a);    // tint first
-			SetShaderTexture(tag);         // enable texture last
-			m_basicMeshes->DrawBoxMesh();
-			SetTextureUVScale(1, 1);
-		};
-
-	auto DrawPlaneTex = [&](glm::vec3 S, glm::vec3 Rdeg, glm::vec3 T,
-		const char* tag, glm::vec2 uv = { 1,1 }, float a = 1.0f)
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+	m_viewPosition = viewPosition;
+}
+
+/***********************************************************
+ *  CookSceneTextures()
+ *
+ *  This method is used for cooking the scene textures into
+ *  the texture cache ahead of time, so even the first launch
+ *  maps containers instead of decoding images.  It returns
+ *  the number of textures cooked.
+ ***********************************************************/
+int SceneManager::CookSceneTextures()
+{
+	const std::string base = FindTexturesBase();
+	TextureCache textureCache;
+	int cookedCount = 0;
+
+	if (base.empty())
+	{
+		return(0);
+	}
+
+	textureCache.SetCacheFolder(FindTextureCacheFolder(base));
+	stbi_set_flip_vertically_on_load(true);
+
+	for (const SCENE_TEXTURE& texture : g_SceneTextures)
+	{
+		std::string filename = base + texture.filename;
+		if (textureCache.Cook(filename.c_str()))
 		{
-			SetTransformations(S, Rdeg.x, Rdeg.y, Rdeg.z, T);
-			SetTextureUVScale(uv.x, uv.y);
-			SetShaderColor(1, 1, 1, a);
-			SetShaderTexture(tag);
-			m_basicMeshes->DrawPlaneMesh();
-			SetTextureUVScale(1, 1);
-		};
-
-	// ---------- palette (kept) ----------
-	const glm::vec4 BLACK = { 0.05f, 0.05f, 0.06f, 1.0f };
-	const glm::vec4 DESK = { 0.18f, 0.18f, 0.20f, 1.0f };
-	const glm::vec4 WALLFLR = { 0.40f, 0.40f, 0.42f, 1.0f };
-	const glm::vec4 WHITE = { 0.92f, 0.92f, 0.94f, 1.0f };
-	const glm::vec4 GREEN = { 0.10f, 0.90f, 0.20f, 1.0f };
-	const glm::vec4 MPAD = { 0.12f, 0.12f, 0.14f, 1.0f };
-
-	// ---------- global scale ----------
-	const float SALL = 1.30f;
-	const float pairX = 0.38f;
-
-	// ---------- back wall & floor (textured) ----------
-	DrawBoxTex({ 4.0f, 2.2f, 0.03f }, { 0,0,0 }, { 0.0f, 1.1f, -0.80f }, "TEX_WALL", { 3.0f,1.5f });
-	DrawPlaneTex({ 8.0f, 1.0f, 8.0f }, { 0,0,0 }, { 0.0f, -0.002f, 0.0f }, "TEX_CARPET", { 6.0f,6.0f });
-
-	// ---------- desk (textured wood, same dims) ----------
-	const glm::vec3 deskS = { 1.60f, 0.03f, 0.60f };
-	const float deskHalfH = deskS.y * 0.5f;
-	DrawBoxTex(deskS, { 0,0,0 }, { 0.0f, 0.0f, 0.0f }, "TEX_WOOD", { 4.0f,1.5f });
-	const float deskTopY = deskHalfH;
-
-	// ---------- shelf (textured wood, same dims) ----------
-	const glm::vec3 shelfS = { 1.50f, 0.05f, 0.45f };
-	const float shelfHalfH = shelfS.y * 0.5f;
-	DrawBoxTex(shelfS, { 0,0,0 }, { 0.0f, 0.32f, -0.05f }, "TEX_WOOD", { 3.0f,1.0f });
-	const float shelfTopY = 0.32f + shelfHalfH;
-
-	// ---------- consoles (left plastic, right white color) ----------
-	const glm::vec3 xbox1S = SALL * glm::vec3(0.33f, 0.08f, 0.27f);
-	const glm::vec3 xbox3S = SALL * glm::vec3(0.31f, 0.08f, 0.26f);
-
-	DrawBoxTex(xbox1S, { 0,0,0 }, { -pairX, shelfTopY + xbox1S.y * 0.5f, -0.08f }, "TEX_PLASTIC");
-	const float xbox1TopY = shelfTopY + xbox1S.y;
-
-	DrawBox(xbox3S, { 0,0,0 }, { pairX, shelfTopY + xbox3S.y * 0.5f, -0.08f }, WHITE);
-	const float xbox3TopY = shelfTopY + xbox3S.y;
-
-	// 360 power ring (unchanged)
-	DrawCyl(SALL * glm::vec3(0.013f, 0.005f, 0.013f), { 90,0,0 },
-		{ pairX + 0.12f, shelfTopY + (xbox3S.y * 0.5f), 0.02f }, GREEN);
-	DrawSphere(SALL * glm::vec3(0.012f, 0.012f, 0.012f), { 0,0,0 },
-		{ pairX + 0.12f, shelfTopY + (xbox3S.y * 0.5f), 0.027f }, WHITE);
-
-	// ================= Stands + Panels (textured bezel + layered screen) =================
-	const glm::vec3 panelS = SALL * glm::vec3(0.53f, 0.33f, 0.02f);
-	const float     panelHalfH = panelS.y * 0.5f;
-	const glm::vec3 standFootS = SALL * glm::vec3(0.20f, 0.02f, 0.12f);
-	const float     postH = SALL * 0.03f;
-	const float     postR = SALL * 0.020f;
-
-	auto StandStack = [&](float baseX, float baseTopY)
+			std::cout << "Cooked texture: " << filename << std::endl;
+			cookedCount++;
+		}
+		else
 		{
-			// Foot (plastic texture)
-			DrawBoxTex(standFootS, { 0,0,0 },
-				{ baseX, baseTopY + standFootS.y * 0.5f, -0.05f }, "TEX_PLASTIC");
-
-			// Post (matte black)
-			DrawCyl({ postR, postH, postR }, { 0,0,0 },
-				{ baseX, baseTopY + standFootS.y + postH * 0.0f, -0.05f }, BLACK);
-
-			// Panel position (center of bezel)
-			const float     supportTopY = baseTopY + standFootS.y + postH;
-			const glm::vec3 panelPos = { baseX, supportTopY + panelHalfH, -0.05f };
-
-			// Bezel (PNG alpha)
-			DrawBoxTex(panelS, { 0,0,0 }, panelPos, "TEX_BEZEL");
-
-			// --- draw the screen + gloss as ultra-thin BOXES (not planes) ---
-			// Screen image, just in front of bezel
-			DrawBoxTex(SALL * glm::vec3(0.495f, 0.315f, 0.0008f), { 0,0,0 },
-				panelPos + glm::vec3(0, 0, 0.0118f), "TEX_SCREEN");
-
-			// Gloss overlay: draw last, disable depth WRITES to avoid fighting
-			glDepthMask(GL_FALSE);
-			DrawBoxTex(SALL * glm::vec3(0.495f, 0.315f, 0.0006f), { 0,0,0 },
-				panelPos + glm::vec3(0, 0, 0.0130f), "TEX_GLOSS", { 1,1 }, 0.35f);
-			glDepthMask(GL_TRUE);
-		};
-
-	StandStack(-pairX, xbox1TopY);   // left
-	StandStack(pairX, xbox3TopY);   // right
-	// ================= end stands + panels ======================================
-
-	// ---------- keyboard / mousepad / mouse ----------
-	DrawBoxTex(SALL * glm::vec3(0.33f, 0.01f, 0.27f), { 0,0,0 },
-		{ 0.55f, deskTopY + (SALL * 0.01f) * 0.5f, 0.05f }, "TEX_FABRIC", { 2.5f,2.0f });
-	DrawBoxTex(SALL * glm::vec3(0.47f, 0.025f, 0.15f), { -3.0f, 10.0f, 0.0f },
-		{ -0.10f, deskTopY + (SALL * 0.025f) * 0.5f, 0.06f }, "TEX_PLASTIC");
-	DrawBox(SALL * glm::vec3(0.06f, 0.007f, 0.09f), { 0, -20.0f, 0 },
-		{ 0.60f, deskTopY + (SALL * 0.007f) * 0.5f, 0.05f }, BLACK);
-	DrawSphere(SALL * glm::vec3(0.05f, 0.025f, 0.075f), { 0, -20.0f, 0 },
-		{ 0.60f, deskTopY + (SALL * 0.007f) + (SALL * 0.025f) * 0.5f + 0.004f, 0.05f }, BLACK);
-}
\ No newline at end of file
+			std::cout << "Could not cook texture: " << filename << std::endl;
+		}
+	}
+
+	return(cookedCount);
+}
+
+/***********************************************************
+ *  CompileSceneFile()
+ *
+ *  This method is used for compiling a scene source ahead
+ *  of time, the default scene when no path is passed in.
+ ***********************************************************/
+bool SceneManager::CompileSceneFile(const char* sourcePath)
+{
+	const std::string source = FindSceneSource((NULL != sourcePath) ? sourcePath : "");
+	if (source.empty())
+	{
+		return(false);
+	}
+
+	const std::string compiled = GetCompiledScenePath(source);
+	if (!SceneCompiler::Compile(source.c_str(), compiled.c_str()))
+	{
+		return(false);
+	}
+
+	std::cout << "Compiled scene: " << compiled << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  LoadSceneFile()
+ *
+ *  This method is used for mapping the compiled scene.  The
+ *  source is only compiled when it is newer than the
+ *  compiled file, so normal launches just map the tables.
+ ***********************************************************/
+bool SceneManager::LoadSceneFile()
+{
+	ScopedCpuTimer timer("LoadSceneFile");
+
+	const std::string compiled = UpdateCompiledScene(m_scenePath);
+	if (compiled.empty())
+	{
+		m_sceneFile.Close();
+		return(false);
+	}
+
+	return(m_sceneFile.Open(compiled.c_str()));
+}
+
+/***********************************************************
+ *  GenerateStressScene()
+ *
+ *  This method is used for writing a compiled scene with a
+ *  grid of copies of a scene, the default one when no path
+ *  is passed in.  It needs no GL.
+ ***********************************************************/
+bool SceneManager::GenerateStressScene(const char* templatePath, int copyCount, const char* targetPath)
+{
+	const std::string compiled = UpdateCompiledScene((NULL != templatePath) ? templatePath : "");
+	SceneFile templateScene;
+	if (compiled.empty() || !templateScene.Open(compiled.c_str()))
+	{
+		return(false);
+	}
+
+	return(SceneGenerator::Generate(templateScene,
+		SceneGenerator::GetDefaultSettings(copyCount), targetPath));
+}
+
+/***********************************************************
+ *  ChangeScene()
+ *
+ *  This method is used for replacing the objects of a
+ *  prepared scene with those of another scene file.  The
+ *  textures, materials and render path resources are kept.
+ ***********************************************************/
+bool SceneManager::ChangeScene(const char* path)
+{
+	SetSceneFile(path);
+	return(LoadSceneObjects());
+}
+
+/***********************************************************
+ *  LoadSceneObjects()
+ *
+ *  This method is used for mapping the scene file and
+ *  building the draw list and static batches from it.
+ ***********************************************************/
+bool SceneManager::LoadSceneObjects()
+{
+	bool bLoaded = LoadSceneFile();
+	if (!bLoaded)
+	{
+		std::cout << "Could not load the scene file" << std::endl;
+	}
+	BuildDrawList();
+
+	// the instanced path already draws each state group in one call
+	if ((m_renderPath == RENDER_PATH_IMMEDIATE) && m_bStaticBatching)
+	{
+		BuildStaticBatches();
+	}
+
+	return(bLoaded);
+}
+
+/***********************************************************
+ *  LoadInstancedPath()
+ *
+ *  This method is used for loading the shaders and meshes of
+ *  the instanced render path.  It returns false when the
+ *  shaders cannot be found or linked.
+ ***********************************************************/
+bool SceneManager::LoadInstancedPath()
+{
+	const std::string base = FindAssetBase("shaders", g_InstancedVertexShader);
+	GLint linked = GL_FALSE;
+
+	if (base.empty())
+	{
+		return(false);
+	}
+
+	m_programCache.SetCacheFolder(m_bProgramCaching ? base + "cache/" : std::string());
+	m_pInstancedShader = new ShaderManager();
+	{
+		ScopedCpuTimer timer("LoadShaders");
+		m_programCache.LoadProgram(m_pInstancedShader,
+			(base + g_InstancedVertexShader).c_str(),
+			(base + g_InstancedFragmentShader).c_str());
+	}
+
+	if (0 != m_pInstancedShader->m_programID)
+	{
+		glGetProgramiv(m_pInstancedShader->m_programID, GL_LINK_STATUS, &linked);
+	}
+	if (GL_TRUE != linked)
+	{
+		std::cout << "Instanced shaders failed to link" << std::endl;
+		delete m_pInstancedShader;
+		m_pInstancedShader = NULL;
+		return(false);
+	}
+
+	BindUniformBlock(m_pInstancedShader->m_programID, "CameraBlock", CAMERA_BLOCK_BINDING);
+	BindSceneBlocks(m_pInstancedShader->m_programID);
+
+	m_primitiveMeshes.LoadMeshes();
+	m_instancedRenderer.Initialize(&m_primitiveMeshes);
+
+	// the new program is not known to the state cache yet
+	m_pStateCache->Invalidate();
+
+	// the array sampler has a unit of its own so the two sampler
+	// types never point at the same unit
+	m_pStateCache->UseProgram(m_pInstancedShader->m_programID);
+	m_pStateCache->SetInt(g_TextureArrayName, g_TextureArrayUnit);
+	m_pStateCache->SetInt(g_OctahedralNormalsName,
+		m_primitiveMeshes.GetVertexFormat() == PrimitiveMeshes::VERTEX_FORMAT_PACKED);
+	m_pStateCache->UseProgram(m_pShaderManager->m_programID);
+
+	return(true);
+}
+
+/***********************************************************
+ *  LoadIndirectPath()
+ *
+ *  This method is used for loading the shaders of the
+ *  multi-draw indirect path, which share the fragment shader
+ *  of the instanced path, and merging the primitive meshes
+ *  into the buffers the commands draw from.
+ ***********************************************************/
+bool SceneManager::LoadIndirectPath()
+{
+	// storage buffers and multi-draw indirect are core in 4.3
+	if (!GLEW_VERSION_4_3 || !GLEW_ARB_shader_draw_parameters)
+	{
+		std::cout << "Multi-draw indirect needs GL 4.3 and ARB_shader_draw_parameters" << std::endl;
+		return(false);
+	}
+
+	const std::string base = FindAssetBase("shaders", g_IndirectVertexShader);
+	GLint linked = GL_FALSE;
+
+	if (base.empty())
+	{
+		return(false);
+	}
+
+	m_programCache.SetCacheFolder(m_bProgramCaching ? base + "cache/" : std::string());
+	m_pIndirectShader = new ShaderManager();
+	{
+		ScopedCpuTimer timer("LoadShaders");
+		m_programCache.LoadProgram(m_pIndirectShader,
+			(base + g_IndirectVertexShader).c_str(),
+			(base + g_InstancedFragmentShader).c_str());
+	}
+
+	if (0 != m_pIndirectShader->m_programID)
+	{
+		glGetProgramiv(m_pIndirectShader->m_programID, GL_LINK_STATUS, &linked);
+	}
+	if (GL_TRUE != linked)
+	{
+		std::cout << "Indirect shaders failed to link" << std::endl;
+		delete m_pIndirectShader;
+		m_pIndirectShader = NULL;
+		return(false);
+	}
+
+	BindUniformBlock(m_pIndirectShader->m_programID, "CameraBlock", CAMERA_BLOCK_BINDING);
+	BindSceneBlocks(m_pIndirectShader->m_programID);
+
+	m_primitiveMeshes.LoadMeshes();
+	m_indirectRenderer.Initialize(&m_primitiveMeshes);
+
+	m_pStateCache->Invalidate();
+
+	m_pStateCache->UseProgram(m_pIndirectShader->m_programID);
+	m_pStateCache->SetInt(g_TextureArrayName, g_TextureArrayUnit);
+	m_pStateCache->SetInt(g_OctahedralNormalsName,
+		m_primitiveMeshes.GetVertexFormat() == PrimitiveMeshes::VERTEX_FORMAT_PACKED);
+	m_pStateCache->UseProgram(m_pShaderManager->m_programID);
+
+	return(true);
+}
+
+/***********************************************************
+ *  BuildInstanceBatches()
+ *
+ *  This method is used for grouping the draw list by
+ *  primitive, level of detail, texture and depth writing.  Groups that do
+ *  not write depth are drawn after all the others so
+ *  blending sees the same surfaces behind it as the per-draw
+ *  path.  Records are taken in render queue order, so the
+ *  opaque records of a group go front to back as of this
+ *  rebuild.
+ ***********************************************************/
+void SceneManager::BuildInstanceBatches()
+{
+	std::vector<InstancedRenderer::INSTANCE_BATCH> batches;
+	std::vector<InstancedRenderer::INSTANCE_DATA> instances;
+	std::vector<int> recordBatch(m_drawList.size(), -1);
+
+	// find the batch of every visible record, opaque groups first
+	BuildRenderQueue();
+	for (int pass = 0; pass < 2; pass++)
+	{
+		bool bDepthWrite = (pass == 0);
+
+		for (int q = 0; q < m_renderQueue.GetCount(); q++)
+		{
+			int i = m_renderQueue.GetItem(q).index;
+			const DRAW_RECORD& record = m_drawList[i];
+			if (record.depthWrite != bDepthWrite)
+			{
+				continue;
+			}
+
+			int textureUnit = -1;
+			GLuint textureID = 0;
+			GLenum textureTarget = GL_TEXTURE_2D;
+			if ((record.textureHandle >= 0) && (m_textures[record.textureHandle].layer < 0))
+			{
+				textureUnit = record.textureHandle % m_textureUnitCount;
+				textureID = m_textures[record.textureHandle].ID;
+			}
+			else if ((record.textureHandle >= 0) || m_textureArray.IsCreated())
+			{
+				// layers and flat colors share one batch per primitive
+				textureUnit = g_TextureArrayUnit;
+				textureID = m_textureArray.GetTextureID();
+				textureTarget = GL_TEXTURE_2D_ARRAY;
+			}
+
+			int level = GetDrawLevel(i);
+			int batchIndex = -1;
+			for (size_t b = 0; b < batches.size(); b++)
+			{
+				if ((batches[b].primitive == record.mesh) &&
+					(batches[b].level == level) &&
+					(batches[b].textureID == textureID) &&
+					(batches[b].depthWrite == record.depthWrite))
+				{
+					batchIndex = static_cast<int>(b);
+					break;
+				}
+			}
+
+			if (batchIndex < 0)
+			{
+				InstancedRenderer::INSTANCE_BATCH batch;
+				batch.primitive = record.mesh;
+				batch.level = level;
+				batch.textureUnit = textureUnit;
+				batch.textureID = textureID;
+				batch.textureTarget = textureTarget;
+				batch.depthWrite = record.depthWrite;
+				batch.firstInstance = 0;
+				batch.instanceCount = 0;
+				batchIndex = static_cast<int>(batches.size());
+				batches.push_back(batch);
+			}
+
+			recordBatch[i] = batchIndex;
+			batches[batchIndex].instanceCount++;
+		}
+	}
+
+	// lay the batches out back to back in the instance buffer
+	GLint nextInstance = 0;
+	for (InstancedRenderer::INSTANCE_BATCH& batch : batches)
+	{
+		batch.firstInstance = nextInstance;
+		nextInstance += batch.instanceCount;
+		batch.instanceCount = 0;
+	}
+
+	instances.resize(nextInstance);
+	for (int q = 0; q < m_renderQueue.GetCount(); q++)
+	{
+		int i = m_renderQueue.GetItem(q).index;
+		const DRAW_RECORD& record = m_drawList[i];
+		InstancedRenderer::INSTANCE_BATCH& batch = batches[recordBatch[i]];
+		InstancedRenderer::INSTANCE_DATA& instance =
+			instances[batch.firstInstance + batch.instanceCount];
+
+		instance.modelMatrix = m_transforms.GetWorldMatrix(record.transformNode);
+		instance.color = record.color;
+		// texture handles and array layers are the same number
+		instance.params = glm::vec4(
+			record.uvScale.x,
+			record.uvScale.y,
+			static_cast<float>(record.textureHandle),
+			static_cast<float>(record.materialIndex));
+		batch.instanceCount++;
+	}
+
+	if (m_renderPath == RENDER_PATH_INDIRECT)
+	{
+		m_indirectRenderer.SetDraws(instances, batches);
+	}
+	else
+	{
+		m_instancedRenderer.SetInstances(instances, batches);
+	}
+	m_bInstancesDirty = false;
+}
+
+/***********************************************************
+ *  BindSceneBlocks()
+ *
+ *  This method is used for attaching the material and light
+ *  blocks of a program to their binding points.
+ ***********************************************************/
+void SceneManager::BindSceneBlocks(GLuint program)
+{
+	BindUniformBlock(program, "MaterialBlock", MATERIAL_BLOCK_BINDING);
+	BindUniformBlock(program, "LightBlock", LIGHT_BLOCK_BINDING);
+}
+
+/***********************************************************
+ *  LoadUniformBlocks()
+ *
+ *  This method is used for uploading the material table and
+ *  the scene lights once, after they have been defined.
+ ***********************************************************/
+void SceneManager::LoadUniformBlocks()
+{
+	MATERIAL_BLOCK materialBlock = {};
+	int materialCount = static_cast<int>(m_objectMaterials.size());
+
+	if (materialCount > MAX_BLOCK_MATERIALS)
+	{
+		std::cout << "Only the first " << MAX_BLOCK_MATERIALS
+			<< " materials fit in the material block" << std::endl;
+		materialCount = MAX_BLOCK_MATERIALS;
+	}
+
+	for (int i = 0; i < materialCount; i++)
+	{
+		const OBJECT_MATERIAL& material = m_objectMaterials[i];
+		materialBlock.materials[i].ambient =
+			glm::vec4(material.ambientColor, material.ambientStrength);
+		materialBlock.materials[i].diffuseColor = glm::vec4(material.diffuseColor, 1.0f);
+		materialBlock.materials[i].specular =
+			glm::vec4(material.specularColor, material.shininess);
+	}
+
+	m_materialBlock.Create(sizeof(MATERIAL_BLOCK), MATERIAL_BLOCK_BINDING);
+	m_materialBlock.Update(&materialBlock, sizeof(materialBlock));
+	m_lightBlock.Create(sizeof(LIGHT_BLOCK), LIGHT_BLOCK_BINDING);
+	m_lightBlock.Update(&m_lights, sizeof(m_lights));
+
+	BindSceneBlocks(m_pShaderManager->m_programID);
+	m_bMaterialBlockBound = (GL_INVALID_INDEX !=
+		glGetUniformBlockIndex(m_pShaderManager->m_programID, "MaterialBlock"));
+
+	// without the block, materials are only sent by name to a lit
+	// program that declares them, the unlit shaders never read them
+	m_bMaterialUniforms = !m_bMaterialBlockBound && (0 != m_lights.useLighting) &&
+		(-1 != glGetUniformLocation(m_pShaderManager->m_programID, "material.diffuseColor"));
+}
+
+/***********************************************************
+ *  RenderImmediate()
+ *
+ *  This method is used for drawing the draw list with one
+ *  ShapeMeshes draw call and one set of uniforms per record,
+ *  in render queue order.  Records at a coarser level of
+ *  detail are drawn from the primitive meshes instead, and
+ *  so is every record once any are merged into batches.
+ ***********************************************************/
+void SceneManager::RenderImmediate()
+{
+	m_lastMaterialIndex = -1;
+
+	// the batches are merged from the primitive meshes, so the
+	// records left out of them are drawn from the same geometry
+	const bool bPrimitiveMeshes = (m_staticBatcher.GetObjectCount() > 0);
+
+	BuildRenderQueue();
+	for (int q = 0; q < m_renderQueue.GetCount(); q++)
+	{
+		const int recordIndex = m_renderQueue.GetItem(q).index;
+		const DRAW_RECORD& record = m_drawList[recordIndex];
+		const int level = GetDrawLevel(recordIndex);
+		if (record.staticBatch >= 0)
+		{
+			// merged vertices are already in world space
+			m_pStateCache->SetMat4(g_ModelName, glm::mat4(1.0f));
+		}
+		else
+		{
+			m_pStateCache->SetMat4(g_ModelName,
+				m_transforms.GetWorldMatrix(record.transformNode));
+		}
+
+		if (record.textureHandle >= 0)
+		{
+			SetTextureUVScale(record.uvScale.x, record.uvScale.y);
+			m_pStateCache->SetVec4(g_ColorValueName, record.color);
+			SetShaderTexture(record.textureHandle);
+		}
+		else
+		{
+			SetShaderColor(record.color.r, record.color.g, record.color.b, record.color.a);
+		}
+
+		if ((record.materialIndex >= 0) && (record.materialIndex != m_lastMaterialIndex))
+		{
+			SetShaderMaterial(record.materialIndex);
+			m_lastMaterialIndex = record.materialIndex;
+		}
+
+		// overlays are drawn without writing depth to avoid fighting
+		m_pStateCache->DepthMask(record.depthWrite ? GL_TRUE : GL_FALSE);
+		if (record.staticBatch >= 0)
+		{
+			m_staticBatcher.DrawBatch(record.staticBatch);
+		}
+		else if ((level > 0) || bPrimitiveMeshes)
+		{
+			const PrimitiveMeshes::GPU_MESH& mesh = m_primitiveMeshes.GetMesh(record.mesh, level);
+			glBindVertexArray(mesh.vao);
+			glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, NULL);
+		}
+		else
+		{
+			DrawShapeMesh(record.mesh);
+		}
+		// counted per object, a ShapeMeshes shape may split its draw
+		m_pStateCache->CountDrawCalls(1);
+	}
+
+	m_pStateCache->DepthMask(GL_TRUE);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  RenderInstanced()
+ *
+ *  This method is used for drawing the draw list with one
+ *  instanced draw call per primitive and texture group.
+ ***********************************************************/
+void SceneManager::RenderInstanced()
+{
+	if (m_bInstancesDirty)
+	{
+		BuildInstanceBatches();
+	}
+
+	// camera, materials and lights come from the uniform blocks
+	m_pStateCache->UseProgram(m_pInstancedShader->m_programID);
+
+	m_instancedRenderer.Draw(m_pStateCache);
+
+	// the view manager sets its uniforms on the main program
+	m_pStateCache->UseProgram(m_pShaderManager->m_programID);
+}
+
+/***********************************************************
+ *  RenderIndirect()
+ *
+ *  This method is used for drawing the draw list from the
+ *  command buffer, which is only rewritten when the records
+ *  or the visible set changed.
+ ***********************************************************/
+void SceneManager::RenderIndirect()
+{
+	if (m_bInstancesDirty)
+	{
+		BuildInstanceBatches();
+	}
+
+	m_pStateCache->UseProgram(m_pIndirectShader->m_programID);
+
+	m_indirectRenderer.Draw(m_pStateCache);
+
+	m_pStateCache->UseProgram(m_pShaderManager->m_programID);
+}
+
+/***********************************************************
+ *  UpdateDrawBounds()
+ *
+ *  This method is used for fitting a world box around every
+ *  record from its mesh bounds and cached world matrix, and
+ *  a sphere around the box to measure its size on screen.
+ *  The records are split over the jobs, each only writing
+ *  its own boxes.
+ *
+ *  The flagged boxes and planes are placed as occluders; the
+ *  box of any other shape reaches past the shape, so it
+ *  would hide objects that are really in view.
+ ***********************************************************/
+void SceneManager::UpdateDrawBounds()
+{
+	const int recordCount = static_cast<int>(m_drawList.size());
+	m_culler.Resize(recordCount);
+	m_lodSelector.Resize(recordCount);
+	m_jobs.ParallelFor(recordCount, g_RecordsPerJob, [this](int range, int first, int count)
+	{
+		for (int i = first; i < first + count; i++)
+		{
+			const DRAW_RECORD& record = m_drawList[i];
+			glm::vec3 center;
+			glm::vec3 extent;
+			FrustumCuller::TransformBounds(
+				m_meshBoundsMin[record.mesh],
+				m_meshBoundsMax[record.mesh],
+				m_transforms.GetWorldMatrix(record.transformNode),
+				center,
+				extent);
+			m_culler.SetBox(i, center, extent);
+			// the sphere around the world box
+			m_lodSelector.SetBounds(i, center, glm::length(extent),
+				PrimitiveMeshes::GetLevelCount(record.mesh));
+		}
+	});
+
+	m_occlusionCuller.ClearOccluders();
+	for (int i = 0; i < recordCount; i++)
+	{
+		const DRAW_RECORD& record = m_drawList[i];
+		if (record.occluder && record.depthWrite &&
+			((record.mesh == MESH_BOX) || (record.mesh == MESH_PLANE)))
+		{
+			m_occlusionCuller.AddOccluder(i, m_meshBoundsMin[record.mesh], m_meshBoundsMax[record.mesh],
+				m_transforms.GetWorldMatrix(record.transformNode));
+		}
+	}
+	m_bBoundsDirty = false;
+}
+
+/***********************************************************
+ *  CullDrawList()
+ *
+ *  This method is used for flagging the records whose box
+ *  touches the frustum of the matrices passed to
+ *  SetViewState(), the same ones the shaders draw with.
+ *  Each job tests its own range of boxes.
+ ***********************************************************/
+void SceneManager::CullDrawList()
+{
+	ScopedCpuTimer timer("FrustumCull");
+
+	if (m_bBoundsDirty)
+	{
+		UpdateDrawBounds();
+	}
+
+	m_visible.swap(m_lastVisible);
+	if (m_bCulling)
+	{
+		m_culler.SetFrustum(m_projectionMatrix * m_viewMatrix);
+		const int boxCount = m_culler.GetBoxCount();
+		m_visible.resize(boxCount);
+		m_rangeCounts.assign(m_jobs.GetRangeCount(boxCount, g_RecordsPerJob), 0);
+		m_jobs.ParallelFor(boxCount, g_RecordsPerJob, [this](int range, int first, int count)
+		{
+			m_rangeCounts[range] = m_culler.CullRange(first, count, m_visible);
+		});
+		m_visibleCount = 0;
+		for (int rangeCount : m_rangeCounts)
+		{
+			m_visibleCount += rangeCount;
+		}
+	}
+	else
+	{
+		m_visible.assign(m_drawList.size(), 1);
+		m_visibleCount = static_cast<int>(m_drawList.size());
+	}
+}
+
+/***********************************************************
+ *  CullOccludedRecords()
+ *
+ *  This method is used for waiting for the occlusion pass
+ *  started at the top of the frame and clearing the visible
+ *  flag of the records it found hidden.
+ ***********************************************************/
+void SceneManager::CullOccludedRecords()
+{
+	ScopedCpuTimer timer("OcclusionWait");
+
+	m_occludedCount = m_occlusionCuller.Finish(m_visible);
+	m_visibleCount -= m_occludedCount;
+}
+
+/***********************************************************
+ *  SelectDrawLevels()
+ *
+ *  This method is used for picking the level of detail of
+ *  the visible records from the camera of the current frame.
+ *  The instanced batches are split by level, so they are
+ *  only rebuilt when a record changed level.
+ ***********************************************************/
+void SceneManager::SelectDrawLevels()
+{
+	ScopedCpuTimer timer("SelectLod");
+
+	const int drawCount = m_lodSelector.GetDrawCount();
+	m_rangeCounts.assign(m_jobs.GetRangeCount(drawCount, g_RecordsPerJob), 0);
+	m_jobs.ParallelFor(drawCount, g_RecordsPerJob, [this](int range, int first, int count)
+	{
+		m_rangeCounts[range] = m_lodSelector.UpdateRange(first, count,
+			m_viewPosition, m_projectionMatrix, m_visible, m_lastVisible);
+	});
+	for (int changedCount : m_rangeCounts)
+	{
+		if (changedCount > 0)
+		{
+			m_bInstancesDirty = true;
+		}
+	}
+}
+
+/***********************************************************
+ *  GetDrawLevel()
+ *
+ *  This method is used for getting the level of detail a
+ *  record is drawn at, 0 when the levels are turned off.
+ ***********************************************************/
+int SceneManager::GetDrawLevel(int recordIndex) const
+{
+	if (!m_bLevelOfDetail || (recordIndex >= m_lodSelector.GetDrawCount()))
+	{
+		return(0);
+	}
+	return(m_lodSelector.GetLevel(recordIndex));
+}
+
+/***********************************************************
+ *  BuildRenderQueue()
+ *
+ *  This method is used for queueing the visible records.
+ *  Opaque records are keyed by their state and view depth.
+ *  Records that do not write depth are drawn last in source
+ *  order, since they blend over what is already drawn.  A
+ *  merged static batch is queued once, by the first of its
+ *  records that is visible.
+ ***********************************************************/
+void SceneManager::BuildRenderQueue()
+{
+	// each job packs the keys of its visible records
+	const int recordCount = static_cast<int>(m_drawList.size());
+	const int rangeCount = m_jobs.GetRangeCount(recordCount, g_RecordsPerJob);
+	if (static_cast<int>(m_drawPackets.size()) < rangeCount)
+	{
+		m_drawPackets.resize(rangeCount);
+	}
+	m_jobs.ParallelFor(recordCount, g_RecordsPerJob, [this](int range, int first, int count)
+	{
+		std::vector<RenderQueue::QUEUE_ITEM>& packets = m_drawPackets[range];
+		packets.clear();
+		for (int i = first; i < first + count; i++)
+		{
+			if ((i < static_cast<int>(m_visible.size())) && !m_visible[i])
+			{
+				continue;
+			}
+
+			const DRAW_RECORD& record = m_drawList[i];
+			RenderQueue::QUEUE_ITEM packet;
+			packet.index = i;
+			if (record.depthWrite)
+			{
+				glm::vec4 viewCenter = m_viewMatrix *
+					m_transforms.GetWorldMatrix(record.transformNode)[3];
+				packet.key = RenderQueue::MakeKey(
+					RenderQueue::PASS_OPAQUE,
+					(record.textureHandle >= 0) ? 1 : 0,
+					record.textureHandle,
+					record.materialIndex,
+					record.mesh * PrimitiveMeshes::LOD_LEVEL_COUNT + GetDrawLevel(i),
+					-viewCenter.z);
+			}
+			else
+			{
+				packet.key = RenderQueue::MakeKey(RenderQueue::PASS_OVERLAY, 0, -1, -1, 0, 0.0f);
+			}
+			packets.push_back(packet);
+		}
+	});
+
+	// merged in record order, keeping the first record of each
+	// static batch, so the queue does not depend on the threads
+	m_renderQueue.Clear();
+	m_staticBatchQueued.assign(m_staticBatcher.GetBatchCount(), 0);
+	for (int range = 0; range < rangeCount; range++)
+	{
+		for (const RenderQueue::QUEUE_ITEM& packet : m_drawPackets[range])
+		{
+			int staticBatch = m_drawList[packet.index].staticBatch;
+			if (staticBatch >= 0)
+			{
+				if (m_staticBatchQueued[staticBatch])
+				{
+					continue;
+				}
+				m_staticBatchQueued[staticBatch] = 1;
+			}
+			m_renderQueue.Push(packet.key, packet.index);
+		}
+	}
+
+	if (m_bSortDraws)
+	{
+		ScopedCpuTimer timer("SortDraws");
+		m_renderQueue.Sort();
+	}
+	else
+	{
+		m_renderQueue.UpdateStats();
+	}
+}
+
+/***********************************************************
+ *  BuildStaticBatches()
+ *
+ *  This method is used for merging the records that never
+ *  move into batches of the same texture, color, UV scale
+ *  and material, each drawn with one call.  Overlays and
+ *  movable records keep their own draws.  ShapeMeshes keeps
+ *  its vertices on the GPU only, so the batches are merged
+ *  from the primitive meshes, which RenderImmediate() then
+ *  draws the other records from as well.
+ ***********************************************************/
+void SceneManager::BuildStaticBatches()
+{
+	m_staticBatcher.Clear();
+	m_nodeRecords.assign(m_transforms.GetNodeCount(), -1);
+
+	// the record that set up each batch holds its draw state
+	std::vector<int> batchRecords;
+	for (size_t i = 0; i < m_drawList.size(); i++)
+	{
+		DRAW_RECORD& record = m_drawList[i];
+		record.staticBatch = -1;
+		record.staticObject = -1;
+		m_nodeRecords[record.transformNode] = static_cast<int>(i);
+		if (record.movable || !record.depthWrite)
+		{
+			continue;
+		}
+
+		int batch = -1;
+		for (size_t b = 0; b < batchRecords.size(); b++)
+		{
+			const DRAW_RECORD& first = m_drawList[batchRecords[b]];
+			if ((first.textureHandle == record.textureHandle) &&
+				(first.materialIndex == record.materialIndex) &&
+				(first.color == record.color) &&
+				(first.uvScale == record.uvScale))
+			{
+				batch = static_cast<int>(b);
+				break;
+			}
+		}
+		if (batch < 0)
+		{
+			batch = static_cast<int>(batchRecords.size());
+			batchRecords.push_back(static_cast<int>(i));
+		}
+
+		record.staticBatch = batch;
+		record.staticObject = m_staticBatcher.AddObject(batch, record.mesh,
+			m_transforms.GetWorldMatrix(record.transformNode));
+	}
+
+	if (!m_staticBatcher.Build())
+	{
+		for (DRAW_RECORD& record : m_drawList)
+		{
+			record.staticBatch = -1;
+			record.staticObject = -1;
+		}
+		m_staticBatcher.Clear();
+		return;
+	}
+
+	std::cout << "Merged " << m_staticBatcher.GetObjectCount() << " static objects into "
+		<< m_staticBatcher.GetBatchCount() << " batches" << std::endl;
+}
+
+/***********************************************************
+ *  UpdateStaticBatches()
+ *
+ *  This method is used for rewriting the merged vertices of
+ *  the static records whose world matrix was recomputed by
+ *  the last transform update, leaving the rest untouched.
+ ***********************************************************/
+void SceneManager::UpdateStaticBatches()
+{
+	if (m_staticBatcher.GetObjectCount() == 0)
+	{
+		return;
+	}
+
+	for (int node : m_transforms.GetLastUpdatedNodes())
+	{
+		int recordIndex = m_nodeRecords[node];
+		if ((recordIndex >= 0) && (m_drawList[recordIndex].staticObject >= 0))
+		{
+			m_staticBatcher.UpdateObject(m_drawList[recordIndex].staticObject,
+				m_transforms.GetWorldMatrix(node));
+		}
+	}
+}
+
+/***********************************************************
+ *  SetObjectTransform()
+ *
+ *  This method is used for placing an object again after the
+ *  scene was prepared.
+ ***********************************************************/
+void SceneManager::SetObjectTransform(
+	int transformNode,
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	if ((transformNode < 0) || (transformNode >= m_transforms.GetNodeCount()))
+	{
+		return;
+	}
+
+	m_transforms.SetLocalTransform(transformNode, scaleXYZ, rotationDegrees, positionXYZ);
+}
+
+/**************************************************************/
+/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
+/*** preparing and rendering their own 3D replicated scenes.***/
+/*** Please refer to the code in the OpenGL sample project  ***/
+/*** for assistance.                                        ***/
+/**************************************************************/
+
+
+/***********************************************************
+ *  DefineObjectMaterials()
+ *
+ *  This method is used for configuring the various material
+ *  settings for all of the objects within the 3D scene.
+ ***********************************************************/
+void SceneManager::DefineObjectMaterials()
+{
+	OBJECT_MATERIAL woodMaterial;
+	woodMaterial.ambientColor = glm::vec3(0.4f, 0.3f, 0.1f);
+	woodMaterial.ambientStrength = 0.2f;
+	woodMaterial.diffuseColor = glm::vec3(0.3f, 0.2f, 0.1f);
+	woodMaterial.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	woodMaterial.shininess = 2.0f;
+	woodMaterial.tag = "wood";
+	AddObjectMaterial(woodMaterial);
+
+	OBJECT_MATERIAL plasticMaterial;
+	plasticMaterial.ambientColor = glm::vec3(0.2f, 0.2f, 0.2f);
+	plasticMaterial.ambientStrength = 0.3f;
+	plasticMaterial.diffuseColor = glm::vec3(0.4f, 0.4f, 0.4f);
+	plasticMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	plasticMaterial.shininess = 22.0f;
+	plasticMaterial.tag = "plastic";
+	AddObjectMaterial(plasticMaterial);
+
+	OBJECT_MATERIAL fabricMaterial;
+	fabricMaterial.ambientColor = glm::vec3(0.2f, 0.2f, 0.2f);
+	fabricMaterial.ambientStrength = 0.3f;
+	fabricMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	fabricMaterial.specularColor = glm::vec3(0.0f, 0.0f, 0.0f);
+	fabricMaterial.shininess = 1.0f;
+	fabricMaterial.tag = "fabric";
+	AddObjectMaterial(fabricMaterial);
+
+	OBJECT_MATERIAL wallMaterial;
+	wallMaterial.ambientColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	wallMaterial.ambientStrength = 0.4f;
+	wallMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	wallMaterial.specularColor = glm::vec3(0.05f, 0.05f, 0.05f);
+	wallMaterial.shininess = 1.0f;
+	wallMaterial.tag = "wall";
+	AddObjectMaterial(wallMaterial);
+
+	OBJECT_MATERIAL glassMaterial;
+	glassMaterial.ambientColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	glassMaterial.ambientStrength = 0.3f;
+	glassMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	glassMaterial.specularColor = glm::vec3(0.9f, 0.9f, 0.9f);
+	glassMaterial.shininess = 85.0f;
+	glassMaterial.tag = "glass";
+	AddObjectMaterial(glassMaterial);
+}
+
+/***********************************************************
+ *  SetupSceneLights()
+ *
+ *  This method is used for adding and configuring the light
+ *  sources for the 3D scene.  The scene is currently shown
+ *  unlit, so the light table is uploaded with lighting off.
+ ***********************************************************/
+void SceneManager::SetupSceneLights()
+{
+	m_lights = {};
+
+	// overhead room light, used once lighting is switched on
+	m_lights.lights[0].position = glm::vec4(0.0f, 2.5f, 1.5f, 1.0f);
+	m_lights.lights[0].ambientColor = glm::vec4(0.2f, 0.2f, 0.2f, 1.0f);
+	m_lights.lights[0].diffuseColor = glm::vec4(0.8f, 0.8f, 0.75f, 1.0f);
+	m_lights.lights[0].specularColor = glm::vec4(0.5f, 0.5f, 0.5f, 0.3f);
+	m_lights.lights[0].params = glm::vec4(32.0f, 0.0f, 0.0f, 0.0f);
+	m_lights.lightCount = 1;
+	m_lights.useLighting = 0;
+}
+
+/***********************************************************
+ *  PrepareScene()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene 
+ *  rendering
+ ***********************************************************/
+void SceneManager::PrepareScene()
+{
+	// the per-draw shader only samples 2D textures
+	if ((m_textureBackend == TEXTURE_BACKEND_ARRAY) && (m_renderPath == RENDER_PATH_IMMEDIATE))
+	{
+		std::cout << "The texture array backend needs the instanced render path" << std::endl;
+		m_textureBackend = TEXTURE_BACKEND_UNITS;
+	}
+
+	// one multi-draw call cannot switch textures between its commands
+	if (m_renderPath == RENDER_PATH_INDIRECT)
+	{
+		m_textureBackend = TEXTURE_BACKEND_ARRAY;
+	}
+
+	// start decoding the textures first so it overlaps the other setup
+	LoadSceneTextures();
+
+	// without the array every command would sample the texture
+	// of the first batch
+	if ((m_renderPath == RENDER_PATH_INDIRECT) && (m_textureBackend != TEXTURE_BACKEND_ARRAY))
+	{
+		std::cout << "The indirect render path needs the texture array, drawing instanced" << std::endl;
+		m_renderPath = RENDER_PATH_INSTANCED;
+	}
+
+	// one thread keeps every loop on the calling thread
+	if (m_threadCount != 1)
+	{
+		m_jobs.Start(m_threadCount - 1);
+	}
+
+	// Load each primitive once; reuse in RenderScene
+	m_basicMeshes->LoadPlaneMesh();
+	m_basicMeshes->LoadBoxMesh();
+	m_basicMeshes->LoadCylinderMesh();
+	m_basicMeshes->LoadSphereMesh();
+
+	// the material table and lights are uploaded once, not per draw
+	DefineObjectMaterials();
+	SetupSceneLights();
+	LoadUniformBlocks();
+
+	if ((m_renderPath == RENDER_PATH_INDIRECT) && !LoadIndirectPath())
+	{
+		std::cout << "Indirect render path unavailable, drawing instanced" << std::endl;
+		m_renderPath = RENDER_PATH_INSTANCED;
+	}
+
+	if ((m_renderPath == RENDER_PATH_INSTANCED) && !LoadInstancedPath())
+	{
+		std::cout << "Instanced render path unavailable, drawing per object" << std::endl;
+		m_renderPath = RENDER_PATH_IMMEDIATE;
+
+		if (m_textureBackend == TEXTURE_BACKEND_ARRAY)
+		{
+			m_textureBackend = TEXTURE_BACKEND_UNITS;
+			LoadSceneTextures();
+		}
+	}
+
+	// the coarser levels of detail come from the primitive meshes,
+	// which the per-draw shader only reads as floats
+	if (m_renderPath == RENDER_PATH_IMMEDIATE)
+	{
+		if (m_primitiveMeshes.GetVertexFormat() != PrimitiveMeshes::VERTEX_FORMAT_FLOAT)
+		{
+			std::cout << "The packed vertex format needs the instanced render path" << std::endl;
+			m_primitiveMeshes.SetVertexFormat(PrimitiveMeshes::VERTEX_FORMAT_FLOAT);
+		}
+		m_primitiveMeshes.LoadMeshes();
+	}
+
+	// nothing in the scene moves, so every size, position, matrix
+	// and texture slot is resolved once here instead of per frame
+	LoadSceneObjects();
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  submitting the draw list built in PrepareScene()
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	// only subtrees that were moved since the last frame are recomputed
+	if (m_transforms.UpdateWorldMatrices(&m_jobs) > 0)
+	{
+		m_bInstancesDirty = true;
+		m_bBoundsDirty = true;
+		UpdateStaticBatches();
+	}
+	if (m_bBoundsDirty)
+	{
+		UpdateDrawBounds();
+	}
+
+	// the occlusion pass runs on its worker while this thread
+	// uploads textures and tests the frustum, and the GPU is
+	// still busy with the previous frame
+	bool bOcclusion = m_bCulling && m_bOcclusionCulling &&
+		(m_occlusionCuller.GetOccluderCount() > 0);
+	if (bOcclusion)
+	{
+		m_occlusionCuller.Begin(m_projectionMatrix * m_viewMatrix, m_culler);
+	}
+
+	// swap placeholders for the textures decoded since the last frame
+	if (m_textureStreamer.GetPendingCount() > 0)
+	{
+		ScopedGpuTimer gpuTimer("TextureUploads");
+		m_textureStreamer.PumpUploads(m_pStateCache);
+	}
+
+	CullDrawList();
+	m_occludedCount = 0;
+	if (bOcclusion)
+	{
+		CullOccludedRecords();
+	}
+	// the instanced batches are only rebuilt when the set of
+	// visible records changed since the last frame
+	if (m_visible != m_lastVisible)
+	{
+		m_bInstancesDirty = true;
+	}
+
+	if (m_bLevelOfDetail)
+	{
+		SelectDrawLevels();
+	}
+
+	ScopedGpuTimer gpuTimer("SceneDraw");
+	if (m_renderPath == RENDER_PATH_INDIRECT)
+	{
+		RenderIndirect();
+	}
+	else if (m_renderPath == RENDER_PATH_INSTANCED)
+	{
+		RenderInstanced();
+	}
+	else
+	{
+		RenderImmediate();
+	}
+}
+
+/***********************************************************
+ *  BuildDrawList()
+ *
+ *  This method is used for filling the retained draw list
+ *  from the mapped scene.  The nodes and draws are read in
+ *  place and the storage is reserved up front, so loading
+ *  does no parsing and no allocation per object.
+ ***********************************************************/
+void SceneManager::BuildDrawList()
+{
+	m_drawList.clear();
+	m_transforms.Clear();
+
+	if (!m_sceneFile.IsOpen())
+	{
+		std::cout << "No scene is loaded, the draw list is empty" << std::endl;
+		return;
+	}
+
+	const int nodeCount = m_sceneFile.GetNodeCount();
+	const int drawCount = m_sceneFile.GetDrawCount();
+	m_transforms.Reserve(nodeCount);
+	m_drawList.reserve(drawCount);
+
+	// each tag is resolved once, the draws only index the tables
+	std::vector<int> textureHandles(m_sceneFile.GetTextureCount());
+	for (int i = 0; i < m_sceneFile.GetTextureCount(); i++)
+	{
+		textureHandles[i] = FindTextureHandle(m_sceneFile.GetTexture(i));
+		if (textureHandles[i] < 0)
+		{
+			std::cout << "Unknown texture tag '" << m_sceneFile.GetTexture(i) << "' in scene" << std::endl;
+		}
+	}
+	std::vector<int> materialHandles(m_sceneFile.GetMaterialCount());
+	for (int i = 0; i < m_sceneFile.GetMaterialCount(); i++)
+	{
+		materialHandles[i] = FindMaterialHandle(m_sceneFile.GetMaterial(i));
+		if (materialHandles[i] < 0)
+		{
+			std::cout << "Unknown material tag '" << m_sceneFile.GetMaterial(i) << "' in scene" << std::endl;
+		}
+	}
+
+	// parents come first in the file, so node indices carry over
+	const SceneFile::SCENE_NODE* pNodes = m_sceneFile.GetNodes();
+	for (int i = 0; i < nodeCount; i++)
+	{
+		const SceneFile::SCENE_NODE& node = pNodes[i];
+		m_transforms.AddNode(
+			node.parent,
+			glm::vec3(node.scale[0], node.scale[1], node.scale[2]),
+			glm::vec3(node.rotationDegrees[0], node.rotationDegrees[1], node.rotationDegrees[2]),
+			glm::vec3(node.position[0], node.position[1], node.position[2]));
+	}
+
+	const SceneFile::SCENE_DRAW* pDraws = m_sceneFile.GetDraws();
+	for (int i = 0; i < drawCount; i++)
+	{
+		const SceneFile::SCENE_DRAW& draw = pDraws[i];
+		DRAW_RECORD record;
+
+		record.mesh = static_cast<SHAPE_MESH>(draw.mesh);
+		record.transformNode = static_cast<int>(draw.node);
+		record.textureHandle = (draw.texture >= 0) ? textureHandles[draw.texture] : -1;
+		record.color = glm::vec4(draw.color[0], draw.color[1], draw.color[2], draw.color[3]);
+		record.uvScale = glm::vec2(draw.uvScale[0], draw.uvScale[1]);
+		record.materialIndex = (draw.material >= 0) ? materialHandles[draw.material] : -1;
+		record.depthWrite = (0 == (draw.flags & SceneFile::DRAW_FLAG_OVERLAY));
+		record.movable = (0 != (draw.flags & SceneFile::DRAW_FLAG_MOVABLE));
+		record.occluder = (0 != (draw.flags & SceneFile::DRAW_FLAG_OCCLUDER));
+		record.staticBatch = -1;
+		record.staticObject = -1;
+
+		m_drawList.push_back(record);
+	}
+
+	// compute every world matrix once; static frames skip this work
+	m_transforms.UpdateWorldMatrices();
+	m_bInstancesDirty = true;
+	m_bBoundsDirty = true;
+}
@@ -11,6 +11,24 @@
 
 #include "ShaderManager.h"
 #include "ShapeMeshes.h"
+#include "TransformGraph.h"
+#include "JobSystem.h"
+#include "PrimitiveMeshes.h"
+#include "InstancedRenderer.h"
+#include "IndirectRenderer.h"
+#include "UniformBlocks.h"
+#include "GLStateCache.h"
+#include "TagRegistry.h"
+#include "TextureStreamer.h"
+#include "TextureCache.h"
+#include "ProgramCache.h"
+#include "TextureArray.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "LodSelector.h"
+#include "RenderQueue.h"
+#include "StaticBatcher.h"
+#include "SceneFile.h"
 
 #include <string>
 #include <vector>
@@ -25,7 +43,7 @@ class SceneManager
 {
 public:
 	// constructor
-	SceneManager(ShaderManager *pShaderManager);
+	SceneManager(ShaderManager *pShaderManager, GLStateCache* pStateCache);
 	// destructor
 	~SceneManager();
 
@@ -33,6 +51,8 @@ public:
 	{
 		std::string tag;
 		uint32_t ID;
+		// layer of the texture array, or -1 for a 2D texture
+		int layer;
 	};
 
 	struct OBJECT_MATERIAL
@@ -45,29 +65,169 @@ public:
 		std::string tag;
 	};
 
+	// basic shape meshes that can be referenced by the draw list
+	enum SHAPE_MESH
+	{
+		MESH_BOX = PrimitiveMeshes::PRIMITIVE_BOX,
+		MESH_CYLINDER = PrimitiveMeshes::PRIMITIVE_CYLINDER,
+		MESH_SPHERE = PrimitiveMeshes::PRIMITIVE_SPHERE,
+		MESH_PLANE = PrimitiveMeshes::PRIMITIVE_PLANE
+	};
+
+	// ways of submitting the draw list to OpenGL
+	enum RENDER_PATH
+	{
+		// one ShapeMeshes draw and set of uniforms per object
+		RENDER_PATH_IMMEDIATE,
+		// one instanced draw per primitive and texture group
+		RENDER_PATH_INSTANCED,
+		// the instanced groups as commands of one multi-draw indirect
+		// call, needs GL 4.3 and ARB_shader_draw_parameters
+		RENDER_PATH_INDIRECT
+	};
+
+	// ways of keeping the scene textures in OpenGL
+	enum TEXTURE_BACKEND
+	{
+		// one 2D texture each, spread over the texture units
+		TEXTURE_BACKEND_UNITS,
+		// layers of one array texture, needs the instanced path
+		TEXTURE_BACKEND_ARRAY
+	};
+
+	// one fully resolved draw, built once when the scene is prepared
+	struct DRAW_RECORD
+	{
+		SHAPE_MESH mesh;
+		// node holding the cached world matrix of the shape
+		int transformNode;
+		// texture handle, or -1 for a flat colored draw
+		int textureHandle;
+		glm::vec4 color;
+		glm::vec2 uvScale;
+		// material handle, which indexes the defined materials, or -1
+		int materialIndex;
+		// false for overlays that must not write depth
+		bool depthWrite;
+		// true for objects that may move, which are never merged
+		bool movable;
+		// true for large boxes and planes drawn into the occlusion buffer
+		bool occluder;
+		// merged batch and object of the static batcher, or -1
+		int staticBatch;
+		int staticObject;
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
+	// pointer to the shared OpenGL state cache
+	GLStateCache* m_pStateCache;
 	// pointer to basic shapes object
 	ShapeMeshes* m_basicMeshes;
-	// total number of loaded textures
-	int m_loadedTextures;
-	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
+	// loaded textures info, indexed by texture handle
+	std::vector<TEXTURE_INFO> m_textures;
+	// texture and material tags interned as handles
+	TagRegistry m_textureTags;
+	TagRegistry m_materialTags;
+	// texture units the loaded textures are spread over
+	int m_textureUnitCount;
+	// cooked texture containers with precomputed mip chains
+	TextureCache m_textureCache;
+	// driver binaries of the linked render path programs
+	ProgramCache m_programCache;
+	bool m_bProgramCaching;
+	// loads texture images in the background at startup
+	TextureStreamer m_textureStreamer;
+	// selected texture backend and its array texture
+	TEXTURE_BACKEND m_textureBackend;
+	int m_textureLayerSize;
+	TextureArray m_textureArray;
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// retained draw list filled by PrepareScene()
+	std::vector<DRAW_RECORD> m_drawList;
+	// placement hierarchy of the scene objects
+	TransformGraph m_transforms;
+	// worker threads sharing the per-frame loops over the scene
+	JobSystem m_jobs;
+	int m_threadCount;
+	// visible records and level changes counted per job range
+	std::vector<int> m_rangeCounts;
+	// queue items built per job range, merged in record order
+	std::vector<std::vector<RenderQueue::QUEUE_ITEM>> m_drawPackets;
+	// scene source or compiled scene, empty for the default scene
+	std::string m_scenePath;
+	// compiled scene mapped while the scene is loaded
+	SceneFile m_sceneFile;
+	// selected way of submitting the draw list
+	RENDER_PATH m_renderPath;
+	// camera matrices of the current frame
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	glm::vec3 m_viewPosition;
+	// instanced render path resources
+	ShaderManager* m_pInstancedShader;
+	PrimitiveMeshes m_primitiveMeshes;
+	InstancedRenderer m_instancedRenderer;
+	bool m_bInstancesDirty;
+	// multi-draw indirect render path resources
+	ShaderManager* m_pIndirectShader;
+	IndirectRenderer m_indirectRenderer;
+	// material table and scene lights uniform blocks
+	UniformBuffer m_materialBlock;
+	UniformBuffer m_lightBlock;
+	LIGHT_BLOCK m_lights;
+	// true when the main program reads materials from the block
+	bool m_bMaterialBlockBound;
+	// true when materials go to the main program by name instead
+	bool m_bMaterialUniforms;
+	// material set by the last immediate draw, -1 for none
+	int m_lastMaterialIndex;
+	// world boxes of the draw list and the frustum test over them
+	FrustumCuller m_culler;
+	glm::vec3 m_meshBoundsMin[PrimitiveMeshes::PRIMITIVE_COUNT];
+	glm::vec3 m_meshBoundsMax[PrimitiveMeshes::PRIMITIVE_COUNT];
+	bool m_bBoundsDirty;
+	bool m_bCulling;
+	// per record visibility of this frame and the one before
+	std::vector<unsigned char> m_visible;
+	std::vector<unsigned char> m_lastVisible;
+	int m_visibleCount;
+	// records hidden behind the occluders, tested on a worker thread
+	OcclusionCuller m_occlusionCuller;
+	bool m_bOcclusionCulling;
+	int m_occludedCount;
+	// level of detail of the curved records, from their size on screen
+	LodSelector m_lodSelector;
+	bool m_bLevelOfDetail;
+	// visible records in the order they are submitted
+	RenderQueue m_renderQueue;
+	bool m_bSortDraws;
+	// static records merged into world space batches
+	StaticBatcher m_staticBatcher;
+	bool m_bStaticBatching;
+	// record of every transform node, or -1
+	std::vector<int> m_nodeRecords;
+	// batches already queued in the frame being built
+	std::vector<unsigned char> m_staticBatchQueued;
 
-	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
+	// create a placeholder texture and stream the image file into it
+	bool LoadGLTextureAsync(const char* filename, const char* tag);
 	// bind loaded OpenGL textures to slots in memory
 	void BindGLTextures();
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
 	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
+	int FindTextureID(const char* tag);
+	int FindTextureHandle(const char* tag);
+	// bind a texture if needed and return its texture unit
+	int BindTextureHandle(int textureHandle);
 	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	bool FindMaterial(const char* tag, OBJECT_MATERIAL& material);
+	int FindMaterialHandle(const char* tag);
+	// define a material and intern its tag
+	int AddObjectMaterial(const OBJECT_MATERIAL& material);
 
 	// set the transformation values 
 	// into the transform buffer
@@ -87,7 +247,7 @@ private:
 
 	// set the texture data into the shader
 	void SetShaderTexture(
-		std::string textureTag);
+		int textureHandle);
 
 	// set the UV scale for the texture mapping
 	void SetTextureUVScale(
@@ -95,13 +255,122 @@ private:
 
 	// set the object material into the shader
 	void SetShaderMaterial(
-		std::string materialTag);
+		int materialHandle);
+
+	// compile the scene source if needed and map the result
+	bool LoadSceneFile();
+	// map the scene file and build the draw list and batches
+	bool LoadSceneObjects();
+	// fill the draw list with the objects of the mapped scene
+	void BuildDrawList();
+	// upload the material table and the lights into their blocks
+	void LoadUniformBlocks();
+	// attach a program to the scene uniform blocks
+	void BindSceneBlocks(GLuint program);
+	// issue the draw command for the passed in mesh
+	void DrawShapeMesh(SHAPE_MESH mesh);
+
+	// load the shaders and meshes of the instanced path
+	bool LoadInstancedPath();
+	// load the shaders and buffers of the indirect path
+	bool LoadIndirectPath();
+	// group the draw list into instanced batches
+	void BuildInstanceBatches();
+	// submit the draw list one object at a time
+	void RenderImmediate();
+	// submit the draw list one batch at a time
+	void RenderInstanced();
+	// submit the draw list with one multi-draw call per pass
+	void RenderIndirect();
+	// fit world boxes around the records after they moved
+	void UpdateDrawBounds();
+	// flag the records inside the camera frustum
+	void CullDrawList();
+	// clear the flag of the records the occlusion pass hid
+	void CullOccludedRecords();
+	// pick the level of detail of the visible records
+	void SelectDrawLevels();
+	// level of detail a record is drawn at
+	int GetDrawLevel(int recordIndex) const;
+	// queue the visible records, sorted by state and depth
+	void BuildRenderQueue();
+	// merge the static records that share a draw state
+	void BuildStaticBatches();
+	// move the merged vertices of the static records that moved
+	void UpdateStaticBatches();
 
 public:
 
+	// select how the draw list is submitted
+	void SetRenderPath(RENDER_PATH renderPath);
+	// select how the textures are kept, before PrepareScene()
+	void SetTextureBackend(TEXTURE_BACKEND textureBackend, int layerSize = 512);
+	// upload the primitive meshes of the instanced paths packed, before PrepareScene()
+	void SetVertexFormat(PrimitiveMeshes::VERTEX_FORMAT format) { m_primitiveMeshes.SetVertexFormat(format); }
+	// threads sharing the scene loops, 0 picks one per core, before PrepareScene()
+	void SetThreadCount(int threadCount) { m_threadCount = threadCount; }
+	int GetThreadCount() const { return m_jobs.GetThreadCount(); }
+	// choices in effect after PrepareScene() applied any fallbacks
+	RENDER_PATH GetRenderPath() const { return m_renderPath; }
+	TEXTURE_BACKEND GetTextureBackend() const { return m_textureBackend; }
+	PrimitiveMeshes::VERTEX_FORMAT GetVertexFormat() const { return m_primitiveMeshes.GetVertexFormat(); }
+	// textures still being decoded or waiting for upload
+	int GetPendingTextureCount() const { return m_textureStreamer.GetPendingCount(); }
+	// skip the records outside the camera frustum, on by default
+	void SetFrustumCulling(bool bEnabled) { m_bCulling = bEnabled; }
+	// skip the records hidden behind the flagged occluders, on by default
+	void SetOcclusionCulling(bool bEnabled) { m_bOcclusionCulling = bEnabled; }
+	bool GetOcclusionCulling() const { return m_bOcclusionCulling; }
+	// records the last frame hid behind occluders, and occluders drawn
+	int GetOccludedCount() const { return m_occludedCount; }
+	int GetOccluderCount() const { return m_occlusionCuller.GetOccluderCount(); }
+	// records drawn by the last frame, out of all of them
+	int GetVisibleCount() const { return m_visibleCount; }
+	int GetDrawCount() const { return static_cast<int>(m_drawList.size()); }
+	// draw small cylinders and spheres with fewer triangles, on by default
+	void SetLevelOfDetail(bool bEnabled) { m_bLevelOfDetail = bEnabled; m_bInstancesDirty = true; }
+	bool GetLevelOfDetail() const { return m_bLevelOfDetail; }
+	// sort the draws by state and depth, on by default
+	void SetDrawSorting(bool bEnabled) { m_bSortDraws = bEnabled; }
+	bool GetDrawSorting() const { return m_bSortDraws; }
+	// merge static objects on the per-object path, before PrepareScene(),
+	// off by default since the whole path then draws the primitive meshes
+	void SetStaticBatching(bool bEnabled) { m_bStaticBatching = bEnabled; }
+	// load the render path programs from cached binaries, on by default
+	void SetProgramCaching(bool bEnabled) { m_bProgramCaching = bEnabled; }
+	int GetStaticBatchCount() const { return m_staticBatcher.GetBatchCount(); }
+	// place an object by the node FindSceneNode() returned,
+	// merged objects are updated in place on the next frame
+	void SetObjectTransform(
+		int transformNode,
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegrees,
+		glm::vec3 positionXYZ);
+	// state changes of the last queue built, before and after sorting
+	const RenderQueue::QUEUE_STATS& GetRenderQueueStats() const { return m_renderQueue.GetStats(); }
+	// pass the camera matrices of the current frame
+	void SetViewState(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		const glm::vec3& viewPosition);
+	// cook every scene texture into the texture cache, no GL needed
+	static int CookSceneTextures();
+	// load a .scene source or a compiled scene, before PrepareScene()
+	void SetSceneFile(const char* path) { m_scenePath = (NULL != path) ? path : ""; }
+	// transform node of a named scene object, or -1
+	int FindSceneNode(const char* name) const { return m_sceneFile.FindNode(name); }
+	// compile a scene source, or the default one, no GL needed
+	static bool CompileSceneFile(const char* sourcePath);
+	// write a grid of copies of a scene as a compiled scene, no GL needed
+	static bool GenerateStressScene(const char* templatePath, int copyCount, const char* targetPath);
+	// swap in the objects of another scene file after PrepareScene()
+	bool ChangeScene(const char* path);
+
 	// The following methods are for the students to 
 	// customize for their own 3D scene
 	void PrepareScene();
 	void RenderScene();
 	void LoadSceneTextures();
+	void DefineObjectMaterials();
+	void SetupSceneLights();
 };
\ No newline at end of file
@@ -0,0 +1,260 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticbatcher.cpp
+// ============
+// merge static primitives into pre-transformed shared buffers
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StaticBatcher.h"
+
+#include <cstddef>
+
+/***********************************************************
+ *  StaticBatcher()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+StaticBatcher::StaticBatcher()
+{
+	m_bPrimitivesBuilt = false;
+	m_vao = 0;
+	m_vbo = 0;
+	m_ibo = 0;
+}
+
+/***********************************************************
+ *  ~StaticBatcher()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+StaticBatcher::~StaticBatcher()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for dropping the objects and batches.
+ ***********************************************************/
+void StaticBatcher::Clear()
+{
+	m_objects.clear();
+	m_batches.clear();
+	m_vertices.clear();
+}
+
+/***********************************************************
+ *  AddObject()
+ *
+ *  This method is used for adding one primitive placed by
+ *  the passed in world matrix to a batch.  Batches are
+ *  numbered by the caller, from 0 up.
+ ***********************************************************/
+int StaticBatcher::AddObject(int batch, int primitive, const glm::mat4& worldMatrix)
+{
+	if ((batch < 0) || (primitive < 0) || (primitive >= PrimitiveMeshes::PRIMITIVE_COUNT))
+	{
+		return(-1);
+	}
+
+	STATIC_OBJECT object;
+	object.batch = batch;
+	object.primitive = primitive;
+	object.worldMatrix = worldMatrix;
+	object.firstVertex = 0;
+	object.vertexCount = 0;
+	m_objects.push_back(object);
+
+	if (batch >= static_cast<int>(m_batches.size()))
+	{
+		STATIC_BATCH empty = { 0, 0 };
+		m_batches.resize(batch + 1, empty);
+	}
+
+	return(static_cast<int>(m_objects.size() - 1));
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for laying the objects out batch by
+ *  batch, so every batch is one contiguous index range, and
+ *  uploading the merged buffers.  Objects keep the order
+ *  they were added in inside their batch.
+ ***********************************************************/
+bool StaticBatcher::Build()
+{
+	if (!m_bPrimitivesBuilt)
+	{
+		for (int i = 0; i < PrimitiveMeshes::PRIMITIVE_COUNT; i++)
+		{
+			PrimitiveMeshes::BuildPrimitive(i, m_primitives[i]);
+		}
+		m_bPrimitivesBuilt = true;
+	}
+
+	// bucket the objects by batch
+	std::vector<std::vector<int> > batchObjects(m_batches.size());
+	for (size_t i = 0; i < m_objects.size(); i++)
+	{
+		batchObjects[m_objects[i].batch].push_back(static_cast<int>(i));
+	}
+
+	std::vector<GLuint> indices;
+	m_vertices.clear();
+	for (size_t b = 0; b < m_batches.size(); b++)
+	{
+		m_batches[b].firstIndex = static_cast<GLsizei>(indices.size());
+		for (int objectIndex : batchObjects[b])
+		{
+			STATIC_OBJECT& object = m_objects[objectIndex];
+			const PrimitiveMeshes::MESH_GEOMETRY& geometry = m_primitives[object.primitive];
+
+			object.firstVertex = static_cast<GLint>(m_vertices.size());
+			object.vertexCount = static_cast<GLsizei>(geometry.vertices.size());
+			m_vertices.resize(m_vertices.size() + geometry.vertices.size());
+			TransformObject(object);
+
+			for (GLuint index : geometry.indices)
+			{
+				indices.push_back(object.firstVertex + index);
+			}
+		}
+		m_batches[b].indexCount = static_cast<GLsizei>(indices.size()) - m_batches[b].firstIndex;
+	}
+
+	if (m_vertices.empty())
+	{
+		return(false);
+	}
+
+	const GLsizei stride = sizeof(PrimitiveMeshes::MESH_VERTEX);
+
+	if (0 == m_vao)
+	{
+		glGenVertexArrays(1, &m_vao);
+		glGenBuffers(1, &m_vbo);
+		glGenBuffers(1, &m_ibo);
+	}
+
+	glBindVertexArray(m_vao);
+
+	// dynamic, since moving one object rewrites part of it
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glBufferData(GL_ARRAY_BUFFER,
+		m_vertices.size() * sizeof(PrimitiveMeshes::MESH_VERTEX),
+		m_vertices.data(),
+		GL_DYNAMIC_DRAW);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+		indices.size() * sizeof(GLuint),
+		indices.data(),
+		GL_STATIC_DRAW);
+
+	// same attribute locations as the primitive meshes
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride,
+		reinterpret_cast<void*>(offsetof(PrimitiveMeshes::MESH_VERTEX, position)));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
+		reinterpret_cast<void*>(offsetof(PrimitiveMeshes::MESH_VERTEX, normal)));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
+		reinterpret_cast<void*>(offsetof(PrimitiveMeshes::MESH_VERTEX, uv)));
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return(true);
+}
+
+/***********************************************************
+ *  UpdateObject()
+ *
+ *  This method is used for moving one object after it was
+ *  built, by transforming its vertices again and uploading
+ *  only that range of the vertex buffer.
+ ***********************************************************/
+void StaticBatcher::UpdateObject(int object, const glm::mat4& worldMatrix)
+{
+	if ((object < 0) || (object >= static_cast<int>(m_objects.size())) || (0 == m_vbo))
+	{
+		return;
+	}
+
+	STATIC_OBJECT& staticObject = m_objects[object];
+	staticObject.worldMatrix = worldMatrix;
+	TransformObject(staticObject);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glBufferSubData(GL_ARRAY_BUFFER,
+		staticObject.firstVertex * sizeof(PrimitiveMeshes::MESH_VERTEX),
+		staticObject.vertexCount * sizeof(PrimitiveMeshes::MESH_VERTEX),
+		&m_vertices[staticObject.firstVertex]);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  TransformObject()
+ *
+ *  This method is used for writing the vertices of one
+ *  object in world space.  Normals go through the inverse
+ *  transpose so that non-uniform scales keep them
+ *  perpendicular to the surface.
+ ***********************************************************/
+void StaticBatcher::TransformObject(const STATIC_OBJECT& object)
+{
+	const PrimitiveMeshes::MESH_GEOMETRY& geometry = m_primitives[object.primitive];
+	glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(object.worldMatrix)));
+
+	for (size_t i = 0; i < geometry.vertices.size(); i++)
+	{
+		const PrimitiveMeshes::MESH_VERTEX& source = geometry.vertices[i];
+		PrimitiveMeshes::MESH_VERTEX& target = m_vertices[object.firstVertex + i];
+
+		target.position = glm::vec3(object.worldMatrix * glm::vec4(source.position, 1.0f));
+		target.normal = glm::normalize(normalMatrix * source.normal);
+		target.uv = source.uv;
+	}
+}
+
+/***********************************************************
+ *  DrawBatch()
+ *
+ *  This method is used for drawing one batch with a single
+ *  call.  The caller sets the model matrix to identity and
+ *  the draw state shared by the batch.
+ ***********************************************************/
+void StaticBatcher::DrawBatch(int batch) const
+{
+	if ((batch < 0) || (batch >= static_cast<int>(m_batches.size())) || (0 == m_vao))
+	{
+		return;
+	}
+
+	const STATIC_BATCH& staticBatch = m_batches[batch];
+	glBindVertexArray(m_vao);
+	glDrawElements(GL_TRIANGLES, staticBatch.indexCount, GL_UNSIGNED_INT,
+		reinterpret_cast<void*>(staticBatch.firstIndex * sizeof(GLuint)));
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the GL buffers.
+ ***********************************************************/
+void StaticBatcher::Destroy()
+{
+	if (0 != m_vao)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		glDeleteBuffers(1, &m_vbo);
+		glDeleteBuffers(1, &m_ibo);
+	}
+	m_vao = 0;
+	m_vbo = 0;
+	m_ibo = 0;
+}
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticbatcher.h
+// ============
+// merge static primitives into pre-transformed shared buffers
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PrimitiveMeshes.h"
+
+#include <vector>
+
+/***********************************************************
+ *  StaticBatcher
+ *
+ *  This class bakes objects that never move into one vertex
+ *  and index buffer, with the positions and normals already
+ *  in world space, so that every batch of objects sharing
+ *  the same draw state is drawn with a single call and an
+ *  identity model matrix.  The vertices keep the position,
+ *  normal and texture coordinate layout of PrimitiveMeshes.
+ *
+ *  The CPU copy of the merged vertices is kept, so when one
+ *  object is moved only its own vertex range is transformed
+ *  again and uploaded.
+ ***********************************************************/
+class StaticBatcher
+{
+public:
+	// constructor
+	StaticBatcher();
+	// destructor
+	~StaticBatcher();
+
+	// forget the objects, keeping the GL buffers for the next build
+	void Clear();
+	// add one primitive to a batch, returns the object index
+	int AddObject(int batch, int primitive, const glm::mat4& worldMatrix);
+	// merge the objects batch by batch and upload them
+	bool Build();
+	// move one object, uploading only its vertices
+	void UpdateObject(int object, const glm::mat4& worldMatrix);
+	// free the GL buffers
+	void Destroy();
+
+	// draw every object of one batch with the bound program
+	void DrawBatch(int batch) const;
+
+	int GetBatchCount() const { return static_cast<int>(m_batches.size()); }
+	int GetObjectCount() const { return static_cast<int>(m_objects.size()); }
+
+private:
+	struct STATIC_OBJECT
+	{
+		int batch;
+		int primitive;
+		glm::mat4 worldMatrix;
+		// range of the object in the merged vertices
+		GLint firstVertex;
+		GLsizei vertexCount;
+	};
+
+	// range of one batch in the merged indices
+	struct STATIC_BATCH
+	{
+		GLsizei firstIndex;
+		GLsizei indexCount;
+	};
+
+	// unit primitives the objects are transformed from
+	PrimitiveMeshes::MESH_GEOMETRY m_primitives[PrimitiveMeshes::PRIMITIVE_COUNT];
+	bool m_bPrimitivesBuilt;
+
+	std::vector<STATIC_OBJECT> m_objects;
+	std::vector<STATIC_BATCH> m_batches;
+	std::vector<PrimitiveMeshes::MESH_VERTEX> m_vertices;
+
+	GLuint m_vao;
+	GLuint m_vbo;
+	GLuint m_ibo;
+
+	// write the world space vertices of one object into m_vertices
+	void TransformObject(const STATIC_OBJECT& object);
+};
@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////
+// tagregistry.cpp
+// ============
+// intern string tags as compact integer handles
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TagRegistry.h"
+
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// slots in a new table, must be a power of two
+	const size_t g_InitialSlotCount = 16;
+}
+
+/***********************************************************
+ *  TagRegistry()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TagRegistry::TagRegistry()
+{
+	Clear();
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for forgetting every registered tag.
+ ***********************************************************/
+void TagRegistry::Clear()
+{
+	SLOT empty = { 0, INVALID_HANDLE };
+
+	m_tags.clear();
+	m_slots.assign(g_InitialSlotCount, empty);
+}
+
+/***********************************************************
+ *  HashTag()
+ *
+ *  This method is used for computing the FNV-1a hash of a
+ *  tag.
+ ***********************************************************/
+uint32_t TagRegistry::HashTag(const char* tag)
+{
+	uint32_t hash = 2166136261u;
+	while (*tag != '\0')
+	{
+		hash ^= static_cast<unsigned char>(*tag++);
+		hash *= 16777619u;
+	}
+	return(hash);
+}
+
+/***********************************************************
+ *  FindSlot()
+ *
+ *  This method is used for probing the table from the home
+ *  slot of the hash until the tag or an empty slot is found.
+ *  The table is never full, so the probe always stops.
+ ***********************************************************/
+size_t TagRegistry::FindSlot(const char* tag, uint32_t hash) const
+{
+	size_t mask = m_slots.size() - 1;
+	size_t index = hash & mask;
+
+	while (m_slots[index].handle != INVALID_HANDLE)
+	{
+		const SLOT& slot = m_slots[index];
+		if ((slot.hash == hash) && (strcmp(m_tags[slot.handle].c_str(), tag) == 0))
+		{
+			break;
+		}
+		index = (index + 1) & mask;
+	}
+
+	return(index);
+}
+
+/***********************************************************
+ *  Rehash()
+ *
+ *  This method is used for growing the table and placing
+ *  every registered tag into its new slot.
+ ***********************************************************/
+void TagRegistry::Rehash(size_t slotCount)
+{
+	SLOT empty = { 0, INVALID_HANDLE };
+	std::vector<SLOT> oldSlots(slotCount, empty);
+	m_slots.swap(oldSlots);
+
+	size_t mask = slotCount - 1;
+	for (const SLOT& slot : oldSlots)
+	{
+		if (slot.handle == INVALID_HANDLE)
+		{
+			continue;
+		}
+
+		size_t index = slot.hash & mask;
+		while (m_slots[index].handle != INVALID_HANDLE)
+		{
+			index = (index + 1) & mask;
+		}
+		m_slots[index] = slot;
+	}
+}
+
+/***********************************************************
+ *  Register()
+ *
+ *  This method is used for getting the handle of a tag,
+ *  adding the tag with the next handle when it is new.
+ ***********************************************************/
+int TagRegistry::Register(const char* tag)
+{
+	uint32_t hash = HashTag(tag);
+	size_t index = FindSlot(tag, hash);
+
+	if (m_slots[index].handle != INVALID_HANDLE)
+	{
+		return(m_slots[index].handle);
+	}
+
+	int handle = static_cast<int>(m_tags.size());
+	m_tags.push_back(tag);
+	m_slots[index].hash = hash;
+	m_slots[index].handle = handle;
+
+	// keep the load factor at or below one half
+	if (m_tags.size() * 2 > m_slots.size())
+	{
+		Rehash(m_slots.size() * 2);
+	}
+
+	return(handle);
+}
+
+/***********************************************************
+ *  Find()
+ *
+ *  This method is used for getting the handle of a tag that
+ *  was registered before.
+ ***********************************************************/
+int TagRegistry::Find(const char* tag) const
+{
+	return(m_slots[FindSlot(tag, HashTag(tag))].handle);
+}
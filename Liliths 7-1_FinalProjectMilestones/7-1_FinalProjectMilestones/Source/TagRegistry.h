@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////////////
+// tagregistry.h
+// ============
+// intern string tags as compact integer handles
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TagRegistry
+ *
+ *  This class turns string tags into dense integer handles,
+ *  0 for the first tag registered, 1 for the next, and so
+ *  on, so a handle can index the array that holds whatever
+ *  the tag names.  Tags are looked up through an open
+ *  addressing hash table with linear probing, and lookups
+ *  work on the characters directly without building strings.
+ ***********************************************************/
+class TagRegistry
+{
+public:
+	// handle returned for tags that are not registered
+	static const int INVALID_HANDLE = -1;
+
+	// constructor
+	TagRegistry();
+
+	// return the handle of the tag, registering it if it is new
+	int Register(const char* tag);
+	// return the handle of the tag, or INVALID_HANDLE
+	int Find(const char* tag) const;
+	// return the tag of a handle
+	const std::string& GetTag(int handle) const { return m_tags[handle]; }
+	int GetCount() const { return static_cast<int>(m_tags.size()); }
+	// forget every tag
+	void Clear();
+
+private:
+	struct SLOT
+	{
+		uint32_t hash;
+		// handle stored in the slot, or INVALID_HANDLE when empty
+		int handle;
+	};
+
+	// tags by handle
+	std::vector<std::string> m_tags;
+	// hash table, the size is always a power of two
+	std::vector<SLOT> m_slots;
+
+	static uint32_t HashTag(const char* tag);
+	// find the slot holding the tag, or the empty slot where it goes
+	size_t FindSlot(const char* tag, uint32_t hash) const;
+	// rebuild the table with the passed in number of slots
+	void Rehash(size_t slotCount);
+};
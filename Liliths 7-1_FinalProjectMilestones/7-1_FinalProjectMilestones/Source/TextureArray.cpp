@@ -0,0 +1,135 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearray.cpp
+// ============
+// layers of same sized textures kept in one GL_TEXTURE_2D_ARRAY
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureArray.h"
+
+#include <iostream>
+#include <vector>
+
+/***********************************************************
+ *  TextureArray()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureArray::TextureArray()
+{
+	m_textureID = 0;
+	m_textureUnit = 0;
+	m_layerSize = 0;
+	m_layerCount = 0;
+	m_levelCount = 0;
+}
+
+/***********************************************************
+ *  ~TextureArray()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureArray::~TextureArray()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  CountLevels()
+ *
+ *  This method is used for counting the mip levels of a
+ *  square, halving down to 1x1 the same way the texture
+ *  cache builds its chains.
+ ***********************************************************/
+int TextureArray::CountLevels(int size)
+{
+	int levelCount = 1;
+	while (size > 1)
+	{
+		size /= 2;
+		levelCount++;
+	}
+	return(levelCount);
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for allocating every level of every
+ *  layer, filled with the placeholder color.
+ ***********************************************************/
+bool TextureArray::Create(
+	GLStateCache* pStateCache,
+	int textureUnit,
+	int layerSize,
+	int layerCount,
+	const unsigned char placeholder[4])
+{
+	GLint maxLayers = 0;
+
+	Destroy();
+
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+	if ((NULL == pStateCache) || (layerSize <= 0) ||
+		(layerCount <= 0) || (layerCount > maxLayers))
+	{
+		std::cout << "Cannot create a texture array of " << layerCount
+			<< " layers, the limit is " << maxLayers << std::endl;
+		return(false);
+	}
+
+	m_textureUnit = textureUnit;
+	m_layerSize = layerSize;
+	m_layerCount = layerCount;
+	m_levelCount = CountLevels(layerSize);
+
+	glGenTextures(1, &m_textureID);
+	pStateCache->BindTexture(m_textureUnit, GL_TEXTURE_2D_ARRAY, m_textureID);
+
+	// Wrapping stays inside each layer
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// Filtering (trilinear)
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, m_levelCount - 1);
+
+	// the first level is the largest, so its buffer fits them all
+	std::vector<unsigned char> pixels(
+		static_cast<size_t>(layerSize) * layerSize * layerCount * 4);
+	for (size_t i = 0; i < pixels.size(); i += 4)
+	{
+		pixels[i + 0] = placeholder[0];
+		pixels[i + 1] = placeholder[1];
+		pixels[i + 2] = placeholder[2];
+		pixels[i + 3] = placeholder[3];
+	}
+
+	int levelSize = layerSize;
+	for (int level = 0; level < m_levelCount; level++)
+	{
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8,
+			levelSize, levelSize, layerCount, 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		levelSize = (levelSize > 1) ? levelSize / 2 : 1;
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the array texture.
+ ***********************************************************/
+void TextureArray::Destroy()
+{
+	if (0 != m_textureID)
+	{
+		glDeleteTextures(1, &m_textureID);
+		m_textureID = 0;
+	}
+	m_layerCount = 0;
+	m_levelCount = 0;
+}
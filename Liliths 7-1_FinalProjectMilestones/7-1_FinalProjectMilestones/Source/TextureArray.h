@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearray.h
+// ============
+// layers of same sized textures kept in one GL_TEXTURE_2D_ARRAY
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLStateCache.h"
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  TextureArray
+ *
+ *  This class owns one array texture with a fixed number of
+ *  square layers and a full mip chain.  Every layer starts
+ *  out filled with a placeholder color and is replaced once
+ *  its image has been resampled to the layer size, see
+ *  TextureCache::Resample().  Draws pick their texture by
+ *  layer index, so textures never have to be switched
+ *  between them.
+ ***********************************************************/
+class TextureArray
+{
+public:
+	// constructor
+	TextureArray();
+	// destructor
+	~TextureArray();
+
+	// allocate the layers on the passed in texture unit
+	bool Create(
+		GLStateCache* pStateCache,
+		int textureUnit,
+		int layerSize,
+		int layerCount,
+		const unsigned char placeholder[4]);
+	// free the array texture
+	void Destroy();
+
+	bool IsCreated() const { return m_textureID != 0; }
+	GLuint GetTextureID() const { return m_textureID; }
+	int GetTextureUnit() const { return m_textureUnit; }
+	int GetLayerSize() const { return m_layerSize; }
+	int GetLayerCount() const { return m_layerCount; }
+	int GetLevelCount() const { return m_levelCount; }
+
+	// number of mip levels of a square of the passed in size
+	static int CountLevels(int size);
+
+private:
+	GLuint m_textureID;
+	int m_textureUnit;
+	int m_layerSize;
+	int m_layerCount;
+	int m_levelCount;
+};
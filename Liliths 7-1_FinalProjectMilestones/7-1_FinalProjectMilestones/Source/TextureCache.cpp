@@ -0,0 +1,594 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.cpp
+// ============
+// cooked texture containers with precomputed mip chains
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureCache.h"
+
+#include "stb_image.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// declaration of global variables
+namespace
+{
+	// bump when the container layout or pixel conversion changes
+	const uint32_t g_ContainerVersion = 1;
+	const char g_ContainerMagic[4] = { 'T', 'X', 'C', '1' };
+	const char* g_ContainerExtension = ".txc";
+	// level data starts on this alignment inside a container
+	const size_t g_LevelAlignment = 16;
+
+	// container layout, little endian, header then level table then levels
+	struct CONTAINER_HEADER
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		uint32_t levelCount;
+		uint32_t internalFormat;
+		uint32_t format;
+		uint32_t type;
+	};
+
+	struct CONTAINER_LEVEL
+	{
+		uint32_t width;
+		uint32_t height;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	static_assert(sizeof(CONTAINER_HEADER) == 32, "CONTAINER_HEADER layout");
+	static_assert(sizeof(CONTAINER_LEVEL) == 24, "CONTAINER_LEVEL layout");
+
+	size_t AlignLevel(size_t offset)
+	{
+		return((offset + g_LevelAlignment - 1) & ~(g_LevelAlignment - 1));
+	}
+
+	/***********************************************************
+	 *  DownsampleLevel()
+	 *
+	 *  Build the next mip level with a 2x2 box filter.  Odd
+	 *  sizes repeat the last row or column.
+	 ***********************************************************/
+	void DownsampleLevel(
+		const unsigned char* pSource, int sourceWidth, int sourceHeight,
+		unsigned char* pTarget, int targetWidth, int targetHeight)
+	{
+		for (int y = 0; y < targetHeight; y++)
+		{
+			int y0 = (2 * y < sourceHeight) ? 2 * y : sourceHeight - 1;
+			int y1 = (2 * y + 1 < sourceHeight) ? 2 * y + 1 : sourceHeight - 1;
+
+			for (int x = 0; x < targetWidth; x++)
+			{
+				int x0 = (2 * x < sourceWidth) ? 2 * x : sourceWidth - 1;
+				int x1 = (2 * x + 1 < sourceWidth) ? 2 * x + 1 : sourceWidth - 1;
+
+				const unsigned char* p00 = pSource + (y0 * sourceWidth + x0) * 4;
+				const unsigned char* p01 = pSource + (y0 * sourceWidth + x1) * 4;
+				const unsigned char* p10 = pSource + (y1 * sourceWidth + x0) * 4;
+				const unsigned char* p11 = pSource + (y1 * sourceWidth + x1) * 4;
+				unsigned char* pOut = pTarget + (y * targetWidth + x) * 4;
+
+				for (int c = 0; c < 4; c++)
+				{
+					pOut[c] = static_cast<unsigned char>(
+						(p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  CookedTexture()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CookedTexture::CookedTexture()
+{
+	m_pLevelData = NULL;
+}
+
+/***********************************************************
+ *  GetLevelDataSize()
+ *
+ *  This method is used for getting the number of bytes that
+ *  cover every level, including the alignment padding.
+ ***********************************************************/
+size_t CookedTexture::GetLevelDataSize() const
+{
+	if (m_levels.empty())
+	{
+		return(0);
+	}
+
+	return(m_levels.back().offset + m_levels.back().size);
+}
+
+/***********************************************************
+ *  Release()
+ *
+ *  This method is used for dropping the levels.
+ ***********************************************************/
+void CookedTexture::Release()
+{
+	m_levels.clear();
+	m_bytes.clear();
+	m_file.Close();
+	m_pLevelData = NULL;
+}
+
+/***********************************************************
+ *  TexImageLevels()
+ *
+ *  This method is used for defining the whole mip chain of
+ *  the bound texture, so no mipmaps are generated on the GPU.
+ ***********************************************************/
+void CookedTexture::TexImageLevels(GLenum target, const unsigned char* pLevelData) const
+{
+	glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, GetLevelCount() - 1);
+
+	for (int i = 0; i < GetLevelCount(); i++)
+	{
+		const TEXTURE_LEVEL& level = m_levels[i];
+		// with a pixel unpack buffer bound the pointer is an offset
+		const void* pPixels = (NULL != pLevelData) ?
+			static_cast<const void*>(pLevelData + level.offset) :
+			reinterpret_cast<const void*>(level.offset);
+		glTexImage2D(target, i, GL_RGBA8, level.width, level.height, 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, pPixels);
+	}
+}
+
+/***********************************************************
+ *  TexSubImageLayer()
+ *
+ *  This method is used for replacing every level of one
+ *  layer of an array texture.
+ ***********************************************************/
+void CookedTexture::TexSubImageLayer(GLenum target, int layer, const unsigned char* pLevelData) const
+{
+	for (int i = 0; i < GetLevelCount(); i++)
+	{
+		const TEXTURE_LEVEL& level = m_levels[i];
+		// with a pixel unpack buffer bound the pointer is an offset
+		const void* pPixels = (NULL != pLevelData) ?
+			static_cast<const void*>(pLevelData + level.offset) :
+			reinterpret_cast<const void*>(level.offset);
+		glTexSubImage3D(target, i, 0, 0, layer, level.width, level.height, 1,
+			GL_RGBA, GL_UNSIGNED_BYTE, pPixels);
+	}
+}
+
+/***********************************************************
+ *  Parse()
+ *
+ *  This method is used for validating a container and
+ *  reading its level table.
+ ***********************************************************/
+bool CookedTexture::Parse(const unsigned char* pData, size_t size, uint64_t sourceHash)
+{
+	m_levels.clear();
+	m_pLevelData = NULL;
+
+	if ((NULL == pData) || (size < sizeof(CONTAINER_HEADER)))
+	{
+		return(false);
+	}
+
+	CONTAINER_HEADER header;
+	memcpy(&header, pData, sizeof(header));
+	if ((memcmp(header.magic, g_ContainerMagic, sizeof(header.magic)) != 0) ||
+		(header.version != g_ContainerVersion) ||
+		(header.sourceHash != sourceHash) ||
+		(header.levelCount == 0) ||
+		(header.internalFormat != GL_RGBA8) ||
+		(size < sizeof(header) + header.levelCount * sizeof(CONTAINER_LEVEL)))
+	{
+		return(false);
+	}
+
+	const unsigned char* pTable = pData + sizeof(header);
+	size_t firstOffset = 0;
+
+	for (uint32_t i = 0; i < header.levelCount; i++)
+	{
+		CONTAINER_LEVEL level;
+		memcpy(&level, pTable + i * sizeof(level), sizeof(level));
+
+		if ((level.offset > size) || (level.size > size - level.offset) ||
+			(level.size != static_cast<uint64_t>(level.width) * level.height * 4))
+		{
+			m_levels.clear();
+			return(false);
+		}
+
+		if (0 == i)
+		{
+			firstOffset = static_cast<size_t>(level.offset);
+		}
+		else if (level.offset < firstOffset)
+		{
+			m_levels.clear();
+			return(false);
+		}
+
+		TEXTURE_LEVEL textureLevel;
+		textureLevel.width = static_cast<int>(level.width);
+		textureLevel.height = static_cast<int>(level.height);
+		textureLevel.offset = static_cast<size_t>(level.offset) - firstOffset;
+		textureLevel.size = static_cast<size_t>(level.size);
+		m_levels.push_back(textureLevel);
+	}
+
+	m_pLevelData = pData + firstOffset;
+	return(true);
+}
+
+/***********************************************************
+ *  TextureCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureCache::TextureCache()
+{
+}
+
+/***********************************************************
+ *  HashSource()
+ *
+ *  This method is used for computing the FNV-1a hash of the
+ *  source file bytes, seeded with the container version so a
+ *  layout change also invalidates every container.
+ ***********************************************************/
+uint64_t TextureCache::HashSource(const unsigned char* pData, size_t size)
+{
+	uint64_t hash = 14695981039346656037ull ^ g_ContainerVersion;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= pData[i];
+		hash *= 1099511628211ull;
+	}
+	return(hash);
+}
+
+/***********************************************************
+ *  GetContainerPath()
+ *
+ *  This method is used for naming the container of a source
+ *  file, <file name>-<source hash>.txc in the cache folder.
+ ***********************************************************/
+std::string TextureCache::GetContainerPath(const char* sourceFile, uint64_t sourceHash) const
+{
+	char hashText[17];
+	snprintf(hashText, sizeof(hashText), "%016llx",
+		static_cast<unsigned long long>(sourceHash));
+
+	std::string name = std::filesystem::path(sourceFile).filename().string();
+	return(m_cacheFolder + name + "-" + hashText + g_ContainerExtension);
+}
+
+/***********************************************************
+ *  BuildContainer()
+ *
+ *  This method is used for decoding an image and laying out
+ *  the full mip chain the way it will be uploaded.
+ ***********************************************************/
+bool TextureCache::BuildContainer(
+	const unsigned char* pSource,
+	size_t sourceSize,
+	uint64_t sourceHash,
+	std::vector<unsigned char>& container)
+{
+	int width = 0, height = 0, colorChannels = 0;
+
+	// Force-convert to RGBA to avoid CMYK/odd formats
+	unsigned char* image = stbi_load_from_memory(pSource, static_cast<int>(sourceSize),
+		&width, &height, &colorChannels, STBI_rgb_alpha);
+	if (NULL == image)
+	{
+		return(false);
+	}
+
+	BuildContainerFromPixels(image, width, height, sourceHash, container);
+	stbi_image_free(image);
+
+	return(true);
+}
+
+/***********************************************************
+ *  BuildContainerFromPixels()
+ *
+ *  This method is used for laying out the full mip chain of
+ *  an RGBA8 image the way it will be uploaded.
+ ***********************************************************/
+void TextureCache::BuildContainerFromPixels(
+	const unsigned char* pPixels,
+	int width,
+	int height,
+	uint64_t sourceHash,
+	std::vector<unsigned char>& container)
+{
+	// every level down to 1x1
+	std::vector<CONTAINER_LEVEL> levels;
+	int levelWidth = width;
+	int levelHeight = height;
+	for (;;)
+	{
+		CONTAINER_LEVEL level;
+		level.width = static_cast<uint32_t>(levelWidth);
+		level.height = static_cast<uint32_t>(levelHeight);
+		level.offset = 0;
+		level.size = static_cast<uint64_t>(levelWidth) * levelHeight * 4;
+		levels.push_back(level);
+
+		if ((1 == levelWidth) && (1 == levelHeight))
+		{
+			break;
+		}
+		levelWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+		levelHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
+	}
+
+	size_t offset = AlignLevel(sizeof(CONTAINER_HEADER) + levels.size() * sizeof(CONTAINER_LEVEL));
+	for (CONTAINER_LEVEL& level : levels)
+	{
+		level.offset = offset;
+		offset = AlignLevel(offset + static_cast<size_t>(level.size));
+	}
+
+	container.assign(static_cast<size_t>(levels.back().offset + levels.back().size), 0);
+
+	CONTAINER_HEADER header;
+	memcpy(header.magic, g_ContainerMagic, sizeof(header.magic));
+	header.version = g_ContainerVersion;
+	header.sourceHash = sourceHash;
+	header.levelCount = static_cast<uint32_t>(levels.size());
+	header.internalFormat = GL_RGBA8;
+	header.format = GL_RGBA;
+	header.type = GL_UNSIGNED_BYTE;
+	memcpy(&container[0], &header, sizeof(header));
+	memcpy(&container[sizeof(header)], levels.data(), levels.size() * sizeof(CONTAINER_LEVEL));
+
+	memcpy(&container[static_cast<size_t>(levels[0].offset)], pPixels,
+		static_cast<size_t>(levels[0].size));
+
+	for (size_t i = 1; i < levels.size(); i++)
+	{
+		DownsampleLevel(
+			&container[static_cast<size_t>(levels[i - 1].offset)],
+			levels[i - 1].width, levels[i - 1].height,
+			&container[static_cast<size_t>(levels[i].offset)],
+			levels[i].width, levels[i].height);
+	}
+}
+
+/***********************************************************
+ *  Resample()
+ *
+ *  This method is used for scaling a cooked texture to a
+ *  square layer.  The smallest cooked level that still
+ *  covers the square is filtered bilinearly, so no level is
+ *  shrunk by more than half, and the mip chain of the
+ *  square is then built with the box filter.
+ ***********************************************************/
+bool TextureCache::Resample(const CookedTexture& source, int size, CookedTexture& target)
+{
+	target.Release();
+
+	if (!source.IsValid() || (size <= 0))
+	{
+		return(false);
+	}
+
+	int sourceLevel = 0;
+	for (int i = 1; i < source.GetLevelCount(); i++)
+	{
+		const CookedTexture::TEXTURE_LEVEL& level = source.GetLevel(i);
+		if ((level.width < size) || (level.height < size))
+		{
+			break;
+		}
+		sourceLevel = i;
+	}
+
+	const CookedTexture::TEXTURE_LEVEL& level = source.GetLevel(sourceLevel);
+	const unsigned char* pSource = source.GetLevelData() + level.offset;
+	std::vector<unsigned char> pixels(static_cast<size_t>(size) * size * 4);
+
+	// sample at texel centers, clamped at the edges
+	float scaleX = static_cast<float>(level.width) / size;
+	float scaleY = static_cast<float>(level.height) / size;
+	for (int y = 0; y < size; y++)
+	{
+		float sourceY = (y + 0.5f) * scaleY - 0.5f;
+		if (sourceY < 0.0f)
+		{
+			sourceY = 0.0f;
+		}
+		int y0 = static_cast<int>(sourceY);
+		int y1 = (y0 + 1 < level.height) ? y0 + 1 : y0;
+		float fy = sourceY - y0;
+
+		for (int x = 0; x < size; x++)
+		{
+			float sourceX = (x + 0.5f) * scaleX - 0.5f;
+			if (sourceX < 0.0f)
+			{
+				sourceX = 0.0f;
+			}
+			int x0 = static_cast<int>(sourceX);
+			int x1 = (x0 + 1 < level.width) ? x0 + 1 : x0;
+			float fx = sourceX - x0;
+
+			const unsigned char* p00 = pSource + (y0 * level.width + x0) * 4;
+			const unsigned char* p01 = pSource + (y0 * level.width + x1) * 4;
+			const unsigned char* p10 = pSource + (y1 * level.width + x0) * 4;
+			const unsigned char* p11 = pSource + (y1 * level.width + x1) * 4;
+			unsigned char* pOut = &pixels[(static_cast<size_t>(y) * size + x) * 4];
+
+			for (int c = 0; c < 4; c++)
+			{
+				float top = p00[c] + (p01[c] - p00[c]) * fx;
+				float bottom = p10[c] + (p11[c] - p10[c]) * fx;
+				pOut[c] = static_cast<unsigned char>(top + (bottom - top) * fy + 0.5f);
+			}
+		}
+	}
+
+	BuildContainerFromPixels(pixels.data(), size, size, 0, target.m_bytes);
+	return(target.Parse(target.m_bytes.data(), target.m_bytes.size(), 0));
+}
+
+/***********************************************************
+ *  WriteContainer()
+ *
+ *  This method is used for saving a container to the cache
+ *  folder.  It is written under a temporary name and renamed
+ *  so a reader never maps a half written file.  Containers
+ *  of earlier versions of the same source are removed.
+ ***********************************************************/
+bool TextureCache::WriteContainer(
+	const char* sourceFile,
+	uint64_t sourceHash,
+	const std::vector<unsigned char>& container) const
+{
+	namespace fs = std::filesystem;
+	std::error_code error;
+
+	fs::create_directories(m_cacheFolder, error);
+
+	std::string path = GetContainerPath(sourceFile, sourceHash);
+	std::string temporaryPath = path + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			return(false);
+		}
+		file.write(reinterpret_cast<const char*>(container.data()),
+			static_cast<std::streamsize>(container.size()));
+		if (!file)
+		{
+			file.close();
+			fs::remove(temporaryPath, error);
+			return(false);
+		}
+	}
+
+	fs::rename(temporaryPath, path, error);
+	if (error)
+	{
+		fs::remove(temporaryPath, error);
+		return(false);
+	}
+
+	// containers of this source with other hashes are stale now
+	std::string prefix = fs::path(sourceFile).filename().string() + "-";
+	std::string current = fs::path(path).filename().string();
+	for (const fs::directory_entry& entry : fs::directory_iterator(m_cacheFolder, error))
+	{
+		std::string name = entry.path().filename().string();
+		if ((name != current) &&
+			(name.compare(0, prefix.size(), prefix) == 0) &&
+			(entry.path().extension() == g_ContainerExtension) &&
+			(name.size() == current.size()))
+		{
+			std::error_code removeError;
+			fs::remove(entry.path(), removeError);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for getting the cooked levels of an
+ *  image file.  A current container is mapped as it is;
+ *  otherwise the image is cooked, saved for the next run,
+ *  and served from memory.  Only a failed decode has a
+ *  reason from stb_image.
+ ***********************************************************/
+bool TextureCache::Load(const char* sourceFile, CookedTexture& texture, const char** ppFailureReason)
+{
+	const char* failureReason = NULL;
+	if (NULL == ppFailureReason)
+	{
+		ppFailureReason = &failureReason;
+	}
+	texture.Release();
+
+	MappedFile source;
+	if (!source.Open(sourceFile))
+	{
+		*ppFailureReason = "file could not be opened";
+		return(false);
+	}
+	uint64_t sourceHash = HashSource(source.GetData(), source.GetSize());
+
+	if (!m_cacheFolder.empty())
+	{
+		std::string path = GetContainerPath(sourceFile, sourceHash);
+		if (texture.m_file.Open(path.c_str()) &&
+			texture.Parse(texture.m_file.GetData(), texture.m_file.GetSize(), sourceHash))
+		{
+			return(true);
+		}
+		texture.m_file.Close();
+	}
+
+	if (!BuildContainer(source.GetData(), source.GetSize(), sourceHash, texture.m_bytes))
+	{
+		*ppFailureReason = stbi_failure_reason();
+		return(false);
+	}
+
+	if (!m_cacheFolder.empty())
+	{
+		WriteContainer(sourceFile, sourceHash, texture.m_bytes);
+	}
+
+	if (!texture.Parse(texture.m_bytes.data(), texture.m_bytes.size(), sourceHash))
+	{
+		*ppFailureReason = "cooked container is not valid";
+		return(false);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  Cook()
+ *
+ *  This method is used for cooking an image file into the
+ *  cache folder whether or not it already has a container.
+ ***********************************************************/
+bool TextureCache::Cook(const char* sourceFile)
+{
+	MappedFile source;
+	std::vector<unsigned char> container;
+
+	if (m_cacheFolder.empty() || !source.Open(sourceFile))
+	{
+		return(false);
+	}
+
+	uint64_t sourceHash = HashSource(source.GetData(), source.GetSize());
+	if (!BuildContainer(source.GetData(), source.GetSize(), sourceHash, container))
+	{
+		return(false);
+	}
+
+	return(WriteContainer(sourceFile, sourceHash, container));
+}
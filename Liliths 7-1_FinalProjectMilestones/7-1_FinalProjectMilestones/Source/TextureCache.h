@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.h
+// ============
+// cooked texture containers with precomputed mip chains
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  CookedTexture
+ *
+ *  This class holds one cooked texture: every mip level as
+ *  tightly packed RGBA8 rows, bottom row first, ready to be
+ *  passed to glTexImage2D.  The levels point into either a
+ *  mapped cache file or the bytes that were just cooked.
+ ***********************************************************/
+class CookedTexture
+{
+public:
+	// constructor
+	CookedTexture();
+
+	struct TEXTURE_LEVEL
+	{
+		int width;
+		int height;
+		// offset of the level from GetLevelData()
+		size_t offset;
+		size_t size;
+	};
+
+	bool IsValid() const { return !m_levels.empty(); }
+	int GetLevelCount() const { return static_cast<int>(m_levels.size()); }
+	const TEXTURE_LEVEL& GetLevel(int level) const { return m_levels[level]; }
+	// start of the first level, the levels follow in order
+	const unsigned char* GetLevelData() const { return m_pLevelData; }
+	// bytes from the start of the first level to the end of the last
+	size_t GetLevelDataSize() const;
+	// true when the levels come from a mapped cache file
+	bool IsMapped() const { return m_file.IsOpen(); }
+	// define every level of the texture bound to the target, reading
+	// from pLevelData, which is NULL when the levels were copied to
+	// the start of the bound pixel unpack buffer
+	void TexImageLevels(GLenum target, const unsigned char* pLevelData) const;
+	// replace one layer of the array texture bound to the target, the
+	// array must have the same size and number of levels
+	void TexSubImageLayer(GLenum target, int layer, const unsigned char* pLevelData) const;
+	// drop the levels and release the mapping or bytes
+	void Release();
+
+private:
+	friend class TextureCache;
+
+	MappedFile m_file;
+	std::vector<unsigned char> m_bytes;
+	std::vector<TEXTURE_LEVEL> m_levels;
+	const unsigned char* m_pLevelData;
+
+	// read the level table of a container, false if it is not a
+	// valid container cooked from a source with the passed in hash
+	bool Parse(const unsigned char* pData, size_t size, uint64_t sourceHash);
+};
+
+/***********************************************************
+ *  TextureCache
+ *
+ *  This class converts image files into cooked containers
+ *  and stores them in a cache folder.  A container is named
+ *  after the hash of the source file bytes, so an edited
+ *  image no longer matches its old container and is cooked
+ *  again on the next load.  Loading a container is a file
+ *  mapping with no decoding and no mipmap generation.
+ *
+ *  Load() may be called from several threads at once for
+ *  different files.  The cache folder must be set before.
+ ***********************************************************/
+class TextureCache
+{
+public:
+	// constructor
+	TextureCache();
+
+	// folder the containers are kept in, empty to cook in memory only
+	void SetCacheFolder(const std::string& folder) { m_cacheFolder = folder; }
+	const std::string& GetCacheFolder() const { return m_cacheFolder; }
+
+	// get the cooked levels of an image file, cooking it when the
+	// cache has no container for the current file contents; on
+	// failure the reason is passed back when asked for
+	bool Load(const char* sourceFile, CookedTexture& texture, const char** ppFailureReason = NULL);
+	// cook an image file into the cache even if it is current
+	bool Cook(const char* sourceFile);
+
+	// hash of the source bytes and the container layout version
+	static uint64_t HashSource(const unsigned char* pData, size_t size);
+	// scale a cooked texture to a square of the passed in size with
+	// a full mip chain, kept in memory
+	static bool Resample(const CookedTexture& source, int size, CookedTexture& target);
+
+private:
+	std::string m_cacheFolder;
+
+	// path of the container for a source file with the passed in hash
+	std::string GetContainerPath(const char* sourceFile, uint64_t sourceHash) const;
+	// decode an image and build the container bytes in memory
+	static bool BuildContainer(
+		const unsigned char* pSource,
+		size_t sourceSize,
+		uint64_t sourceHash,
+		std::vector<unsigned char>& container);
+	// lay out a container for RGBA8 pixels and build its mip chain
+	static void BuildContainerFromPixels(
+		const unsigned char* pPixels,
+		int width,
+		int height,
+		uint64_t sourceHash,
+		std::vector<unsigned char>& container);
+	// write a container and remove the ones of older source versions
+	bool WriteContainer(
+		const char* sourceFile,
+		uint64_t sourceHash,
+		const std::vector<unsigned char>& container) const;
+};
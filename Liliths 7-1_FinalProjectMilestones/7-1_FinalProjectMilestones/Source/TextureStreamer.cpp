@@ -0,0 +1,347 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturestreamer.cpp
+// ============
+// load texture images on worker threads and upload them per frame
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureStreamer.h"
+#include "Profiler.h"
+
+#include "stb_image.h"
+
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// default bytes uploaded per frame
+	const size_t g_DefaultUploadBudget = 16 * 1024 * 1024;
+}
+
+/***********************************************************
+ *  TextureStreamer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureStreamer::TextureStreamer()
+{
+	m_pTextureCache = NULL;
+	m_bStopping = false;
+	m_pendingCount = 0;
+	m_requestedCount = 0;
+	m_nextPixelBuffer = 0;
+	m_uploadBudget = g_DefaultUploadBudget;
+	for (int i = 0; i < PIXEL_BUFFER_COUNT; i++)
+	{
+		m_pixelBuffers[i] = 0;
+	}
+}
+
+/***********************************************************
+ *  ~TextureStreamer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureStreamer::~TextureStreamer()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting the loading threads.
+ ***********************************************************/
+void TextureStreamer::Start(int workerCount)
+{
+	if (!m_workers.empty())
+	{
+		return;
+	}
+
+	if (workerCount <= 0)
+	{
+		workerCount = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+		if (workerCount < 1)
+		{
+			workerCount = 1;
+		}
+	}
+
+	// stb_image keeps the flip setting in a global, so it is set
+	// here once, before any worker cooks an image
+	stbi_set_flip_vertically_on_load(true);
+
+	m_bStopping = false;
+	for (int i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&TextureStreamer::WorkerLoop, this));
+	}
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for stopping the loading threads
+ *  and freeing the images that were not uploaded.
+ ***********************************************************/
+void TextureStreamer::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+		m_jobs.clear();
+	}
+	m_jobReady.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+
+	m_decoded.clear();
+	m_pendingCount = 0;
+
+	if (0 != m_pixelBuffers[0])
+	{
+		glDeleteBuffers(PIXEL_BUFFER_COUNT, m_pixelBuffers);
+		for (int i = 0; i < PIXEL_BUFFER_COUNT; i++)
+		{
+			m_pixelBuffers[i] = 0;
+		}
+	}
+}
+
+/***********************************************************
+ *  Request()
+ *
+ *  This method is used for queuing an image file to be
+ *  loaded into the passed in texture object.
+ ***********************************************************/
+void TextureStreamer::Request(const char* filename, GLuint textureID, int textureUnit)
+{
+	DECODE_JOB job;
+	job.filename = filename;
+	job.textureID = textureID;
+	job.textureUnit = textureUnit;
+	job.layer = -1;
+	job.layerSize = 0;
+
+	QueueJob(job);
+}
+
+/***********************************************************
+ *  RequestLayer()
+ *
+ *  This method is used for queuing an image file to be
+ *  loaded, scaled to the layer size and copied into one
+ *  layer of an array texture.
+ ***********************************************************/
+void TextureStreamer::RequestLayer(
+	const char* filename,
+	GLuint arrayTextureID,
+	int textureUnit,
+	int layer,
+	int layerSize)
+{
+	DECODE_JOB job;
+	job.filename = filename;
+	job.textureID = arrayTextureID;
+	job.textureUnit = textureUnit;
+	job.layer = layer;
+	job.layerSize = layerSize;
+
+	QueueJob(job);
+}
+
+/***********************************************************
+ *  QueueJob()
+ *
+ *  This method is used for handing a job to the workers,
+ *  starting them on the first request.
+ ***********************************************************/
+void TextureStreamer::QueueJob(const DECODE_JOB& job)
+{
+	if (m_workers.empty())
+	{
+		Start();
+	}
+
+	if (0 == m_pendingCount)
+	{
+		m_startTime = std::chrono::steady_clock::now();
+		m_requestedCount = 0;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(job);
+	}
+	m_jobReady.notify_one();
+
+	m_pendingCount++;
+	m_requestedCount++;
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used for loading queued image files until
+ *  the streamer is stopped.  Images with a current cache
+ *  container are only mapped, the others are cooked.
+ ***********************************************************/
+void TextureStreamer::WorkerLoop()
+{
+	// without a shared cache the images are cooked in memory only
+	TextureCache memoryCache;
+	TextureCache* pTextureCache =
+		(NULL != m_pTextureCache) ? m_pTextureCache : &memoryCache;
+
+	for (;;)
+	{
+		DECODE_JOB job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobReady.wait(lock, [this] { return m_bStopping || !m_jobs.empty(); });
+			if (m_bStopping)
+			{
+				return;
+			}
+			job = m_jobs.front();
+			m_jobs.pop_front();
+		}
+
+		DECODED_IMAGE image;
+		image.job = job;
+		image.failureReason = NULL;
+		{
+			ScopedCpuTimer timer("DecodeTexture");
+			pTextureCache->Load(job.filename.c_str(), image.texture, &image.failureReason);
+
+			// array layers all share one size
+			if ((job.layer >= 0) && image.texture.IsValid())
+			{
+				CookedTexture layerTexture;
+				TextureCache::Resample(image.texture, job.layerSize, layerTexture);
+				image.texture = std::move(layerTexture);
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_bStopping)
+		{
+			return;
+		}
+		m_decoded.push_back(std::move(image));
+	}
+}
+
+/***********************************************************
+ *  PumpUploads()
+ *
+ *  This method is used for copying loaded images into their
+ *  textures.  It is called once per frame on the thread that
+ *  owns the OpenGL context.
+ ***********************************************************/
+int TextureStreamer::PumpUploads(GLStateCache* pStateCache)
+{
+	if ((0 == m_pendingCount) || (NULL == pStateCache))
+	{
+		return(0);
+	}
+
+	int uploaded = 0;
+	size_t uploadedBytes = 0;
+
+	while ((0 == uploaded) || (uploadedBytes < m_uploadBudget))
+	{
+		DECODED_IMAGE image;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_decoded.empty())
+			{
+				break;
+			}
+			image = std::move(m_decoded.front());
+			m_decoded.pop_front();
+		}
+
+		if (!image.texture.IsValid())
+		{
+			std::cout << "Could not load image:" << image.job.filename
+				<< "  reason: " << ((NULL != image.failureReason) ? image.failureReason : "unknown")
+				<< ", keeping the placeholder" << std::endl;
+		}
+		else
+		{
+			Upload(pStateCache, image);
+			uploadedBytes += image.texture.GetLevelDataSize();
+			uploaded++;
+		}
+		m_pendingCount--;
+	}
+
+	if ((0 == m_pendingCount) && (m_requestedCount > 0))
+	{
+		double elapsed = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - m_startTime).count();
+		std::cout << "All " << m_requestedCount << " streamed textures resident after "
+			<< elapsed << " ms" << std::endl;
+		m_requestedCount = 0;
+	}
+
+	return(uploaded);
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for copying the mip chain of one
+ *  image into a staging buffer and from there into its
+ *  texture.  The staging buffers are used in turn and
+ *  orphaned before each copy so the driver never has to wait
+ *  on an earlier transfer.
+ ***********************************************************/
+void TextureStreamer::Upload(GLStateCache* pStateCache, const DECODED_IMAGE& image)
+{
+	GLsizeiptr size = static_cast<GLsizeiptr>(image.texture.GetLevelDataSize());
+
+	if (0 == m_pixelBuffers[0])
+	{
+		glGenBuffers(PIXEL_BUFFER_COUNT, m_pixelBuffers);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffers[m_nextPixelBuffer]);
+	m_nextPixelBuffer = (m_nextPixelBuffer + 1) % PIXEL_BUFFER_COUNT;
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+
+	void* pStaging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (NULL != pStaging)
+	{
+		memcpy(pStaging, image.texture.GetLevelData(), static_cast<size_t>(size));
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
+	else
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	// the levels are read from the bound staging buffer, or from
+	// the cooked texture itself if the buffer could not be mapped
+	const unsigned char* pLevelData = (NULL != pStaging) ? NULL : image.texture.GetLevelData();
+	if (image.job.layer >= 0)
+	{
+		pStateCache->BindTexture(image.job.textureUnit, GL_TEXTURE_2D_ARRAY, image.job.textureID);
+		image.texture.TexSubImageLayer(GL_TEXTURE_2D_ARRAY, image.job.layer, pLevelData);
+	}
+	else
+	{
+		pStateCache->BindTexture(image.job.textureUnit, GL_TEXTURE_2D, image.job.textureID);
+		image.texture.TexImageLevels(GL_TEXTURE_2D, pLevelData);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturestreamer.h
+// ============
+// load texture images on worker threads and upload them per frame
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLStateCache.h"
+#include "TextureCache.h"
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  TextureStreamer
+ *
+ *  This class loads image files through the texture cache
+ *  on a pool of worker threads while the main thread carries
+ *  on with the rest of the setup.  The cooked mip chains are
+ *  handed back to the main thread, which copies them into
+ *  the texture objects through pixel buffer objects a few
+ *  at a time per frame.  Until then each texture keeps
+ *  whatever placeholder the caller filled it with.
+ ***********************************************************/
+class TextureStreamer
+{
+public:
+	// constructor
+	TextureStreamer();
+	// destructor
+	~TextureStreamer();
+
+	// cache the images are loaded through, set before streaming starts
+	void SetTextureCache(TextureCache* pTextureCache) { m_pTextureCache = pTextureCache; }
+
+	// start the loading threads, 0 picks one per spare core
+	void Start(int workerCount = 0);
+	// stop the threads and free the images not uploaded yet
+	void Stop();
+
+	// queue an image file to be loaded into the passed in texture
+	void Request(const char* filename, GLuint textureID, int textureUnit);
+	// queue an image file to be resampled into a layer of an array texture
+	void RequestLayer(
+		const char* filename,
+		GLuint arrayTextureID,
+		int textureUnit,
+		int layer,
+		int layerSize);
+
+	// upload the decoded images that fit in the frame budget,
+	// returns the number of textures made resident
+	int PumpUploads(GLStateCache* pStateCache);
+
+	// most bytes uploaded by one pump, at least one image is always sent
+	void SetUploadBudget(size_t bytes) { m_uploadBudget = bytes; }
+	// textures requested but not resident yet
+	int GetPendingCount() const { return m_pendingCount; }
+
+private:
+	struct DECODE_JOB
+	{
+		std::string filename;
+		GLuint textureID;
+		int textureUnit;
+		// array layer and its size, or -1 and 0 for a 2D texture
+		int layer;
+		int layerSize;
+	};
+
+	struct DECODED_IMAGE
+	{
+		DECODE_JOB job;
+		// every mip level, not valid when loading failed
+		CookedTexture texture;
+		// why loading failed, from the texture cache
+		const char* failureReason;
+	};
+
+	// number of staging buffers used in turn
+	static const int PIXEL_BUFFER_COUNT = 2;
+
+	TextureCache* m_pTextureCache;
+	std::vector<std::thread> m_workers;
+	std::deque<DECODE_JOB> m_jobs;
+	std::deque<DECODED_IMAGE> m_decoded;
+	std::mutex m_mutex;
+	std::condition_variable m_jobReady;
+	bool m_bStopping;
+
+	// only touched by the main thread
+	int m_pendingCount;
+	int m_requestedCount;
+	std::chrono::steady_clock::time_point m_startTime;
+	GLuint m_pixelBuffers[PIXEL_BUFFER_COUNT];
+	int m_nextPixelBuffer;
+	size_t m_uploadBudget;
+
+	// queue a job for the workers
+	void QueueJob(const DECODE_JOB& job);
+	// load jobs until the streamer stops
+	void WorkerLoop();
+	// copy the mip chain of one image into its texture
+	void Upload(GLStateCache* pStateCache, const DECODED_IMAGE& image);
+};
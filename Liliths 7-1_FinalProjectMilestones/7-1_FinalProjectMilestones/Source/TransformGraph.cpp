@@ -0,0 +1,327 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformgraph.cpp
+// ============
+// hierarchy of local transforms with cached world matrices
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformGraph.h"
+#include "JobSystem.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+
+// declaration of global variables
+namespace
+{
+	// nodes behind the first dirty one before an update is shared out
+	const int g_MinParallelNodes = 4096;
+	// nodes of one depth per job
+	const int g_NodesPerJob = 512;
+}
+
+/***********************************************************
+ *  TransformGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TransformGraph::TransformGraph()
+{
+	m_firstDirty = -1;
+	m_lastUpdateCount = 0;
+	m_bDepthNodesDirty = true;
+}
+
+/***********************************************************
+ *  ComposeMatrix()
+ *
+ *  This method is used for building the matrix
+ *  translation * rotationX * rotationY * rotationZ * scale
+ *  without multiplying five full 4x4 matrices together.
+ ***********************************************************/
+glm::mat4 TransformGraph::ComposeMatrix(
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	glm::mat4 matrix(1.0f);
+
+	// only build the rotation when there is one, most nodes have none
+	if ((rotationDegrees.x != 0.0f) ||
+		(rotationDegrees.y != 0.0f) ||
+		(rotationDegrees.z != 0.0f))
+	{
+		matrix =
+			glm::rotate(glm::radians(rotationDegrees.x), glm::vec3(1.0f, 0.0f, 0.0f)) *
+			glm::rotate(glm::radians(rotationDegrees.y), glm::vec3(0.0f, 1.0f, 0.0f)) *
+			glm::rotate(glm::radians(rotationDegrees.z), glm::vec3(0.0f, 0.0f, 1.0f));
+	}
+
+	// scaling on the right only scales the basis columns
+	matrix[0] = matrix[0] * scaleXYZ.x;
+	matrix[1] = matrix[1] * scaleXYZ.y;
+	matrix[2] = matrix[2] * scaleXYZ.z;
+	// translation on the left only replaces the last column
+	matrix[3] = glm::vec4(positionXYZ, 1.0f);
+
+	return(matrix);
+}
+
+/***********************************************************
+ *  AddNode()
+ *
+ *  This method is used for appending a node to the graph.
+ *  The new node starts dirty so the next update computes
+ *  its world matrix.
+ ***********************************************************/
+int TransformGraph::AddNode(
+	int parent,
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	TRANSFORM_NODE node;
+	int index = static_cast<int>(m_nodes.size());
+
+	// keeping parents first lets one forward pass update the graph
+	if (parent >= index)
+	{
+		parent = -1;
+	}
+
+	node.parent = parent;
+	node.scale = scaleXYZ;
+	node.rotationDegrees = rotationDegrees;
+	node.position = positionXYZ;
+	node.worldMatrix = glm::mat4(1.0f);
+	node.dirty = false;
+
+	m_nodes.push_back(node);
+	m_updated.push_back(0);
+	m_depths.push_back((parent >= 0) ? m_depths[parent] + 1 : 0);
+	m_bDepthNodesDirty = true;
+	MarkDirty(index);
+
+	return(index);
+}
+
+/***********************************************************
+ *  AddAnchor()
+ *
+ *  This method is used for appending a placement node with
+ *  unit scale and no rotation.  Children of an anchor are
+ *  positioned relative to it without inheriting any scale.
+ ***********************************************************/
+int TransformGraph::AddAnchor(int parent, glm::vec3 positionXYZ)
+{
+	return(AddNode(
+		parent,
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		glm::vec3(0.0f, 0.0f, 0.0f),
+		positionXYZ));
+}
+
+/***********************************************************
+ *  SetLocalTransform()
+ *
+ *  This method is used for replacing the local values of a
+ *  node.  Its subtree is recomputed on the next update.
+ ***********************************************************/
+void TransformGraph::SetLocalTransform(
+	int node,
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	m_nodes[node].scale = scaleXYZ;
+	m_nodes[node].rotationDegrees = rotationDegrees;
+	m_nodes[node].position = positionXYZ;
+	MarkDirty(node);
+}
+
+/***********************************************************
+ *  SetLocalPosition()
+ *
+ *  This method is used for moving a node relative to its
+ *  parent.
+ ***********************************************************/
+void TransformGraph::SetLocalPosition(int node, glm::vec3 positionXYZ)
+{
+	m_nodes[node].position = positionXYZ;
+	MarkDirty(node);
+}
+
+/***********************************************************
+ *  MarkDirty()
+ *
+ *  This method is used for flagging a node so that it and
+ *  all of its descendants get new world matrices.
+ ***********************************************************/
+void TransformGraph::MarkDirty(int node)
+{
+	m_nodes[node].dirty = true;
+	if ((m_firstDirty < 0) || (node < m_firstDirty))
+	{
+		m_firstDirty = node;
+	}
+}
+
+/***********************************************************
+ *  UpdateWorldMatrices()
+ *
+ *  This method is used for recomputing the world matrices of
+ *  the dirty nodes and their descendants.  Because parents
+ *  are stored before children, a single forward pass starting
+ *  at the first dirty node is enough.  When nothing is dirty
+ *  no matrix math is done at all.
+ *
+ *  Spread over jobs, the nodes of each depth are updated in
+ *  parallel before moving to the next depth, and the result
+ *  is the same as the forward pass.
+ ***********************************************************/
+int TransformGraph::UpdateWorldMatrices(JobSystem* pJobs)
+{
+	m_lastUpdateCount = 0;
+	m_lastUpdated.clear();
+
+	if (m_firstDirty < 0)
+	{
+		return(0);
+	}
+
+	int nodeCount = static_cast<int>(m_nodes.size());
+	if ((NULL != pJobs) && (pJobs->GetThreadCount() > 1) &&
+		(nodeCount - m_firstDirty >= g_MinParallelNodes))
+	{
+		BuildDepthNodes();
+		for (const std::vector<int>& depthNodes : m_depthNodes)
+		{
+			// only nodes from the first dirty one on can change
+			std::vector<int>::const_iterator firstNode =
+				std::lower_bound(depthNodes.begin(), depthNodes.end(), m_firstDirty);
+			const int* pNodes = depthNodes.data() + (firstNode - depthNodes.begin());
+			int count = static_cast<int>(depthNodes.end() - firstNode);
+			pJobs->ParallelFor(count, g_NodesPerJob, [this, pNodes](int range, int first, int rangeCount)
+			{
+				for (int i = first; i < first + rangeCount; i++)
+				{
+					UpdateNode(pNodes[i]);
+				}
+			});
+		}
+	}
+	else
+	{
+		for (int index = m_firstDirty; index < nodeCount; index++)
+		{
+			UpdateNode(index);
+		}
+	}
+
+	// list the updated nodes and reset the scratch flags for
+	// the range that was visited
+	for (int index = m_firstDirty; index < nodeCount; index++)
+	{
+		if (m_updated[index])
+		{
+			m_lastUpdated.push_back(index);
+			m_lastUpdateCount++;
+			m_updated[index] = 0;
+		}
+	}
+	m_firstDirty = -1;
+
+	return(m_lastUpdateCount);
+}
+
+/***********************************************************
+ *  UpdateNode()
+ *
+ *  This method is used for recomputing the world matrix of
+ *  a node that is dirty or whose parent was just updated.
+ ***********************************************************/
+void TransformGraph::UpdateNode(int index)
+{
+	TRANSFORM_NODE& node = m_nodes[index];
+	bool bParentUpdated =
+		(node.parent >= m_firstDirty) && (m_updated[node.parent] != 0);
+
+	if (node.dirty || bParentUpdated)
+	{
+		glm::mat4 local = ComposeMatrix(
+			node.scale,
+			node.rotationDegrees,
+			node.position);
+
+		if (node.parent >= 0)
+		{
+			node.worldMatrix = m_nodes[node.parent].worldMatrix * local;
+		}
+		else
+		{
+			node.worldMatrix = local;
+		}
+
+		node.dirty = false;
+		m_updated[index] = 1;
+	}
+}
+
+/***********************************************************
+ *  BuildDepthNodes()
+ *
+ *  This method is used for listing the nodes of each depth,
+ *  which stay in index order as they are added that way.
+ ***********************************************************/
+void TransformGraph::BuildDepthNodes()
+{
+	if (!m_bDepthNodesDirty)
+	{
+		return;
+	}
+
+	m_depthNodes.clear();
+	for (int index = 0; index < static_cast<int>(m_depths.size()); index++)
+	{
+		int depth = m_depths[index];
+		if (depth >= static_cast<int>(m_depthNodes.size()))
+		{
+			m_depthNodes.resize(depth + 1);
+		}
+		m_depthNodes[depth].push_back(index);
+	}
+	m_bDepthNodesDirty = false;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all the nodes.
+ ***********************************************************/
+void TransformGraph::Clear()
+{
+	m_nodes.clear();
+	m_updated.clear();
+	m_depths.clear();
+	m_depthNodes.clear();
+	m_bDepthNodesDirty = true;
+	m_lastUpdated.clear();
+	m_firstDirty = -1;
+	m_lastUpdateCount = 0;
+}
+
+/***********************************************************
+ *  Reserve()
+ *
+ *  This method is used for allocating the storage of a
+ *  known number of nodes, so adding them does not grow the
+ *  node arrays one at a time.
+ ***********************************************************/
+void TransformGraph::Reserve(int nodeCount)
+{
+	m_nodes.reserve(nodeCount);
+	m_updated.reserve(nodeCount);
+	m_depths.reserve(nodeCount);
+	m_lastUpdated.reserve(nodeCount);
+}
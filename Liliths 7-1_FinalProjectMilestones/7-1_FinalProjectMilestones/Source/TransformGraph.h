@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformgraph.h
+// ============
+// hierarchy of local transforms with cached world matrices
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class JobSystem;
+
+/***********************************************************
+ *  TransformGraph
+ *
+ *  This class contains a flat hierarchy of transform nodes.
+ *  Each node stores its local scale, rotation and position
+ *  and a cached world matrix that is only recomputed when
+ *  the node or one of its ancestors has been marked dirty.
+ *  Large updates can be shared over a JobSystem, one depth
+ *  of the hierarchy after the other, since the nodes of one
+ *  depth only read the matrices of the depth above.
+ ***********************************************************/
+class TransformGraph
+{
+public:
+	// constructor
+	TransformGraph();
+
+	struct TRANSFORM_NODE
+	{
+		// index of the parent node, or -1 for a root node
+		int parent;
+		glm::vec3 scale;
+		glm::vec3 rotationDegrees;
+		glm::vec3 position;
+		glm::mat4 worldMatrix;
+		// local values changed since the last update
+		bool dirty;
+	};
+
+	// compose scale, X/Y/Z rotations and translation into one matrix
+	static glm::mat4 ComposeMatrix(
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// add a node; parents must be added before their children
+	int AddNode(
+		int parent,
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegrees,
+		glm::vec3 positionXYZ);
+	// add a unit scale, unrotated node used only for placement
+	int AddAnchor(int parent, glm::vec3 positionXYZ);
+
+	// change the local values of a node and mark it dirty
+	void SetLocalTransform(
+		int node,
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegrees,
+		glm::vec3 positionXYZ);
+	void SetLocalPosition(int node, glm::vec3 positionXYZ);
+	void MarkDirty(int node);
+
+	// recompute the world matrices of every dirty subtree, spread
+	// over the passed in jobs when enough nodes may have changed
+	int UpdateWorldMatrices(JobSystem* pJobs = NULL);
+
+	const glm::mat4& GetWorldMatrix(int node) const { return m_nodes[node].worldMatrix; }
+	const TRANSFORM_NODE& GetNode(int node) const { return m_nodes[node]; }
+	int GetNodeCount() const { return static_cast<int>(m_nodes.size()); }
+	// number of nodes recomputed by the last update
+	int GetLastUpdateCount() const { return m_lastUpdateCount; }
+	// nodes recomputed by the last update, in index order
+	const std::vector<int>& GetLastUpdatedNodes() const { return m_lastUpdated; }
+	// free all the nodes
+	void Clear();
+	// allocate room for a number of nodes up front
+	void Reserve(int nodeCount);
+
+private:
+	// nodes in parent-before-child order
+	std::vector<TRANSFORM_NODE> m_nodes;
+	// per node flag set while an update recomputes its subtree
+	std::vector<unsigned char> m_updated;
+	// depth of each node, 0 for the roots
+	std::vector<int> m_depths;
+	// nodes of each depth in index order, rebuilt after nodes are added
+	std::vector<std::vector<int>> m_depthNodes;
+	bool m_bDepthNodesDirty;
+	// lowest dirty node index, or -1 when nothing is dirty
+	int m_firstDirty;
+	int m_lastUpdateCount;
+	std::vector<int> m_lastUpdated;
+
+	// recompute one node when it or its parent changed
+	void UpdateNode(int index);
+	// group the nodes by depth
+	void BuildDepthNodes();
+};
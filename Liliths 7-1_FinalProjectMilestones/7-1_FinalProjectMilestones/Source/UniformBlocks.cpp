@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformblocks.cpp
+// ============
+// std140 uniform buffer blocks shared by the scene shaders
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "UniformBlocks.h"
+
+// the C++ mirrors must have exactly the std140 sizes
+static_assert(sizeof(CAMERA_BLOCK) == 144, "CAMERA_BLOCK does not match std140");
+static_assert(sizeof(MATERIAL_BLOCK_ENTRY) == 48, "MATERIAL_BLOCK_ENTRY does not match std140");
+static_assert(sizeof(LIGHT_BLOCK_ENTRY) == 80, "LIGHT_BLOCK_ENTRY does not match std140");
+static_assert(sizeof(LIGHT_BLOCK) == 16 + 80 * MAX_BLOCK_LIGHTS, "LIGHT_BLOCK does not match std140");
+
+/***********************************************************
+ *  UniformBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+UniformBuffer::UniformBuffer()
+{
+	m_buffer = 0;
+	m_size = 0;
+}
+
+/***********************************************************
+ *  ~UniformBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+UniformBuffer::~UniformBuffer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for allocating the buffer storage and
+ *  attaching the buffer to its binding point.  Every program
+ *  whose block is bound to the same point then reads it.
+ ***********************************************************/
+void UniformBuffer::Create(GLsizeiptr size, GLuint binding)
+{
+	Destroy();
+
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_buffer);
+
+	m_size = size;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for copying new contents into the
+ *  buffer in a single upload.
+ ***********************************************************/
+void UniformBuffer::Update(const void* pData, GLsizeiptr size, GLintptr offset)
+{
+	if ((0 == m_buffer) || (offset + size > m_size))
+	{
+		return;
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, offset, size, pData);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the buffer.
+ ***********************************************************/
+void UniformBuffer::Destroy()
+{
+	if (0 != m_buffer)
+	{
+		glDeleteBuffers(1, &m_buffer);
+		m_buffer = 0;
+	}
+	m_size = 0;
+}
+
+/***********************************************************
+ *  BindUniformBlock()
+ *
+ *  This function is used for attaching the named uniform
+ *  block of a program to a binding point.  It returns false
+ *  when the program does not declare that block, so callers
+ *  can fall back to setting the uniforms by name.
+ ***********************************************************/
+bool BindUniformBlock(GLuint program, const char* blockName, GLuint binding)
+{
+	if (0 == program)
+	{
+		return(false);
+	}
+
+	GLuint blockIndex = glGetUniformBlockIndex(program, blockName);
+	if (GL_INVALID_INDEX == blockIndex)
+	{
+		return(false);
+	}
+
+	glUniformBlockBinding(program, blockIndex, binding);
+	return(true);
+}
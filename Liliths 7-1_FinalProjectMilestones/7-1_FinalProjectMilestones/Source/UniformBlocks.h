@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformblocks.h
+// ============
+// std140 uniform buffer blocks shared by the scene shaders
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// binding points of the uniform blocks, matching the GLSL block names
+enum UNIFORM_BLOCK_BINDING
+{
+	CAMERA_BLOCK_BINDING = 0,	// "CameraBlock"
+	MATERIAL_BLOCK_BINDING = 1,	// "MaterialBlock"
+	LIGHT_BLOCK_BINDING = 2		// "LightBlock"
+};
+
+// binding points of the shader storage blocks
+enum STORAGE_BLOCK_BINDING
+{
+	OBJECT_BUFFER_BINDING = 0	// "ObjectBuffer"
+};
+
+// capacities of the array blocks, matching the GLSL declarations
+const int MAX_BLOCK_MATERIALS = 64;
+const int MAX_BLOCK_LIGHTS = 4;
+
+// per-frame camera state (std140)
+struct CAMERA_BLOCK
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	// xyz = camera position
+	glm::vec4 viewPosition;
+};
+
+// one material of the material table (std140)
+struct MATERIAL_BLOCK_ENTRY
+{
+	// rgb = ambient color, a = ambient strength
+	glm::vec4 ambient;
+	glm::vec4 diffuseColor;
+	// rgb = specular color, a = shininess
+	glm::vec4 specular;
+};
+
+// material table, uploaded once when the scene is prepared (std140)
+struct MATERIAL_BLOCK
+{
+	MATERIAL_BLOCK_ENTRY materials[MAX_BLOCK_MATERIALS];
+};
+
+// one light source (std140)
+struct LIGHT_BLOCK_ENTRY
+{
+	glm::vec4 position;
+	glm::vec4 ambientColor;
+	glm::vec4 diffuseColor;
+	// rgb = specular color, a = specular intensity
+	glm::vec4 specularColor;
+	// x = focal strength
+	glm::vec4 params;
+};
+
+// scene lights (std140)
+struct LIGHT_BLOCK
+{
+	int lightCount;
+	int useLighting;
+	int padding[2];
+	LIGHT_BLOCK_ENTRY lights[MAX_BLOCK_LIGHTS];
+};
+
+/***********************************************************
+ *  UniformBuffer
+ *
+ *  This class owns one uniform buffer object attached to a
+ *  fixed binding point.
+ ***********************************************************/
+class UniformBuffer
+{
+public:
+	// constructor
+	UniformBuffer();
+	// destructor
+	~UniformBuffer();
+
+	// allocate the buffer and attach it to the binding point
+	void Create(GLsizeiptr size, GLuint binding);
+	// copy new contents into the buffer
+	void Update(const void* pData, GLsizeiptr size, GLintptr offset = 0);
+	// free the buffer
+	void Destroy();
+
+	bool IsCreated() const { return m_buffer != 0; }
+
+private:
+	GLuint m_buffer;
+	GLsizeiptr m_size;
+};
+
+// attach a program's named block to a binding point, false if it has none
+bool BindUniformBlock(GLuint program, const char* blockName, GLuint binding);
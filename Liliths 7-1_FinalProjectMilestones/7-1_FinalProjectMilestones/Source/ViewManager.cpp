@@ -9,6 +9,8 @@
 
 #include "ViewManager.h"
 
+#include <atomic>
+#include <cmath>
 #include <iostream>
 
 // GLM Math Header inclusions
@@ -19,13 +21,18 @@
 // declaration of the global variables and defines
 namespace
 {
-    // Window size (fixed for this assignment; resize handling optional)
+    // Initial window size, and the size of offscreen views
     const int WINDOW_WIDTH = 1000;
     const int WINDOW_HEIGHT = 800;
 
+    // Current framebuffer size, kept up to date by the resize callback
+    int gViewWidth = WINDOW_WIDTH;
+    int gViewHeight = WINDOW_HEIGHT;
+
     // Uniform names
     const char* g_ViewName = "view";
     const char* g_ProjectionName = "projection";
+    const char* g_ViewPositionName = "viewPosition";
 
     // Camera used to view/interact with the 3D scene
     Camera* g_pCamera = nullptr;
@@ -35,9 +42,29 @@ namespace
     float gLastY = WINDOW_HEIGHT * 0.5f;
     bool  gFirstMouse = true;
 
-    // Frame timing
-    float gDeltaTime = 0.0f;
-    float gLastFrame = 0.0f;
+    // Fixed camera tick: movement and mouse-look advance in steps
+    // of this length however long the frames take
+    double gTickSeconds = 1.0 / 120.0;
+    // most ticks caught up in one frame, so a stall does not snowball
+    const int gMaxTicksPerFrame = 12;
+    double gLastTime = -1.0;
+    double gTickAccumulator = 0.0;
+
+    // Mouse-look collected by the callback between ticks
+    std::atomic<float> gMouseDeltaX(0.0f);
+    std::atomic<float> gMouseDeltaY(0.0f);
+
+    // Camera at the last two ticks, drawn blended between them
+    struct CAMERA_STATE
+    {
+        glm::vec3 position;
+        glm::vec3 front;
+        glm::vec3 up;
+    };
+    CAMERA_STATE gPreviousState{};
+    CAMERA_STATE gCurrentState{};
+    // set when the camera jumps, so it is not blended across the jump
+    bool gSnapCamera = true;
 
     // Ortho vs Perspective
     bool bOrthographicProjection = false;
@@ -54,6 +81,25 @@ namespace
     // Save/restore perspective camera when entering/leaving Ortho
     bool  gSavedCamValid = false;
     glm::vec3 gSavedPos{}, gSavedFront{}, gSavedUp{};
+
+    // add to a mouse total without a lock
+    void AddMouseDelta(std::atomic<float>& total, float delta)
+    {
+        float current = total.load();
+        while (!total.compare_exchange_weak(current, current + delta))
+        {
+        }
+    }
+
+    // the camera as it stands now
+    CAMERA_STATE CaptureCameraState()
+    {
+        CAMERA_STATE state;
+        state.position = g_pCamera->Position;
+        state.front = g_pCamera->Front;
+        state.up = g_pCamera->Up;
+        return state;
+    }
 }
 
 /***********************************************************
@@ -61,11 +107,16 @@ namespace
  *
  *  The constructor for the class
  ***********************************************************/
-ViewManager::ViewManager(ShaderManager* pShaderManager)
+ViewManager::ViewManager(ShaderManager* pShaderManager, GLStateCache* pStateCache)
 {
     // initialize the member variables
     m_pShaderManager = pShaderManager;
+    m_pStateCache = pStateCache;
     m_pWindow = NULL;
+    m_viewMatrix = glm::mat4(1.0f);
+    m_projectionMatrix = glm::mat4(1.0f);
+    m_viewPosition = glm::vec3(0.0f, 0.0f, 0.0f);
+    m_bCameraBlockBound = false;
 
     // Camera with a seated/desk vantage
     g_pCamera = new Camera();
@@ -73,6 +124,7 @@ ViewManager::ViewManager(ShaderManager* pShaderManager)
     g_pCamera->Front = glm::vec3(0.0f, -0.15f, -1.0f);
     g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
     g_pCamera->Zoom = 45.0f; // FOV for perspective
+    m_viewPosition = g_pCamera->Position;
 }
 
 /***********************************************************
@@ -83,6 +135,7 @@ ViewManager::ViewManager(ShaderManager* pShaderManager)
 ViewManager::~ViewManager()
 {
     m_pShaderManager = NULL;
+    m_pStateCache = NULL;
     m_pWindow = NULL;
     if (NULL != g_pCamera)
     {
@@ -98,6 +151,8 @@ ViewManager::~ViewManager()
  ***********************************************************/
 GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 {
+    // the scene is drawn at any size, so let the user resize
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
     GLFWwindow* window = glfwCreateWindow(
         WINDOW_WIDTH,
         WINDOW_HEIGHT,
@@ -112,26 +167,112 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
     }
     glfwMakeContextCurrent(window);
 
+    // the framebuffer can differ from the window size on high DPI screens
+    glfwGetFramebufferSize(window, &gViewWidth, &gViewHeight);
+
     // OPTIONAL: capture cursor for FPS-style look
     // glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
     // callbacks
     glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
     glfwSetScrollCallback(window, &ViewManager::Mouse_Scroll_Callback);
+    glfwSetFramebufferSizeCallback(window, &ViewManager::Framebuffer_Size_Callback);
 
-    // enable blending for transparent rendering
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    SetRenderState();
 
     m_pWindow = window;
     return window;
 }
 
+/***********************************************************
+ *  PrepareOffscreenView()
+ *
+ *  Set up for rendering with an offscreen context, where
+ *  the camera is placed by SetScriptedCamera() instead of
+ *  the keyboard and mouse.
+ ***********************************************************/
+void ViewManager::PrepareOffscreenView()
+{
+    m_pWindow = NULL;
+    SetRenderState();
+}
+
+/***********************************************************
+ *  SetRenderState()
+ *
+ *  Render state every view starts out with.
+ ***********************************************************/
+void ViewManager::SetRenderState()
+{
+    // enable blending for transparent rendering
+    m_pStateCache->Enable(GL_BLEND);
+    m_pStateCache->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+/***********************************************************
+ *  SetScriptedCamera()
+ *
+ *  Place the camera at a position looking at a target.
+ ***********************************************************/
+void ViewManager::SetScriptedCamera(const glm::vec3& position, const glm::vec3& target)
+{
+    if (NULL == g_pCamera)
+    {
+        return;
+    }
+
+    g_pCamera->Position = position;
+    g_pCamera->Front = glm::normalize(target - position);
+    g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
+    gSnapCamera = true;
+}
+
+/***********************************************************
+ *  SetTickRate()
+ *
+ *  Set how many fixed camera updates run per second.
+ ***********************************************************/
+void ViewManager::SetTickRate(int ticksPerSecond)
+{
+    if (ticksPerSecond > 0)
+    {
+        gTickSeconds = 1.0 / ticksPerSecond;
+    }
+}
+
+/***********************************************************
+ *  GetViewWidth() / GetViewHeight()
+ *
+ *  Size of the view the projection is built for.
+ ***********************************************************/
+int ViewManager::GetViewWidth() const
+{
+    return gViewWidth;
+}
+
+int ViewManager::GetViewHeight() const
+{
+    return gViewHeight;
+}
+
+/***********************************************************
+ *  Framebuffer_Size_Callback()
+ *
+ *  Keep the view size matching the window when it is
+ *  resized, 0 while it is minimized.
+ ***********************************************************/
+void ViewManager::Framebuffer_Size_Callback(GLFWwindow* /*window*/, int width, int height)
+{
+    gViewWidth = width;
+    gViewHeight = height;
+}
+
 /***********************************************************
  *  Mouse_Position_Callback()
  *
  *  Called by GLFW whenever the mouse moves in the window.
- *  Implements FPS-style look (yaw/pitch).
+ *  Implements FPS-style look (yaw/pitch).  The offsets are
+ *  only collected here; the next camera tick turns by them.
  ***********************************************************/
 void ViewManager::Mouse_Position_Callback(GLFWwindow* /*window*/, double xMousePos, double yMousePos)
 {
@@ -150,11 +291,8 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* /*window*/, double xMouseP
     gLastX = xpos;
     gLastY = ypos;
 
-    if (g_pCamera)
-    {
-        // Delegate to typical learnopengl-style camera
-        g_pCamera->ProcessMouseMovement(xoffset, yoffset);
-    }
+    AddMouseDelta(gMouseDeltaX, xoffset);
+    AddMouseDelta(gMouseDeltaY, yoffset);
 }
 
 /***********************************************************
@@ -180,7 +318,8 @@ void ViewManager::Mouse_Scroll_Callback(GLFWwindow* /*window*/, double /*xoffset
 /***********************************************************
  *  ProcessKeyboardEvents()
  *
- *  Poll keyboard for movement and projection toggles.
+ *  Poll keyboard for closing and projection toggles, once
+ *  per frame.  Movement is polled by TickCamera().
  ***********************************************************/
 void ViewManager::ProcessKeyboardEvents()
 {
@@ -192,29 +331,6 @@ void ViewManager::ProcessKeyboardEvents()
 
     if (!g_pCamera) return;
 
-    // --- Basic 6-DOF translation with WASD + QE ---
-    // Scale by delta time *and* gMoveSpeed so scroll changes travel rate.
-    float dt = gDeltaTime;
-    // If your Camera uses its own MovementSpeed, passing dt is fine.
-    // Otherwise multiply dt by gMoveSpeed to get a world-speed effect.
-    // We'll do both to be robust:
-    float dtSpeed = dt * (gMoveSpeed / 2.5f); // normalize against base 2.5
-
-    if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
-        g_pCamera->ProcessKeyboard(FORWARD, dtSpeed);
-    if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
-        g_pCamera->ProcessKeyboard(BACKWARD, dtSpeed);
-    if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
-        g_pCamera->ProcessKeyboard(LEFT, dtSpeed);
-    if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
-        g_pCamera->ProcessKeyboard(RIGHT, dtSpeed);
-
-    // Vertical (up/down) with Q/E
-    if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
-        g_pCamera->ProcessKeyboard(UP, dtSpeed);
-    if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
-        g_pCamera->ProcessKeyboard(DOWN, dtSpeed);
-
     // --- Projection toggles with debounce (tap O/P) ---
     bool pDown = glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS;
     bool oDown = glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS;
@@ -231,6 +347,7 @@ void ViewManager::ProcessKeyboardEvents()
             g_pCamera->Front = gSavedFront;
             g_pCamera->Up = gSavedUp;
             gSavedCamValid = false;
+            gSnapCamera = true;
         }
     }
     gWasPDown = pDown;
@@ -254,10 +371,98 @@ void ViewManager::ProcessKeyboardEvents()
         g_pCamera->Position = glm::vec3(0.0f, 0.0f, 3.0f);
         g_pCamera->Front = glm::vec3(0.0f, 0.0f, -1.0f);
         g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
+        gSnapCamera = true;
     }
     gWasODown = oDown;
 }
 
+/***********************************************************
+ *  TickCamera()
+ *
+ *  Advance the camera by one fixed step: turn by the mouse
+ *  movement collected since the last tick and move by the
+ *  keys held down.
+ ***********************************************************/
+void ViewManager::TickCamera(float tickSeconds)
+{
+    if (!g_pCamera) return;
+
+    // Delegate to typical learnopengl-style camera
+    float xoffset = gMouseDeltaX.exchange(0.0f);
+    float yoffset = gMouseDeltaY.exchange(0.0f);
+    if ((xoffset != 0.0f) || (yoffset != 0.0f))
+    {
+        g_pCamera->ProcessMouseMovement(xoffset, yoffset);
+    }
+
+    // --- Basic 6-DOF translation with WASD + QE ---
+    // Scale by delta time *and* gMoveSpeed so scroll changes travel rate.
+    float dt = tickSeconds;
+    // If your Camera uses its own MovementSpeed, passing dt is fine.
+    // Otherwise multiply dt by gMoveSpeed to get a world-speed effect.
+    // We'll do both to be robust:
+    float dtSpeed = dt * (gMoveSpeed / 2.5f); // normalize against base 2.5
+
+    if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
+        g_pCamera->ProcessKeyboard(FORWARD, dtSpeed);
+    if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
+        g_pCamera->ProcessKeyboard(BACKWARD, dtSpeed);
+    if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
+        g_pCamera->ProcessKeyboard(LEFT, dtSpeed);
+    if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
+        g_pCamera->ProcessKeyboard(RIGHT, dtSpeed);
+
+    // Vertical (up/down) with Q/E
+    if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
+        g_pCamera->ProcessKeyboard(UP, dtSpeed);
+    if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
+        g_pCamera->ProcessKeyboard(DOWN, dtSpeed);
+}
+
+/***********************************************************
+ *  UpdateCamera()
+ *
+ *  Run as many fixed camera ticks as fit in the time since
+ *  the last frame, keeping the remainder for the next one,
+ *  so the camera moves at the same rate whatever the frame
+ *  cost.  Returns the remainder as a fraction of a tick.
+ ***********************************************************/
+float ViewManager::UpdateCamera()
+{
+    double currentTime = glfwGetTime();
+    if (gLastTime < 0.0)
+    {
+        gLastTime = currentTime;
+    }
+    gTickAccumulator += currentTime - gLastTime;
+    gLastTime = currentTime;
+
+    ProcessKeyboardEvents();
+    if (gSnapCamera)
+    {
+        gCurrentState = CaptureCameraState();
+        gPreviousState = gCurrentState;
+        gSnapCamera = false;
+    }
+
+    int tickCount = 0;
+    while ((gTickAccumulator >= gTickSeconds) && (tickCount < gMaxTicksPerFrame))
+    {
+        gPreviousState = gCurrentState;
+        TickCamera(static_cast<float>(gTickSeconds));
+        gCurrentState = CaptureCameraState();
+        gTickAccumulator -= gTickSeconds;
+        tickCount++;
+    }
+    // drop the time of a stall the ticks could not catch up on
+    if (gTickAccumulator >= gTickSeconds)
+    {
+        gTickAccumulator = std::fmod(gTickAccumulator, gTickSeconds);
+    }
+
+    return static_cast<float>(gTickAccumulator / gTickSeconds);
+}
+
 /***********************************************************
  *  PrepareSceneView()
  *
@@ -268,19 +473,29 @@ void ViewManager::PrepareSceneView()
     glm::mat4 view;
     glm::mat4 projection;
 
-    // Per-frame timing
-    float currentFrame = static_cast<float>(glfwGetTime());
-    gDeltaTime = currentFrame - gLastFrame;
-    gLastFrame = currentFrame;
-
-    // Keyboard handling (movement + toggles)
-    ProcessKeyboardEvents();
+    // Fixed camera ticks and keyboard handling (movement + toggles),
+    // drawn between the last two ticks; offscreen views are driven
+    // by SetScriptedCamera() instead
+    glm::vec3 position = g_pCamera->Position;
+    glm::vec3 front = g_pCamera->Front;
+    glm::vec3 up = g_pCamera->Up;
+    if (NULL != m_pWindow)
+    {
+        float blend = UpdateCamera();
+        position = glm::mix(gPreviousState.position, gCurrentState.position, blend);
+        front = glm::normalize(glm::mix(gPreviousState.front, gCurrentState.front, blend));
+        up = glm::normalize(glm::mix(gPreviousState.up, gCurrentState.up, blend));
+    }
 
     // View from camera
-    view = g_pCamera->GetViewMatrix();
+    view = glm::lookAt(position, position + front, up);
 
     // Projection selection
     float aspect = static_cast<float>(WINDOW_WIDTH) / static_cast<float>(WINDOW_HEIGHT);
+    if ((gViewWidth > 0) && (gViewHeight > 0))
+    {
+        aspect = static_cast<float>(gViewWidth) / static_cast<float>(gViewHeight);
+    }
     if (!bOrthographicProjection)
     {
         // Perspective projection
@@ -297,11 +512,44 @@ void ViewManager::PrepareSceneView()
         projection = glm::ortho(-halfWidth, halfWidth, -halfHeight, halfHeight, 0.1f, 100.0f);
     }
 
-    // Push matrices and camera position to shader
-    if (NULL != m_pShaderManager)
+    // Keep this frame's matrices for render paths with their own shaders
+    m_viewMatrix = view;
+    m_projectionMatrix = projection;
+    m_viewPosition = position;
+
+    // Create the camera block once the GL context and shaders exist
+    if (!m_cameraBlock.IsCreated())
     {
-        m_pShaderManager->setMat4Value(g_ViewName, view);
-        m_pShaderManager->setMat4Value(g_ProjectionName, projection);
-        m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+        m_cameraBlock.Create(sizeof(CAMERA_BLOCK), CAMERA_BLOCK_BINDING);
+        if (NULL != m_pShaderManager)
+        {
+            m_bCameraBlockBound = BindUniformBlock(
+                m_pShaderManager->m_programID, "CameraBlock", CAMERA_BLOCK_BINDING);
+        }
     }
+
+    // One upload serves every program that declares the camera block
+    CAMERA_BLOCK cameraBlock;
+    cameraBlock.view = view;
+    cameraBlock.projection = projection;
+    cameraBlock.viewPosition = glm::vec4(position, 1.0f);
+    m_cameraBlock.Update(&cameraBlock, sizeof(cameraBlock));
+
+    // Push matrices and camera position by name to shaders without the block
+    if ((NULL != m_pStateCache) && !m_bCameraBlockBound)
+    {
+        m_pStateCache->SetMat4(g_ViewName, view);
+        m_pStateCache->SetMat4(g_ProjectionName, projection);
+        m_pStateCache->SetVec3(g_ViewPositionName, position);
+    }
+}
+
+/***********************************************************
+ *  GetCameraPosition()
+ *
+ *  Return the world position the current frame is drawn from.
+ ***********************************************************/
+glm::vec3 ViewManager::GetCameraPosition() const
+{
+    return m_viewPosition;
 }
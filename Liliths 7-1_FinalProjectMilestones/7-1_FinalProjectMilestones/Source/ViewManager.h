@@ -10,6 +10,8 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "UniformBlocks.h"
+#include "GLStateCache.h"
 #include "camera.h"
 
 // GLFW library
@@ -19,7 +21,7 @@ class ViewManager
 {
 public:
     // constructor
-    ViewManager(ShaderManager* pShaderManager);
+    ViewManager(ShaderManager* pShaderManager, GLStateCache* pStateCache);
     // destructor
     ~ViewManager();
 
@@ -27,20 +29,56 @@ public:
     static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
     // mouse scroll callback for speed control
     static void Mouse_Scroll_Callback(GLFWwindow* window, double xoffset, double yoffset);
+    // framebuffer size callback for window resizing
+    static void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
 
 private:
     // pointer to shader manager object
     ShaderManager* m_pShaderManager;
+    // pointer to the shared OpenGL state cache
+    GLStateCache* m_pStateCache;
     // active OpenGL display window
     GLFWwindow* m_pWindow;
+    // matrices and camera position prepared for the current frame
+    glm::mat4 m_viewMatrix;
+    glm::mat4 m_projectionMatrix;
+    glm::vec3 m_viewPosition;
+    // per-frame camera uniform block
+    UniformBuffer m_cameraBlock;
+    // true when the main program reads the camera block
+    bool m_bCameraBlockBound;
 
     // process keyboard events for interaction with the 3D scene
     void ProcessKeyboardEvents();
+    // run the camera ticks due since the last frame, returns how
+    // far the frame is between the last two ticks
+    float UpdateCamera();
+    // one fixed step of keyboard movement and mouse-look
+    void TickCamera(float tickSeconds);
+    // state shared by the window and offscreen views
+    void SetRenderState();
 
 public:
     // create the initial OpenGL display window
     GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+    // set up for rendering into a target with no window
+    void PrepareOffscreenView();
+
+    // place the camera for runs without keyboard or mouse
+    void SetScriptedCamera(const glm::vec3& position, const glm::vec3& target);
+    // camera ticks per second, 120 by default
+    void SetTickRate(int ticksPerSecond);
+    // size of the view the projection is built for, the window's
+    // framebuffer size, or 0 while the window is minimized
+    int GetViewWidth() const;
+    int GetViewHeight() const;
 
     // prepare the conversion from 3D object display to 2D scene display
     void PrepareSceneView();
+
+    // matrices and camera position prepared by PrepareSceneView(),
+    // blended between the last two camera ticks
+    const glm::mat4& GetViewMatrix() const { return m_viewMatrix; }
+    const glm::mat4& GetProjectionMatrix() const { return m_projectionMatrix; }
+    glm::vec3 GetCameraPosition() const;
 };
@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////////////
+// indirectVertexShader.glsl
+// ============
+// vertex shader for the multi-draw indirect render path; the model matrix,
+// color and texture parameters of every object are read from a storage
+// buffer, indexed by the base instance of the draw command
+///////////////////////////////////////////////////////////////////////////////
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : require
+
+// float vertices, or PrimitiveMeshes::PACKED_VERTEX with the position as a
+// fraction of the mesh box and the normal octahedral encoded in xy
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+flat out vec4 fragmentColor;
+flat out vec4 fragmentParams;
+
+// same layout as InstancedRenderer::INSTANCE_DATA
+struct ObjectData
+{
+	mat4 model;
+	vec4 color;
+	// UV scale in xy, texture layer in z (-1 untextured), material in w
+	vec4 params;
+};
+
+// every object of the scene, see UniformBlocks.h
+layout (std430, binding = 0) readonly buffer ObjectBuffer
+{
+	ObjectData objects[];
+};
+
+// per-frame camera state, see UniformBlocks.h
+layout (std140) uniform CameraBlock
+{
+	mat4 view;
+	mat4 projection;
+	vec4 viewPosition;
+};
+
+// box of the packed positions, 0 and 1 for float vertices
+uniform vec3 positionMin;
+uniform vec3 positionExtent = vec3(1.0f);
+uniform bool bOctahedralNormals = false;
+
+// unfold the octahedral normal, bytes 0 to 254 arrive as 0 to 254/255
+vec3 DecodeNormal()
+{
+	if (!bOctahedralNormals)
+	{
+		return inVertexNormal;
+	}
+
+	vec2 octahedral = inVertexNormal.xy * (255.0f / 127.0f) - 1.0f;
+	vec3 normal = vec3(octahedral, 1.0f - abs(octahedral.x) - abs(octahedral.y));
+	float fold = max(-normal.z, 0.0f);
+	normal.x += (normal.x >= 0.0f) ? -fold : fold;
+	normal.y += (normal.y >= 0.0f) ? -fold : fold;
+	return normalize(normal);
+}
+
+void main()
+{
+	// gl_DrawID restarts with every multi-draw call, the base instance
+	// of the command does not
+	ObjectData object = objects[gl_BaseInstanceARB + gl_InstanceID];
+	vec3 localPosition = positionMin + inVertexPosition * positionExtent;
+	vec4 worldPosition = object.model * vec4(localPosition, 1.0f);
+
+	gl_Position = projection * view * worldPosition;
+
+	fragmentPosition = vec3(worldPosition);
+	fragmentVertexNormal = mat3(transpose(inverse(object.model))) * DecodeNormal();
+	fragmentTextureCoordinate = inTextureCoordinate;
+	fragmentColor = object.color;
+	fragmentParams = object.params;
+}
@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+// instancedFragmentShader.glsl
+// ============
+// fragment shader for the instanced render path; produces the same output
+// as the per-draw shader, reading camera, materials and lights from the
+// uniform blocks declared in UniformBlocks.h
+///////////////////////////////////////////////////////////////////////////////
+#version 330 core
+
+#define MAX_BLOCK_MATERIALS 64
+#define MAX_BLOCK_LIGHTS 4
+
+struct Material
+{
+	vec4 ambient;		// rgb = color, a = strength
+	vec4 diffuseColor;
+	vec4 specular;		// rgb = color, a = shininess
+};
+
+struct LightSource
+{
+	vec4 position;
+	vec4 ambientColor;
+	vec4 diffuseColor;
+	vec4 specularColor;	// a = specular intensity
+	vec4 params;		// x = focal strength
+};
+
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+flat in vec4 fragmentColor;
+flat in vec4 fragmentParams;
+
+out vec4 outFragmentColor;
+
+layout (std140) uniform CameraBlock
+{
+	mat4 view;
+	mat4 projection;
+	vec4 viewPosition;
+};
+
+layout (std140) uniform MaterialBlock
+{
+	Material materials[MAX_BLOCK_MATERIALS];
+};
+
+layout (std140) uniform LightBlock
+{
+	int lightCount;
+	int useLighting;
+	LightSource lights[MAX_BLOCK_LIGHTS];
+};
+
+uniform sampler2D objectTexture;
+// layers of the texture array backend, picked by fragmentParams.z
+uniform sampler2DArray objectTextureArray;
+uniform bool bUseTextureArray;
+
+vec3 CalcLightSource(LightSource light, Material material, vec3 lightNormal, vec3 viewDirection)
+{
+	vec3 lightDirection = normalize(light.position.xyz - fragmentPosition);
+	vec3 ambient = light.ambientColor.rgb * material.ambient.rgb * material.ambient.a;
+
+	float impact = max(dot(lightNormal, lightDirection), 0.0f);
+	vec3 diffuse = impact * light.diffuseColor.rgb * material.diffuseColor.rgb;
+
+	vec3 reflectDirection = reflect(-lightDirection, lightNormal);
+	float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0f), light.params.x);
+	vec3 specular = light.specularColor.a * specularComponent * material.specular.rgb;
+
+	return ambient + diffuse + specular;
+}
+
+void main()
+{
+	bool bUseTexture = fragmentParams.z >= 0.0f;
+	int materialIndex = int(fragmentParams.w);
+	vec4 baseColor = fragmentColor;
+
+	if (bUseTexture)
+	{
+		vec2 uv = fragmentTextureCoordinate * fragmentParams.xy;
+		if (bUseTextureArray)
+		{
+			baseColor = fragmentColor * texture(objectTextureArray, vec3(uv, fragmentParams.z));
+		}
+		else
+		{
+			baseColor = fragmentColor * texture(objectTexture, uv);
+		}
+	}
+
+	if ((useLighting != 0) && (materialIndex >= 0))
+	{
+		Material material = materials[materialIndex];
+		vec3 lightNormal = normalize(fragmentVertexNormal);
+		vec3 viewDirection = normalize(viewPosition.xyz - fragmentPosition);
+		vec3 phongResult = vec3(0.0f);
+
+		for (int i = 0; i < lightCount; i++)
+		{
+			phongResult += CalcLightSource(lights[i], material, lightNormal, viewDirection);
+		}
+		outFragmentColor = vec4(phongResult * baseColor.rgb, baseColor.a);
+	}
+	else
+	{
+		outFragmentColor = baseColor;
+	}
+}
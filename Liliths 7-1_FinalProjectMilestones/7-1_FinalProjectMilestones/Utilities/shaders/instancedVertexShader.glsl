@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////////////////////
+// instancedVertexShader.glsl
+// ============
+// vertex shader for the instanced render path; the model matrix, color and
+// texture parameters come from the per-instance attributes
+///////////////////////////////////////////////////////////////////////////////
+#version 330 core
+
+// float vertices, or PrimitiveMeshes::PACKED_VERTEX with the position as a
+// fraction of the mesh box and the normal octahedral encoded in xy
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+// locations 3 to 6 hold the columns of the model matrix
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceColor;
+// UV scale in xy, texture layer in z (-1 untextured), material in w
+layout (location = 8) in vec4 inInstanceParams;
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+flat out vec4 fragmentColor;
+flat out vec4 fragmentParams;
+
+// per-frame camera state, see UniformBlocks.h
+layout (std140) uniform CameraBlock
+{
+	mat4 view;
+	mat4 projection;
+	vec4 viewPosition;
+};
+
+// box of the packed positions, 0 and 1 for float vertices
+uniform vec3 positionMin;
+uniform vec3 positionExtent = vec3(1.0f);
+uniform bool bOctahedralNormals = false;
+
+// unfold the octahedral normal, bytes 0 to 254 arrive as 0 to 254/255
+vec3 DecodeNormal()
+{
+	if (!bOctahedralNormals)
+	{
+		return inVertexNormal;
+	}
+
+	vec2 octahedral = inVertexNormal.xy * (255.0f / 127.0f) - 1.0f;
+	vec3 normal = vec3(octahedral, 1.0f - abs(octahedral.x) - abs(octahedral.y));
+	float fold = max(-normal.z, 0.0f);
+	normal.x += (normal.x >= 0.0f) ? -fold : fold;
+	normal.y += (normal.y >= 0.0f) ? -fold : fold;
+	return normalize(normal);
+}
+
+void main()
+{
+	vec3 localPosition = positionMin + inVertexPosition * positionExtent;
+	vec4 worldPosition = inInstanceModel * vec4(localPosition, 1.0f);
+
+	gl_Position = projection * view * worldPosition;
+
+	fragmentPosition = vec3(worldPosition);
+	fragmentVertexNormal = mat3(transpose(inverse(inInstanceModel))) * DecodeNormal();
+	fragmentTextureCoordinate = inTextureCoordinate;
+	fragmentColor = inInstanceColor;
+	fragmentParams = inInstanceParams;
+}